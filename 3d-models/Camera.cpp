@@ -55,6 +55,19 @@ void Camera::Control(float frameTime, KeyCode turnUp, KeyCode turnDown, KeyCode
 }
 
 
+// Get a copy of the camera placed t of the way (0 to 1) from where it was at the start of the last simulation step to
+// where it is now
+Camera Camera::Interpolated(float t)
+{
+    Camera camera = *this;
+    camera.mPosition = mPreviousPosition + (mPosition - mPreviousPosition) * t;
+    camera.mRotation = { LerpAngle(mPreviousRotation.x, mRotation.x, t),
+                         LerpAngle(mPreviousRotation.y, mRotation.y, t),
+                         LerpAngle(mPreviousRotation.z, mRotation.z, t) };
+    return camera;
+}
+
+
 // Update the matrices used for the camera in the rendering pipeline
 void Camera::UpdateMatrices()
 {
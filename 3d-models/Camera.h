@@ -23,7 +23,8 @@ public:
 	// Constructor - initialise all settings, sensible defaults provided for everything.
 	Camera(CVector3 position = {0,0,0}, CVector3 rotation = {0,0,0}, 
            float fov = PI/3, float aspectRatio = 4.0f / 3.0f, float nearClip = 0.1f, float farClip = 10000.0f)
-        : mPosition(position), mRotation(rotation), mFOVx(fov), mAspectRatio(aspectRatio), mNearClip(nearClip), mFarClip(farClip)
+        : mPosition(position), mRotation(rotation), mFOVx(fov), mAspectRatio(aspectRatio), mNearClip(nearClip), mFarClip(farClip),
+          mPreviousPosition(position), mPreviousRotation(rotation)
     {
     }
 
@@ -32,6 +33,12 @@ public:
 	void Control( float frameTime, KeyCode turnUp, KeyCode turnDown, KeyCode turnLeft, KeyCode turnRight,  
 	              KeyCode moveForward, KeyCode moveBackward, KeyCode moveLeft, KeyCode moveRight);
 
+    // Fixed timestep support (see FixedTimestep.h). Call StartStep before each simulation step that may move the camera
+    // to remember where it was. Interpolated returns a copy of the camera placed t of the way (0 to 1) from there to
+    // where it is now, to render from between steps
+    void   StartStep()  { mPreviousPosition = mPosition;  mPreviousRotation = mRotation; }
+    Camera Interpolated(float t);
+
 
 	//-------------------------------------
 	// Data access
@@ -52,6 +59,7 @@ public:
 	void SetFarClip (float farClip )  { mFarClip  = farClip;  }
 
 	// Read only access to camera matrices, updated on request from position, rotation and camera settings
+	CMatrix4x4 WorldMatrix()           { UpdateMatrices(); return mWorldMatrix;          }
 	CMatrix4x4 ViewMatrix()            { UpdateMatrices(); return mViewMatrix;           }
 	CMatrix4x4 ProjectionMatrix()      { UpdateMatrices(); return mProjectionMatrix;     }
 	CMatrix4x4 ViewProjectionMatrix()  { UpdateMatrices(); return mViewProjectionMatrix; }
@@ -82,6 +90,10 @@ private:
 	CMatrix4x4 mProjectionMatrix;     // Projection matrix holds the field of view and near/far clip distances
 	CMatrix4x4 mViewProjectionMatrix; // Combine (multiply) the view and projection matrices together, which
 	                                  // can sometimes save a matrix multiply in the shader (optional)
+
+	// Position and rotation at the start of the last simulation step
+	CVector3 mPreviousPosition;
+	CVector3 mPreviousRotation;
 };
 
 
@@ -9,33 +9,42 @@
 // Shader code
 //--------------------------------------------------------------------------------------
 
-// Vertex shader expands the model slightly for the outline
-// Only output is the vertex position transformed into screen space, but needs a little work
-// to get the amount to expand based on distance
-BasicPixelShaderInput main(BasicVertex modelVertex)
-{
-    BasicPixelShaderInput output; // This is the data the pixel shader requires from this vertex shader
-
-    // Transform model vertex position to world space using the world matrix passed from C++
-    float4 modelPosition = float4(modelVertex.position, 1);
-    float4 worldPosition = mul(gWorldMatrix, modelPosition);
+// Outline thickness on screen, as wide as if it stuck out OutlineThickness * sqrt(distance from camera) in the world. So it
+// gets thinner in the distance, but always remains clear
+static const float OutlineThickness = 0.015f;
 
-	// Next the usual transform from world space to camera space - but we don't go any further here - this will be used to help expand the outline
-	// The result "viewPosition" is the xyz position of the vertex as seen from the camera. The z component is the distance from the camera - that's useful...
-    float4 viewPosition = mul(gViewMatrix, worldPosition);
+// Pulls the outline towards the camera so it isn't hidden by the surface it is drawn along
+static const float OutlineDepthBias = 0.0002f;
 
-	// Transform model normal to world space. We will use the normal to expand the geometry, not for lighting
-    float4 modelNormal = float4(modelVertex.normal, 0.0f); // Set 4th element to 0.0 this time as normals are vectors
-    float4 worldNormal = normalize(mul(gWorldMatrix, modelNormal)); // Normalise in case of world matrix scaling
 
-	// Now we return to the world position of this vertex and expand it along the world normal - that will expand the geometry outwards.
-	// Use the distance from the camera to decide how much to expand. Use this distance together with a sqrt to creates an outline that
-	// gets thinner in the distance, but always remains clear. Overall thickness is also controlled by the constant "OutlineThickness"
-    worldPosition += 0.015f * sqrt(viewPosition.z) * worldNormal;
-
-    // Transform new expanded world-space vertex position to view space then 2D projection space and output
-    viewPosition = mul(gViewMatrix, worldPosition);
-    output.projectedPosition = mul(gProjectionMatrix, viewPosition);
+// The outline is drawn as quads along the silhouette edges of the model, found on the CPU (see SilhouetteEdges.h). Each
+// corner of a quad is at one end of its edge and is pushed sideways on screen to give the quad its thickness
+BasicPixelShaderInput main(OutlineVertex outlineVertex)
+{
+    BasicPixelShaderInput output; // This is the data the pixel shader requires from this vertex shader
 
+    // Transform both ends of the edge to view space and then 2D projection space
+    float4 worldPosition  = mul(gWorldMatrix, float4(outlineVertex.position, 1));
+    float4 viewPosition   = mul(gViewMatrix, worldPosition);
+    float4 projected      = mul(gProjectionMatrix, viewPosition);
+    float4 otherProjected = mul(gViewProjectionMatrix, mul(gWorldMatrix, float4(outlineVertex.otherEnd, 1)));
+
+    // Direction along the edge on screen, with x scaled by the aspect ratio so the thickness is the same in any direction.
+    // The projection matrix scales x and y by different amounts, their ratio is the aspect ratio
+    float aspect = gProjectionMatrix[1][1] / gProjectionMatrix[0][0];
+    float2 screen      = projected.xy / max(projected.w, 0.0001f);
+    float2 otherScreen = otherProjected.xy / max(otherProjected.w, 0.0001f);
+    float2 alongEdge = (otherScreen - screen) * float2(aspect, 1);
+    alongEdge = dot(alongEdge, alongEdge) > 0 ? normalize(alongEdge) : float2(1, 0);
+    float2 acrossEdge = float2(-alongEdge.y, alongEdge.x);
+
+    // Push the corner to its side of the edge, and also a little past the end of the edge so the quads of neighbouring
+    // edges overlap without gaps at the corners
+    float thickness = OutlineThickness * gProjectionMatrix[1][1] / sqrt(max(viewPosition.z, 0.0001f));
+    float2 offset = (acrossEdge * outlineVertex.side - alongEdge) * thickness;
+    projected.xy += offset * float2(1 / aspect, 1) * projected.w;
+    projected.z  -= OutlineDepthBias * projected.w;
+
+    output.projectedPosition = projected;
     return output; // Ouput data sent down the pipeline (to the pixel shader)
 }
@@ -106,9 +106,36 @@ struct PerModelConstants
     CMatrix4x4 worldMatrix;
     CVector3   objectColour; // Allows each light model to be tinted to match the light colour they cast
     float      padding6;
+
+    uint32_t   diffuseSpecularSlice;  // Slice of the diffuse-specular texture array that holds this model's texture
+    uint32_t   diffuseSpecularSlice2; // Slice for the second texture, for shaders that mix two textures
+    float      padding7[2];
 };
 extern PerModelConstants gPerModelConstants;      // This variable holds the CPU-side constant buffer described above
 extern ID3D11Buffer*     gPerModelConstantBuffer; // This variable controls the GPU-side constant buffer related to the above structure
 
 
+
+// Point lights used by the stress scene (see StressScene.h). They have no cone and cast no shadows, so any number can
+// be added to a scene cheaply (compared to spotlights, which each need a shadow map). Updated once per frame when used
+const int MAX_POINT_LIGHTS = 32; // Must match the value in Common.hlsli
+
+struct PointLight
+{
+    CVector3 position;
+    float    padding8;
+    CVector3 colour; // Includes the light strength
+    float    padding9;
+};
+
+struct PointLightConstants
+{
+    PointLight pointLights[MAX_POINT_LIGHTS];
+    uint32_t   numPointLights;
+    float      padding10[3];
+};
+extern PointLightConstants gPointLightConstants;      // This variable holds the CPU-side constant buffer described above
+extern ID3D11Buffer*       gPointLightConstantBuffer; // This variable controls the GPU-side constant buffer related to the above structure
+
+
 #endif //_COMMON_H_INCLUDED_
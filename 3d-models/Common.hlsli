@@ -16,6 +16,25 @@ struct BasicVertex
     float2 uv       : uv;
 };
 
+// One corner of a quad drawn along a silhouette edge for cartoon outlines (OutlineVertex in SilhouetteEdges.h).
+// Each corner knows both ends of its edge so it can be pushed out to the side on screen
+struct OutlineVertex
+{
+    float3 position : position; // End of the edge this corner is at
+    float3 otherEnd : otherEnd;
+    float  side     : side;     // -1 or 1, which side of the edge to push the corner to
+};
+
+// One corner of a camera-facing sprite (SpriteVertex in SpriteBatch.h). All four corners carry the whole sprite, the
+// vertex shader places each one from its vertex number
+struct SpriteVertex
+{
+    float3 position : position; // Centre of the sprite
+    float  size     : size;
+    float3 colour   : colour;
+    float  rotation : rotation;
+};
+
 // The most basic pixel shader input, just the screen space position for the pixel
 struct BasicPixelShaderInput
 {
@@ -49,6 +68,14 @@ struct SimplePixelShaderInput
 };
 
 
+// Sprites are tinted by their own colour rather than a per-model colour, as a whole batch is drawn at once
+struct SpritePixelShaderInput
+{
+    float4 projectedPosition : SV_Position;
+    float2 uv     : uv;
+    float3 colour : colour;
+};
+
 //--------------------------------------------------------------------------------------
 // Constant Buffers
 //--------------------------------------------------------------------------------------
@@ -108,4 +135,29 @@ cbuffer PerModelConstants : register(b1) // The b1 gives this constant buffer th
 
     float3   gObjectColour;
     float    padding6;  // See notes on padding in structure above
+
+    uint     gDiffuseSpecularSlice;  // Diffuse-specular maps are held in texture arrays, this selects the slice for this model
+    uint     gDiffuseSpecularSlice2; // Slice for the second texture, for shaders that mix two textures
+    float2   padding7;
+}
+
+
+
+// Point lights, which have no cone and cast no shadows. Only used by permutations of Lighting_ps with POINT_LIGHTS set
+// These variables must match exactly the gPointLightConstants structure in StressScene.cpp
+static const uint MAX_POINT_LIGHTS = 32;
+
+struct PointLight
+{
+    float3 position;
+    float  padding8;
+    float3 colour; // Includes the light strength
+    float  padding9;
+};
+
+cbuffer PointLightConstants : register(b2)
+{
+    PointLight gPointLights[MAX_POINT_LIGHTS];
+    uint       gNumPointLights;
+    float3     padding10;
 }
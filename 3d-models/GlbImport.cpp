@@ -0,0 +1,1370 @@
+//--------------------------------------------------------------------------------------
+// Native binary glTF 2.0 (.glb) mesh import
+//--------------------------------------------------------------------------------------
+
+#include "GlbImport.h"
+#include "MappedFile.h"
+#include "CVector2.h"
+#include "CVector3.h"
+
+#include <emmintrin.h> // SSE2
+#include <stdexcept>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+
+namespace
+{
+    //--------------------------------------------------------------------------------------
+    // JSON
+    //--------------------------------------------------------------------------------------
+
+    // A parsed JSON value, only as much as reading the glTF JSON chunk needs
+    struct JsonValue
+    {
+        enum class Type { Null, Bool, Number, String, Array, Object };
+
+        Type                     type    = Type::Null;
+        bool                     boolean = false;
+        double                   number  = 0;
+        std::string              string;
+        std::vector<std::string> keys;   // Objects only, the key of each value
+        std::vector<JsonValue>   values; // Elements of an array or values of an object
+
+        // Member of an object or element of an array, a null value if there isn't one
+        const JsonValue& operator[](const char* key) const;
+        const JsonValue& operator[](size_t index) const;
+
+        bool   IsNull() const  { return type == Type::Null; }
+        size_t Size()   const  { return type == Type::Array ? values.size() : 0; }
+
+        // The value as a number or string, the given default if it is missing or of another type
+        double Number(double otherwise = 0) const  { return type == Type::Number ? number : otherwise; }
+
+        // The value as an index, count or byte offset, SIZE_MAX if it isn't a whole number that fits in 32 bits
+        size_t Index(size_t otherwise = SIZE_MAX) const
+        {
+            if (type != Type::Number)  return otherwise;
+            return (number >= 0 && number < 4294967296.0 && number == std::floor(number)) ? static_cast<size_t>(number) : SIZE_MAX;
+        }
+        const std::string& String() const  { return string; }
+    };
+
+    const JsonValue& NullValue()
+    {
+        static const JsonValue null;
+        return null;
+    }
+
+    const JsonValue& JsonValue::operator[](const char* key) const
+    {
+        if (type != Type::Object)  return NullValue();
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (keys[i] == key)  return values[i];
+        }
+        return NullValue();
+    }
+
+    const JsonValue& JsonValue::operator[](size_t index) const
+    {
+        return (type == Type::Array && index < values.size()) ? values[index] : NullValue();
+    }
+
+
+    // Recursive descent JSON parser, throws a std::runtime_error on invalid JSON
+    class JsonParser
+    {
+    public:
+        JsonParser(const char* text, size_t length, const std::string& fileName)
+            : mText(text), mEnd(text + length), mFileName(fileName) {}
+
+        JsonValue Parse()
+        {
+            JsonValue root;
+            ParseValue(root, 0);
+            SkipSpace();
+            while (mText != mEnd && *mText == '\0')  ++mText; // Some exporters pad the chunk with zeros rather than spaces
+            if (mText != mEnd)  Fail("unexpected text after the end");
+            return root;
+        }
+
+    private:
+        static const int MAX_DEPTH = 64;
+
+        void ParseValue(JsonValue& value, int depth)
+        {
+            if (depth > MAX_DEPTH)  Fail("nested too deeply");
+            SkipSpace();
+            if (mText == mEnd)  Fail("unexpected end");
+
+            char c = *mText;
+            if (c == '{')
+            {
+                value.type = JsonValue::Type::Object;
+                ++mText;
+                if (Next('}'))  return;
+                do
+                {
+                    SkipSpace();
+                    if (mText == mEnd || *mText != '"')  Fail("expected a key");
+                    value.keys.emplace_back();
+                    ParseString(value.keys.back());
+                    if (!Next(':'))  Fail("expected ':'");
+                    value.values.emplace_back();
+                    ParseValue(value.values.back(), depth + 1);
+                } while (Next(','));
+                if (!Next('}'))  Fail("expected '}'");
+            }
+            else if (c == '[')
+            {
+                value.type = JsonValue::Type::Array;
+                ++mText;
+                if (Next(']'))  return;
+                do
+                {
+                    value.values.emplace_back();
+                    ParseValue(value.values.back(), depth + 1);
+                } while (Next(','));
+                if (!Next(']'))  Fail("expected ']'");
+            }
+            else if (c == '"')
+            {
+                value.type = JsonValue::Type::String;
+                ParseString(value.string);
+            }
+            else if (c == '-' || (c >= '0' && c <= '9'))
+            {
+                // Copied out for strtod, the chunk isn't null terminated
+                char number[64];
+                size_t length = 0;
+                while (mText != mEnd && length < sizeof(number) - 1 && std::strchr("+-.eE0123456789", *mText) != nullptr)
+                {
+                    number[length++] = *mText++;
+                }
+                number[length] = '\0';
+                char* end;
+                value.type = JsonValue::Type::Number;
+                value.number = std::strtod(number, &end);
+                if (end != number + length)  Fail("invalid number");
+            }
+            else if (Word("true"))   { value.type = JsonValue::Type::Bool;  value.boolean = true; }
+            else if (Word("false"))  { value.type = JsonValue::Type::Bool;  value.boolean = false; }
+            else if (Word("null"))   { value.type = JsonValue::Type::Null; }
+            else  Fail("unexpected character");
+        }
+
+        // Read a string starting at its opening quote, converting escapes (\u escapes to UTF-8)
+        void ParseString(std::string& string)
+        {
+            ++mText;
+            while (true)
+            {
+                if (mText == mEnd)  Fail("unterminated string");
+                char c = *mText++;
+                if (c == '"')  return;
+                if (c != '\\')
+                {
+                    string += c;
+                    continue;
+                }
+
+                if (mText == mEnd)  Fail("unterminated string");
+                c = *mText++;
+                switch (c)
+                {
+                case 'b':  string += '\b';  break;
+                case 'f':  string += '\f';  break;
+                case 'n':  string += '\n';  break;
+                case 'r':  string += '\r';  break;
+                case 't':  string += '\t';  break;
+                case 'u':
+                {
+                    uint32_t code = HexCode();
+                    if (code >= 0xD800 && code < 0xDC00 && mEnd - mText >= 6 && mText[0] == '\\' && mText[1] == 'u')
+                    {
+                        mText += 2;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (HexCode() - 0xDC00);
+                    }
+                    if (code < 0x80)   { string += static_cast<char>(code); }
+                    else if (code < 0x800)
+                    {
+                        string += static_cast<char>(0xC0 | (code >> 6));
+                        string += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    else if (code < 0x10000)
+                    {
+                        string += static_cast<char>(0xE0 | (code >> 12));
+                        string += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        string += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    else
+                    {
+                        string += static_cast<char>(0xF0 | (code >> 18));
+                        string += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                        string += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        string += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default:   string += c; // \" \\ and \/
+                }
+            }
+        }
+
+        uint32_t HexCode()
+        {
+            if (mEnd - mText < 4)  Fail("invalid escape");
+            uint32_t code = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                char c = *mText++;
+                code <<= 4;
+                if      (c >= '0' && c <= '9')  code |= c - '0';
+                else if (c >= 'a' && c <= 'f')  code |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')  code |= c - 'A' + 10;
+                else  Fail("invalid escape");
+            }
+            return code;
+        }
+
+        void SkipSpace()
+        {
+            while (mText != mEnd && (*mText == ' ' || *mText == '\t' || *mText == '\n' || *mText == '\r'))  ++mText;
+        }
+
+        // Skip the given character (after any space) if it is next
+        bool Next(char c)
+        {
+            SkipSpace();
+            if (mText == mEnd || *mText != c)  return false;
+            ++mText;
+            return true;
+        }
+
+        bool Word(const char* word)
+        {
+            size_t length = std::strlen(word);
+            if (static_cast<size_t>(mEnd - mText) < length || std::strncmp(mText, word, length) != 0)  return false;
+            mText += length;
+            return true;
+        }
+
+        [[noreturn]] void Fail(const char* reason)
+        {
+            throw std::runtime_error(std::string("Invalid JSON in ") + mFileName + " (" + reason + ")");
+        }
+
+        const char*        mText;
+        const char*        mEnd;
+        const std::string& mFileName;
+    };
+
+
+
+    //--------------------------------------------------------------------------------------
+    // EXT_meshopt_compression decoding
+    //--------------------------------------------------------------------------------------
+    // Decoders for the bitstreams written by meshoptimizer's encodeVertexBuffer, encodeIndexBuffer and
+    // encodeIndexSequence, as specified by the extension. Each returns false for data that is corrupt or truncated
+
+    const size_t BYTE_GROUP_SIZE         = 16;
+    const size_t BYTE_GROUP_DECODE_LIMIT = 24;
+    const size_t VERTEX_BLOCK_MAX_BYTES  = 8192;
+    const size_t VERTEX_BLOCK_MAX_SIZE   = 256;
+    const size_t VERTEX_TAIL_MAX_SIZE    = 32;
+
+    // Decode a group of 16 bytes packed with 0, 2, 4 or 8 bits each (bits = 1 << bitsLog2, 0 bits for bitsLog2 0). Packed
+    // values equal to the largest for their size are followed by the actual byte in the data after the group
+    const uint8_t* DecodeBytesGroup(const uint8_t* data, uint8_t* out, int bitsLog2)
+    {
+        if (bitsLog2 == 0)
+        {
+            std::memset(out, 0, BYTE_GROUP_SIZE);
+            return data;
+        }
+        if (bitsLog2 == 3)
+        {
+            std::memcpy(out, data, BYTE_GROUP_SIZE);
+            return data + BYTE_GROUP_SIZE;
+        }
+
+        int bits = bitsLog2 == 1 ? 2 : 4;
+        int perByte = 8 / bits;
+        unsigned int escape = (1u << bits) - 1;
+        const uint8_t* extra = data + BYTE_GROUP_SIZE / perByte;
+        for (size_t i = 0; i < BYTE_GROUP_SIZE; i += perByte)
+        {
+            unsigned int packed = *data++;
+            for (int j = 0; j < perByte; ++j)
+            {
+                unsigned int value = (packed >> (8 - bits)) & escape;
+                packed <<= bits;
+                out[i + j] = value == escape ? *extra++ : static_cast<uint8_t>(value);
+            }
+        }
+        return extra;
+    }
+
+    const uint8_t* DecodeBytes(const uint8_t* data, const uint8_t* end, uint8_t* out, size_t size)
+    {
+        size_t headerSize = (size / BYTE_GROUP_SIZE + 3) / 4;
+        if (static_cast<size_t>(end - data) < headerSize)  return nullptr;
+        const uint8_t* header = data;
+        data += headerSize;
+
+        for (size_t i = 0; i < size; i += BYTE_GROUP_SIZE)
+        {
+            if (static_cast<size_t>(end - data) < BYTE_GROUP_DECODE_LIMIT)  return nullptr;
+            size_t group = i / BYTE_GROUP_SIZE;
+            int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+            data = DecodeBytesGroup(data, out + i, bitsLog2);
+        }
+        return data;
+    }
+
+    // Vertex buffer codec: vertices in blocks, each byte of the vertex stored as zigzag deltas from the same byte of the
+    // previous vertex, starting from a copy of the first vertex at the end of the data
+    bool DecodeVertexBuffer(uint8_t* out, size_t count, size_t vertexSize, const uint8_t* data, size_t size)
+    {
+        if (vertexSize == 0 || vertexSize > 256 || vertexSize % 4 != 0)  return false;
+        if (size < 1 + vertexSize || (data[0] & 0xF0) != 0xA0 || (data[0] & 0x0F) > 0)  return false;
+        const uint8_t* end = data + size;
+        ++data;
+
+        uint8_t last[256];
+        std::memcpy(last, end - vertexSize, vertexSize);
+
+        size_t blockSize = std::min((VERTEX_BLOCK_MAX_BYTES / vertexSize) & ~(BYTE_GROUP_SIZE - 1), VERTEX_BLOCK_MAX_SIZE);
+        uint8_t deltas[VERTEX_BLOCK_MAX_SIZE];
+        for (size_t first = 0; first < count; first += blockSize)
+        {
+            size_t blockCount = std::min(blockSize, count - first);
+            size_t alignedCount = (blockCount + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+            uint8_t* block = out + first * vertexSize;
+            for (size_t byte = 0; byte < vertexSize; ++byte)
+            {
+                data = DecodeBytes(data, end, deltas, alignedCount);
+                if (data == nullptr)  return false;
+
+                uint8_t previous = last[byte];
+                for (size_t i = 0; i < blockCount; ++i)
+                {
+                    uint8_t delta = deltas[i];
+                    previous = static_cast<uint8_t>(previous + ((delta >> 1) ^ (0u - (delta & 1))));
+                    block[i * vertexSize + byte] = previous;
+                }
+                last[byte] = previous;
+            }
+        }
+
+        size_t tailSize = std::max(vertexSize, VERTEX_TAIL_MAX_SIZE);
+        return static_cast<size_t>(end - data) == tailSize;
+    }
+
+
+    uint32_t DecodeVByte(const uint8_t*& data)
+    {
+        uint32_t lead = *data++;
+        if (lead < 128)  return lead;
+
+        uint32_t result = lead & 127;
+        for (int shift = 7; shift <= 28; shift += 7)
+        {
+            uint32_t group = *data++;
+            result |= (group & 127) << shift;
+            if (group < 128)  break;
+        }
+        return result;
+    }
+
+    uint32_t DecodeIndexDelta(const uint8_t*& data, uint32_t last)
+    {
+        uint32_t v = DecodeVByte(data);
+        return last + ((v >> 1) ^ (0u - (v & 1)));
+    }
+
+    void WriteIndex(uint8_t* out, size_t i, size_t indexSize, uint32_t index)
+    {
+        if (indexSize == 2)  { uint16_t value = static_cast<uint16_t>(index);  std::memcpy(out + i * 2, &value, 2); }
+        else                 { std::memcpy(out + i * 4, &index, 4); }
+    }
+
+    // Index buffer codec: each triangle is a code byte describing it in terms of recent edges and vertices kept in two
+    // small FIFOs, plus the occasional explicit index
+    bool DecodeIndexBuffer(uint8_t* out, size_t count, size_t indexSize, const uint8_t* data, size_t size)
+    {
+        if (count % 3 != 0 || size < 1 + count / 3 + 16 || (data[0] & 0xF0) != 0xE0)  return false;
+        int version = data[0] & 0x0F;
+        if (version > 1)  return false;
+
+        uint32_t edges[16][2];
+        uint32_t vertices[16];
+        std::memset(edges, 0xFF, sizeof(edges));
+        std::memset(vertices, 0xFF, sizeof(vertices));
+        size_t edgeOffset = 0, vertexOffset = 0;
+        uint32_t next = 0, last = 0;
+        int maxFec = version >= 1 ? 13 : 15;
+
+        auto pushEdge = [&](uint32_t a, uint32_t b)
+        {
+            edges[edgeOffset][0] = a;
+            edges[edgeOffset][1] = b;
+            edgeOffset = (edgeOffset + 1) & 15;
+        };
+        auto pushVertex = [&](uint32_t v, bool push)
+        {
+            vertices[vertexOffset] = v;
+            vertexOffset = (vertexOffset + (push ? 1 : 0)) & 15;
+        };
+        auto triangle = [&](size_t i, uint32_t a, uint32_t b, uint32_t c)
+        {
+            WriteIndex(out, i, indexSize, a);
+            WriteIndex(out, i + 1, indexSize, b);
+            WriteIndex(out, i + 2, indexSize, c);
+        };
+
+        const uint8_t* code    = data + 1;
+        const uint8_t* extra   = code + count / 3;
+        const uint8_t* safeEnd = data + size - 16;
+        const uint8_t* auxTable = safeEnd; // The last 16 bytes
+        for (size_t i = 0; i < count; i += 3)
+        {
+            if (extra > safeEnd)  return false;
+            uint8_t codeTri = *code++;
+
+            if (codeTri < 0xF0)
+            {
+                // An edge from the FIFO and a new, recent or explicit third vertex
+                int fe = codeTri >> 4;
+                uint32_t a = edges[(edgeOffset - 1 - fe) & 15][0];
+                uint32_t b = edges[(edgeOffset - 1 - fe) & 15][1];
+                int fec = codeTri & 15;
+                uint32_t c;
+                bool pushC = true;
+                if (fec < maxFec)
+                {
+                    c = (fec == 0) ? next : vertices[(vertexOffset - 1 - fec) & 15];
+                    pushC = (fec == 0);
+                    if (fec == 0)  ++next;
+                }
+                else
+                {
+                    // 13 and 14 are one below and above the last explicit index
+                    c = last = (fec != 15) ? last + (fec - (fec ^ 3)) : DecodeIndexDelta(extra, last);
+                }
+                triangle(i, a, b, c);
+                pushVertex(c, pushC);
+                pushEdge(c, b);
+                pushEdge(a, c);
+            }
+            else if (codeTri < 0xFE)
+            {
+                // A new vertex and two more, each new or recent, described by the table
+                uint8_t codeAux = auxTable[codeTri & 15];
+                int feb = codeAux >> 4;
+                int fec = codeAux & 15;
+                uint32_t a = next++;
+                uint32_t b = (feb == 0) ? next : vertices[(vertexOffset - feb) & 15];
+                if (feb == 0)  ++next;
+                uint32_t c = (fec == 0) ? next : vertices[(vertexOffset - fec) & 15];
+                if (fec == 0)  ++next;
+                triangle(i, a, b, c);
+                pushVertex(a, true);
+                pushVertex(b, feb == 0);
+                pushVertex(c, fec == 0);
+                pushEdge(b, a);
+                pushEdge(c, b);
+                pushEdge(a, c);
+            }
+            else
+            {
+                // Each vertex new, recent or explicit, described by the next extra byte
+                uint8_t codeAux = *extra++;
+                int fea = codeTri == 0xFE ? 0 : 15;
+                int feb = codeAux >> 4;
+                int fec = codeAux & 15;
+                uint32_t a = (fea == 0) ? next++ : 0;
+                uint32_t b = (feb == 0) ? next++ : vertices[(vertexOffset - feb) & 15];
+                uint32_t c = (fec == 0) ? next++ : vertices[(vertexOffset - fec) & 15];
+                if (fea == 15)  last = a = DecodeIndexDelta(extra, last);
+                if (feb == 15)  last = b = DecodeIndexDelta(extra, last);
+                if (fec == 15)  last = c = DecodeIndexDelta(extra, last);
+                triangle(i, a, b, c);
+                pushVertex(a, true);
+                pushVertex(b, feb == 0 || feb == 15);
+                pushVertex(c, fec == 0 || fec == 15);
+                pushEdge(b, a);
+                pushEdge(c, b);
+                pushEdge(a, c);
+            }
+        }
+        return extra == safeEnd;
+    }
+
+    // Index sequence codec: each index is a zigzag delta from one of two previous indices
+    bool DecodeIndexSequence(uint8_t* out, size_t count, size_t indexSize, const uint8_t* data, size_t size)
+    {
+        if (size < 1 + count + 4 || (data[0] & 0xF0) != 0xD0 || (data[0] & 0x0F) > 1)  return false;
+
+        const uint8_t* safeEnd = data + size - 4;
+        ++data;
+        uint32_t last[2] = { 0, 0 };
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (data >= safeEnd)  return false;
+            uint32_t v = DecodeVByte(data);
+            uint32_t baseline = v & 1;
+            v >>= 1;
+            last[baseline] += (v >> 1) ^ (0u - (v & 1));
+            WriteIndex(out, i, indexSize, last[baseline]);
+        }
+        return data == safeEnd;
+    }
+
+
+    // Octahedral filter: unit vectors stored as two octahedral coordinates and a scale, written back as a normalised
+    // 8 or 16 bit vector. The fourth component is left alone
+    template <class T>
+    void DecodeOctahedralFilter(uint8_t* data, size_t count)
+    {
+        const float maxValue = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            T v[4];
+            std::memcpy(v, data + i * sizeof(v), sizeof(v));
+            float x = v[0], y = v[1];
+            float z = v[2] - std::fabs(x) - std::fabs(y);
+            float t = std::min(z, 0.0f);
+            x += x >= 0 ? t : -t;
+            y += y >= 0 ? t : -t;
+            float scale = maxValue / std::sqrt(x * x + y * y + z * z);
+            v[0] = static_cast<T>(std::lround(x * scale));
+            v[1] = static_cast<T>(std::lround(y * scale));
+            v[2] = static_cast<T>(std::lround(z * scale));
+            std::memcpy(data + i * sizeof(v), v, sizeof(v));
+        }
+    }
+
+    // Exponential filter: each 32-bit value holds an 8-bit exponent and a 24-bit mantissa, decoded to a float
+    void DecodeExponentialFilter(uint8_t* data, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            int32_t v;
+            std::memcpy(&v, data + i * 4, 4);
+            int32_t mantissa = static_cast<int32_t>(static_cast<uint32_t>(v) << 8) >> 8;
+            int32_t exponent = v >> 24;
+            float value = std::ldexp(static_cast<float>(mantissa), exponent);
+            std::memcpy(data + i * 4, &value, 4);
+        }
+    }
+
+
+
+    //--------------------------------------------------------------------------------------
+    // GLB file
+    //--------------------------------------------------------------------------------------
+
+    const uint32_t GLB_MAGIC      = 0x46546C67; // "glTF"
+    const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    const uint32_t GLB_CHUNK_BIN  = 0x004E4942;
+
+    // Accessor component types (the OpenGL constants)
+    const uint32_t COMPONENT_BYTE           = 5120;
+    const uint32_t COMPONENT_UNSIGNED_BYTE  = 5121;
+    const uint32_t COMPONENT_SHORT          = 5122;
+    const uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+    const uint32_t COMPONENT_UNSIGNED_INT   = 5125;
+    const uint32_t COMPONENT_FLOAT          = 5126;
+
+    // Primitive modes
+    const int MODE_TRIANGLES      = 4;
+    const int MODE_TRIANGLE_STRIP = 5;
+    const int MODE_TRIANGLE_FAN   = 6;
+
+    uint32_t ComponentSize(uint32_t componentType)
+    {
+        switch (componentType)
+        {
+        case COMPONENT_BYTE:  case COMPONENT_UNSIGNED_BYTE:   return 1;
+        case COMPONENT_SHORT: case COMPONENT_UNSIGNED_SHORT:  return 2;
+        case COMPONENT_UNSIGNED_INT: case COMPONENT_FLOAT:    return 4;
+        default:                                              return 0;
+        }
+    }
+
+    uint32_t ReadUint32(const uint8_t* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, 4);
+        return value;
+    }
+
+
+    // An accessor's elements where they lie in the file (or in decoded memory for compressed buffer views)
+    struct AccessorView
+    {
+        const uint8_t* data;          // First element
+        size_t         available;     // Bytes from the first element to the end of its buffer view
+        uint32_t       stride;        // Bytes from one element to the next
+        uint32_t       count;
+        uint32_t       componentType;
+        uint32_t       components;    // 1 to 4
+        bool           normalized;
+    };
+
+
+    // The JSON and binary data of a .glb file, resolving accessors to views into the data
+    class GlbFile
+    {
+    public:
+        // The folder is where external buffers are looked for, empty if they are not allowed
+        GlbFile(const uint8_t* data, size_t size, const std::string& name, const std::string& folder)
+            : mName(name), mFolder(folder)
+        {
+            if (size < 20 || ReadUint32(data) != GLB_MAGIC)  Fail("not a binary glTF file");
+            if (ReadUint32(data + 4) != 2)  Fail("only glTF 2.0 is supported");
+            size = std::min<size_t>(size, ReadUint32(data + 8));
+
+            uint32_t jsonLength = ReadUint32(data + 12);
+            if (ReadUint32(data + 16) != GLB_CHUNK_JSON || jsonLength > size - 20)  Fail("missing JSON chunk");
+            mJson = JsonParser(reinterpret_cast<const char*>(data + 20), jsonLength, mName).Parse();
+
+            size_t binChunk = 20 + ((jsonLength + 3) & ~3u);
+            if (binChunk + 8 <= size && ReadUint32(data + binChunk + 4) == GLB_CHUNK_BIN)
+            {
+                mBin       = data + binChunk + 8;
+                mBinLength = std::min<size_t>(ReadUint32(data + binChunk), size - binChunk - 8);
+            }
+
+            // Only geometry matters here, so only extensions that change it can make the file unreadable
+            const JsonValue& required = mJson["extensionsRequired"];
+            for (size_t i = 0; i < required.Size(); ++i)
+            {
+                const std::string& extension = required[i].String();
+                if (extension == "KHR_draco_mesh_compression" || extension == "EXT_mesh_gpu_instancing")
+                {
+                    Fail(("needs the unsupported extension " + extension).c_str());
+                }
+            }
+
+            mViews.resize(mJson["bufferViews"].Size());
+            mBuffers.resize(mJson["buffers"].Size());
+        }
+
+        const JsonValue& Json() const  { return mJson; }
+
+        // View of the given accessor. What it is used for is only for error messages
+        AccessorView Accessor(const JsonValue& index, const char* usedFor)
+        {
+            const JsonValue& accessor = mJson["accessors"][index.Index()];
+            if (accessor.IsNull())  Fail((std::string("missing ") + usedFor + " accessor").c_str());
+            if (!accessor["sparse"].IsNull())  Fail("sparse accessors are not supported");
+
+            AccessorView view;
+            size_t count = accessor["count"].Index();
+            if (count > UINT32_MAX)  Fail((std::string("invalid ") + usedFor + " accessor count").c_str());
+            view.count         = static_cast<uint32_t>(count);
+            view.componentType = static_cast<uint32_t>(std::min<size_t>(accessor["componentType"].Index(), UINT32_MAX));
+            view.normalized    = accessor["normalized"].boolean;
+            const std::string& type = accessor["type"].String();
+            view.components = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+            uint32_t componentSize = ComponentSize(view.componentType);
+            if (view.components == 0 || componentSize == 0)  Fail((std::string("unsupported ") + usedFor + " accessor type").c_str());
+            uint32_t elementSize = componentSize * view.components;
+
+            // Accessors without a buffer view are all zeros
+            if (accessor["bufferView"].IsNull())
+            {
+                static const uint8_t zeros[16] = {};
+                view.data      = zeros;
+                view.available = sizeof(zeros);
+                view.stride    = 0;
+                return view;
+            }
+
+            const ViewData& bufferView = BufferView(accessor["bufferView"].Index());
+            size_t offset = accessor["byteOffset"].Index(0);
+            view.stride = bufferView.stride != 0 ? bufferView.stride : elementSize;
+            if (view.count > 0 && (offset > bufferView.length || bufferView.length - offset < elementSize ||
+                                   (bufferView.length - offset - elementSize) / view.stride < view.count - 1))
+            {
+                Fail((std::string(usedFor) + " accessor is outside its buffer view").c_str());
+            }
+            view.data      = bufferView.data + offset;
+            view.available = bufferView.length - offset;
+            return view;
+        }
+
+        [[noreturn]] void Fail(const char* reason) const
+        {
+            throw std::runtime_error("Error loading mesh (" + mName + "). " + reason);
+        }
+
+    private:
+        struct ViewData
+        {
+            const uint8_t* data     = nullptr;
+            size_t         length   = 0;
+            uint32_t       stride   = 0;
+            bool           resolved = false;
+        };
+
+        const ViewData& BufferView(size_t index)
+        {
+            if (index >= mViews.size())  Fail("missing buffer view");
+            ViewData& view = mViews[index];
+            if (view.resolved)  return view;
+
+            const JsonValue& json = mJson["bufferViews"][index];
+            const JsonValue& compressed = json["extensions"]["EXT_meshopt_compression"];
+            if (!compressed.IsNull())
+            {
+                Decompress(view, compressed);
+            }
+            else
+            {
+                view.data   = BufferRange(json);
+                view.length = json["byteLength"].Index(0);
+                size_t stride = json["byteStride"].Index(0);
+                if (stride > 252)  Fail("invalid buffer view stride");
+                view.stride = static_cast<uint32_t>(stride);
+            }
+            view.resolved = true;
+            return view;
+        }
+
+        // Start of the range of a buffer given by an object with buffer, byteOffset and byteLength members, checked to be
+        // inside the buffer
+        const uint8_t* BufferRange(const JsonValue& range)
+        {
+            size_t index = range["buffer"].Index();
+            if (index >= mBuffers.size())  Fail("missing buffer");
+            const uint8_t* data = nullptr;
+            size_t length = 0;
+            const std::string& uri = mJson["buffers"][index]["uri"].String();
+            if (uri.empty())
+            {
+                // Only the first buffer can be the binary chunk, compression fallback buffers have no data at all
+                if (index != 0 || mBin == nullptr)  Fail("buffer has no data");
+                data   = mBin;
+                length = mBinLength;
+            }
+            else
+            {
+                if (mFolder.empty() && mBuffers[index] == nullptr)  Fail("external buffers are not available");
+                if (uri.compare(0, 5, "data:") == 0)  Fail("embedded base64 buffers are not supported");
+                if (mBuffers[index] == nullptr)
+                {
+                    mBuffers[index] = std::make_unique<MappedFile>();
+                    if (!mBuffers[index]->Open(mFolder + uri))  Fail(("cannot open buffer " + uri).c_str());
+                }
+                data   = mBuffers[index]->Data();
+                length = mBuffers[index]->Size();
+            }
+
+            size_t offset     = range["byteOffset"].Index(0);
+            size_t byteLength = range["byteLength"].Index(0);
+            if (offset > length || byteLength > length - offset)  Fail("buffer view is outside its buffer");
+            return data + offset;
+        }
+
+        // Decode an EXT_meshopt_compression buffer view into memory of its own
+        void Decompress(ViewData& view, const JsonValue& compressed)
+        {
+            const uint8_t* source = BufferRange(compressed);
+            size_t sourceLength = compressed["byteLength"].Index(0);
+            size_t stride       = compressed["byteStride"].Index(0);
+            size_t count        = compressed["count"].Index(0);
+            const std::string& mode   = compressed["mode"].String();
+            const std::string& filter = compressed["filter"].String();
+            if (stride == 0 || stride > 256 || count > (1u << 30) / stride)  Fail("invalid compressed buffer view");
+
+            mDecoded.emplace_back(new uint8_t[count * stride]);
+            uint8_t* decoded = mDecoded.back().get();
+            bool ok;
+            if (mode == "ATTRIBUTES")
+            {
+                ok = DecodeVertexBuffer(decoded, count, stride, source, sourceLength);
+            }
+            else if (mode == "TRIANGLES" || mode == "INDICES")
+            {
+                if (stride != 2 && stride != 4)  Fail("invalid compressed index stride");
+                ok = mode == "TRIANGLES" ? DecodeIndexBuffer(decoded, count, stride, source, sourceLength)
+                                         : DecodeIndexSequence(decoded, count, stride, source, sourceLength);
+            }
+            else
+            {
+                Fail(("unknown compression mode " + mode).c_str());
+            }
+            if (!ok)  Fail("corrupt compressed buffer view");
+
+            if (filter == "OCTAHEDRAL")
+            {
+                if      (stride == 4)  DecodeOctahedralFilter<int8_t>(decoded, count);
+                else if (stride == 8)  DecodeOctahedralFilter<int16_t>(decoded, count);
+                else  Fail("invalid octahedral filter stride");
+            }
+            else if (filter == "EXPONENTIAL")
+            {
+                DecodeExponentialFilter(decoded, count * stride / 4);
+            }
+            else if (!filter.empty() && filter != "NONE")
+            {
+                Fail(("unsupported compression filter " + filter).c_str()); // QUATERNION is only used for animation
+            }
+
+            view.data   = decoded;
+            view.length = count * stride;
+            view.stride = mode == "ATTRIBUTES" ? static_cast<uint32_t>(stride) : 0;
+        }
+
+        std::string mName;
+        std::string mFolder;
+        JsonValue   mJson;
+
+        const uint8_t* mBin       = nullptr;
+        size_t         mBinLength = 0;
+
+        std::vector<std::unique_ptr<MappedFile>> mBuffers; // External buffers, mapped when first used
+        std::vector<ViewData>                    mViews;   // Resolved when first used
+        std::vector<std::unique_ptr<uint8_t[]>>  mDecoded; // Decompressed buffer views
+    };
+
+
+
+    //--------------------------------------------------------------------------------------
+    // Attribute conversion
+    //--------------------------------------------------------------------------------------
+
+    // Load one element as four floats. Reads a whole four components, so the caller masks off those past the element
+    // and makes sure the read stays inside the data (see ForEachElement)
+    template <uint32_t ComponentType, bool Normalized>
+    __m128 LoadElement(const uint8_t* element)
+    {
+        if constexpr (ComponentType == COMPONENT_FLOAT)
+        {
+            return _mm_loadu_ps(reinterpret_cast<const float*>(element));
+        }
+        else
+        {
+            __m128i v;
+            float scale;
+            if constexpr (ComponentType == COMPONENT_BYTE || ComponentType == COMPONENT_UNSIGNED_BYTE)
+            {
+                int32_t bytes;
+                std::memcpy(&bytes, element, 4);
+                v = _mm_cvtsi32_si128(bytes);
+                if constexpr (ComponentType == COMPONENT_BYTE)
+                {
+                    v = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_unpacklo_epi8(v, v), _mm_unpacklo_epi8(v, v)), 24);
+                    scale = 1.0f / 127;
+                }
+                else
+                {
+                    v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, _mm_setzero_si128()), _mm_setzero_si128());
+                    scale = 1.0f / 255;
+                }
+            }
+            else
+            {
+                v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(element));
+                if constexpr (ComponentType == COMPONENT_SHORT)
+                {
+                    v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+                    scale = 1.0f / 32767;
+                }
+                else
+                {
+                    v = _mm_unpacklo_epi16(v, _mm_setzero_si128());
+                    scale = 1.0f / 65535;
+                }
+            }
+
+            __m128 result = _mm_cvtepi32_ps(v);
+            if constexpr (Normalized)
+            {
+                result = _mm_max_ps(_mm_mul_ps(result, _mm_set1_ps(scale)), _mm_set1_ps(-1.0f)); // Signed minimum is -1 too
+            }
+            return result;
+        }
+    }
+
+    typedef __m128 (*ElementLoader)(const uint8_t* element);
+
+    ElementLoader GetElementLoader(uint32_t componentType, bool normalized)
+    {
+        switch (componentType)
+        {
+        case COMPONENT_FLOAT:           return LoadElement<COMPONENT_FLOAT, false>;
+        case COMPONENT_BYTE:            return normalized ? LoadElement<COMPONENT_BYTE, true>           : LoadElement<COMPONENT_BYTE, false>;
+        case COMPONENT_UNSIGNED_BYTE:   return normalized ? LoadElement<COMPONENT_UNSIGNED_BYTE, true>  : LoadElement<COMPONENT_UNSIGNED_BYTE, false>;
+        case COMPONENT_SHORT:           return normalized ? LoadElement<COMPONENT_SHORT, true>          : LoadElement<COMPONENT_SHORT, false>;
+        case COMPONENT_UNSIGNED_SHORT:  return normalized ? LoadElement<COMPONENT_UNSIGNED_SHORT, true> : LoadElement<COMPONENT_UNSIGNED_SHORT, false>;
+        default:                        return nullptr;
+        }
+    }
+
+
+    // Call function(i, element) for each element of a vertex attribute as four floats, components past the first
+    // numComponents set to 0
+    template <class Function>
+    void ForEachElement(GlbFile& file, const AccessorView& view, uint32_t numComponents, const char* usedFor, Function function)
+    {
+        ElementLoader load = GetElementLoader(view.componentType, view.normalized);
+        if (load == nullptr)  file.Fail((std::string("unsupported ") + usedFor + " component type").c_str());
+
+        static const int32_t LANE_MASKS[5][4] = { { 0, 0, 0, 0 }, { -1, 0, 0, 0 }, { -1, -1, 0, 0 }, { -1, -1, -1, 0 }, { -1, -1, -1, -1 } };
+        __m128 mask = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(LANE_MASKS[std::min(numComponents, view.components)])));
+
+        // Elements are loaded four components at a time straight from the view, except those too near its end, which
+        // are copied out first
+        uint32_t componentSize = ComponentSize(view.componentType);
+        size_t wideLoad    = componentSize * 4;
+        size_t elementSize = componentSize * view.components;
+        const uint8_t* element = view.data;
+        for (uint32_t i = 0; i < view.count; ++i, element += view.stride)
+        {
+            size_t offset = static_cast<size_t>(i) * view.stride;
+            __m128 value;
+            if (view.available - offset >= wideLoad)
+            {
+                value = load(element);
+            }
+            else
+            {
+                uint8_t copy[16] = {};
+                std::memcpy(copy, element, elementSize);
+                value = load(copy);
+            }
+            function(i, _mm_and_ps(value, mask));
+        }
+    }
+
+    // Write the x, y and z of a vector to unaligned memory
+    void StoreVector3(uint8_t* out, __m128 v)
+    {
+        alignas(16) float values[4];
+        _mm_store_ps(values, v);
+        std::memcpy(out, values, 12);
+    }
+
+    // x * column0 + y * column1 + z * column2 + column3
+    __m128 Transform(__m128 v, const __m128 columns[4])
+    {
+        __m128 x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, columns[0]), _mm_mul_ps(y, columns[1])),
+                          _mm_add_ps(_mm_mul_ps(z, columns[2]), columns[3]));
+    }
+
+    // Unit length version of a vector with 0 in its fourth component, or the vector itself if it has no length
+    __m128 UnitVector(__m128 v)
+    {
+        __m128 squares = _mm_mul_ps(v, v);
+        __m128 sum = _mm_add_ps(squares, _mm_movehl_ps(squares, squares));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+        float lengthSquared = _mm_cvtss_f32(sum);
+        if (lengthSquared <= 0)  return v;
+        return _mm_div_ps(v, _mm_set1_ps(std::sqrt(lengthSquared)));
+    }
+
+
+
+    //--------------------------------------------------------------------------------------
+    // Scene
+    //--------------------------------------------------------------------------------------
+
+    // Affine transform, p' = m * (p, 1). Columns 0 to 2 are the X, Y and Z axes and column 3 is the translation
+    struct Affine
+    {
+        float m[3][4];
+
+        CVector3 Column(int c) const  { return { m[0][c], m[1][c], m[2][c] }; }
+    };
+
+    const Affine IDENTITY = { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } };
+
+    Affine Multiply(const Affine& a, const Affine& b)
+    {
+        Affine result;
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + (c == 3 ? a.m[r][3] : 0);
+            }
+        }
+        return result;
+    }
+
+    // A node's transform relative to its parent, from its matrix or its translation, rotation and scale
+    Affine NodeTransform(const JsonValue& node)
+    {
+        Affine transform;
+        const JsonValue& matrix = node["matrix"];
+        if (matrix.Size() == 16)
+        {
+            for (int r = 0; r < 3; ++r)
+            {
+                for (int c = 0; c < 4; ++c)  transform.m[r][c] = static_cast<float>(matrix[c * 4 + r].Number()); // Column major
+            }
+            return transform;
+        }
+
+        float translation[3], scale[3], q[4];
+        for (size_t i = 0; i < 4; ++i)
+        {
+            if (i < 3)  translation[i] = static_cast<float>(node["translation"][i].Number());
+            if (i < 3)  scale[i]       = static_cast<float>(node["scale"][i].Number(1));
+            q[i] = static_cast<float>(node["rotation"][i].Number(i == 3 ? 1 : 0));
+        }
+        float x = q[0], y = q[1], z = q[2], w = q[3];
+        float rotation[3][3] =
+        {
+            { 1 - 2 * (y * y + z * z), 2 * (x * y - z * w),     2 * (x * z + y * w)     },
+            { 2 * (x * y + z * w),     1 - 2 * (x * x + z * z), 2 * (y * z - x * w)     },
+            { 2 * (x * z - y * w),     2 * (y * z + x * w),     1 - 2 * (x * x + y * y) },
+        };
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int c = 0; c < 3; ++c)  transform.m[row][c] = rotation[row][c] * scale[c];
+            transform.m[row][3] = translation[row];
+        }
+        return transform;
+    }
+
+    // A primitive to import and the transform of the node it is in
+    struct ScenePrimitive
+    {
+        const JsonValue* primitive;
+        Affine           transform;
+    };
+
+    void CollectNode(GlbFile& file, size_t nodeIndex, const Affine& parent, int depth, std::vector<ScenePrimitive>& primitives)
+    {
+        const JsonValue& node = file.Json()["nodes"][nodeIndex];
+        if (node.IsNull())  file.Fail("missing node");
+        if (depth > 64)  file.Fail("node hierarchy is too deep or has a loop");
+
+        Affine transform = Multiply(parent, NodeTransform(node));
+        if (!node["mesh"].IsNull())
+        {
+            const JsonValue& mesh = file.Json()["meshes"][node["mesh"].Index()];
+            if (mesh.IsNull())  file.Fail("missing mesh");
+            for (size_t i = 0; i < mesh["primitives"].Size(); ++i)  primitives.push_back({ &mesh["primitives"][i], transform });
+        }
+
+        const JsonValue& children = node["children"];
+        for (size_t i = 0; i < children.Size(); ++i)
+        {
+            CollectNode(file, children[i].Index(), transform, depth + 1, primitives);
+        }
+    }
+
+
+    // Number of triangles a primitive draws, 0 for points and lines
+    uint32_t CountTriangles(int mode, uint32_t numIndices)
+    {
+        if (mode == MODE_TRIANGLES)  return numIndices / 3;
+        if (mode == MODE_TRIANGLE_STRIP || mode == MODE_TRIANGLE_FAN)  return numIndices >= 3 ? numIndices - 2 : 0;
+        return 0;
+    }
+
+    // Write a primitive's triangles as a list, offset by the primitive's first vertex and optionally with the winding
+    // reversed. fetch(i) gives the primitive's i-th index
+    template <class Fetch>
+    void WriteTriangles(GlbFile& file, Fetch fetch, uint32_t numIndices, int mode, uint32_t firstVertex, uint32_t numVertices,
+                        bool reverse, uint32_t* out)
+    {
+        auto triangle = [&](uint32_t a, uint32_t b, uint32_t c)
+        {
+            if (a >= numVertices || b >= numVertices || c >= numVertices)  file.Fail("index out of range");
+            out[0] = firstVertex + a;
+            out[1] = firstVertex + (reverse ? c : b);
+            out[2] = firstVertex + (reverse ? b : c);
+            out += 3;
+        };
+
+        if (mode == MODE_TRIANGLES)
+        {
+            for (uint32_t i = 0; i + 2 < numIndices; i += 3)  triangle(fetch(i), fetch(i + 1), fetch(i + 2));
+        }
+        else if (mode == MODE_TRIANGLE_STRIP)
+        {
+            for (uint32_t i = 0; i + 2 < numIndices; ++i)
+            {
+                if (i & 1)  triangle(fetch(i), fetch(i + 2), fetch(i + 1));
+                else        triangle(fetch(i), fetch(i + 1), fetch(i + 2));
+            }
+        }
+        else
+        {
+            for (uint32_t i = 1; i + 1 < numIndices; ++i)  triangle(fetch(i), fetch(i + 1), fetch(0));
+        }
+    }
+
+    template <class T>
+    T ReadIndex(const AccessorView& view, uint32_t i)
+    {
+        T index;
+        std::memcpy(&index, view.data + static_cast<size_t>(i) * view.stride, sizeof(T));
+        return index;
+    }
+
+
+    // Area weighted normals for vertices of a primitive that had none. Front faces are clockwise, see MeshPrimitives.h
+    void GenerateNormals(uint8_t* vertices, const MeshVertexLayout& layout, uint32_t firstVertex, uint32_t numVertices,
+                         const uint32_t* indices, uint32_t numIndices)
+    {
+        auto position = [&](uint32_t v) { CVector3 p;  std::memcpy(&p, vertices + v * layout.vertexSize + layout.positionOffset, 12);  return p; };
+        std::vector<CVector3> normals(numVertices, CVector3(0, 0, 0));
+        for (uint32_t i = 0; i < numIndices; i += 3)
+        {
+            CVector3 a = position(indices[i]);
+            CVector3 faceNormal = Cross(position(indices[i + 1]) - a, position(indices[i + 2]) - a);
+            for (int c = 0; c < 3; ++c)  normals[indices[i + c] - firstVertex] += faceNormal;
+        }
+        for (uint32_t v = 0; v < numVertices; ++v)
+        {
+            CVector3 normal = Length(normals[v]) > 0 ? Normalise(normals[v]) : CVector3(0, 1, 0);
+            std::memcpy(vertices + (firstVertex + v) * layout.vertexSize + layout.normalOffset, &normal, 12);
+        }
+    }
+
+    // Tangents along the direction of increasing U, made perpendicular to the normals
+    void GenerateTangents(uint8_t* vertices, const MeshVertexLayout& layout, uint32_t firstVertex, uint32_t numVertices,
+                          const uint32_t* indices, uint32_t numIndices)
+    {
+        auto read = [&](uint32_t v, unsigned int offset) { CVector3 p;  std::memcpy(&p, vertices + v * layout.vertexSize + offset, 12);  return p; };
+        auto uv   = [&](uint32_t v) { CVector2 t;  std::memcpy(&t, vertices + v * layout.vertexSize + layout.uvOffset, 8);  return t; };
+        std::vector<CVector3> tangents(numVertices, CVector3(0, 0, 0));
+        for (uint32_t i = 0; i < numIndices; i += 3)
+        {
+            uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            CVector3 edge1 = read(b, layout.positionOffset) - read(a, layout.positionOffset);
+            CVector3 edge2 = read(c, layout.positionOffset) - read(a, layout.positionOffset);
+            CVector2 uv1 = uv(b) - uv(a);
+            CVector2 uv2 = uv(c) - uv(a);
+            float determinant = uv1.x * uv2.y - uv2.x * uv1.y;
+            if (determinant == 0)  continue;
+            CVector3 tangent = (edge1 * uv2.y - edge2 * uv1.y) * (1 / determinant);
+            for (uint32_t v : { a, b, c })  tangents[v - firstVertex] += tangent;
+        }
+        for (uint32_t v = 0; v < numVertices; ++v)
+        {
+            CVector3 normal  = read(firstVertex + v, layout.normalOffset);
+            CVector3 tangent = tangents[v] - Dot(tangents[v], normal) * normal;
+            if (Length(tangent) <= 0)  tangent = Cross(normal, std::fabs(normal.x) < 0.9f ? CVector3(1, 0, 0) : CVector3(0, 1, 0));
+            tangent = Normalise(tangent);
+            std::memcpy(vertices + (firstVertex + v) * layout.vertexSize + layout.tangentOffset, &tangent, 12);
+        }
+    }
+
+
+    void ImportGlb(GlbFile& file, bool requireTangents, MeshData& meshData)
+    {
+        const JsonValue& json = file.Json();
+
+        // Primitives of the default scene (or every mesh if there are no scenes)
+        std::vector<ScenePrimitive> primitives;
+        const JsonValue& scenes = json["scenes"];
+        if (scenes.Size() > 0)
+        {
+            const JsonValue& scene = scenes[json["scene"].Index(0)];
+            for (size_t i = 0; i < scene["nodes"].Size(); ++i)
+            {
+                CollectNode(file, scene["nodes"][i].Index(), IDENTITY, 0, primitives);
+            }
+        }
+        else
+        {
+            const JsonValue& meshes = json["meshes"];
+            for (size_t m = 0; m < meshes.Size(); ++m)
+            {
+                for (size_t i = 0; i < meshes[m]["primitives"].Size(); ++i)  primitives.push_back({ &meshes[m]["primitives"][i], IDENTITY });
+            }
+        }
+
+        // Size everything first so the staging block can be sized up front, skipping points and lines
+        struct PrimitiveViews
+        {
+            const ScenePrimitive* primitive;
+            int          mode;
+            AccessorView positions;
+            AccessorView indices;
+            bool         indexed;
+            uint32_t     numTriangles;
+        };
+        std::vector<PrimitiveViews> views;
+        uint64_t totalVertices = 0, totalIndices = 0;
+        bool hasUVs = false;
+        for (auto& primitive : primitives)
+        {
+            const JsonValue& primitiveJson = *primitive.primitive;
+            PrimitiveViews view = {};
+            view.primitive = &primitive;
+            view.mode = static_cast<int>(std::min<size_t>(primitiveJson["mode"].Index(MODE_TRIANGLES), INT32_MAX));
+            if (CountTriangles(view.mode, 3) == 0)  continue;
+
+            const JsonValue& attributes = primitiveJson["attributes"];
+            view.positions = file.Accessor(attributes["POSITION"], "position");
+            view.indexed = !primitiveJson["indices"].IsNull();
+            if (view.indexed)  view.indices = file.Accessor(primitiveJson["indices"], "index");
+            view.numTriangles = CountTriangles(view.mode, view.indexed ? view.indices.count : view.positions.count);
+            if (view.numTriangles == 0)  continue;
+
+            hasUVs |= !attributes["TEXCOORD_0"].IsNull();
+            totalVertices += view.positions.count;
+            totalIndices  += view.numTriangles * 3ull;
+            views.push_back(view);
+        }
+        if (views.empty())  file.Fail("no triangles");
+        if (totalVertices > UINT32_MAX || totalIndices > UINT32_MAX)  file.Fail("too many vertices");
+
+        meshData.flags       = (requireTangents ? MeshHasTangents : 0) | (hasUVs ? MeshHasUVs : 0);
+        MeshVertexLayout layout = GetMeshVertexLayout(meshData.flags);
+        meshData.vertexSize  = layout.vertexSize;
+        meshData.numVertices = static_cast<unsigned int>(totalVertices);
+        meshData.numIndices  = static_cast<unsigned int>(totalIndices);
+        size_t vertexBytes = static_cast<size_t>(totalVertices) * layout.vertexSize;
+        meshData.staging  = gMeshStagingPool.Acquire(vertexBytes + static_cast<size_t>(totalIndices) * 4);
+        meshData.vertices = meshData.staging.Data();
+        meshData.indices  = meshData.staging.Data() + vertexBytes;
+        uint32_t* indices = reinterpret_cast<uint32_t*>(meshData.indices);
+
+        // Write each primitive's attributes from their views straight into the interleaved vertices
+        uint32_t firstVertex = 0, firstIndex = 0;
+        for (auto& view : views)
+        {
+            const JsonValue& attributes = (*view.primitive->primitive)["attributes"];
+            uint32_t numVertices = view.positions.count;
+            uint8_t* vertices = meshData.vertices + static_cast<size_t>(firstVertex) * layout.vertexSize;
+
+            // glTF is right-handed, so Z is negated (as assimp's MakeLeftHanded does) and the triangles reversed. A node
+            // transform that mirrors reverses them again
+            Affine transform = view.primitive->transform;
+            for (int c = 0; c < 4; ++c)  transform.m[2][c] = -transform.m[2][c];
+            CVector3 axes[3] = { transform.Column(0), transform.Column(1), transform.Column(2) };
+            float determinant = Dot(axes[0], Cross(axes[1], axes[2]));
+            float sign = determinant < 0 ? -1.0f : 1.0f;
+            CVector3 normalAxes[3] = { sign * Cross(axes[1], axes[2]), sign * Cross(axes[2], axes[0]), sign * Cross(axes[0], axes[1]) };
+
+            __m128 positionColumns[4], normalColumns[4], tangentColumns[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                CVector3 axis = transform.Column(c);
+                positionColumns[c] = _mm_setr_ps(axis.x, axis.y, axis.z, 0);
+                tangentColumns[c]  = c < 3 ? positionColumns[c] : _mm_setzero_ps();
+                normalColumns[c]   = c < 3 ? _mm_setr_ps(normalAxes[c].x, normalAxes[c].y, normalAxes[c].z, 0) : _mm_setzero_ps();
+            }
+
+            ForEachElement(file, view.positions, 3, "position", [&](uint32_t i, __m128 position)
+            {
+                StoreVector3(vertices + i * layout.vertexSize + layout.positionOffset, Transform(position, positionColumns));
+            });
+
+            auto readAttribute = [&](const char* name, uint32_t components, const char* usedFor, unsigned int offset, const __m128* columns)
+            {
+                if (attributes[name].IsNull())  return false;
+                AccessorView attribute = file.Accessor(attributes[name], usedFor);
+                if (attribute.count != numVertices)  file.Fail((std::string(usedFor) + " count does not match the positions").c_str());
+                ForEachElement(file, attribute, components, usedFor, [&](uint32_t i, __m128 value)
+                {
+                    uint8_t* out = vertices + i * layout.vertexSize + offset;
+                    if (columns == nullptr)
+                    {
+                        alignas(16) float uv[4];
+                        _mm_store_ps(uv, value);
+                        std::memcpy(out, uv, 8);
+                    }
+                    else
+                    {
+                        StoreVector3(out, UnitVector(Transform(value, columns)));
+                    }
+                });
+                return true;
+            };
+            bool hasNormals  = readAttribute("NORMAL", 3, "normal", layout.normalOffset, normalColumns);
+            bool hasTangents = requireTangents && readAttribute("TANGENT", 3, "tangent", layout.tangentOffset, tangentColumns);
+            bool hasUV       = hasUVs && readAttribute("TEXCOORD_0", 2, "UV", layout.uvOffset, nullptr);
+            if (hasUVs && !hasUV)
+            {
+                for (uint32_t i = 0; i < numVertices; ++i)  std::memset(vertices + i * layout.vertexSize + layout.uvOffset, 0, 8);
+            }
+
+            // Triangles
+            bool reverse = determinant < 0;
+            uint32_t* out = indices + firstIndex;
+            if (!view.indexed)
+            {
+                WriteTriangles(file, [](uint32_t i) { return i; }, numVertices, view.mode, firstVertex, numVertices, reverse, out);
+            }
+            else
+            {
+                const AccessorView& index = view.indices;
+                if (index.components != 1)  file.Fail("invalid index accessor");
+                switch (index.componentType)
+                {
+                case COMPONENT_UNSIGNED_BYTE:
+                    WriteTriangles(file, [&](uint32_t i) { return uint32_t{ ReadIndex<uint8_t>(index, i) }; },  index.count, view.mode, firstVertex, numVertices, reverse, out);
+                    break;
+                case COMPONENT_UNSIGNED_SHORT:
+                    WriteTriangles(file, [&](uint32_t i) { return uint32_t{ ReadIndex<uint16_t>(index, i) }; }, index.count, view.mode, firstVertex, numVertices, reverse, out);
+                    break;
+                case COMPONENT_UNSIGNED_INT:
+                    WriteTriangles(file, [&](uint32_t i) { return ReadIndex<uint32_t>(index, i); },             index.count, view.mode, firstVertex, numVertices, reverse, out);
+                    break;
+                default:
+                    file.Fail("invalid index component type");
+                }
+            }
+
+            uint32_t numIndices = view.numTriangles * 3;
+            if (!hasNormals)  GenerateNormals(meshData.vertices, layout, firstVertex, numVertices, out, numIndices);
+            if (requireTangents && !hasTangents)
+            {
+                if (!hasUV)  file.Fail("no tangents, and no UVs to generate them from");
+                GenerateTangents(meshData.vertices, layout, firstVertex, numVertices, out, numIndices);
+            }
+
+            firstVertex += numVertices;
+            firstIndex  += numIndices;
+        }
+    }
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Import
+//--------------------------------------------------------------------------------------
+
+// Import the meshes of a .glb file into the vertex and index layout described in MeshImport.h. Optionally request
+// tangents (for normal and parallax mapping). ImportMesh calls this for files with a .glb extension.
+// Will throw a std::runtime_error exception on failure.
+void ImportGlbMesh(const std::string& fileName, bool requireTangents, MeshData& meshData)
+{
+    MappedFile mapping;
+    if (!mapping.Open(fileName))  throw std::runtime_error("Error loading mesh (" + fileName + "). Cannot open file");
+    mapping.Prefetch();
+
+    size_t slash = fileName.find_last_of("/\\");
+    std::string folder = slash == std::string::npos ? "./" : fileName.substr(0, slash + 1);
+    GlbFile file(mapping.Data(), mapping.Size(), fileName, folder);
+    ImportGlb(file, requireTangents, meshData);
+}
+
+// As above for a .glb file already in memory, e.g. in an asset package. The name is only used in error messages.
+// The file cannot refer to external buffers
+void ImportGlbMesh(const uint8_t* data, size_t size, const std::string& name, bool requireTangents, MeshData& meshData)
+{
+    GlbFile file(data, size, name, "");
+    ImportGlb(file, requireTangents, meshData);
+}
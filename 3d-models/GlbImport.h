@@ -0,0 +1,32 @@
+//--------------------------------------------------------------------------------------
+// Native binary glTF 2.0 (.glb) mesh import
+//--------------------------------------------------------------------------------------
+// Reads .glb files without assimp. Each accessor is read in place from the memory-mapped file
+// and written once into the MeshData staging block (see MeshImport.h), converting quantised
+// attributes with SSE. See ImportGlbMesh for what is supported.
+
+#ifndef _GLB_IMPORT_H_INCLUDED_
+#define _GLB_IMPORT_H_INCLUDED_
+
+#include "MeshImport.h"
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+
+// Import the meshes of a .glb file into the vertex and index layout described in MeshImport.h. Optionally request
+// tangents (for normal and parallax mapping). ImportMesh calls this for files with a .glb extension.
+// Every triangle primitive of every mesh in the default scene is merged into one mesh with the node transforms applied,
+// as assimp's PreTransformVertices does. Supports triangle lists, strips and fans with 8, 16 or 32 bit indices or none,
+// KHR_mesh_quantization and EXT_meshopt_compression (decoded into temporary memory first, with the octahedral and
+// exponential filters). Normals and tangents are generated when missing. Materials, skins and animations are ignored.
+// Will throw a std::runtime_error exception on failure.
+void ImportGlbMesh(const std::string& fileName, bool requireTangents, MeshData& meshData);
+
+// As above for a .glb file already in memory, e.g. in an asset package. The name is only used in error messages.
+// The file cannot refer to external buffers
+void ImportGlbMesh(const uint8_t* data, size_t size, const std::string& name, bool requireTangents, MeshData& meshData);
+
+
+#endif //_GLB_IMPORT_H_INCLUDED_
@@ -0,0 +1,166 @@
+//--------------------------------------------------------------------------------------
+// Lighting Pixel Shader with permutations
+//--------------------------------------------------------------------------------------
+// Pixel shader receives position and normal from the vertex shader and uses them to calculate
+// lighting per pixel, then combines it with a diffuse + specular texture map.
+//
+// This one file is compiled into several different shaders ("permutations") by setting the
+// preprocessor keys below from the C++ side (see LoadPixelShaderPermutation in Shader.cpp).
+// Each permutation contains only the code for the features it was compiled with, so a model
+// that doesn't use shadows or texture mixing doesn't pay for them in every pixel. This file
+// is compiled at runtime so it is not built by the project like the other shaders.
+//
+// Keys (default values in brackets):
+//   LIGHT_COUNT    (2) Number of lights, 0 to 2
+//   SHADOWS        (1) Lights are spotlights that cast shadows, using the shadow maps in t1 and t2
+//   TEXTURE_MIXING (0) Blend a second texture array (t3) into the first by "fading"
+//   CELL_SHADING   (0) Cartoon lighting - diffuse light levels are looked up in a cell map (t4)
+//   TEXTURE_ARRAY  (1) The diffuse + specular map is a slice of a texture array rather than a single texture
+//   POINT_LIGHTS   (0) Also add the unshadowed point lights in the point light constant buffer (b2)
+
+#include "Common.hlsli" // Shaders can also use include files - note the extension
+
+#ifndef LIGHT_COUNT
+#define LIGHT_COUNT 2
+#endif
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+#ifndef TEXTURE_MIXING
+#define TEXTURE_MIXING 0
+#endif
+#ifndef CELL_SHADING
+#define CELL_SHADING 0
+#endif
+#ifndef TEXTURE_ARRAY
+#define TEXTURE_ARRAY 1
+#endif
+#ifndef POINT_LIGHTS
+#define POINT_LIGHTS 0
+#endif
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+// Textures and samplers a permutation doesn't use are left out of its compiled code
+
+// Textures here can contain a diffuse map (main colour) in their rgb channels and a specular map (shininess) in the a channel.
+// Several models' textures are held in one texture array, gDiffuseSpecularSlice selects this model's one
+#if TEXTURE_ARRAY
+Texture2DArray DiffuseSpecularMap : register(t0);
+#else
+Texture2D      DiffuseSpecularMap : register(t0);
+#endif
+Texture2DArray DiffuseSpecularMap2 : register(t3); // Second texture for texture mixing, slice gDiffuseSpecularSlice2
+SamplerState   TexSampler : register(s0); // A sampler is a filter for a texture like bilinear, trilinear or anisotropic
+
+Texture2D    ShadowMapLight1 : register(t1); // Texture holding the view of the scene from a light
+Texture2D    ShadowMapLight2 : register(t2); // Texture holding the view of the scene from a light
+Texture2D    CellMap         : register(t4); // CellMap is a 1D map that is used to limit the range of colours used in cell shading
+SamplerState PointClamp      : register(s1); // No filtering for shadow maps or cell maps (filtering shadow maps would filter light depths not the shadows cast)
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+// Add the diffuse and specular light reaching a pixel from a light with no cone or shadow
+void AddPointLight(float3 lightPosition, float3 lightColour, float3 worldPosition, float3 worldNormal, float3 cameraDirection,
+                   inout float3 diffuseLight, inout float3 specularLight)
+{
+    float3 lightVector = lightPosition - worldPosition;
+    float  lightDistance = length(lightVector);
+    float3 lightDirection = lightVector / lightDistance; // Quicker than normalising as we have length for attenuation
+
+    float diffuseLevel = max(dot(worldNormal, lightDirection), 0);
+#if CELL_SHADING
+    // To make a cartoon look to the lighting, clamp the basic light level to just a small range of colours by using it as
+    // the U coordinate to look up a colour in a 1D texture. GPUs are faster at looking up small textures than if statements
+    diffuseLevel = CellMap.SampleLevel(PointClamp, float2(diffuseLevel, 0.5f), 0).r;
+#endif
+
+    float3 diffuse = lightColour * diffuseLevel / lightDistance; // Equations from lighting lecture
+    float3 halfway = normalize(lightDirection + cameraDirection);
+    diffuseLight  += diffuse;
+    specularLight += diffuse * pow(max(dot(worldNormal, halfway), 0), gSpecularPower); // Multiplying by diffuse light instead of light colour - my own personal preference
+}
+
+
+// Add the diffuse and specular light reaching a pixel from one spotlight. The spotlight and shadow parameters are ignored
+// in permutations without shadows
+void AddLight(float3 lightPosition, float3 lightColour, float3 lightFacing, float lightCosHalfAngle,
+              float4x4 lightViewMatrix, float4x4 lightProjectionMatrix, Texture2D shadowMap,
+              float3 worldPosition, float3 worldNormal, float3 cameraDirection,
+              inout float3 diffuseLight, inout float3 specularLight)
+{
+#if SHADOWS
+    // Pixels outside the light cone get nothing from this light
+    float3 lightDirection = normalize(lightPosition - worldPosition);
+    if (dot(lightDirection, -lightFacing) <= lightCosHalfAngle)  return;
+
+    // Using the world position of the current pixel and the matrices of the light (as a camera), find the 2D position of the
+    // pixel *as seen from the light*. Will use this to find which part of the shadow map to look at
+    float4 lightProjection = mul(lightProjectionMatrix, mul(lightViewMatrix, float4(worldPosition, 1.0f)));
+
+    // Convert 2D pixel position as viewed from light into texture coordinates for shadow map - perspective divide, then
+    // convert from range -1->1 to UV range 0->1. Also flip V axis
+    float2 shadowMapUV = 0.5f * lightProjection.xy / lightProjection.w + float2(0.5f, 0.5f);
+    shadowMapUV.y = 1.0f - shadowMapUV.y;
+
+    // Compare pixel depth from light with depth held in shadow map of the light. If shadow map depth is less then something
+    // is nearer to the light than this pixel - so the pixel gets no effect from this light. The shadow map has no mip-maps,
+    // so sample level 0 explicitly, which is also safe inside this branch
+    float depthFromLight = lightProjection.z / lightProjection.w;
+    if (depthFromLight >= shadowMap.SampleLevel(PointClamp, shadowMapUV, 0).r)  return;
+#endif
+
+    AddPointLight(lightPosition, lightColour, worldPosition, worldNormal, cameraDirection, diffuseLight, specularLight);
+}
+
+
+// Pixel shader entry point - each shader has a "main" function
+float4 main(LightingPixelShaderInput input) : SV_Target
+{
+    // Normal might have been scaled by model scaling or interpolation so renormalise
+    input.worldNormal = normalize(input.worldNormal);
+
+    // Direction from pixel to camera
+    float3 cameraDirection = normalize(gCameraPosition - input.worldPosition);
+
+    // Sum the effect of the lights - start with the ambient light rather than adding it for each light
+    float3 diffuseLight  = gAmbientColour;
+    float3 specularLight = 0;
+#if LIGHT_COUNT >= 1
+    AddLight(gLight1Position, gLight1Colour, gLight1Facing, gLight1CosHalfAngle, gLight1ViewMatrix, gLight1ProjectionMatrix,
+             ShadowMapLight1, input.worldPosition, input.worldNormal, cameraDirection, diffuseLight, specularLight);
+#endif
+#if LIGHT_COUNT >= 2
+    AddLight(gLight2Position, gLight2Colour, gLight2Facing, gLight2CosHalfAngle, gLight2ViewMatrix, gLight2ProjectionMatrix,
+             ShadowMapLight2, input.worldPosition, input.worldNormal, cameraDirection, diffuseLight, specularLight);
+#endif
+#if POINT_LIGHTS
+    for (uint i = 0; i < gNumPointLights; ++i)
+    {
+        AddPointLight(gPointLights[i].position, gPointLights[i].colour, input.worldPosition, input.worldNormal, cameraDirection,
+                      diffuseLight, specularLight);
+    }
+#endif
+
+    // Sample diffuse material and specular material colour for this pixel from a texture using a given sampler that you set up in the C++ code
+#if TEXTURE_ARRAY
+    float4 textureColour = DiffuseSpecularMap.Sample(TexSampler, float3(input.uv, gDiffuseSpecularSlice));
+#else
+    float4 textureColour = DiffuseSpecularMap.Sample(TexSampler, input.uv);
+#endif
+#if TEXTURE_MIXING
+    textureColour = lerp(textureColour, DiffuseSpecularMap2.Sample(TexSampler, float3(input.uv, gDiffuseSpecularSlice2)), fading);
+#endif
+    float3 diffuseMaterialColour = textureColour.rgb; // Diffuse material colour in texture RGB (base colour of model)
+    float specularMaterialColour = textureColour.a;   // Specular material colour in texture A (shininess of the surface)
+
+    // Combine lighting with texture colours
+    float3 finalColour = diffuseLight * diffuseMaterialColour + specularLight * specularMaterialColour;
+
+    return float4(finalColour, 1.0f); // Always use 1.0f for output alpha - no alpha blending in this lab
+}
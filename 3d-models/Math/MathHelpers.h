@@ -42,4 +42,18 @@ inline float ToDegrees(float r)
 }
 
 
+// Linear interpolation from a (t = 0) to b (t = 1)
+inline float Lerp(float a, float b, float t)
+{
+    return a + (b - a) * t;
+}
+
+// Linear interpolation between two angles in radians, taking the shorter way round
+inline float LerpAngle(float a, float b, float t)
+{
+    float difference = std::remainder(b - a, 2.0f * PI); // -PI to PI
+    return a + difference * t;
+}
+
+
 #endif // _MATH_HELPERS_H_DEFINED_
@@ -8,202 +8,172 @@
 // expected to select these things. A later lab will introduce a more robust loader.
 
 #include "Mesh.h"
+#include "MeshImport.h"
+#include "MeshCodec.h"
 #include "Shader.h" // Needed for helper function CreateSignatureForVertexLayout
-#include "CVector2.h" 
-#include "CVector3.h" 
+#include "AssetPackage.h"
+#include "GraphicsHelpers.h" // Render counters, memory accounting
+#include "Profiler.h"
 
-#include <assimp/Importer.hpp>
 #include <assimp/DefaultLogger.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
 
-#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+    // Most silhouette edges drawn by one draw call. The outline quads use 16-bit indices, so at most 65536 vertices
+    const unsigned int MAX_OUTLINE_EDGES_PER_DRAW = 65536 / OUTLINE_VERTICES_PER_EDGE;
+}
 
 
 // Pass the name of the mesh file to load. Uses assimp (http://www.assimp.org/) to support many file types
 // Optionally request tangents to be calculated (for normal and parallax mapping - see later lab)
 // Will throw a std::runtime_error exception on failure (since constructors can't return errors).
-Mesh::Mesh(const std::string& fileName, bool requireTangents /*= false*/)
+Mesh::Mesh(const std::string& fileName, bool requireTangents /*= false*/, bool buildEdgeAdjacency /*= false*/)
 {
-    Assimp::Importer importer;
-
-    // Flags for processing the mesh. Assimp provides a huge amount of control - right click any of these
-    // and "Peek Definition" to see documention above each constant
-    unsigned int assimpFlags = aiProcess_MakeLeftHanded |
-                               aiProcess_GenSmoothNormals |
-                               aiProcess_FixInfacingNormals |
-                               aiProcess_GenUVCoords | 
-                               aiProcess_TransformUVCoords |
-                               aiProcess_FlipUVs |
-                               aiProcess_FlipWindingOrder |
-                               aiProcess_Triangulate |
-                               aiProcess_PreTransformVertices |
-                               aiProcess_JoinIdenticalVertices |
-                               aiProcess_ImproveCacheLocality |
-                               aiProcess_SortByPType |
-                               aiProcess_FindInvalidData | 
-                               aiProcess_OptimizeMeshes |
-                               aiProcess_FindInstances |
-                               aiProcess_FindDegenerates |
-                               aiProcess_RemoveRedundantMaterials |
-                               aiProcess_Debone |
-                               aiProcess_RemoveComponent;
-
-    // Flags to specify what mesh data to ignore
-    int removeComponents = aiComponent_LIGHTS | aiComponent_CAMERAS | aiComponent_TEXTURES | aiComponent_COLORS | 
-                           aiComponent_BONEWEIGHTS | aiComponent_ANIMATIONS | aiComponent_MATERIALS;
-
-    // Add / remove tangents as required by user
-    if (requireTangents)
+    PROFILE_ZONE("Mesh import");
+
+    // If the asset package has a cooked version of this mesh then the GPU buffers are created straight
+    // from the mapped package data - no import, no parsing and no CPU-side copies
+    const PackageEntry* cooked = gAssetPackage.Find(fileName, AssetType::Mesh);
+    if (cooked != nullptr && cooked->size >= sizeof(CookedMeshHeader))
+    {
+        auto header = reinterpret_cast<const CookedMeshHeader*>(gAssetPackage.Data(*cooked));
+        uint64_t vertexBytes = static_cast<uint64_t>(header->numVertices) * header->vertexSize;
+        uint64_t indexBytes  = static_cast<uint64_t>(header->numIndices) * 4;
+        bool hasTangents = (header->flags & MeshHasTangents) != 0;
+        if (hasTangents == requireTangents && header->vertexSize == GetMeshVertexLayout(header->flags).vertexSize &&
+            sizeof(CookedMeshHeader) + vertexBytes + indexBytes <= cooked->size)
+        {
+            const unsigned char* vertices = reinterpret_cast<const unsigned char*>(header + 1);
+            CreateBuffers(fileName, header->flags, header->numVertices, header->numIndices, vertices, vertices + vertexBytes);
+            if (buildEdgeAdjacency)
+            {
+                CreateOutlineBuffers(fileName, header->flags, header->numVertices, header->numIndices, vertices, vertices + vertexBytes);
+            }
+            return;
+        }
+    }
+
+    // A compressed mesh in the package is decoded into a staging block, which reads about a third of the data of an
+    // uncompressed one and is still far quicker than an import. Otherwise import the mesh file with assimp - log
+    // output. Either way the CPU-side copies of the mesh are counted as staging memory until they are freed at the
+    // end of this function
+    MeshData meshData;
+    const PackageEntry* compressed = gAssetPackage.Find(fileName, AssetType::CompressedMesh);
+    if (compressed != nullptr && compressed->size >= sizeof(CompressedMeshHeader) &&
+        ((reinterpret_cast<const CompressedMeshHeader*>(gAssetPackage.Data(*compressed))->flags & MeshHasTangents) != 0) == requireTangents)
     {
-        assimpFlags |= aiProcess_CalcTangentSpace;
+        MemoryScope scope(MemoryCategory::MeshStaging);
+        DecodeMesh(gAssetPackage.Data(*compressed), static_cast<size_t>(compressed->size), meshData);
     }
     else
     {
-        removeComponents |= aiComponent_TANGENTS_AND_BITANGENTS;
+        Assimp::DefaultLogger::create("", Assimp::DefaultLogger::VERBOSE);
+        try
+        {
+            MemoryScope scope(MemoryCategory::MeshStaging);
+            ImportMesh(fileName, requireTangents, meshData);
+        }
+        catch (...)
+        {
+            Assimp::DefaultLogger::kill();
+            throw;
+        }
+        Assimp::DefaultLogger::kill();
     }
 
-    // Other miscellaneous settings
-    importer.SetPropertyFloat(AI_CONFIG_PP_GSN_MAX_SMOOTHING_ANGLE, 80.0f); // Smoothing angle for normals
-    importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);  // Remove points and lines (keep triangles only)
-    importer.SetPropertyBool(AI_CONFIG_PP_FD_REMOVE, true);                 // Remove degenerate triangles
-    importer.SetPropertyBool(AI_CONFIG_PP_DB_ALL_OR_NONE, true);            // Default to removing bones/weights from meshes that don't need skinning
-  
-    importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, removeComponents);
-
-    // Import mesh with assimp given above requirements - log output
-    Assimp::DefaultLogger::create("", Assimp::DefaultLogger::VERBOSE);
-    const aiScene* scene = importer.ReadFile(fileName, assimpFlags);
-    Assimp::DefaultLogger::kill();
-    if (scene == nullptr)  throw std::runtime_error("Error loading mesh (" + fileName + "). " + importer.GetErrorString());
-    if (scene->mNumMeshes == 0)  throw std::runtime_error("No usable geometry in mesh: " + fileName);
+    // The staging block goes back to the pool for the next import as soon as the GPU buffers have been filled from it
+    CreateBuffers(fileName, meshData.flags, meshData.numVertices, meshData.numIndices, meshData.vertices, meshData.indices);
+    if (buildEdgeAdjacency)
+    {
+        CreateOutlineBuffers(fileName, meshData.flags, meshData.numVertices, meshData.numIndices, meshData.vertices, meshData.indices);
+    }
+    meshData.staging.Release();
+}
 
 
-    //-----------------------------------
+// Create a mesh from data already in memory, e.g. a generated primitive (see MeshPrimitives.h). The name is only
+// used in error messages. The data's staging block is released once the GPU buffers have been created.
+// Will throw a std::runtime_error exception on failure.
+Mesh::Mesh(const std::string& name, MeshData& meshData, bool buildEdgeAdjacency /*= false*/)
+{
+    CreateBuffers(name, meshData.flags, meshData.numVertices, meshData.numIndices, meshData.vertices, meshData.indices);
+    if (buildEdgeAdjacency)
+    {
+        CreateOutlineBuffers(name, meshData.flags, meshData.numVertices, meshData.numIndices, meshData.vertices, meshData.indices);
+    }
+    meshData.staging.Release();
+}
 
-    // Only importing first submesh - significant limitation - do not use this importer for your own projects
-    aiMesh* assimpMesh = scene->mMeshes[0];
-    std::string subMeshName = assimpMesh->mName.C_Str();
 
-    
-    //-----------------------------------
+// Create the input layout and GPU-side vertex and index buffers from mesh data in the layout described
+// in MeshImport.h. The data can come from an import or directly from a cooked asset package.
+// Will throw a std::runtime_error exception on failure.
+void Mesh::CreateBuffers(const std::string& fileName, unsigned int flags, unsigned int numVertices, unsigned int numIndices,
+                         const void* vertices, const void* indices)
+{
+    MeshVertexLayout layout = GetMeshVertexLayout(flags);
 
-    // Check for presence of position and normal data. Tangents and UVs are optional.
+    // Describe to DirectX what is in each vertex of this mesh. Tangents and UVs are optional.
     std::vector<D3D11_INPUT_ELEMENT_DESC> vertexElements;
-    unsigned int offset = 0;
-    
-    if (!assimpMesh->HasPositions())  throw std::runtime_error("No position data for sub-mesh " + subMeshName + " in " + fileName);
-    unsigned int positionOffset = offset;
-    vertexElements.push_back( { "Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, positionOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 } );
-    offset += 12;
-
-    if (!assimpMesh->HasNormals())  throw std::runtime_error("No normal data for sub-mesh " + subMeshName + " in " + fileName);
-    unsigned int normalOffset = offset;
-    vertexElements.push_back( { "Normal", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, normalOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 } );
-    offset += 12;
-
-    unsigned int tangentOffset = offset;
-    if (requireTangents)
+    vertexElements.push_back( { "Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, layout.positionOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 } );
+    vertexElements.push_back( { "Normal",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, layout.normalOffset,   D3D11_INPUT_PER_VERTEX_DATA, 0 } );
+    if (flags & MeshHasTangents)
     {
-        if (!assimpMesh->HasTangentsAndBitangents())  throw std::runtime_error("No tangent data for sub-mesh " + subMeshName + " in " + fileName);
-        vertexElements.push_back( { "Tangent", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, tangentOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 } );
-        offset += 12;
+        vertexElements.push_back( { "Tangent", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, layout.tangentOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 } );
     }
-    
-    unsigned int uvOffset = offset;
-    if (assimpMesh->GetNumUVChannels() > 0 && assimpMesh->HasTextureCoords(0))
+    if (flags & MeshHasUVs)
     {
-        if (assimpMesh->mNumUVComponents[0] != 2)  throw std::runtime_error("Unsupported texture coordinates in " + subMeshName + " in " + fileName);
-        vertexElements.push_back( { "UV", 0, DXGI_FORMAT_R32G32_FLOAT, 0, uvOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 } );
-        offset += 8;
+        vertexElements.push_back( { "UV", 0, DXGI_FORMAT_R32G32_FLOAT, 0, layout.uvOffset, D3D11_INPUT_PER_VERTEX_DATA, 0 } );
     }
 
-    mVertexSize = offset;
-
-
-    // Create a "vertex layout" to describe to DirectX what is data in each vertex of this mesh
-    auto shaderSignature = CreateSignatureForVertexLayout(vertexElements.data(), static_cast<int>(vertexElements.size()));
-    HRESULT hr = gD3DDevice->CreateInputLayout(vertexElements.data(), static_cast<UINT>(vertexElements.size()),
-                                               shaderSignature->GetBufferPointer(), shaderSignature->GetBufferSize(),
-                                               &mVertexLayout);
-    if (shaderSignature)  shaderSignature->Release();
-    if (FAILED(hr))  throw std::runtime_error("Failure creating input layout for " + fileName);
-
+    mVertexSize  = layout.vertexSize;
+    mNumVertices = numVertices;
+    mNumIndices  = numIndices;
 
 
-    //-----------------------------------
-
-    // Create CPU-side buffers to hold current mesh data - exact content is flexible so can't use a structure for a vertex - so just a block of bytes
-    // Note: for large arrays a unique_ptr is better than a vector because vectors default-initialise all the values which is a waste of time.
-    mNumVertices = assimpMesh->mNumVertices;
-    mNumIndices  = assimpMesh->mNumFaces * 3;
-    auto vertices = std::make_unique<unsigned char[]>(mNumVertices * mVertexSize);
-    auto indices  = std::make_unique<unsigned char[]>(mNumIndices * 4); // Using 32 bit indexes (4 bytes) for each indeex
-
-
-    //-----------------------------------
-
-    // Copy mesh data from assimp to our CPU-side vertex buffer
-
-    CVector3* assimpPosition = reinterpret_cast<CVector3*>(assimpMesh->mVertices);
-    unsigned char* position = vertices.get() + positionOffset;
-    unsigned char* positionEnd = position + mNumVertices * mVertexSize;
-    while (position != positionEnd)
-    {
-        *(CVector3*)position = *assimpPosition;
-        position += mVertexSize;
-        ++assimpPosition;
-    }
-
-    CVector3* assimpNormal = reinterpret_cast<CVector3*>(assimpMesh->mNormals);
-    unsigned char* normal = vertices.get() + normalOffset;
-    unsigned char* normalEnd = normal + mNumVertices * mVertexSize;
-    while (normal != normalEnd)
-    {
-        *(CVector3*)normal = *assimpNormal;
-        normal += mVertexSize;
-        ++assimpNormal;
-    }
+    // Bounding radius from the vertex positions, UV density from the total surface area of the triangles in model
+    // space and in UV space (the square root gives UV units per model space unit along a line)
+    const char* vertexData = static_cast<const char*>(vertices);
+    auto position = [&](unsigned int index) { return *reinterpret_cast<const CVector3*>(vertexData + index * mVertexSize + layout.positionOffset); };
+    auto uv       = [&](unsigned int index) { return reinterpret_cast<const float*>(vertexData + index * mVertexSize + layout.uvOffset); };
 
-    if (requireTangents)
-    {
-      CVector3* assimpTangent = reinterpret_cast<CVector3*>(assimpMesh->mTangents);
-      unsigned char* tangent =  vertices.get() + tangentOffset;
-      unsigned char* tangentEnd = tangent + mNumVertices * mVertexSize;
-      while (tangent != tangentEnd)
-      {
-        *(CVector3*)tangent = *assimpTangent;
-        tangent += mVertexSize;
-        ++assimpTangent;
-      }
-    }
+    mBoundingRadius = 0;
+    for (unsigned int v = 0; v < mNumVertices; ++v)  mBoundingRadius = std::max(mBoundingRadius, Length(position(v)));
 
-    if (assimpMesh->GetNumUVChannels() > 0 && assimpMesh->HasTextureCoords(0))
+    mUVDensity = 0;
+    if (flags & MeshHasUVs)
     {
-        aiVector3D* assimpUV = assimpMesh->mTextureCoords[0];
-        unsigned char* uv = vertices.get() + uvOffset;
-        unsigned char* uvEnd = uv + mNumVertices * mVertexSize;
-        while (uv != uvEnd)
+        const DWORD* indexData = static_cast<const DWORD*>(indices);
+        double area = 0, uvArea = 0;
+        for (unsigned int i = 0; i + 2 < mNumIndices; i += 3)
         {
-            *(CVector2*)uv = CVector2(assimpUV->x, assimpUV->y);
-            uv += mVertexSize;
-            ++assimpUV;
+            CVector3 p0 = position(indexData[i]);
+            area += 0.5 * Length(Cross(position(indexData[i + 1]) - p0, position(indexData[i + 2]) - p0));
+
+            const float* uv0 = uv(indexData[i]);
+            const float* uv1 = uv(indexData[i + 1]);
+            const float* uv2 = uv(indexData[i + 2]);
+            uvArea += 0.5 * std::fabs((uv1[0] - uv0[0]) * (uv2[1] - uv0[1]) - (uv2[0] - uv0[0]) * (uv1[1] - uv0[1]));
         }
+        if (area > 0)  mUVDensity = static_cast<float>(std::sqrt(uvArea / area));
     }
 
 
-    //-----------------------------------
-
-    // Copy face data from assimp to our CPU-side index buffer
-    if (!assimpMesh->HasFaces())  throw std::runtime_error("No face data in " + subMeshName + " in " + fileName);
-
-    DWORD* index = reinterpret_cast<DWORD*>(indices.get());
-    for (unsigned int face = 0; face < assimpMesh->mNumFaces; ++face)
-    {
-        *index++ = assimpMesh->mFaces[face].mIndices[0];
-        *index++ = assimpMesh->mFaces[face].mIndices[1];
-        *index++ = assimpMesh->mFaces[face].mIndices[2];
-    }
+    // Create a "vertex layout" to describe to DirectX what is data in each vertex of this mesh
+    auto shaderSignature = CreateSignatureForVertexLayout(vertexElements.data(), static_cast<int>(vertexElements.size()));
+    if (shaderSignature == nullptr)  throw std::runtime_error("Failure creating input layout for " + fileName);
+    HRESULT hr = gD3DDevice->CreateInputLayout(vertexElements.data(), static_cast<UINT>(vertexElements.size()),
+                                               shaderSignature->GetBufferPointer(), shaderSignature->GetBufferSize(),
+                                               &mVertexLayout);
+    shaderSignature->Release();
+    if (FAILED(hr))  throw std::runtime_error("Failure creating input layout for " + fileName);
 
 
     //-----------------------------------
@@ -211,35 +181,100 @@ Mesh::Mesh(const std::string& fileName, bool requireTangents /*= false*/)
     D3D11_BUFFER_DESC bufferDesc;
     D3D11_SUBRESOURCE_DATA initData;
 
-    // Create GPU-side vertex buffer and copy the vertices imported by assimp into it
+    // Create GPU-side vertex buffer and copy the vertices into it
     bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Indicate it is a vertex buffer
     bufferDesc.Usage = D3D11_USAGE_DEFAULT;          // Default usage for this buffer - we'll see other usages later
     bufferDesc.ByteWidth = mNumVertices * mVertexSize; // Size of the buffer in bytes
     bufferDesc.CPUAccessFlags = 0;
     bufferDesc.MiscFlags = 0;
-    initData.pSysMem = vertices.get(); // Fill the new vertex buffer with data loaded by assimp
-    
+    initData.pSysMem = vertices; // Fill the new vertex buffer with the mesh data
+
     hr = gD3DDevice->CreateBuffer(&bufferDesc, &initData, &mVertexBuffer);
     if (FAILED(hr))  throw std::runtime_error("Failure creating vertex buffer for " + fileName);
+    TrackMemory(MemoryCategory::Meshes, MemoryHeap::GPU, bufferDesc.ByteWidth);
 
 
-    // Create GPU-side index buffer and copy the vertices imported by assimp into it
+    // Create GPU-side index buffer and copy the indices into it
     bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER; // Indicate it is an index buffer
     bufferDesc.Usage = D3D11_USAGE_DEFAULT;         // Default usage for this buffer - we'll see other usages later
     bufferDesc.ByteWidth = mNumIndices * sizeof(DWORD); // Size of the buffer in bytes
     bufferDesc.CPUAccessFlags = 0;
     bufferDesc.MiscFlags = 0;
-    initData.pSysMem = indices.get(); // Fill the new index buffer with data loaded by assimp
+    initData.pSysMem = indices; // Fill the new index buffer with the mesh data
 
     hr = gD3DDevice->CreateBuffer(&bufferDesc, &initData, &mIndexBuffer);
     if (FAILED(hr))  throw std::runtime_error("Failure creating index buffer for " + fileName);
+    TrackMemory(MemoryCategory::Meshes, MemoryHeap::GPU, bufferDesc.ByteWidth);
+}
+
+
+// Build the edge adjacency from the same data as CreateBuffers and create the buffers the outline is drawn from
+// Will throw a std::runtime_error exception on failure.
+void Mesh::CreateOutlineBuffers(const std::string& fileName, unsigned int flags, unsigned int numVertices, unsigned int numIndices,
+                                const void* vertices, const void* indices)
+{
+    MeshVertexLayout layout = GetMeshVertexLayout(flags);
+    mEdges.Build(vertices, layout.vertexSize, layout.positionOffset, numVertices, static_cast<const uint32_t*>(indices), numIndices);
+    if (mEdges.NumEdges() == 0)  return;
+
+    // Describe the outline quad corners (OutlineVertex in SilhouetteEdges.h) to DirectX
+    D3D11_INPUT_ELEMENT_DESC vertexElements[] =
+    {
+        { "Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(OutlineVertex, position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "OtherEnd", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(OutlineVertex, otherEnd), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "Side",     0, DXGI_FORMAT_R32_FLOAT,       0, offsetof(OutlineVertex, side),     D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    };
+    const int numElements = sizeof(vertexElements) / sizeof(vertexElements[0]);
+    auto shaderSignature = CreateSignatureForVertexLayout(vertexElements, numElements);
+    if (shaderSignature == nullptr)  throw std::runtime_error("Failure creating outline input layout for " + fileName);
+    HRESULT hr = gD3DDevice->CreateInputLayout(vertexElements, numElements, shaderSignature->GetBufferPointer(),
+                                               shaderSignature->GetBufferSize(), &mOutlineLayout);
+    shaderSignature->Release();
+    if (FAILED(hr))  throw std::runtime_error("Failure creating outline input layout for " + fileName);
+
+    // The quads are rewritten every frame, so the vertex buffer is dynamic. It only needs room for every edge at once
+    // on small meshes, larger silhouettes are drawn in several batches
+    mOutlineCapacity = std::min(mEdges.NumEdges(), MAX_OUTLINE_EDGES_PER_DRAW);
+
+    D3D11_BUFFER_DESC bufferDesc;
+    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = mOutlineCapacity * OUTLINE_VERTICES_PER_EDGE * sizeof(OutlineVertex);
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    bufferDesc.MiscFlags = 0;
+    hr = gD3DDevice->CreateBuffer(&bufferDesc, nullptr, &mOutlineVertexBuffer);
+    if (FAILED(hr))  throw std::runtime_error("Failure creating outline vertex buffer for " + fileName);
+    TrackMemory(MemoryCategory::Meshes, MemoryHeap::GPU, bufferDesc.ByteWidth);
+
+    // The indices are the same for every batch: two triangles for each quad
+    std::vector<uint16_t> quadIndices(mOutlineCapacity * OUTLINE_INDICES_PER_EDGE);
+    for (unsigned int quad = 0; quad < mOutlineCapacity; ++quad)
+    {
+        uint16_t first = static_cast<uint16_t>(quad * OUTLINE_VERTICES_PER_EDGE);
+        uint16_t* index = &quadIndices[quad * OUTLINE_INDICES_PER_EDGE];
+        index[0] = first;      index[1] = first + 1;  index[2] = first + 2;
+        index[3] = first + 2;  index[4] = first + 1;  index[5] = first + 3;
+    }
+
+    D3D11_SUBRESOURCE_DATA initData;
+    bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    bufferDesc.ByteWidth = static_cast<UINT>(quadIndices.size() * sizeof(uint16_t));
+    bufferDesc.CPUAccessFlags = 0;
+    initData.pSysMem = quadIndices.data();
+    hr = gD3DDevice->CreateBuffer(&bufferDesc, &initData, &mOutlineIndexBuffer);
+    if (FAILED(hr))  throw std::runtime_error("Failure creating outline index buffer for " + fileName);
+    TrackMemory(MemoryCategory::Meshes, MemoryHeap::GPU, bufferDesc.ByteWidth);
 }
 
 
 Mesh::~Mesh()
 {
-    if (mIndexBuffer)   mIndexBuffer ->Release();
-    if (mVertexBuffer)  mVertexBuffer->Release();
+    ReleaseTracked(mOutlineIndexBuffer,  MemoryCategory::Meshes);
+    ReleaseTracked(mOutlineVertexBuffer, MemoryCategory::Meshes);
+    if (mOutlineLayout)  mOutlineLayout->Release();
+    ReleaseTracked(mIndexBuffer,  MemoryCategory::Meshes);
+    ReleaseTracked(mVertexBuffer, MemoryCategory::Meshes);
     if (mVertexLayout)  mVertexLayout->Release();
 }
 
@@ -264,4 +299,47 @@ void Mesh::Render()
 
     // Render mesh
     gD3DContext->DrawIndexed(mNumIndices, 0, 0);
+
+    gRenderCounters.stateChanges += 4;
+    ++gRenderCounters.drawCalls;
+    gRenderCounters.triangles += mNumIndices / 3;
+}
+
+
+// Draw the outline of the mesh as seen from the given viewpoint (in model space) as quads along its silhouette edges,
+// which are found on the CPU. Needs the outline shaders and the per-model constants set up already. Does nothing
+// unless the mesh was loaded with edge adjacency
+void Mesh::RenderOutline(const CVector3& viewpoint)
+{
+    if (mOutlineVertexBuffer == nullptr)  return;
+
+    const std::vector<uint32_t>* edges;
+    {
+        PROFILE_ZONE("Silhouette edges");
+        edges = &mSilhouette.Extract(mEdges, viewpoint);
+    }
+    if (edges->empty())  return;
+
+    UINT stride = sizeof(OutlineVertex);
+    UINT offset = 0;
+    gD3DContext->IASetVertexBuffers(0, 1, &mOutlineVertexBuffer, &stride, &offset);
+    gD3DContext->IASetInputLayout(mOutlineLayout);
+    gD3DContext->IASetIndexBuffer(mOutlineIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+    gD3DContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    gRenderCounters.stateChanges += 4;
+
+    // Write as many quads as the buffer holds and draw them, until the whole silhouette is drawn
+    for (size_t first = 0; first < edges->size(); first += mOutlineCapacity)
+    {
+        unsigned int numEdges = static_cast<unsigned int>(std::min<size_t>(mOutlineCapacity, edges->size() - first));
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (FAILED(gD3DContext->Map(mOutlineVertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))  return;
+        WriteOutlineQuads(mEdges, edges->data() + first, numEdges, static_cast<OutlineVertex*>(mapped.pData));
+        gD3DContext->Unmap(mOutlineVertexBuffer, 0);
+
+        gD3DContext->DrawIndexed(numEdges * OUTLINE_INDICES_PER_EDGE, 0, 0);
+        ++gRenderCounters.drawCalls;
+        gRenderCounters.triangles += numEdges * 2;
+    }
 }
@@ -8,27 +8,59 @@
 // expected to select these things. A later lab will introduce a more robust loader.
 
 #include "common.h"
+#include "SilhouetteEdges.h"
 
 #include <string>
 
 #ifndef _MESH_H_INCLUDED_
 #define _MESH_H_INCLUDED_
 
+struct MeshData;
+
 class Mesh
 {
 public:
     // Pass the name of the mesh file to load. Uses assimp (http://www.assimp.org/) to support many file types
     // Optionally request tangents to be calculated (for normal and parallax mapping - see later lab)
+    // Request edge adjacency for meshes that will be drawn with outlines (see RenderOutline)
     // Will throw a std::runtime_error exception on failure (since constructors can't return errors).
-    Mesh(const std::string& fileName, bool requireTangents = false);
+    Mesh(const std::string& fileName, bool requireTangents = false, bool buildEdgeAdjacency = false);
+
+    // Create a mesh from data already in memory, e.g. a generated primitive (see MeshPrimitives.h). The name is only
+    // used in error messages. The data's staging block is released once the GPU buffers have been created.
+    // Will throw a std::runtime_error exception on failure.
+    Mesh(const std::string& name, MeshData& meshData, bool buildEdgeAdjacency = false);
     ~Mesh();
 
     // The render function assumes shaders, matrices, textures, samplers etc. have been set up already.
     // It simply draws this mesh with whatever settings the GPU is currently using.
     void Render();
 
+    // Draw the outline of the mesh as seen from the given viewpoint (in model space) as quads along its silhouette
+    // edges, which are found on the CPU. Needs the outline shaders and the per-model constants set up already. Does
+    // nothing unless the mesh was loaded with edge adjacency
+    void RenderOutline(const CVector3& viewpoint);
+
+
+    // Radius of a sphere around the mesh origin that contains the whole mesh (in model space)
+    float BoundingRadius()  { return mBoundingRadius; }
+
+    // Average number of UV units per model space unit across the surface of the mesh, 0 if the mesh has no UVs.
+    // Used with a model's size on screen to find out how much detail of a texture is visible
+    float UVDensity()       { return mUVDensity; }
+
 
 private:
+    // Create the input layout and GPU-side vertex and index buffers from mesh data in the layout described
+    // in MeshImport.h. The data can come from an import or directly from a cooked asset package.
+    // Will throw a std::runtime_error exception on failure.
+    void CreateBuffers(const std::string& fileName, unsigned int flags, unsigned int numVertices, unsigned int numIndices,
+                       const void* vertices, const void* indices);
+
+    // Build the edge adjacency from the same data as above and create the buffers the outline is drawn from
+    void CreateOutlineBuffers(const std::string& fileName, unsigned int flags, unsigned int numVertices, unsigned int numIndices,
+                              const void* vertices, const void* indices);
+
     unsigned int       mVertexSize;             // Size in bytes of a single vertex (depends on what it contains, uvs, tangents etc.)
     ID3D11InputLayout* mVertexLayout = nullptr; // DirectX specification of data held in a single vertex
 
@@ -38,6 +70,18 @@ private:
 
     unsigned int       mNumIndices;
     ID3D11Buffer*      mIndexBuffer  = nullptr;
+
+    float              mBoundingRadius = 0;
+    float              mUVDensity      = 0;
+
+    // Outline drawing, only for meshes loaded with edge adjacency. The quads for the silhouette edges are written to a
+    // dynamic vertex buffer each frame, with room for mOutlineCapacity edges per draw call
+    EdgeAdjacency       mEdges;
+    SilhouetteExtractor mSilhouette;
+    ID3D11InputLayout*  mOutlineLayout       = nullptr;
+    ID3D11Buffer*       mOutlineVertexBuffer = nullptr;
+    ID3D11Buffer*       mOutlineIndexBuffer  = nullptr;
+    unsigned int        mOutlineCapacity     = 0;
 };
 
 
@@ -0,0 +1,663 @@
+//--------------------------------------------------------------------------------------
+// Mesh compression
+//--------------------------------------------------------------------------------------
+
+#include "MeshCodec.h"
+#include "MeshPrimitives.h" // OptimiseVertexCache
+
+#include <emmintrin.h> // SSE2
+#include <stdexcept>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+
+namespace
+{
+    // Vertices and indices are split into chunks of these sizes, which are coded separately so they can be decoded on
+    // different threads. Both are multiples of the 16 value block size
+    const uint32_t VERTEX_CHUNK = 8192;
+    const uint32_t INDEX_CHUNK  = 8192 * 3;
+    const uint32_t BLOCK        = 16;
+
+    // Meshes with fewer chunks than this for each thread use fewer threads, starting threads costs more than the work
+    const uint32_t MIN_CHUNKS_PER_THREAD = 2;
+
+    // Bytes used by 16 values packed with each width code: 0, 2, 4 or 8 bits per value
+    const uint32_t GROUP_BYTES[4] = { 0, 4, 8, 16 };
+
+
+    // Components of a vertex, all uint16. Position xyz, octahedral normal, octahedral tangent (if any) and UV (if any)
+    unsigned int NumComponents(unsigned int flags)
+    {
+        return 5 + ((flags & MeshHasTangents) ? 2 : 0) + ((flags & MeshHasUVs) ? 2 : 0);
+    }
+
+    uint32_t NumChunks(uint32_t count, uint32_t chunkSize)
+    {
+        return (count + chunkSize - 1) / chunkSize;
+    }
+
+
+    //--------------------------------------------------------------------------------------
+    // Octahedral vectors
+    //--------------------------------------------------------------------------------------
+
+    // Unit vector from octahedral coordinates, the same calculation as the SSE version in the decoder
+    void OctahedralDecode(float u, float v, float out[3])
+    {
+        float z = 1.0f - std::fabs(u) - std::fabs(v);
+        float t = std::max(-z, 0.0f);
+        u -= std::copysign(t, u);
+        v -= std::copysign(t, v);
+        float length = std::sqrt(u * u + v * v + z * z);
+        out[0] = u / length;
+        out[1] = v / length;
+        out[2] = z / length;
+    }
+
+    // Quantised octahedral coordinates for a vector. Of the four grid points around the exact coordinates, the one that
+    // decodes closest to the vector is chosen
+    void OctahedralEncode(const float* vector, unsigned int bits, uint16_t out[2])
+    {
+        float n[3] = { vector[0], vector[1], vector[2] };
+        float sum = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+        if (!(sum > 0))  { n[0] = 0; n[1] = 0; n[2] = 1; sum = 1; } // Zero or invalid vectors point along z
+        float u = n[0] / sum;
+        float v = n[1] / sum;
+        if (n[2] < 0)
+        {
+            float oldU = u;
+            u = std::copysign(1.0f - std::fabs(v), oldU);
+            v = std::copysign(1.0f - std::fabs(oldU), v);
+        }
+
+        float maxValue = static_cast<float>((1u << bits) - 1);
+        float scale = 2.0f / maxValue;
+        float qu = std::floor((u + 1.0f) / scale);
+        float qv = std::floor((v + 1.0f) / scale);
+
+        float bestDot = -2;
+        for (int corner = 0; corner < 4; ++corner)
+        {
+            float cu = std::min(qu + (corner & 1), maxValue);
+            float cv = std::min(qv + (corner >> 1), maxValue);
+            float decoded[3];
+            OctahedralDecode(cu * scale - 1.0f, cv * scale - 1.0f, decoded);
+            float dot = (decoded[0] * n[0] + decoded[1] * n[1] + decoded[2] * n[2]);
+            if (dot > bestDot)
+            {
+                bestDot = dot;
+                out[0] = static_cast<uint16_t>(cu);
+                out[1] = static_cast<uint16_t>(cv);
+            }
+        }
+    }
+
+
+    //--------------------------------------------------------------------------------------
+    // Encoding
+    //--------------------------------------------------------------------------------------
+
+    // Width code for 16 values, the fewest bits that hold them all
+    unsigned int GroupWidth(const uint8_t* values)
+    {
+        uint8_t largest = *std::max_element(values, values + BLOCK);
+        return largest == 0 ? 0 : largest < 4 ? 1 : largest < 16 ? 2 : 3;
+    }
+
+    // Pack 16 values with the given width code. Value i goes in byte i * bits / 8 at bit i * bits % 8
+    void PackGroup(const uint8_t* values, unsigned int width, std::vector<uint8_t>& output)
+    {
+        if (width == 0)  return;
+        if (width == 3)
+        {
+            output.insert(output.end(), values, values + BLOCK);
+            return;
+        }
+        unsigned int bits = 1u << width;
+        unsigned int perByte = 8 / bits;
+        for (uint32_t i = 0; i < BLOCK; i += perByte)
+        {
+            uint8_t packed = 0;
+            for (unsigned int j = 0; j < perByte; ++j)  packed = static_cast<uint8_t>(packed | (values[i + j] << (j * bits)));
+            output.push_back(packed);
+        }
+    }
+
+
+    // Vertex chunk: for each block of 16 vertices a header of one nibble per component (low byte width code, then high
+    // byte width code in the upper two bits), then the low then high bytes of each component. The values are zigzag
+    // coded differences from the previous vertex, starting from 0 in each chunk. The last block is padded with copies
+    // of the last vertex
+    void EncodeVertexChunk(const std::vector<uint16_t>* components, unsigned int numComponents, uint32_t first,
+                           uint32_t count, std::vector<uint8_t>& output)
+    {
+        uint16_t previous[MESH_CODEC_MAX_COMPONENTS] = {};
+        for (uint32_t block = 0; block < count; block += BLOCK)
+        {
+            size_t header = output.size();
+            output.resize(header + (numComponents + 1) / 2, 0);
+            for (unsigned int c = 0; c < numComponents; ++c)
+            {
+                uint8_t planes[2][BLOCK];
+                for (uint32_t i = 0; i < BLOCK; ++i)
+                {
+                    uint16_t value = components[c][first + std::min(block + i, count - 1)];
+                    uint16_t delta = static_cast<uint16_t>(value - previous[c]);
+                    uint16_t zigzag = static_cast<uint16_t>((delta << 1) ^ ((delta & 0x8000) ? 0xFFFF : 0));
+                    previous[c] = value;
+                    planes[0][i] = static_cast<uint8_t>(zigzag);
+                    planes[1][i] = static_cast<uint8_t>(zigzag >> 8);
+                }
+                unsigned int lowWidth  = GroupWidth(planes[0]);
+                unsigned int highWidth = GroupWidth(planes[1]);
+                output[header + c / 2] |= static_cast<uint8_t>((lowWidth | (highWidth << 2)) << ((c & 1) * 4));
+                PackGroup(planes[0], lowWidth,  output);
+                PackGroup(planes[1], highWidth, output);
+            }
+        }
+    }
+
+
+    // Index chunk: for each block of 16 indices a header byte with a width code for each of the four byte planes (lowest
+    // first), then the planes. Each index is stored as the number of vertices back from the next vertex not used yet.
+    // The last block is padded with zeros
+    void EncodeIndexChunk(const uint32_t* indices, uint32_t count, uint32_t& nextVertex, std::vector<uint8_t>& output)
+    {
+        for (uint32_t block = 0; block < count; block += BLOCK)
+        {
+            uint8_t planes[4][BLOCK] = {};
+            for (uint32_t i = 0; i < BLOCK && block + i < count; ++i)
+            {
+                uint32_t index = indices[block + i];
+                uint32_t code = nextVertex - index;
+                if (index == nextVertex)  ++nextVertex;
+                for (int plane = 0; plane < 4; ++plane)  planes[plane][i] = static_cast<uint8_t>(code >> (plane * 8));
+            }
+
+            size_t header = output.size();
+            output.push_back(0);
+            for (int plane = 0; plane < 4; ++plane)
+            {
+                unsigned int width = GroupWidth(planes[plane]);
+                output[header] |= static_cast<uint8_t>(width << (plane * 2));
+                PackGroup(planes[plane], width, output);
+            }
+        }
+    }
+
+
+    //--------------------------------------------------------------------------------------
+    // Decoding
+    //--------------------------------------------------------------------------------------
+
+    // Unpack 16 bytes packed with the given width code and move past them. The caller has checked they are there
+    inline __m128i UnpackGroup(const uint8_t*& data, unsigned int width)
+    {
+        switch (width)
+        {
+        case 0:
+            return _mm_setzero_si128();
+
+        case 1:
+        {
+            uint32_t bits;
+            std::memcpy(&bits, data, 4);
+            data += 4;
+            const __m128i mask = _mm_set1_epi8(3);
+            __m128i packed = _mm_cvtsi32_si128(static_cast<int>(bits));
+            __m128i v0 = _mm_and_si128(packed, mask);
+            __m128i v1 = _mm_and_si128(_mm_srli_epi16(packed, 2), mask);
+            __m128i v2 = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+            __m128i v3 = _mm_and_si128(_mm_srli_epi16(packed, 6), mask);
+            return _mm_unpacklo_epi16(_mm_unpacklo_epi8(v0, v1), _mm_unpacklo_epi8(v2, v3));
+        }
+
+        case 2:
+        {
+            const __m128i mask = _mm_set1_epi8(15);
+            __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+            data += 8;
+            return _mm_unpacklo_epi8(_mm_and_si128(packed, mask), _mm_and_si128(_mm_srli_epi16(packed, 4), mask));
+        }
+
+        default:
+        {
+            __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            data += 16;
+            return values;
+        }
+        }
+    }
+
+
+    // Undo the zigzag coding of 8 differences and add them up, continuing from the last value in previous
+    inline __m128i UndoDeltas(__m128i zigzag, __m128i previous)
+    {
+        __m128i delta = _mm_xor_si128(_mm_srli_epi16(zigzag, 1),
+                                      _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(zigzag, _mm_set1_epi16(1))));
+        delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 2));
+        delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 4));
+        delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 8));
+        __m128i last = _mm_shufflehi_epi16(previous, 0xFF);
+        return _mm_add_epi16(delta, _mm_unpackhi_epi64(last, last));
+    }
+
+
+    // Four uint16 values from a block as floats, q * scale + offset
+    inline __m128 Dequantise(const uint16_t* values, __m128 scale, __m128 offset)
+    {
+        __m128i q = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values)), _mm_setzero_si128());
+        return _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(q), scale), offset);
+    }
+
+    // Four unit vectors from octahedral coordinates, the same calculation as OctahedralDecode
+    inline void OctahedralDecode(__m128 u, __m128 v, __m128& x, __m128& y, __m128& z)
+    {
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        z = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_andnot_ps(sign, u)), _mm_andnot_ps(sign, v));
+        __m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+        x = _mm_sub_ps(u, _mm_or_ps(t, _mm_and_ps(u, sign)));
+        y = _mm_sub_ps(v, _mm_or_ps(t, _mm_and_ps(v, sign)));
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        x = _mm_div_ps(x, length);
+        y = _mm_div_ps(y, length);
+        z = _mm_div_ps(z, length);
+    }
+
+
+    // Decodes the vertex chunks of one vertex layout. The layout is a template parameter so the loops over components
+    // and floats are unrolled
+    template <bool TANGENTS, bool UVS>
+    struct VertexDecoder
+    {
+        static const unsigned int NUM_COMPONENTS = 5 + (TANGENTS ? 2 : 0) + (UVS ? 2 : 0);
+        static const unsigned int NUM_FLOATS     = 6 + (TANGENTS ? 3 : 0) + (UVS ? 2 : 0);
+        static const unsigned int NUM_ROWS       = (NUM_FLOATS + 3) / 4; // Four floats of a vertex written at a time
+
+        // Bytes used by the header of a block, a nibble per component
+        static const unsigned int HEADER_BYTES = (NUM_COMPONENTS + 1) / 2;
+
+        // Decode count vertices from [data, end) to output. Returns false if the data runs out
+        static bool DecodeChunk(const uint8_t* data, const uint8_t* end, uint32_t count, const float* scale,
+                                const float* offset, float* output)
+        {
+            __m128 scales[NUM_COMPONENTS], offsets[NUM_COMPONENTS];
+            for (unsigned int c = 0; c < NUM_COMPONENTS; ++c)
+            {
+                scales[c]  = _mm_set1_ps(scale[c]);
+                offsets[c] = _mm_set1_ps(offset[c]);
+            }
+
+            __m128i previous[NUM_COMPONENTS];
+            for (unsigned int c = 0; c < NUM_COMPONENTS; ++c)  previous[c] = _mm_setzero_si128();
+
+            // Full blocks are written straight to the output. The last block of the chunk goes through a temporary
+            // buffer, as writing a row of floats at a time can go past the last vertex
+            for (uint32_t block = 0; block < count; block += BLOCK)
+            {
+                if (static_cast<size_t>(end - data) < HEADER_BYTES)  return false;
+                const uint8_t* header = data;
+                data += HEADER_BYTES;
+
+                size_t blockBytes = 0;
+                for (unsigned int c = 0; c < NUM_COMPONENTS; ++c)
+                {
+                    unsigned int widths = (header[c / 2] >> ((c & 1) * 4)) & 15;
+                    blockBytes += GROUP_BYTES[widths & 3] + GROUP_BYTES[widths >> 2];
+                }
+                if (static_cast<size_t>(end - data) < blockBytes)  return false;
+
+                alignas(16) uint16_t values[NUM_COMPONENTS][BLOCK];
+                for (unsigned int c = 0; c < NUM_COMPONENTS; ++c)
+                {
+                    unsigned int widths = (header[c / 2] >> ((c & 1) * 4)) & 15;
+                    __m128i low  = UnpackGroup(data, widths & 3);
+                    __m128i high = UnpackGroup(data, widths >> 2);
+                    __m128i first  = UndoDeltas(_mm_unpacklo_epi8(low, high), previous[c]);
+                    __m128i second = UndoDeltas(_mm_unpackhi_epi8(low, high), first);
+                    previous[c] = second;
+                    _mm_store_si128(reinterpret_cast<__m128i*>(values[c]),     first);
+                    _mm_store_si128(reinterpret_cast<__m128i*>(values[c] + 8), second);
+                }
+
+                uint32_t blockCount = std::min(BLOCK, count - block);
+                float temporary[BLOCK * NUM_FLOATS + 4];
+                float* vertices = (block + BLOCK < count) ? output + block * NUM_FLOATS : temporary;
+                for (uint32_t v = 0; v < BLOCK; v += 4)
+                {
+                    __m128 floats[NUM_ROWS * 4];
+                    for (unsigned int c = 0; c < 3; ++c)  floats[c] = Dequantise(values[c] + v, scales[c], offsets[c]);
+                    OctahedralDecode(Dequantise(values[3] + v, scales[3], offsets[3]),
+                                     Dequantise(values[4] + v, scales[4], offsets[4]), floats[3], floats[4], floats[5]);
+                    unsigned int next = 6, component = 5;
+                    if (TANGENTS)
+                    {
+                        OctahedralDecode(Dequantise(values[5] + v, scales[5], offsets[5]),
+                                         Dequantise(values[6] + v, scales[6], offsets[6]), floats[6], floats[7], floats[8]);
+                        next = 9;
+                        component = 7;
+                    }
+                    if (UVS)
+                    {
+                        floats[next]     = Dequantise(values[component] + v,     scales[component],     offsets[component]);
+                        floats[next + 1] = Dequantise(values[component + 1] + v, scales[component + 1], offsets[component + 1]);
+                        next += 2;
+                    }
+                    for (; next < NUM_ROWS * 4; ++next)  floats[next] = _mm_setzero_ps();
+
+                    // Transpose each four floats of the four vertices into a row for each vertex. The rows of a vertex
+                    // are written in order, so a row that goes into the next vertex is overwritten by it
+                    for (unsigned int row = 0; row < NUM_ROWS; ++row)
+                    {
+                        _MM_TRANSPOSE4_PS(floats[row * 4], floats[row * 4 + 1], floats[row * 4 + 2], floats[row * 4 + 3]);
+                    }
+                    for (unsigned int vertex = 0; vertex < 4; ++vertex)
+                    {
+                        float* out = vertices + (v + vertex) * NUM_FLOATS;
+                        for (unsigned int row = 0; row < NUM_ROWS; ++row)  _mm_storeu_ps(out + row * 4, floats[row * 4 + vertex]);
+                    }
+                }
+                if (vertices == temporary)  std::memcpy(output + block * NUM_FLOATS, temporary, blockCount * NUM_FLOATS * 4);
+            }
+            return true;
+        }
+    };
+
+
+    // Decode count indices from [data, end) to output, numbering new vertices from nextVertex. Returns false if the data
+    // runs out or an index is not below numVertices
+    bool DecodeIndexChunk(const uint8_t* data, const uint8_t* end, uint32_t count, uint32_t nextVertex,
+                          uint32_t numVertices, uint32_t* output)
+    {
+        __m128i next  = _mm_set1_epi32(static_cast<int>(nextVertex));
+        __m128i lastVertex = _mm_set1_epi32(static_cast<int>(numVertices) - 1);
+        __m128i invalid = _mm_setzero_si128();
+        for (uint32_t block = 0; block < count; block += BLOCK)
+        {
+            if (data == end)  return false;
+            unsigned int widths = *data++;
+            if (static_cast<size_t>(end - data) < GROUP_BYTES[widths & 3] + GROUP_BYTES[(widths >> 2) & 3] +
+                                                  GROUP_BYTES[(widths >> 4) & 3] + GROUP_BYTES[widths >> 6])
+            {
+                return false;
+            }
+            __m128i plane0 = UnpackGroup(data, widths & 3);
+            __m128i plane1 = UnpackGroup(data, (widths >> 2) & 3);
+            __m128i plane2 = UnpackGroup(data, (widths >> 4) & 3);
+            __m128i plane3 = UnpackGroup(data, widths >> 6);
+            __m128i low0  = _mm_unpacklo_epi8(plane0, plane1);
+            __m128i low1  = _mm_unpackhi_epi8(plane0, plane1);
+            __m128i high0 = _mm_unpacklo_epi8(plane2, plane3);
+            __m128i high1 = _mm_unpackhi_epi8(plane2, plane3);
+            __m128i codes[4] = { _mm_unpacklo_epi16(low0, high0), _mm_unpackhi_epi16(low0, high0),
+                                 _mm_unpacklo_epi16(low1, high1), _mm_unpackhi_epi16(low1, high1) };
+
+            // A code of 0 is the next new vertex, the running count of zeros before each index gives its next vertex
+            // Indices are checked as signed values, so one below 0 from a code that is too big is caught as well
+            alignas(16) uint32_t indices[BLOCK];
+            __m128i blockInvalid = _mm_setzero_si128();
+            for (int i = 0; i < 4; ++i)
+            {
+                __m128i isNew = _mm_srli_epi32(_mm_cmpeq_epi32(codes[i], _mm_setzero_si128()), 31);
+                __m128i newBefore = _mm_slli_si128(isNew, 4);
+                newBefore = _mm_add_epi32(newBefore, _mm_slli_si128(newBefore, 4));
+                newBefore = _mm_add_epi32(newBefore, _mm_slli_si128(newBefore, 8));
+                __m128i index = _mm_sub_epi32(_mm_add_epi32(next, newBefore), codes[i]);
+                blockInvalid = _mm_or_si128(blockInvalid, _mm_or_si128(_mm_cmplt_epi32(index, _mm_setzero_si128()),
+                                                                       _mm_cmpgt_epi32(index, lastVertex)));
+                _mm_store_si128(reinterpret_cast<__m128i*>(indices + i * 4), index);
+
+                __m128i total = _mm_add_epi32(newBefore, isNew);
+                next = _mm_add_epi32(next, _mm_shuffle_epi32(total, 0xFF));
+            }
+
+            // Padding after the last index is neither checked nor written
+            uint32_t blockCount = std::min(BLOCK, count - block);
+            if (blockCount < BLOCK)
+            {
+                for (uint32_t i = 0; i < blockCount; ++i)
+                {
+                    if (indices[i] >= numVertices)  return false;
+                }
+                std::memcpy(output + block, indices, blockCount * 4);
+                break;
+            }
+            invalid = _mm_or_si128(invalid, blockInvalid);
+            std::memcpy(output + block, indices, sizeof(indices));
+        }
+        return _mm_movemask_epi8(invalid) == 0;
+    }
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Encoding
+//--------------------------------------------------------------------------------------
+
+// Compress a mesh, replacing the contents of output. The triangles and vertices of meshData are reordered first as
+// described in MeshCodec.h, so afterwards it holds what DecodeMesh gives back, apart from the quantisation
+void EncodeMesh(MeshData& meshData, const MeshCodecSettings& settings, std::vector<uint8_t>& output)
+{
+    MeshVertexLayout layout = GetMeshVertexLayout(meshData.flags);
+    uint32_t numVertices = meshData.numVertices;
+    uint32_t numIndices  = meshData.numIndices;
+    uint32_t* indices = reinterpret_cast<uint32_t*>(meshData.indices);
+
+    // Triangles in vertex cache order, then vertices in the order the triangles first use them with any unused ones
+    // at the end
+    OptimiseVertexCache(indices, numIndices, numVertices);
+    {
+        const uint32_t UNUSED = UINT32_MAX;
+        std::vector<uint32_t> remap(numVertices, UNUSED);
+        uint32_t next = 0;
+        for (uint32_t i = 0; i < numIndices; ++i)
+        {
+            if (remap[indices[i]] == UNUSED)  remap[indices[i]] = next++;
+            indices[i] = remap[indices[i]];
+        }
+        for (auto& vertex : remap)  if (vertex == UNUSED)  vertex = next++;
+
+        std::vector<unsigned char> original(meshData.vertices, meshData.vertices + static_cast<size_t>(numVertices) * layout.vertexSize);
+        for (uint32_t v = 0; v < numVertices; ++v)
+        {
+            std::memcpy(meshData.vertices + static_cast<size_t>(remap[v]) * layout.vertexSize,
+                        original.data() + static_cast<size_t>(v) * layout.vertexSize, layout.vertexSize);
+        }
+    }
+
+    // Quantise each component. Positions and UVs across their range, octahedral vectors from -1 to 1
+    CompressedMeshHeader header = {};
+    header.flags         = meshData.flags;
+    header.numVertices   = numVertices;
+    header.numIndices    = numIndices;
+    header.numComponents = NumComponents(meshData.flags);
+
+    std::vector<uint16_t> components[MESH_CODEC_MAX_COMPONENTS];
+    for (unsigned int c = 0; c < header.numComponents; ++c)  components[c].resize(numVertices);
+    auto vertexFloats = [&](uint32_t v, unsigned int offset)
+    {
+        return reinterpret_cast<const float*>(meshData.vertices + static_cast<size_t>(v) * layout.vertexSize + offset);
+    };
+
+    auto quantiseRange = [&](unsigned int component, unsigned int offset, unsigned int bits)
+    {
+        float minimum = 0, maximum = 0;
+        for (uint32_t v = 0; v < numVertices; ++v)
+        {
+            float value = *vertexFloats(v, offset);
+            minimum = (v == 0) ? value : std::min(minimum, value);
+            maximum = (v == 0) ? value : std::max(maximum, value);
+        }
+        float maxValue = static_cast<float>((1u << bits) - 1);
+        float scale = (maximum - minimum) / maxValue;
+        header.offset[component] = minimum;
+        header.scale[component]  = scale;
+        for (uint32_t v = 0; v < numVertices; ++v)
+        {
+            float q = (scale > 0) ? std::round((*vertexFloats(v, offset) - minimum) / scale) : 0.0f;
+            components[component][v] = static_cast<uint16_t>(std::min(std::max(q, 0.0f), maxValue));
+        }
+    };
+
+    auto quantiseOctahedral = [&](unsigned int component, unsigned int offset, unsigned int bits)
+    {
+        header.offset[component] = header.offset[component + 1] = -1.0f;
+        header.scale[component]  = header.scale[component + 1]  = 2.0f / static_cast<float>((1u << bits) - 1);
+        for (uint32_t v = 0; v < numVertices; ++v)
+        {
+            uint16_t q[2];
+            OctahedralEncode(vertexFloats(v, offset), bits, q);
+            components[component][v]     = q[0];
+            components[component + 1][v] = q[1];
+        }
+    };
+
+    unsigned int positionBits = std::min(std::max(settings.positionBits, 1u), 16u);
+    unsigned int normalBits   = std::min(std::max(settings.normalBits,   1u), 16u);
+    unsigned int uvBits       = std::min(std::max(settings.uvBits,       1u), 16u);
+    for (unsigned int c = 0; c < 3; ++c)  quantiseRange(c, layout.positionOffset + c * 4, positionBits);
+    quantiseOctahedral(3, layout.normalOffset, normalBits);
+    unsigned int component = 5;
+    if (meshData.flags & MeshHasTangents)
+    {
+        quantiseOctahedral(component, layout.tangentOffset, normalBits);
+        component += 2;
+    }
+    if (meshData.flags & MeshHasUVs)
+    {
+        quantiseRange(component,     layout.uvOffset,     uvBits);
+        quantiseRange(component + 1, layout.uvOffset + 4, uvBits);
+    }
+
+    // Header and chunk table, which is filled in as the chunks are written
+    uint32_t numVertexChunks = NumChunks(numVertices, VERTEX_CHUNK);
+    uint32_t numIndexChunks  = NumChunks(numIndices,  INDEX_CHUNK);
+    size_t tableStart = sizeof(header);
+    size_t baseStart  = tableStart + (numVertexChunks + numIndexChunks + 1) * 4;
+    output.assign(baseStart + numIndexChunks * 4, 0);
+    std::memcpy(output.data(), &header, sizeof(header));
+    auto setTableEntry = [&](size_t position, size_t value)
+    {
+        uint32_t value32 = static_cast<uint32_t>(value);
+        std::memcpy(output.data() + position, &value32, 4);
+    };
+
+    uint32_t chunk = 0;
+    for (uint32_t first = 0; first < numVertices; first += VERTEX_CHUNK, ++chunk)
+    {
+        setTableEntry(tableStart + chunk * 4, output.size());
+        EncodeVertexChunk(components, header.numComponents, first, std::min(VERTEX_CHUNK, numVertices - first), output);
+    }
+    uint32_t nextVertex = 0;
+    for (uint32_t first = 0; first < numIndices; first += INDEX_CHUNK, ++chunk)
+    {
+        setTableEntry(tableStart + chunk * 4, output.size());
+        setTableEntry(baseStart + (chunk - numVertexChunks) * 4, nextVertex);
+        EncodeIndexChunk(indices + first, std::min(INDEX_CHUNK, numIndices - first), nextVertex, output);
+    }
+    setTableEntry(tableStart + chunk * 4, output.size());
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Decoding
+//--------------------------------------------------------------------------------------
+
+// Decode a compressed mesh into a staging block from gMeshStagingPool, in the layout described in MeshImport.h. Uses
+// up to numThreads threads (0 for one per hardware thread) for meshes big enough to be worth splitting.
+// Will throw a std::runtime_error exception if the data is not a valid compressed mesh.
+void DecodeMesh(const uint8_t* data, size_t size, MeshData& meshData, unsigned int numThreads /*= 0*/)
+{
+    // Check the header and chunk table before trusting any of it
+    CompressedMeshHeader header;
+    if (size < sizeof(header))  throw std::runtime_error("Compressed mesh is truncated");
+    std::memcpy(&header, data, sizeof(header));
+    if ((header.flags & ~(MeshHasTangents | MeshHasUVs)) != 0 || header.numComponents != NumComponents(header.flags) ||
+        header.numVertices > INT32_MAX || header.numIndices % 3 != 0)
+    {
+        throw std::runtime_error("Compressed mesh has an invalid header");
+    }
+
+    uint32_t numVertexChunks = NumChunks(header.numVertices, VERTEX_CHUNK);
+    uint32_t numIndexChunks  = NumChunks(header.numIndices,  INDEX_CHUNK);
+    uint32_t numChunks = numVertexChunks + numIndexChunks;
+    size_t tableBytes = (static_cast<size_t>(numChunks) + 1 + numIndexChunks) * 4;
+    if (size - sizeof(header) < tableBytes)  throw std::runtime_error("Compressed mesh is truncated");
+    std::vector<uint32_t> table(numChunks + 1 + numIndexChunks);
+    std::memcpy(table.data(), data + sizeof(header), tableBytes);
+    for (uint32_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        if (table[chunk] > table[chunk + 1] || table[chunk + 1] > size)  throw std::runtime_error("Compressed mesh is truncated");
+    }
+
+    // Every block has a header, so the counts can't be more than the data holds. Checked before the staging memory
+    // is allocated
+    uint64_t minimumBytes = static_cast<uint64_t>(NumChunks(header.numVertices, BLOCK)) * ((header.numComponents + 1) / 2) +
+                            NumChunks(header.numIndices, BLOCK);
+    if (minimumBytes > size)  throw std::runtime_error("Compressed mesh is truncated");
+
+    MeshVertexLayout layout = GetMeshVertexLayout(header.flags);
+    meshData.flags       = header.flags;
+    meshData.vertexSize  = layout.vertexSize;
+    meshData.numVertices = header.numVertices;
+    meshData.numIndices  = header.numIndices;
+
+    size_t vertexBytes = static_cast<size_t>(header.numVertices) * layout.vertexSize;
+    meshData.staging  = gMeshStagingPool.Acquire(vertexBytes + static_cast<size_t>(header.numIndices) * 4);
+    meshData.vertices = meshData.staging.Data();
+    meshData.indices  = meshData.staging.Data() + vertexBytes;
+
+    auto decodeVertices = (header.flags == 0)                            ? &VertexDecoder<false, false>::DecodeChunk :
+                          (header.flags == MeshHasTangents)              ? &VertexDecoder<true,  false>::DecodeChunk :
+                          (header.flags == MeshHasUVs)                   ? &VertexDecoder<false, true>::DecodeChunk :
+                                                                           &VertexDecoder<true,  true>::DecodeChunk;
+    auto decodeChunk = [&](uint32_t chunk)
+    {
+        const uint8_t* start = data + table[chunk];
+        const uint8_t* end   = data + table[chunk + 1];
+        if (chunk < numVertexChunks)
+        {
+            uint32_t first = chunk * VERTEX_CHUNK;
+            float* output = reinterpret_cast<float*>(meshData.vertices + static_cast<size_t>(first) * layout.vertexSize);
+            return decodeVertices(start, end, std::min(VERTEX_CHUNK, header.numVertices - first), header.scale,
+                                  header.offset, output);
+        }
+        uint32_t indexChunk = chunk - numVertexChunks;
+        uint32_t first = indexChunk * INDEX_CHUNK;
+        return DecodeIndexChunk(start, end, std::min(INDEX_CHUNK, header.numIndices - first),
+                                table[numChunks + 1 + indexChunk], header.numVertices,
+                                reinterpret_cast<uint32_t*>(meshData.indices) + first);
+    };
+
+    // Each thread takes the next chunk until there are none left
+    unsigned int maxThreads = numChunks / MIN_CHUNKS_PER_THREAD;
+    if (numThreads == 0 && maxThreads > 1)  numThreads = std::thread::hardware_concurrency();
+    numThreads = std::max(1u, std::min(numThreads, maxThreads));
+    std::atomic<uint32_t> nextChunk(0);
+    std::atomic<bool> valid(true);
+    auto worker = [&]()
+    {
+        for (uint32_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++)
+        {
+            if (!decodeChunk(chunk))  valid = false;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int thread = 1; thread < numThreads; ++thread)  threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)  thread.join();
+
+    if (!valid)
+    {
+        meshData.staging.Release();
+        throw std::runtime_error("Compressed mesh data is invalid");
+    }
+}
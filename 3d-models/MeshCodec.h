@@ -0,0 +1,59 @@
+//--------------------------------------------------------------------------------------
+// Mesh compression
+//--------------------------------------------------------------------------------------
+// Compresses meshes for the asset package and decodes them straight into a MeshData staging
+// block. Triangles are put in vertex cache order and indices stored relative to the next new
+// vertex. Vertices are quantised (normals octahedral), delta coded and split into bit-packed
+// byte planes. Decoding uses SSE2 on several threads. Vertices are lossy, triangles exact.
+
+#ifndef _MESH_CODEC_H_INCLUDED_
+#define _MESH_CODEC_H_INCLUDED_
+
+#include "MeshImport.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+// Precision of the vertex data, each 1 to 16 bits per component. Positions and UVs are spread over the range of the
+// mesh's values, so the largest error is half that range divided by 2^bits - 1. The octahedral normals and tangents
+// are accurate to about 0.05 degrees at 12 bits
+struct MeshCodecSettings
+{
+    unsigned int positionBits = 16;
+    unsigned int normalBits   = 12; // Also used for tangents
+    unsigned int uvBits       = 16;
+};
+
+
+// Most quantised components in a vertex: position, normal, tangent and UV
+const unsigned int MESH_CODEC_MAX_COMPONENTS = 9;
+
+// Header at the start of a compressed mesh. It is followed by the offsets of the vertex chunks, the offsets of the
+// index chunks and the offset of the end of the data (all from the start of the header), then by the first vertex
+// number of each index chunk, then by the chunks
+struct CompressedMeshHeader
+{
+    uint32_t flags;       // MeshFlags of the decoded vertices
+    uint32_t numVertices;
+    uint32_t numIndices;
+    uint32_t numComponents;
+
+    // Each quantised value q decodes to q * scale + offset
+    float offset[MESH_CODEC_MAX_COMPONENTS];
+    float scale[MESH_CODEC_MAX_COMPONENTS];
+};
+
+
+// Compress a mesh, replacing the contents of output. The triangles and vertices of meshData are reordered first as
+// described above, so afterwards it holds what DecodeMesh gives back, apart from the quantisation
+void EncodeMesh(MeshData& meshData, const MeshCodecSettings& settings, std::vector<uint8_t>& output);
+
+// Decode a compressed mesh into a staging block from gMeshStagingPool, in the layout described in MeshImport.h. Uses
+// up to numThreads threads (0 for one per hardware thread) for meshes big enough to be worth splitting.
+// Will throw a std::runtime_error exception if the data is not a valid compressed mesh.
+void DecodeMesh(const uint8_t* data, size_t size, MeshData& meshData, unsigned int numThreads = 0);
+
+
+#endif //_MESH_CODEC_H_INCLUDED_
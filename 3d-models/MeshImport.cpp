@@ -0,0 +1,222 @@
+//--------------------------------------------------------------------------------------
+// CPU-side mesh import
+//--------------------------------------------------------------------------------------
+// Converts a mesh file into vertex and index data in exactly the layout used by the GPU
+// buffers of the Mesh class. Kept separate from the Mesh class (and free of any DirectX
+// code) so the offline AssetCooker tool can use the same import as the app.
+// ** THIS VERSION WILL ONLY KEEP THE FIRST SUB-MESH OTHER PARTS WILL BE MISSING **
+
+#include "MeshImport.h"
+#include "GlbImport.h"
+#include "CVector2.h"
+#include "CVector3.h"
+#include "MappedIOSystem.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+
+
+namespace
+{
+    // Whether a file name ends with the given lower case extension, ignoring case
+    bool HasExtension(const std::string& fileName, const char* extension)
+    {
+        size_t length = std::char_traits<char>::length(extension);
+        if (fileName.size() < length)  return false;
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (std::tolower(static_cast<unsigned char>(fileName[fileName.size() - length + i])) != extension[i])  return false;
+        }
+        return true;
+    }
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Import
+//--------------------------------------------------------------------------------------
+
+// Import the given mesh file using assimp (http://www.assimp.org/), which supports many file types
+// Optionally request tangents to be calculated (for normal and parallax mapping - see later lab)
+// Files are read through memory mappings unless useMappedIO is false, which selects assimp's default file access
+// Binary glTF (.glb) files are read with the native importer in GlbImport.h instead of assimp, unless useMappedIO is false
+// Will throw a std::runtime_error exception on failure.
+void ImportMesh(const std::string& fileName, bool requireTangents, MeshData& meshData, bool useMappedIO /*= true*/)
+{
+    if (useMappedIO && HasExtension(fileName, ".glb"))
+    {
+        ImportGlbMesh(fileName, requireTangents, meshData);
+        return;
+    }
+
+    Assimp::Importer importer;
+    if (useMappedIO)  importer.SetIOHandler(new MappedIOSystem); // Importer takes ownership
+
+    // Flags for processing the mesh. Assimp provides a huge amount of control - right click any of these
+    // and "Peek Definition" to see documention above each constant
+    unsigned int assimpFlags = aiProcess_MakeLeftHanded |
+                               aiProcess_GenSmoothNormals |
+                               aiProcess_FixInfacingNormals |
+                               aiProcess_GenUVCoords |
+                               aiProcess_TransformUVCoords |
+                               aiProcess_FlipUVs |
+                               aiProcess_FlipWindingOrder |
+                               aiProcess_Triangulate |
+                               aiProcess_PreTransformVertices |
+                               aiProcess_JoinIdenticalVertices |
+                               aiProcess_ImproveCacheLocality |
+                               aiProcess_SortByPType |
+                               aiProcess_FindInvalidData |
+                               aiProcess_OptimizeMeshes |
+                               aiProcess_FindInstances |
+                               aiProcess_FindDegenerates |
+                               aiProcess_RemoveRedundantMaterials |
+                               aiProcess_Debone |
+                               aiProcess_RemoveComponent;
+
+    // Flags to specify what mesh data to ignore
+    int removeComponents = aiComponent_LIGHTS | aiComponent_CAMERAS | aiComponent_TEXTURES | aiComponent_COLORS |
+                           aiComponent_BONEWEIGHTS | aiComponent_ANIMATIONS | aiComponent_MATERIALS;
+
+    // Add / remove tangents as required by user
+    if (requireTangents)
+    {
+        assimpFlags |= aiProcess_CalcTangentSpace;
+    }
+    else
+    {
+        removeComponents |= aiComponent_TANGENTS_AND_BITANGENTS;
+    }
+
+    // Other miscellaneous settings
+    importer.SetPropertyFloat(AI_CONFIG_PP_GSN_MAX_SMOOTHING_ANGLE, 80.0f); // Smoothing angle for normals
+    importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);  // Remove points and lines (keep triangles only)
+    importer.SetPropertyBool(AI_CONFIG_PP_FD_REMOVE, true);                 // Remove degenerate triangles
+    importer.SetPropertyBool(AI_CONFIG_PP_DB_ALL_OR_NONE, true);            // Default to removing bones/weights from meshes that don't need skinning
+
+    importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, removeComponents);
+
+    // Import mesh with assimp given above requirements. Logging is left to the caller as assimp's logger is global
+    const aiScene* scene = importer.ReadFile(fileName, assimpFlags);
+    if (scene == nullptr)  throw std::runtime_error("Error loading mesh (" + fileName + "). " + importer.GetErrorString());
+    if (scene->mNumMeshes == 0)  throw std::runtime_error("No usable geometry in mesh: " + fileName);
+
+
+    //-----------------------------------
+
+    // Only importing first submesh - significant limitation - do not use this importer for your own projects
+    aiMesh* assimpMesh = scene->mMeshes[0];
+    std::string subMeshName = assimpMesh->mName.C_Str();
+
+
+    //-----------------------------------
+
+    // Check for presence of position and normal data. Tangents and UVs are optional.
+    if (!assimpMesh->HasPositions())  throw std::runtime_error("No position data for sub-mesh " + subMeshName + " in " + fileName);
+    if (!assimpMesh->HasNormals())  throw std::runtime_error("No normal data for sub-mesh " + subMeshName + " in " + fileName);
+
+    unsigned int flags = 0;
+    if (requireTangents)
+    {
+        if (!assimpMesh->HasTangentsAndBitangents())  throw std::runtime_error("No tangent data for sub-mesh " + subMeshName + " in " + fileName);
+        flags |= MeshHasTangents;
+    }
+
+    if (assimpMesh->GetNumUVChannels() > 0 && assimpMesh->HasTextureCoords(0))
+    {
+        if (assimpMesh->mNumUVComponents[0] != 2)  throw std::runtime_error("Unsupported texture coordinates in " + subMeshName + " in " + fileName);
+        flags |= MeshHasUVs;
+    }
+
+    if (!assimpMesh->HasFaces())  throw std::runtime_error("No face data in " + subMeshName + " in " + fileName);
+
+    MeshVertexLayout layout = GetMeshVertexLayout(flags);
+
+
+    //-----------------------------------
+
+    // Get a CPU-side block to hold the mesh data - exact content is flexible so can't use a structure for a vertex - so just a block
+    // of bytes. The vertices and indices share one block, sized up front so everything below is written straight into place
+    meshData.flags       = flags;
+    meshData.vertexSize  = layout.vertexSize;
+    meshData.numVertices = assimpMesh->mNumVertices;
+    meshData.numIndices  = assimpMesh->mNumFaces * 3;
+    size_t vertexBytes = static_cast<size_t>(meshData.numVertices) * meshData.vertexSize;
+    size_t indexBytes  = static_cast<size_t>(meshData.numIndices) * 4; // Using 32 bit indexes (4 bytes) for each index
+    meshData.staging  = gMeshStagingPool.Acquire(vertexBytes + indexBytes);
+    meshData.vertices = meshData.staging.Data();
+    meshData.indices  = meshData.staging.Data() + vertexBytes; // Vertex size is a multiple of 4 so the indices are aligned
+
+    const unsigned int vertexSize = meshData.vertexSize;
+    unsigned char* vertices = meshData.vertices;
+
+
+    //-----------------------------------
+
+    // Copy mesh data from assimp to our CPU-side vertex buffer
+
+    CVector3* assimpPosition = reinterpret_cast<CVector3*>(assimpMesh->mVertices);
+    unsigned char* position = vertices + layout.positionOffset;
+    unsigned char* positionEnd = position + meshData.numVertices * vertexSize;
+    while (position != positionEnd)
+    {
+        *(CVector3*)position = *assimpPosition;
+        position += vertexSize;
+        ++assimpPosition;
+    }
+
+    CVector3* assimpNormal = reinterpret_cast<CVector3*>(assimpMesh->mNormals);
+    unsigned char* normal = vertices + layout.normalOffset;
+    unsigned char* normalEnd = normal + meshData.numVertices * vertexSize;
+    while (normal != normalEnd)
+    {
+        *(CVector3*)normal = *assimpNormal;
+        normal += vertexSize;
+        ++assimpNormal;
+    }
+
+    if (flags & MeshHasTangents)
+    {
+      CVector3* assimpTangent = reinterpret_cast<CVector3*>(assimpMesh->mTangents);
+      unsigned char* tangent =  vertices + layout.tangentOffset;
+      unsigned char* tangentEnd = tangent + meshData.numVertices * vertexSize;
+      while (tangent != tangentEnd)
+      {
+        *(CVector3*)tangent = *assimpTangent;
+        tangent += vertexSize;
+        ++assimpTangent;
+      }
+    }
+
+    if (flags & MeshHasUVs)
+    {
+        aiVector3D* assimpUV = assimpMesh->mTextureCoords[0];
+        unsigned char* uv = vertices + layout.uvOffset;
+        unsigned char* uvEnd = uv + meshData.numVertices * vertexSize;
+        while (uv != uvEnd)
+        {
+            *(CVector2*)uv = CVector2(assimpUV->x, assimpUV->y);
+            uv += vertexSize;
+            ++assimpUV;
+        }
+    }
+
+
+    //-----------------------------------
+
+    // Copy face data from assimp to our CPU-side index buffer
+    uint32_t* index = reinterpret_cast<uint32_t*>(meshData.indices);
+    for (unsigned int face = 0; face < assimpMesh->mNumFaces; ++face)
+    {
+        *index++ = assimpMesh->mFaces[face].mIndices[0];
+        *index++ = assimpMesh->mFaces[face].mIndices[1];
+        *index++ = assimpMesh->mFaces[face].mIndices[2];
+    }
+}
@@ -0,0 +1,156 @@
+//--------------------------------------------------------------------------------------
+// CPU-side mesh import
+//--------------------------------------------------------------------------------------
+// Converts a mesh file into vertex and index data in exactly the layout used by the GPU
+// buffers of the Mesh class. Kept separate from the Mesh class (and free of any DirectX
+// code) so the offline AssetCooker tool can use the same import as the app.
+// ** THIS VERSION WILL ONLY KEEP THE FIRST SUB-MESH OTHER PARTS WILL BE MISSING **
+
+#ifndef _MESH_IMPORT_H_INCLUDED_
+#define _MESH_IMPORT_H_INCLUDED_
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+
+// Optional parts of the vertex layout. Every vertex has a position and a normal (12 bytes each),
+// then a tangent (12 bytes) if MeshHasTangents is set, then a UV (8 bytes) if MeshHasUVs is set
+enum MeshFlags
+{
+    MeshHasTangents = 1,
+    MeshHasUVs      = 2,
+};
+
+// Byte offsets of each element within a vertex and the total vertex size for the given flags
+struct MeshVertexLayout
+{
+    unsigned int positionOffset;
+    unsigned int normalOffset;
+    unsigned int tangentOffset; // Only meaningful with MeshHasTangents
+    unsigned int uvOffset;      // Only meaningful with MeshHasUVs
+    unsigned int vertexSize;
+};
+MeshVertexLayout GetMeshVertexLayout(unsigned int flags);
+
+
+//--------------------------------------------------------------------------------------
+// Staging memory
+//--------------------------------------------------------------------------------------
+// Along with GetMeshVertexLayout these are in MeshStaging.cpp, which doesn't need assimp
+
+class MeshStagingPool;
+
+// A block of staging memory from a MeshStagingPool, given back to the pool when destroyed or released. Can be moved
+// but not copied
+class MeshStagingBuffer
+{
+public:
+    MeshStagingBuffer() = default;
+    ~MeshStagingBuffer()  { Release(); }
+
+    MeshStagingBuffer(MeshStagingBuffer&& other) noexcept;
+    MeshStagingBuffer& operator=(MeshStagingBuffer&& other) noexcept;
+    MeshStagingBuffer(const MeshStagingBuffer&) = delete;
+    MeshStagingBuffer& operator=(const MeshStagingBuffer&) = delete;
+
+    // Give the memory back to the pool now, e.g. as soon as it has been copied to the GPU
+    void Release();
+
+    unsigned char* Data()      { return mData; }
+    size_t         Capacity()  { return mCapacity; }
+
+private:
+    friend class MeshStagingPool;
+
+    MeshStagingPool* mPool     = nullptr;
+    unsigned char*   mData     = nullptr;
+    size_t           mCapacity = 0;
+};
+
+
+// Counts of a MeshStagingPool
+struct MeshStagingStats
+{
+    uint64_t acquires;
+    uint64_t reuses;        // Acquires given a kept block rather than a new one
+    size_t   keptBytes;     // Size of the blocks held for reuse now
+    size_t   peakLiveBytes; // Most staging memory in use by imports at once
+};
+
+
+// Keeps the staging blocks of finished imports and hands them to later imports, so loading many meshes doesn't
+// allocate, page in and free a large block for each one. Blocks are not cleared, the import overwrites all of them.
+// Thread-safe
+class MeshStagingPool
+{
+public:
+    // At most maxKeptBytes of unused blocks are kept, larger ones are freed when released
+    explicit MeshStagingPool(size_t maxKeptBytes);
+    ~MeshStagingPool()  { Trim(); }
+
+    // A block of at least the given size, the smallest kept block that is big enough or a new one
+    MeshStagingBuffer Acquire(size_t bytes);
+
+    // Free the kept blocks, e.g. when loading is finished
+    void Trim();
+
+    MeshStagingStats Stats();
+
+private:
+    friend class MeshStagingBuffer;
+
+    struct Block
+    {
+        unsigned char* data;
+        size_t         capacity;
+    };
+
+    void Release(unsigned char* data, size_t capacity);
+
+    size_t             mMaxKeptBytes;
+    std::mutex         mMutex;
+    std::vector<Block> mKept;
+    size_t             mLiveBytes = 0;
+    MeshStagingStats   mStats = {};
+};
+
+// Shared by all imports
+extern MeshStagingPool gMeshStagingPool;
+
+
+
+//--------------------------------------------------------------------------------------
+// Import
+//--------------------------------------------------------------------------------------
+
+// Vertex and index data for a single mesh, 32-bit indices for a triangle list
+struct MeshData
+{
+    unsigned int flags       = 0;
+    unsigned int vertexSize  = 0;
+    unsigned int numVertices = 0;
+    unsigned int numIndices  = 0;
+
+    // The vertices followed by the indices in a single block from gMeshStagingPool, sized up front so the import writes
+    // every value straight into its final place. The pointers are into this block
+    MeshStagingBuffer staging;
+    unsigned char*    vertices = nullptr;
+    unsigned char*    indices  = nullptr;
+};
+
+
+// Import the given mesh file using assimp (http://www.assimp.org/), which supports many file types. Assimp's copy of the
+// mesh is freed before returning, so only the staging block is left
+// Optionally request tangents to be calculated (for normal and parallax mapping - see later lab)
+// Files are read through memory mappings (see MappedIOSystem.h) unless useMappedIO is false, which selects assimp's
+// default stdio based file access (only useful for comparing the two).
+// Binary glTF (.glb) files are read with the native importer in GlbImport.h instead of assimp, unless useMappedIO is
+// false, which again gives assimp's import for comparison.
+// Will throw a std::runtime_error exception on failure.
+void ImportMesh(const std::string& fileName, bool requireTangents, MeshData& meshData, bool useMappedIO = true);
+
+
+#endif //_MESH_IMPORT_H_INCLUDED_
@@ -0,0 +1,560 @@
+//--------------------------------------------------------------------------------------
+// Procedural mesh primitives
+//--------------------------------------------------------------------------------------
+
+#include "MeshPrimitives.h"
+#include "CVector3.h"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace
+{
+    // Writes the vertices and indices of a primitive into a MeshData's staging block in the vertex layout of MeshImport.h
+    class PrimitiveWriter
+    {
+    public:
+        PrimitiveWriter(MeshData& meshData, uint32_t numVertices, uint32_t numIndices, bool requireTangents)
+            : mMeshData(meshData)
+        {
+            meshData.flags       = MeshHasUVs | (requireTangents ? MeshHasTangents : 0);
+            mLayout              = GetMeshVertexLayout(meshData.flags);
+            meshData.vertexSize  = mLayout.vertexSize;
+            meshData.numVertices = numVertices;
+            meshData.numIndices  = numIndices;
+
+            size_t vertexBytes = static_cast<size_t>(numVertices) * mLayout.vertexSize;
+            meshData.staging  = gMeshStagingPool.Acquire(vertexBytes + static_cast<size_t>(numIndices) * 4);
+            meshData.vertices = meshData.staging.Data();
+            meshData.indices  = meshData.staging.Data() + vertexBytes;
+            mVertex = meshData.vertices;
+            mIndex  = reinterpret_cast<uint32_t*>(meshData.indices);
+        }
+
+        // Write the next vertex, returns its index
+        uint32_t Vertex(const CVector3& position, const CVector3& normal, const CVector3& tangent, float u, float v)
+        {
+            float uv[2] = { u, v };
+            std::memcpy(mVertex + mLayout.positionOffset, &position, sizeof(CVector3));
+            std::memcpy(mVertex + mLayout.normalOffset,   &normal,   sizeof(CVector3));
+            if (mMeshData.flags & MeshHasTangents)  std::memcpy(mVertex + mLayout.tangentOffset, &tangent, sizeof(CVector3));
+            std::memcpy(mVertex + mLayout.uvOffset, uv, sizeof(uv));
+            mVertex += mLayout.vertexSize;
+            return mNextVertex++;
+        }
+
+        void Triangle(uint32_t a, uint32_t b, uint32_t c)
+        {
+            *mIndex++ = a;
+            *mIndex++ = b;
+            *mIndex++ = c;
+        }
+
+        // Two triangles for each square of a grid of vertices written a row at a time, (columns + 1) vertices in each of
+        // (rows + 1) rows starting at vertex first. Seen from the front, U (along a row) must be to the left of the
+        // direction from one row to the next, e.g. left to right along rows that go down
+        void Grid(uint32_t first, uint32_t columns, uint32_t rows)
+        {
+            for (uint32_t row = 0; row < rows; ++row)
+            {
+                for (uint32_t column = 0; column < columns; ++column)
+                {
+                    uint32_t v00 = first + row * (columns + 1) + column;
+                    uint32_t v10 = v00 + columns + 1;
+                    Triangle(v00, v00 + 1, v10);
+                    Triangle(v10, v00 + 1, v10 + 1);
+                }
+            }
+        }
+
+        uint32_t NumVertices() const  { return mNextVertex; }
+
+        // Check everything was written and put the triangles in vertex cache order
+        void Finish()
+        {
+            uint32_t* indices = reinterpret_cast<uint32_t*>(mMeshData.indices);
+            mMeshData.numVertices = mNextVertex;
+            mMeshData.numIndices  = static_cast<unsigned int>(mIndex - indices);
+            OptimiseVertexCache(indices, mMeshData.numIndices, mMeshData.numVertices);
+        }
+
+    private:
+        MeshData&        mMeshData;
+        MeshVertexLayout mLayout;
+        unsigned char*   mVertex;
+        uint32_t*        mIndex;
+        uint32_t         mNextVertex = 0;
+    };
+
+
+    // Direction of increasing U around the Y axis at the given angle, the tangent of the shapes that go round the Y axis
+    CVector3 TangentAroundY(float angle)
+    {
+        return { -std::sin(angle), 0, std::cos(angle) };
+    }
+
+
+    //--------------------------------------------------------------------------------------
+    // Vertex cache optimisation scores (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation")
+    //--------------------------------------------------------------------------------------
+
+    const int   CACHE_SIZE          = 32;    // Size of the cache modelled, larger than most GPUs' so it suits any of them
+    const float CACHE_DECAY_POWER   = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f; // Vertices of the last triangle, slightly less than the top of the cache
+    const float VALENCE_BOOST_SCALE = 2.0f;  // Favours vertices with few triangles left, to finish them off
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    float VertexScore(int cachePosition, uint32_t trianglesLeft)
+    {
+        if (trianglesLeft == 0)  return -1.0f;
+
+        float score = 0;
+        if (cachePosition >= 3)
+        {
+            score = std::pow(1.0f - (cachePosition - 3) / static_cast<float>(CACHE_SIZE - 3), CACHE_DECAY_POWER);
+        }
+        else if (cachePosition >= 0)
+        {
+            score = LAST_TRIANGLE_SCORE;
+        }
+        return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(trianglesLeft), -VALENCE_BOOST_POWER);
+    }
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Primitives
+//--------------------------------------------------------------------------------------
+
+// Sphere with segments around the equator and rings from pole to pole, centred on the origin with the poles on the Y
+// axis. U goes once around the equator, V from the top pole to the bottom one. Needs at least 3 segments and 2 rings
+void GenerateUVSphere(float radius, unsigned int segments, unsigned int rings, bool requireTangents, MeshData& meshData)
+{
+    segments = std::max(segments, 3u);
+    rings    = std::max(rings, 2u);
+
+    // A row of vertices for each ring edge including the poles, with the first column repeated at the end for the U seam.
+    // The repeat is placed at the first column's angle rather than a whole turn round, so the positions either side of
+    // the seam are exactly equal and the mesh welds closed. Each pole vertex has the U of the middle of its segment, the
+    // triangle next to it is the only one using it
+    PrimitiveWriter writer(meshData, (rings + 1) * (segments + 1), segments * (rings - 1) * 6, requireTangents);
+    for (unsigned int ring = 0; ring <= rings; ++ring)
+    {
+        float v = static_cast<float>(ring) / rings;
+        float latitude = PI * v;
+        for (unsigned int segment = 0; segment <= segments; ++segment)
+        {
+            bool pole = (ring == 0 || ring == rings);
+            float u = (segment + (pole ? 0.5f : 0.0f)) / segments;
+            float longitude = 2 * PI * (pole ? u : static_cast<float>(segment % segments) / segments);
+            CVector3 normal = { std::sin(latitude) * std::cos(longitude), std::cos(latitude), std::sin(latitude) * std::sin(longitude) };
+            if (pole)  normal = { 0, ring == 0 ? 1.0f : -1.0f, 0 };
+            writer.Vertex(radius * normal, normal, TangentAroundY(longitude), u, v);
+        }
+    }
+
+    // As PrimitiveWriter::Grid, leaving out the triangles that would have two corners at a pole
+    for (unsigned int ring = 0; ring < rings; ++ring)
+    {
+        for (unsigned int segment = 0; segment < segments; ++segment)
+        {
+            uint32_t v00 = ring * (segments + 1) + segment;
+            uint32_t v10 = v00 + segments + 1;
+            if (ring != 0)          writer.Triangle(v00, v00 + 1, v10);
+            if (ring != rings - 1)  writer.Triangle(v10, v00 + 1, v10 + 1);
+        }
+    }
+    writer.Finish();
+}
+
+
+// Sphere made by dividing each triangle of an icosahedron into four the given number of times (0 is an icosahedron),
+// which spreads the triangles more evenly than a UV sphere. UVs as for the UV sphere
+void GenerateIcoSphere(float radius, unsigned int subdivisions, bool requireTangents, MeshData& meshData)
+{
+    // Icosahedron, corners at (0, +-1, +-g), (+-1, +-g, 0), (+-g, 0, +-1) for the golden ratio g
+    const float g = (1 + std::sqrt(5.0f)) / 2;
+    std::vector<CVector3> positions =
+    {
+        { -1,  g,  0 }, {  1,  g,  0 }, { -1, -g,  0 }, {  1, -g,  0 },
+        {  0, -1,  g }, {  0,  1,  g }, {  0, -1, -g }, {  0,  1, -g },
+        {  g,  0, -1 }, {  g,  0,  1 }, { -g,  0, -1 }, { -g,  0,  1 },
+    };
+    for (auto& position : positions)  position = Normalise(position);
+    std::vector<uint32_t> triangles =
+    {
+        0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+        1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+        3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+        4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1,
+    };
+
+    // Split each triangle into four, sharing the new vertex in the middle of each edge with the triangle on the other side
+    for (unsigned int level = 0; level < subdivisions; ++level)
+    {
+        std::unordered_map<uint64_t, uint32_t> midpoints;
+        auto midpoint = [&](uint32_t a, uint32_t b)
+        {
+            uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+            auto found = midpoints.find(key);
+            if (found != midpoints.end())  return found->second;
+            positions.push_back(Normalise(positions[a] + positions[b]));
+            uint32_t index = static_cast<uint32_t>(positions.size() - 1);
+            midpoints[key] = index;
+            return index;
+        };
+
+        std::vector<uint32_t> divided;
+        divided.reserve(triangles.size() * 4);
+        for (size_t i = 0; i < triangles.size(); i += 3)
+        {
+            uint32_t a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+            uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            uint32_t split[12] = { a, ab, ca,   ab, b, bc,   ca, bc, c,   ab, bc, ca };
+            divided.insert(divided.end(), split, split + 12);
+        }
+        triangles.swap(divided);
+    }
+
+    // Spherical UVs. The U seam is where U goes from 1 back to 0: triangles across it get copies of their vertices on the
+    // 0 side with 1 added to U. Vertices exactly on a pole take the U of the rest of their triangle, so they are copied
+    // for each triangle
+    struct SphereVertex
+    {
+        CVector3 position;
+        float    u, v;
+    };
+    std::vector<SphereVertex> vertices;
+    vertices.reserve(positions.size() * 2);
+    for (auto& position : positions)
+    {
+        float u = std::atan2(position.z, position.x) / (2 * PI);
+        if (u < 0)  u += 1;
+        vertices.push_back({ position, u, std::acos(std::max(-1.0f, std::min(1.0f, position.y))) / PI });
+    }
+
+    std::unordered_map<uint32_t, uint32_t> seamCopies;
+    for (size_t i = 0; i < triangles.size(); i += 3)
+    {
+        uint32_t* corner = &triangles[i];
+
+        // Clockwise seen from outside
+        CVector3 p0 = vertices[corner[0]].position;
+        if (Dot(Cross(vertices[corner[1]].position - p0, vertices[corner[2]].position - p0), p0) < 0)  std::swap(corner[1], corner[2]);
+
+        float minU = 1, maxU = 0;
+        for (int c = 0; c < 3; ++c)
+        {
+            const CVector3& p = vertices[corner[c]].position;
+            if (std::fabs(p.x) + std::fabs(p.z) < 1e-6f)  continue;
+            minU = std::min(minU, vertices[corner[c]].u);
+            maxU = std::max(maxU, vertices[corner[c]].u);
+        }
+        bool acrossSeam = maxU - minU > 0.5f;
+        for (int c = 0; c < 3; ++c)
+        {
+            const CVector3& p = vertices[corner[c]].position;
+            if (acrossSeam && vertices[corner[c]].u < 0.5f && std::fabs(p.x) + std::fabs(p.z) >= 1e-6f)
+            {
+                auto found = seamCopies.find(corner[c]);
+                if (found == seamCopies.end())
+                {
+                    vertices.push_back({ p, vertices[corner[c]].u + 1, vertices[corner[c]].v });
+                    found = seamCopies.emplace(corner[c], static_cast<uint32_t>(vertices.size() - 1)).first;
+                }
+                corner[c] = found->second;
+            }
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            const CVector3& p = vertices[corner[c]].position;
+            if (std::fabs(p.x) + std::fabs(p.z) < 1e-6f)
+            {
+                float u = 0;
+                for (int other = 0; other < 3; ++other)  if (other != c)  u += vertices[corner[other]].u / 2;
+                vertices.push_back({ p, acrossSeam && u < 0.5f ? u + 1 : u, vertices[corner[c]].v });
+                corner[c] = static_cast<uint32_t>(vertices.size() - 1);
+            }
+        }
+    }
+
+    PrimitiveWriter writer(meshData, static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(triangles.size()), requireTangents);
+    for (auto& vertex : vertices)
+    {
+        writer.Vertex(radius * vertex.position, vertex.position, TangentAroundY(2 * PI * vertex.u), vertex.u, vertex.v);
+    }
+    for (size_t i = 0; i < triangles.size(); i += 3)  writer.Triangle(triangles[i], triangles[i + 1], triangles[i + 2]);
+    writer.Finish();
+}
+
+
+// Box centred on the origin with each face divided into segments x segments squares. Each face has UVs from 0 to 1
+void GenerateBox(const CVector3& size, unsigned int segments, bool requireTangents, MeshData& meshData)
+{
+    segments = std::max(segments, 1u);
+
+    // Each face's outward normal, then the directions U and V increase in across it (V goes down the sides)
+    struct BoxFace
+    {
+        CVector3 normal, uAxis, vAxis;
+    };
+    const BoxFace faces[6] =
+    {
+        { {  0,  0, -1 }, {  1, 0,  0 }, { 0, -1,  0 } },
+        { {  1,  0,  0 }, {  0, 0,  1 }, { 0, -1,  0 } },
+        { {  0,  0,  1 }, { -1, 0,  0 }, { 0, -1,  0 } },
+        { { -1,  0,  0 }, {  0, 0, -1 }, { 0, -1,  0 } },
+        { {  0,  1,  0 }, {  1, 0,  0 }, { 0,  0, -1 } },
+        { {  0, -1,  0 }, {  1, 0,  0 }, { 0,  0,  1 } },
+    };
+
+    // Positions are worked out from whole numbers of segments from the -X -Y -Z corner, the same way on every face, so
+    // the vertices along an edge shared by two faces are exactly equal and the mesh welds closed
+    auto position = [&](const CVector3& steps)
+    {
+        return CVector3{ (steps.x / segments - 0.5f) * size.x, (steps.y / segments - 0.5f) * size.y,
+                         (steps.z / segments - 0.5f) * size.z };
+    };
+
+    PrimitiveWriter writer(meshData, 6 * (segments + 1) * (segments + 1), 6 * segments * segments * 6, requireTangents);
+    for (auto& face : faces)
+    {
+        // The face's first corner (U and V of 0) in segments
+        CVector3 corner = (0.5f * segments) * (CVector3{ 1, 1, 1 } + face.normal - face.uAxis - face.vAxis);
+
+        uint32_t first = writer.NumVertices();
+        for (unsigned int row = 0; row <= segments; ++row)
+        {
+            float v = static_cast<float>(row) / segments;
+            for (unsigned int column = 0; column <= segments; ++column)
+            {
+                float u = static_cast<float>(column) / segments;
+                CVector3 steps = corner + static_cast<float>(column) * face.uAxis + static_cast<float>(row) * face.vAxis;
+                writer.Vertex(position(steps), face.normal, face.uAxis, u, v);
+            }
+        }
+        writer.Grid(first, segments, segments);
+    }
+    writer.Finish();
+}
+
+
+// Flat plane facing up (+Y) through the origin, width along X and depth along Z, divided into the given number of
+// squares in each direction. UVs go from 0 to uvRepeat across the plane, so a texture repeats that many times
+void GeneratePlane(float width, float depth, unsigned int segmentsX, unsigned int segmentsZ, float uvRepeat,
+                   bool requireTangents, MeshData& meshData)
+{
+    segmentsX = std::max(segmentsX, 1u);
+    segmentsZ = std::max(segmentsZ, 1u);
+
+    // Rows go from the far (+Z) edge towards the near one so the triangles face up
+    PrimitiveWriter writer(meshData, (segmentsX + 1) * (segmentsZ + 1), segmentsX * segmentsZ * 6, requireTangents);
+    for (unsigned int row = 0; row <= segmentsZ; ++row)
+    {
+        float v = 1.0f - static_cast<float>(row) / segmentsZ;
+        for (unsigned int column = 0; column <= segmentsX; ++column)
+        {
+            float u = static_cast<float>(column) / segmentsX;
+            writer.Vertex({ (u - 0.5f) * width, 0, (v - 0.5f) * depth }, { 0, 1, 0 }, { 1, 0, 0 }, u * uvRepeat, v * uvRepeat);
+        }
+    }
+    writer.Grid(0, segmentsX, segmentsZ);
+    writer.Finish();
+}
+
+
+// Cylinder centred on the origin along the Y axis with segments around it and stacks from bottom to top, closed at
+// both ends. U goes once around the side, the ends have UVs from 0 to 1 across them. Needs at least 3 segments
+void GenerateCylinder(float radius, float height, unsigned int segments, unsigned int stacks, bool requireTangents,
+                      MeshData& meshData)
+{
+    segments = std::max(segments, 3u);
+    stacks   = std::max(stacks, 1u);
+
+    // Directions out from the axis for each segment, shared by the side and the ends so the positions where they meet,
+    // and either side of the U seam, are exactly equal and the mesh welds closed
+    std::vector<CVector3> outwards(segments);
+    for (unsigned int segment = 0; segment < segments; ++segment)
+    {
+        float angle = 2 * PI * segment / segments;
+        outwards[segment] = { std::cos(angle), 0, std::sin(angle) };
+    }
+    auto rimPosition = [&](unsigned int segment, float y)
+    {
+        return radius * outwards[segment % segments] + CVector3{ 0, y, 0 };
+    };
+
+    // Side, a row for each stack edge from the top down with the first column repeated for the U seam. Then each end, a
+    // centre vertex and a ring of its own so the edge is sharp
+    PrimitiveWriter writer(meshData, (stacks + 1) * (segments + 1) + 2 * (segments + 1),
+                           segments * stacks * 6 + 2 * segments * 3, requireTangents);
+    for (unsigned int stack = 0; stack <= stacks; ++stack)
+    {
+        float v = static_cast<float>(stack) / stacks;
+        for (unsigned int segment = 0; segment <= segments; ++segment)
+        {
+            float u = static_cast<float>(segment) / segments;
+            writer.Vertex(rimPosition(segment, (0.5f - v) * height), outwards[segment % segments],
+                          TangentAroundY(2 * PI * u), u, v);
+        }
+    }
+    writer.Grid(0, segments, stacks);
+
+    for (int end = 0; end < 2; ++end)
+    {
+        bool top = (end == 0);
+        CVector3 normal = { 0, top ? 1.0f : -1.0f, 0 };
+        float y = (0.5f - (top ? 0.0f : 1.0f)) * height; // As the top and bottom rows of the side
+
+        // UVs seen from outside each end with U along +X
+        uint32_t centre = writer.Vertex({ 0, y, 0 }, normal, { 1, 0, 0 }, 0.5f, 0.5f);
+        for (unsigned int segment = 0; segment < segments; ++segment)
+        {
+            float x = outwards[segment].x, z = outwards[segment].z;
+            writer.Vertex(rimPosition(segment, y), normal, { 1, 0, 0 }, 0.5f + 0.5f * x, 0.5f + (top ? -0.5f : 0.5f) * z);
+        }
+        for (unsigned int segment = 0; segment < segments; ++segment)
+        {
+            uint32_t a = centre + 1 + segment;
+            uint32_t b = centre + 1 + (segment + 1) % segments;
+            if (top)  writer.Triangle(centre, b, a);
+            else      writer.Triangle(centre, a, b);
+        }
+    }
+    writer.Finish();
+}
+
+
+// Torus (ring) around the Y axis, majorRadius from the centre to the middle of the tube and minorRadius across the tube.
+// U goes once around the ring, V once around the tube. Needs at least 3 segments each way
+void GenerateTorus(float majorRadius, float minorRadius, unsigned int majorSegments, unsigned int minorSegments,
+                   bool requireTangents, MeshData& meshData)
+{
+    majorSegments = std::max(majorSegments, 3u);
+    minorSegments = std::max(minorSegments, 3u);
+
+    // A row for each step around the tube, starting on the outside and going down first so the triangles face out. The
+    // last row and column repeat the first for the UV seams, at the first's angles so the positions either side of each
+    // seam are exactly equal and the mesh welds closed
+    PrimitiveWriter writer(meshData, (minorSegments + 1) * (majorSegments + 1), majorSegments * minorSegments * 6, requireTangents);
+    for (unsigned int minor = 0; minor <= minorSegments; ++minor)
+    {
+        float v = static_cast<float>(minor) / minorSegments;
+        float tubeAngle = -2 * PI * (minor % minorSegments) / minorSegments;
+        for (unsigned int major = 0; major <= majorSegments; ++major)
+        {
+            float u = static_cast<float>(major) / majorSegments;
+            float ringAngle = 2 * PI * (major % majorSegments) / majorSegments;
+            CVector3 outwards = { std::cos(ringAngle), 0, std::sin(ringAngle) };
+            CVector3 normal = std::cos(tubeAngle) * outwards + CVector3{ 0, std::sin(tubeAngle), 0 };
+            writer.Vertex(majorRadius * outwards + minorRadius * normal, normal, TangentAroundY(ringAngle), u, v);
+        }
+    }
+    writer.Grid(0, majorSegments, minorSegments);
+    writer.Finish();
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Vertex cache optimisation
+//--------------------------------------------------------------------------------------
+
+// Reorder the triangles of a triangle list so vertices are reused while they are still in the GPU's post-transform
+// cache (Tom Forsyth's linear-speed vertex cache optimisation). Used on every primitive, available for other meshes
+void OptimiseVertexCache(uint32_t* indices, uint32_t numIndices, uint32_t numVertices)
+{
+    const uint32_t NO_TRIANGLE = UINT32_MAX;
+    uint32_t numTriangles = numIndices / 3;
+    if (numTriangles < 2)  return;
+
+    // The triangles using each vertex, in one array with each vertex's list starting at triangleStart[vertex]
+    std::vector<uint32_t> triangleStart(numVertices + 1, 0);
+    for (uint32_t i = 0; i < numTriangles * 3; ++i)  ++triangleStart[indices[i] + 1];
+    for (uint32_t v = 0; v < numVertices; ++v)  triangleStart[v + 1] += triangleStart[v];
+    std::vector<uint32_t> vertexTriangles(numTriangles * 3);
+    {
+        std::vector<uint32_t> next(triangleStart.begin(), triangleStart.end() - 1);
+        for (uint32_t i = 0; i < numTriangles * 3; ++i)  vertexTriangles[next[indices[i]]++] = i / 3;
+    }
+
+    std::vector<uint32_t> trianglesLeft(numVertices);
+    std::vector<int>      cachePosition(numVertices, -1);
+    std::vector<float>    vertexScore(numVertices);
+    for (uint32_t v = 0; v < numVertices; ++v)
+    {
+        trianglesLeft[v] = triangleStart[v + 1] - triangleStart[v];
+        vertexScore[v] = VertexScore(-1, trianglesLeft[v]);
+    }
+
+    std::vector<float>   triangleScore(numTriangles);
+    std::vector<uint8_t> emitted(numTriangles, 0);
+    uint32_t bestTriangle = 0;
+    for (uint32_t t = 0; t < numTriangles; ++t)
+    {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if (triangleScore[t] > triangleScore[bestTriangle])  bestTriangle = t;
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(numTriangles * 3);
+    std::vector<uint32_t> cache, newCache;
+    cache.reserve(CACHE_SIZE + 3);
+    newCache.reserve(CACHE_SIZE + 3);
+    uint32_t firstNotEmitted = 0;
+    for (uint32_t n = 0; n < numTriangles; ++n)
+    {
+        // No triangle of a cached vertex is left, start again from the first triangle not yet used
+        if (bestTriangle == NO_TRIANGLE)
+        {
+            while (emitted[firstNotEmitted])  ++firstNotEmitted;
+            bestTriangle = firstNotEmitted;
+        }
+
+        const uint32_t* corners = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = 1;
+        output.insert(output.end(), corners, corners + 3);
+
+        // Move the triangle's vertices to the front of the cache, pushing the rest back
+        newCache.assign(corners, corners + 3);
+        for (uint32_t v : cache)
+        {
+            if (v != corners[0] && v != corners[1] && v != corners[2])  newCache.push_back(v);
+        }
+        for (int c = 0; c < 3; ++c)  --trianglesLeft[corners[c]];
+
+        // Rescore the vertices that were in the cache or have just joined it, and the triangles still to use them. Only
+        // those triangles are candidates for the next one
+        bestTriangle = NO_TRIANGLE;
+        float bestScore = -1;
+        for (size_t position = 0; position < newCache.size(); ++position)
+        {
+            uint32_t v = newCache[position];
+            cachePosition[v] = position < CACHE_SIZE ? static_cast<int>(position) : -1;
+            vertexScore[v] = VertexScore(cachePosition[v], trianglesLeft[v]);
+        }
+        for (uint32_t v : newCache)
+        {
+            for (uint32_t i = triangleStart[v]; i < triangleStart[v + 1]; ++i)
+            {
+                uint32_t t = vertexTriangles[i];
+                if (emitted[t])  continue;
+                triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore && cachePosition[v] >= 0)
+                {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+        if (newCache.size() > CACHE_SIZE)  newCache.resize(CACHE_SIZE);
+        cache.swap(newCache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
@@ -0,0 +1,47 @@
+//--------------------------------------------------------------------------------------
+// Procedural mesh primitives
+//--------------------------------------------------------------------------------------
+// Generates spheres, boxes, planes, cylinders and tori as the same MeshData as ImportMesh
+// (see MeshImport.h), so simple shapes don't need a model file. Triangles are wound clockwise
+// seen from outside and ordered for the vertex cache.
+
+#ifndef _MESH_PRIMITIVES_H_INCLUDED_
+#define _MESH_PRIMITIVES_H_INCLUDED_
+
+#include "MeshImport.h"
+#include "CVector3.h"
+
+
+// Sphere with segments around the equator and rings from pole to pole, centred on the origin with the poles on the Y
+// axis. U goes once around the equator, V from the top pole to the bottom one. Needs at least 3 segments and 2 rings
+void GenerateUVSphere(float radius, unsigned int segments, unsigned int rings, bool requireTangents, MeshData& meshData);
+
+// Sphere made by dividing each triangle of an icosahedron into four the given number of times (0 is an icosahedron),
+// which spreads the triangles more evenly than a UV sphere. UVs as for the UV sphere
+void GenerateIcoSphere(float radius, unsigned int subdivisions, bool requireTangents, MeshData& meshData);
+
+// Box centred on the origin with each face divided into segments x segments squares. Each face has UVs from 0 to 1
+void GenerateBox(const CVector3& size, unsigned int segments, bool requireTangents, MeshData& meshData);
+
+// Flat plane facing up (+Y) through the origin, width along X and depth along Z, divided into the given number of
+// squares in each direction. UVs go from 0 to uvRepeat across the plane, so a texture repeats that many times
+void GeneratePlane(float width, float depth, unsigned int segmentsX, unsigned int segmentsZ, float uvRepeat,
+                   bool requireTangents, MeshData& meshData);
+
+// Cylinder centred on the origin along the Y axis with segments around it and stacks from bottom to top, closed at
+// both ends. U goes once around the side, the ends have UVs from 0 to 1 across them. Needs at least 3 segments
+void GenerateCylinder(float radius, float height, unsigned int segments, unsigned int stacks, bool requireTangents,
+                      MeshData& meshData);
+
+// Torus (ring) around the Y axis, majorRadius from the centre to the middle of the tube and minorRadius across the tube.
+// U goes once around the ring, V once around the tube. Needs at least 3 segments each way
+void GenerateTorus(float majorRadius, float minorRadius, unsigned int majorSegments, unsigned int minorSegments,
+                   bool requireTangents, MeshData& meshData);
+
+
+// Reorder the triangles of a triangle list so vertices are reused while they are still in the GPU's post-transform
+// cache (Tom Forsyth's linear-speed vertex cache optimisation). Used on every primitive, available for other meshes
+void OptimiseVertexCache(uint32_t* indices, uint32_t numIndices, uint32_t numVertices);
+
+
+#endif //_MESH_PRIMITIVES_H_INCLUDED_
@@ -0,0 +1,163 @@
+//--------------------------------------------------------------------------------------
+// Mesh staging memory and vertex layout
+//--------------------------------------------------------------------------------------
+// The parts of MeshImport.h that don't use assimp, so code that only builds or decodes meshes (MeshPrimitives.h,
+// MeshCodec.h) can be used without it
+
+#include "MeshImport.h"
+
+#include <algorithm>
+
+
+namespace
+{
+    // Staging blocks are made in whole multiples of this, so a block can be reused by meshes of a similar size
+    const size_t STAGING_GRANULARITY = 64 * 1024;
+
+    // Unused staging memory kept by gMeshStagingPool, enough for the largest model
+    const size_t MAX_KEPT_STAGING_BYTES = 32 * 1024 * 1024;
+}
+
+MeshStagingPool gMeshStagingPool(MAX_KEPT_STAGING_BYTES);
+
+
+
+//--------------------------------------------------------------------------------------
+// Staging memory
+//--------------------------------------------------------------------------------------
+
+MeshStagingBuffer::MeshStagingBuffer(MeshStagingBuffer&& other) noexcept
+    : mPool(other.mPool), mData(other.mData), mCapacity(other.mCapacity)
+{
+    other.mPool = nullptr;
+    other.mData = nullptr;
+    other.mCapacity = 0;
+}
+
+MeshStagingBuffer& MeshStagingBuffer::operator=(MeshStagingBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        std::swap(mPool, other.mPool);
+        std::swap(mData, other.mData);
+        std::swap(mCapacity, other.mCapacity);
+    }
+    return *this;
+}
+
+// Give the memory back to the pool now, e.g. as soon as it has been copied to the GPU
+void MeshStagingBuffer::Release()
+{
+    if (mData == nullptr)  return;
+    mPool->Release(mData, mCapacity);
+    mPool = nullptr;
+    mData = nullptr;
+    mCapacity = 0;
+}
+
+
+MeshStagingPool::MeshStagingPool(size_t maxKeptBytes)
+    : mMaxKeptBytes(maxKeptBytes)
+{
+}
+
+
+// A block of at least the given size, the smallest kept block that is big enough or a new one
+MeshStagingBuffer MeshStagingPool::Acquire(size_t bytes)
+{
+    MeshStagingBuffer buffer;
+    buffer.mPool = this;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mStats.acquires;
+
+        auto best = mKept.end();
+        for (auto block = mKept.begin(); block != mKept.end(); ++block)
+        {
+            if (block->capacity >= bytes && (best == mKept.end() || block->capacity < best->capacity))  best = block;
+        }
+        if (best != mKept.end())
+        {
+            buffer.mData     = best->data;
+            buffer.mCapacity = best->capacity;
+            mStats.keptBytes -= best->capacity;
+            mKept.erase(best);
+            ++mStats.reuses;
+        }
+        else
+        {
+            buffer.mCapacity = (std::max<size_t>(bytes, 1) + STAGING_GRANULARITY - 1) / STAGING_GRANULARITY * STAGING_GRANULARITY;
+        }
+        mLiveBytes += buffer.mCapacity;
+        mStats.peakLiveBytes = std::max(mStats.peakLiveBytes, mLiveBytes);
+    }
+
+    // Not a make_unique or vector, they would write zeros over the whole block just before the import overwrites it
+    if (buffer.mData == nullptr)  buffer.mData = new unsigned char[buffer.mCapacity];
+    return buffer;
+}
+
+
+// Free the kept blocks, e.g. when loading is finished
+void MeshStagingPool::Trim()
+{
+    std::vector<Block> kept;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        kept.swap(mKept);
+        mStats.keptBytes = 0;
+    }
+    for (auto& block : kept)  delete[] block.data;
+}
+
+
+MeshStagingStats MeshStagingPool::Stats()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+
+void MeshStagingPool::Release(unsigned char* data, size_t capacity)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mLiveBytes -= capacity;
+        if (mStats.keptBytes + capacity <= mMaxKeptBytes)
+        {
+            mKept.push_back({ data, capacity });
+            mStats.keptBytes += capacity;
+            return;
+        }
+    }
+    delete[] data;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Vertex layout
+//--------------------------------------------------------------------------------------
+
+// Byte offsets of each element within a vertex and the total vertex size for the given flags
+MeshVertexLayout GetMeshVertexLayout(unsigned int flags)
+{
+    MeshVertexLayout layout;
+    unsigned int offset = 0;
+
+    layout.positionOffset = offset;
+    offset += 12;
+
+    layout.normalOffset = offset;
+    offset += 12;
+
+    layout.tangentOffset = offset;
+    if (flags & MeshHasTangents)  offset += 12;
+
+    layout.uvOffset = offset;
+    if (flags & MeshHasUVs)  offset += 8;
+
+    layout.vertexSize = offset;
+    return layout;
+}
@@ -9,19 +9,46 @@
 #include "Common.h"
 #include "GraphicsHelpers.h"
 #include "Mesh.h"
+#include "Profiler.h"
 
 void Model::Render()
 {
-    UpdateWorldMatrix();
+    Render(WorldMatrix());
+}
+
+void Model::Render(const CMatrix4x4& worldMatrix)
+{
+    PROFILE_ZONE("Model::Render");
+
+    SetConstants(worldMatrix);
+    mMesh->Render();
+}
+
+// Draw the outline of the model as seen from the given camera position (world space) with the current shaders,
+// see Mesh::RenderOutline
+void Model::RenderOutline(const CVector3& cameraPosition)
+{
+    PROFILE_ZONE("Model::RenderOutline");
+
+    CMatrix4x4 worldMatrix = WorldMatrix();
+    SetConstants(worldMatrix);
 
-    gPerModelConstants.worldMatrix = mWorldMatrix; // Update C++ side constant buffer
+    // The silhouette depends on where the camera is relative to the model, so find the camera position in model space
+    CMatrix4x4 cameraInModelSpace = MatrixTranslation(cameraPosition) * InverseAffine(worldMatrix);
+    mMesh->RenderOutline(cameraInModelSpace.GetPosition());
+}
+
+
+// Set the world matrix in the per-model constant buffer and make that buffer available to the shaders
+void Model::SetConstants(const CMatrix4x4& worldMatrix)
+{
+    gPerModelConstants.worldMatrix = worldMatrix; // Update C++ side constant buffer
     UpdateConstantBuffer(gPerModelConstantBuffer, gPerModelConstants); // Send to GPU
 
     // Indicate that the constant buffer we just updated is for use in the vertex shader (VS) and pixel shader (PS)
     gD3DContext->VSSetConstantBuffers(1, 1, &gPerModelConstantBuffer); // First parameter must match constant buffer number in the shader
     gD3DContext->PSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
-
-    mMesh->Render();
+    gRenderCounters.stateChanges += 2;
 }
 
 
@@ -74,6 +101,19 @@ void Model::Control(float frameTime, KeyCode turnUp, KeyCode turnDown, KeyCode t
 }
 
 
+// Get the world matrix t of the way (0 to 1) from where the model was at the start of the last simulation step to where
+// it is now
+CMatrix4x4 Model::InterpolatedMatrix(float t)
+{
+    CVector3 position = mPreviousPosition + (mPosition - mPreviousPosition) * t;
+    CVector3 rotation = { LerpAngle(mPreviousRotation.x, mRotation.x, t),
+                          LerpAngle(mPreviousRotation.y, mRotation.y, t),
+                          LerpAngle(mPreviousRotation.z, mRotation.z, t) };
+    CVector3 scale    = mPreviousScale + (mScale - mPreviousScale) * t;
+    return MatrixScaling(scale) * MatrixRotationZ(rotation.z) * MatrixRotationX(rotation.x) * MatrixRotationY(rotation.y) * MatrixTranslation(position);
+}
+
+
 void Model::UpdateWorldMatrix()
 {
     mWorldMatrix = MatrixScaling(mScale) * MatrixRotationZ(mRotation.z) * MatrixRotationX(mRotation.x) * MatrixRotationY(mRotation.y) * MatrixTranslation(mPosition);
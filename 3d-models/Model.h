@@ -22,7 +22,8 @@ public:
 	//-------------------------------------
 
     Model(Mesh* mesh, CVector3 position = { 0,0,0 }, CVector3 rotation = { 0,0,0 }, float scale = 1)
-        : mMesh(mesh), mPosition(position), mRotation(rotation), mScale({ scale, scale, scale })
+        : mMesh(mesh), mPosition(position), mRotation(rotation), mScale({ scale, scale, scale }),
+          mPreviousPosition(position), mPreviousRotation(rotation), mPreviousScale({ scale, scale, scale })
     {
     }
 
@@ -31,12 +32,27 @@ public:
     // So all other per-frame constants must have been set already along with shaders, textures, samplers, states etc.
     void Render();
 
+    // Render with the given world matrix instead of the model's own, e.g. one from a snapshot of the scene (see
+    // Pipeline.h). Doesn't read or change the model's position, so is safe while another thread moves the model
+    void Render(const CMatrix4x4& worldMatrix);
+
+    // Draw the outline of the model as seen from the given camera position (world space) with the current shaders,
+    // see Mesh::RenderOutline
+    void RenderOutline(const CVector3& cameraPosition);
+
 
 	// Control the model's position and rotation using keys provided. Amount of motion performed depends on frame time
 	void Control( float frameTime, KeyCode turnUp, KeyCode turnDown, KeyCode turnLeft, KeyCode turnRight,  
 				  KeyCode turnCW, KeyCode turnCCW, KeyCode moveForward, KeyCode moveBackward );
 
 
+    // Fixed timestep support (see FixedTimestep.h). Call StartStep before each simulation step that may move the model
+    // to remember where it was. InterpolatedMatrix returns the world matrix t of the way (0 to 1) from there to where
+    // the model is now, to render it with
+    void StartStep()  { mPreviousPosition = mPosition;  mPreviousRotation = mRotation;  mPreviousScale = mScale; }
+    CMatrix4x4 InterpolatedMatrix(float t);
+
+
     void FaceTarget(CVector3 target)
     {
         UpdateWorldMatrix();
@@ -50,6 +66,7 @@ public:
 	//-------------------------------------
 
 	// Getters / setters
+	Mesh*    GetMesh()   { return mMesh;     }
 	CVector3 Position()  { return mPosition; }
 	CVector3 Rotation()  { return mRotation; }
 	CVector3 Scale()     { return mScale;    }
@@ -71,6 +88,9 @@ public:
 private:
     void UpdateWorldMatrix();
 
+    // Set the world matrix in the per-model constant buffer and make that buffer available to the shaders
+    void SetConstants(const CMatrix4x4& worldMatrix);
+
     Mesh* mMesh;
 
 	// Position, rotation and scaling for the model
@@ -80,6 +100,11 @@ private:
 
 	// World matrix for the model - built from the above
 	CMatrix4x4 mWorldMatrix;
+
+    // Position, rotation and scaling at the start of the last simulation step
+    CVector3 mPreviousPosition;
+    CVector3 mPreviousRotation;
+    CVector3 mPreviousScale;
 };
 
 
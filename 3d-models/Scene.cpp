@@ -17,11 +17,25 @@
 #include "CMatrix4x4.h"
 #include "MathHelpers.h"     // Helper functions for maths
 #include "GraphicsHelpers.h" // Helper functions to unclutter the code here
+#include "AssetPackage.h"    // Cooked assets, see Tools/AssetCooker.cpp
+#include "TextureStreamer.h" // Mip levels of the larger textures are loaded as they are needed
+#include "Profiler.h"        // Zone markers for CPU timing
+#include "FrameStats.h"      // Frame time percentiles
+#include "StressScene.h"     // Large numbers of instances for the scalability benchmark
+#include "Pipeline.h"        // Simulation runs on another thread while the renderer draws a snapshot of the scene
+#include "FramePacer.h"      // Vsync or frame rate caps, chosen with the P key
+#include "Allocators.h"      // Scene arena and model pool
+#include "MeshImport.h"      // Mesh staging memory
+#include "MeshPrimitives.h"  // Sphere, cube and floor are generated rather than loaded
+#include "SpriteRenderer.h"  // Light flares are drawn as sprites in one batch
 
 #include "ColourRGBA.h" 
 
-#include <sstream>
+#include <cstdio>
 #include <memory>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
 
 
 //--------------------------------------------------------------------------------------
@@ -35,33 +49,53 @@ const float ROTATION_SPEED = 2.0f;  // 2 radians per second for rotation
 const float MOVEMENT_SPEED = 50.0f; // 50 units per second for movement (what a unit of length is depends on 3D model - i.e. an artist decision usually)
 
 
-// Meshes, models and cameras, same meaning as TL-Engine. Meshes prepared in InitGeometry function, Models & camera in InitScene
+// Meshes, models and cameras, same meaning as TL-Engine. Meshes prepared in InitGeometry function, Models & camera in InitScene.
+// The meshes and camera last as long as the scene, so they are created in the scene arena rather than one by one on the
+// heap, and are all released together by ReleaseResources
+LinearAllocator gSceneArena(64 * 1024, MemoryCategory::Scene);
+
 Mesh* gTeapotMesh;
 Mesh* gSphereMesh;
 Mesh* gCubeMesh;
 Mesh* gFloorMesh;
-Mesh* gLightMesh;
 Mesh* gTrollMesh;
 
-Model* gTeapot;
-Model* gSphere;
-Model* gCube;
-Model* gFloor;
-Model* gTroll;
+// Models are kept in a fixed-size pool and referred to by handle (see Allocators.h)
+const uint32_t MAX_SCENE_MODELS = 16;
+using ModelHandle = PoolHandle<Model>;
+ObjectPool<Model, MAX_SCENE_MODELS> gModels;
+
+ModelHandle gTeapot;
+ModelHandle gSphere;
+ModelHandle gCube;
+ModelHandle gFloor;
+ModelHandle gTroll;
 
 Camera* gCamera;
 
 
 // Store lights in an array in this exercise
 const int NUM_LIGHTS = 2;
+
+// Lights are drawn as flares (see RenderSceneFromCamera) so they have no model, just a place in the world and the point
+// their spotlight faces
 struct Light
 {
-    Model*   model;
+    CVector3 position;
+    CVector3 target;   // The spotlight points at this
+    float    scale;    // Size of the light's flare, set to suit its strength
     CVector3 colour;
     float    strength;
+
+    // Where the light was and what it pointed at when the last simulation step started
+    CVector3 previousPosition;
+    CVector3 previousTarget;
 };
 Light gLights[NUM_LIGHTS]; 
 
+// The light flares drawn in the main pass, refilled each time it is rendered (see RenderSceneFromCamera)
+SpriteBatch gLightSprites;
+
 
 // Additional light information
 CVector3 gAmbientColour = { 0.2f, 0.2f, 0.3f }; // Background level of light (slightly bluish to match the far background, which is dark blue)
@@ -76,8 +110,8 @@ const float gLightOrbitSpeed = 0.7f;
 // Spotlight data - using spotlights in this lab because shadow mapping needs to treat each light as a camera, which is easy with spotlights
 float gSpotlightConeAngle = 90.0f; // Spot light cone angle (degrees), like the FOV (field-of-view) of the spot light
 
-// Lock FPS to monitor refresh rate, which will typically set it to 60fps. Press 'p' to toggle to full fps
-bool lockFPS = true;
+// CPU time in seconds spent by the last RenderScene sending work to the GPU, before Present
+float gSubmitTime = 0;
 
 
 // Wiggling Sphere
@@ -87,6 +121,33 @@ float gShift;
 // Fading Cube
 float gFading;
 
+// Values of the above at the start of the last simulation step, rendering is between these and the current values
+float gPreviousWiggle;
+float gPreviousShift;
+float gPreviousFading;
+
+
+// Everything rendering needs from the simulation, taken at the end of its steps so it can move on while the frame is
+// rendered (see Pipeline.h). Models that move are already placed between the last two simulation steps. The renderer
+// uses only a snapshot and resources that don't change (meshes, textures, shaders), never the models or lights above
+struct SceneSnapshot
+{
+    CMatrix4x4 teapotMatrix;
+    CMatrix4x4 lightMatrices[NUM_LIGHTS];
+    CVector3   lightColours[NUM_LIGHTS];
+    float      lightStrengths[NUM_LIGHTS];
+    Camera     camera;
+
+    float wiggle;
+    float shift;
+    float fading;
+
+    StressSceneSnapshot stress;
+
+    FramePacer::Clock::time_point inputTime; // When the input used by the simulation was read
+};
+SnapshotBuffer<SceneSnapshot> gSceneSnapshots;
+
 //--------------------------------------------------------------------------------------
 //**** Shadow Texture  ****//
 //--------------------------------------------------------------------------------------
@@ -131,19 +192,18 @@ ID3D11Buffer*     gPerModelConstantBuffer; // --"--
 // Textures
 //--------------------------------------------------------------------------------------
 
-// DirectX objects controlling textures used in this lab
-ID3D11Resource*           gTeapotDiffuseSpecularMap    = nullptr; // This object represents the memory used by the texture on the GPU
-ID3D11ShaderResourceView* gTeapotDiffuseSpecularMapSRV = nullptr; // This object is used to give shaders access to the texture above (SRV = shader resource view)
-
-ID3D11Resource*           gSphereDiffuseSpecularMap    = nullptr;
-ID3D11ShaderResourceView* gSphereDiffuseSpecularMapSRV = nullptr;
+// The diffuse-specular maps are streamed, only the mip levels needed for the size of the models on screen are loaded
+// (see TextureStreamer.h). Textures loaded twice are shared, so the teapot and sphere use the same texture. Textures of
+// the same size and format are packed into texture arrays, models select their slice in the per-model constants. Get
+// the SRV from the texture each frame as it changes when mip levels are streamed in or out
+const size_t TEXTURE_STREAMING_BUDGET = 8 * 1024 * 1024; // GPU memory in bytes for the streamed textures
 
-ID3D11Resource*           gCubeDiffuseSpecularMap = nullptr;
-ID3D11ShaderResourceView* gCubeDiffuseSpecularMapSRV = nullptr;
-
-ID3D11Resource*           gFloorDiffuseSpecularMap    = nullptr;
-ID3D11ShaderResourceView* gFloorDiffuseSpecularMapSRV = nullptr;
+StreamedTexture* gTeapotDiffuseSpecularMap = nullptr;
+StreamedTexture* gSphereDiffuseSpecularMap = nullptr;
+StreamedTexture* gCubeDiffuseSpecularMap   = nullptr;
+StreamedTexture* gFloorDiffuseSpecularMap  = nullptr;
 
+// DirectX objects controlling other textures used in this lab
 ID3D11Resource*           gLightDiffuseMap    = nullptr;
 ID3D11ShaderResourceView* gLightDiffuseMapSRV = nullptr;
 
@@ -157,10 +217,18 @@ ID3D11ShaderResourceView* gTrollDiffuseMapSRV = nullptr; // This object is used
 // Light Helper Functions
 //--------------------------------------------------------------------------------------
 
-// Get "camera-like" view matrix for a spotlight
-CMatrix4x4 CalculateLightViewMatrix(int lightIndex)
+// World matrix of a light at the given position facing the given target, scaled to the size of its flare
+CMatrix4x4 MakeLightMatrix(const CVector3& position, const CVector3& target, float scale)
+{
+    CMatrix4x4 lightMatrix = MatrixScaling(scale) * MatrixTranslation(position);
+    lightMatrix.FaceTarget(target);
+    return lightMatrix;
+}
+
+// Get "camera-like" view matrix for a spotlight, placed where the light is in the snapshot being rendered
+CMatrix4x4 CalculateLightViewMatrix(const SceneSnapshot& snapshot, int lightIndex)
 {
-    return InverseAffine(gLights[lightIndex].model->WorldMatrix());
+    return InverseAffine(snapshot.lightMatrices[lightIndex]);
 }
 
 // Get "camera-like" projection matrix for a spotlight
@@ -178,16 +246,27 @@ CMatrix4x4 CalculateLightProjectionMatrix(int lightIndex)
 // Returns true on success
 bool InitGeometry()
 {
+    PROFILE_ZONE("InitGeometry");
+
+    // Use the cooked asset package if there is one. Meshes, textures and shaders found in it are used straight from the
+    // memory-mapped package, anything missing (or everything, if the package hasn't been cooked) is loaded from loose files
+    gAssetPackage.Open("Assets.pak");
+
     // Load mesh geometry data, just like TL-Engine this doesn't create anything in the scene. Create a Model for that.
     // IMPORTANT NOTE: Will only keep the first object from the mesh - multipart objects will have parts missing - see later lab for more robust loader
     try 
     {
-        gTeapotMesh = new Mesh("Models/Teapot.x");
-        gSphereMesh = new Mesh("Models/Sphere.x");
-        gCubeMesh   = new Mesh("Models/Cube.x");
-        gFloorMesh  = new Mesh("Models/Floor.x");
-        gLightMesh  = new Mesh("Models/Light.x");
-        gTrollMesh  = new Mesh("Models/troll.x");
+        gTeapotMesh = gSceneArena.New<Mesh>("Models/Teapot.x");
+        gTrollMesh  = gSceneArena.New<Mesh>("Models/troll.x", false, true); // Edge adjacency for the outline
+
+        // The simple shapes are generated rather than loaded, the same size and UVs as the model files they replace
+        MeshData primitive;
+        GenerateUVSphere(10, 30, 30, false, primitive);
+        gSphereMesh = gSceneArena.New<Mesh>("Sphere", primitive);
+        GenerateBox({ 10, 10, 10 }, 1, false, primitive);
+        gCubeMesh   = gSceneArena.New<Mesh>("Cube", primitive);
+        GeneratePlane(2000, 2000, 1, 1, 60, false, primitive);
+        gFloorMesh  = gSceneArena.New<Mesh>("Floor", primitive);
     }
     catch (std::runtime_error e)  // Constructors cannot return error messages so use exceptions to catch mesh errors (fairly standard approach this)
     {
@@ -195,6 +274,9 @@ bool InitGeometry()
         return false;
     }
 
+    // The imports reused each other's staging memory, there are no more to load so free it
+    gMeshStagingPool.Trim();
+
 
     // Load the shaders required for the geometry we will use (see Shader.cpp / .h)
     if (!LoadShaders())
@@ -204,6 +286,14 @@ bool InitGeometry()
     }
 
 
+    // The light flares are drawn as sprites, which share one set of buffers
+    if (!InitSpriteRenderer())
+    {
+        gLastError = "Error creating sprite buffers";
+        return false;
+    }
+
+
     // Create GPU-side constant buffers to receive the gPerFrameConstants and gPerModelConstants structures above
     // These allow us to pass data from CPU to shaders such as lighting information or matrices
     // See the comments above where these variable are declared and also the UpdateScene function
@@ -222,10 +312,14 @@ bool InitGeometry()
     // The LoadTexture function requires you to pass a ID3D11Resource* (e.g. &gCubeDiffuseMap), which manages the GPU memory for the
     // texture and also a ID3D11ShaderResourceView* (e.g. &gCubeDiffuseMapSRV), which allows us to use the texture in shaders
     // The function will fill in these pointers with usable data. The variables used here are globals found near the top of the file.
-    if (!LoadTexture("Textures/PatternDiffuseSpecular.dds", &gTeapotDiffuseSpecularMap, &gTeapotDiffuseSpecularMapSRV) ||
-        !LoadTexture("Textures/PatternDiffuseSpecular.dds", &gSphereDiffuseSpecularMap, &gSphereDiffuseSpecularMapSRV) ||
-        !LoadTexture("Textures/StoneDiffuseSpecular.dds",   &gCubeDiffuseSpecularMap,   &gCubeDiffuseSpecularMapSRV) ||
-        !LoadTexture("Textures/WoodDiffuseSpecular.dds",    &gFloorDiffuseSpecularMap,  &gFloorDiffuseSpecularMapSRV) ||
+    // Streamed textures start with only their smallest mip levels loaded
+    gTextureStreamer.Init(TEXTURE_STREAMING_BUDGET);
+    gTeapotDiffuseSpecularMap = gTextureStreamer.Load("Textures/PatternDiffuseSpecular.dds");
+    gSphereDiffuseSpecularMap = gTextureStreamer.Load("Textures/PatternDiffuseSpecular.dds");
+    gCubeDiffuseSpecularMap   = gTextureStreamer.Load("Textures/StoneDiffuseSpecular.dds");
+    gFloorDiffuseSpecularMap  = gTextureStreamer.Load("Textures/WoodDiffuseSpecular.dds");
+    if (gTeapotDiffuseSpecularMap == nullptr || gSphereDiffuseSpecularMap == nullptr ||
+        gCubeDiffuseSpecularMap   == nullptr || gFloorDiffuseSpecularMap  == nullptr ||
         !LoadTexture("Textures/Flare.jpg",                  &gLightDiffuseMap,          &gLightDiffuseMapSRV) ||
         !LoadTexture("Textures/Green.png",                  &gTrollDiffuseMap,          &gTrollDiffuseMapSRV) ||
         !LoadTexture("Textures/CellGradient.png",           &gCellMap,                  &gCellMapSRV))
@@ -256,6 +350,7 @@ bool InitGeometry()
 		gLastError = "Error creating shadow map texture";
 		return false;
 	}
+	TrackMemory(MemoryCategory::ShadowMaps, MemoryHeap::GPU, ResourceBytes(gShadowMap1Texture));
 
 
 	// Create the depth stencil view, i.e. indicate that the texture just created is to be used as a depth buffer
@@ -290,6 +385,7 @@ bool InitGeometry()
         gLastError = "Error creating shadow map texture";
         return false;
     }
+    TrackMemory(MemoryCategory::ShadowMaps, MemoryHeap::GPU, ResourceBytes(gShadowMap2Texture));
 
 
     if (FAILED(gD3DDevice->CreateDepthStencilView(gShadowMap2Texture, &dsvDesc, &gShadowMap2DepthStencil)))
@@ -325,47 +421,48 @@ bool InitScene()
 {
     //// Set up scene ////
 
-    gTeapot = new Model(gTeapotMesh);
-    gSphere = new Model(gSphereMesh);
-    gCube   = new Model(gCubeMesh);
-    gFloor  = new Model(gFloorMesh);
-    gTroll  = new Model(gTrollMesh);
+    gTeapot = gModels.Create(gTeapotMesh);
+    gSphere = gModels.Create(gSphereMesh);
+    gCube   = gModels.Create(gCubeMesh);
+    gFloor  = gModels.Create(gFloorMesh);
+    gTroll  = gModels.Create(gTrollMesh);
 
 
 	// Initial positions
-	gTeapot->SetPosition({ 15, 0, 0 });
-    gTeapot->SetRotation({ 0, ToRadians(215.0f), 0 });
-	gSphere->SetPosition({ 40, 10, 30 });
-	gSphere->SetRotation({ 0.0f, ToRadians(-20.0f), 0.0f });
-    gCube->SetPosition({ -15, 10, 0 });
-    gTroll->SetPosition({ 10, 0, 15 });
-    gTroll->SetScale(4.0f);
-    gTroll->SetRotation({ 0, ToRadians(180.0f), 0 });
+	gModels.Get(gTeapot)->SetPosition({ 15, 0, 0 });
+    gModels.Get(gTeapot)->SetRotation({ 0, ToRadians(215.0f), 0 });
+	gModels.Get(gSphere)->SetPosition({ 40, 10, 30 });
+	gModels.Get(gSphere)->SetRotation({ 0.0f, ToRadians(-20.0f), 0.0f });
+    gModels.Get(gCube)->SetPosition({ -15, 10, 0 });
+    gModels.Get(gTroll)->SetPosition({ 10, 0, 15 });
+    gModels.Get(gTroll)->SetScale(4.0f);
+    gModels.Get(gTroll)->SetRotation({ 0, ToRadians(180.0f), 0 });
 
 
 
     // Light set-up - using an array this time
-    for (int i = 0; i < NUM_LIGHTS; ++i)
-    {
-        gLights[i].model = new Model(gLightMesh);
-    }
-
     gLights[0].colour = { 0.8f, 0.8f, 1.0f };
     gLights[0].strength = 10;
-    gLights[0].model->SetPosition({ 30, 20, 0 });
-    gLights[0].model->SetScale(pow(gLights[0].strength, 0.7f)); // Convert light strength into a nice value for the scale of the light - equation is ad-hoc.
-	gLights[0].model->FaceTarget(gTeapot->Position());
+    gLights[0].position = { 30, 20, 0 };
+    gLights[0].scale = pow(gLights[0].strength, 0.7f); // Convert light strength into a nice value for the scale of the light - equation is ad-hoc.
+    gLights[0].target = gModels.Get(gTeapot)->Position();
 
     gLights[1].colour = { 1.0f, 0.8f, 0.2f };
     gLights[1].strength = 40;
-    gLights[1].model->SetPosition({ -20, 30, 20 });
-    gLights[1].model->SetScale(pow(gLights[1].strength, 0.7f));
-	gLights[1].model->FaceTarget({ 0, 0, 0 });
+    gLights[1].position = { -20, 30, 20 };
+    gLights[1].scale = pow(gLights[1].strength, 0.7f);
+    gLights[1].target = { 0, 0, 0 };
+
+    for (int i = 0; i < NUM_LIGHTS; ++i)
+    {
+        gLights[i].previousPosition = gLights[i].position;
+        gLights[i].previousTarget   = gLights[i].target;
+    }
 
 
     //// Set up camera ////
 
-    gCamera = new Camera();
+    gCamera = gSceneArena.New<Camera>();
     gCamera->SetPosition({ 15, 30,-70 });
     gCamera->SetRotation({ ToRadians(13), 0, 0 });
 
@@ -380,49 +477,34 @@ void ReleaseResources()
 
     if (gShadowMap1DepthStencil)  gShadowMap1DepthStencil->Release();
     if (gShadowMap1SRV)           gShadowMap1SRV->Release();
-    if (gShadowMap1Texture)       gShadowMap1Texture->Release();
+    ReleaseTracked(gShadowMap1Texture, MemoryCategory::ShadowMaps);
     if (gShadowMap2DepthStencil)  gShadowMap2DepthStencil->Release();
     if (gShadowMap2SRV)           gShadowMap2SRV->Release();
-    if (gShadowMap2Texture)       gShadowMap2Texture->Release();
+    ReleaseTracked(gShadowMap2Texture, MemoryCategory::ShadowMaps);
     if (gCellMapSRV)           gCellMapSRV->Release();
-    if (gCellMap)              gCellMap->Release();
+    ReleaseTracked(gCellMap, MemoryCategory::Textures);
 
     if (gLightDiffuseMapSRV)          gLightDiffuseMapSRV->Release();
-    if (gLightDiffuseMap)             gLightDiffuseMap->Release();
-    if (gFloorDiffuseSpecularMapSRV)  gFloorDiffuseSpecularMapSRV->Release();
-    if (gFloorDiffuseSpecularMap)     gFloorDiffuseSpecularMap->Release();
-    if (gSphereDiffuseSpecularMapSRV) gSphereDiffuseSpecularMapSRV->Release();
-    if (gSphereDiffuseSpecularMap)    gSphereDiffuseSpecularMap->Release();
-    if (gCubeDiffuseSpecularMapSRV)   gCubeDiffuseSpecularMapSRV->Release();
-    if (gCubeDiffuseSpecularMap)      gCubeDiffuseSpecularMap->Release();
-    if (gTeapotDiffuseSpecularMapSRV) gTeapotDiffuseSpecularMapSRV->Release();
-    if (gTeapotDiffuseSpecularMap)    gTeapotDiffuseSpecularMap->Release();
+    ReleaseTracked(gLightDiffuseMap, MemoryCategory::Textures);
+    ReleaseStressScene();
+    gTextureStreamer.Shutdown(); // Releases the streamed textures
+    gTeapotDiffuseSpecularMap = gSphereDiffuseSpecularMap = gCubeDiffuseSpecularMap = gFloorDiffuseSpecularMap = nullptr;
     if (gTrollDiffuseMapSRV)          gTrollDiffuseMapSRV->Release();
-    if (gTrollDiffuseMap)             gTrollDiffuseMap->Release();
+    ReleaseTracked(gTrollDiffuseMap, MemoryCategory::Textures);
 
-    if (gPerModelConstantBuffer)  gPerModelConstantBuffer->Release();
-    if (gPerFrameConstantBuffer)  gPerFrameConstantBuffer->Release();
+    ReleaseTracked(gPerModelConstantBuffer, MemoryCategory::ConstantBuffers);
+    ReleaseTracked(gPerFrameConstantBuffer, MemoryCategory::ConstantBuffers);
 
+    ReleaseSpriteRenderer();
     ReleaseShaders();
 
-    // See note in InitGeometry about why we're not using unique_ptr and having to manually delete
-    for (int i = 0; i < NUM_LIGHTS; ++i)
-    {
-        delete gLights[i].model;  gLights[i].model = nullptr;
-    }
-    delete gCamera; gCamera = nullptr;
-    delete gFloor;  gFloor  = nullptr;
-    delete gSphere; gSphere = nullptr;
-    delete gCube;   gCube   = nullptr;
-    delete gTeapot; gTeapot = nullptr;
-    delete gTroll;   gTroll = nullptr;
-
-    delete gLightMesh;  gLightMesh  = nullptr;
-    delete gFloorMesh;  gFloorMesh  = nullptr;
-    delete gSphereMesh; gSphereMesh = nullptr;
-    delete gCubeMesh;   gCubeMesh   = nullptr;
-    delete gTeapotMesh; gTeapotMesh = nullptr;
-    delete gTrollMesh;  gTrollMesh = nullptr;
+    gAssetPackage.Close();
+
+    // The models, then the meshes and camera, are destroyed together
+    gModels.Clear();
+    gSceneArena.Reset();
+    gCamera = nullptr;
+    gTeapotMesh = gSphereMesh = gCubeMesh = gFloorMesh = gTrollMesh = nullptr;
 }
 
 
@@ -432,10 +514,12 @@ void ReleaseResources()
 //--------------------------------------------------------------------------------------
 
 // Render the scene from the given light's point of view. Only renders depth buffer
-void RenderDepthBufferFromLight(int lightIndex)
+void RenderDepthBufferFromLight(const SceneSnapshot& snapshot, int lightIndex)
 {
+    PROFILE_ZONE("Shadow map pass");
+
     // Get camera-like matrices from the spotlight, seet in the constant buffer and send over to GPU
-    gPerFrameConstants.viewMatrix           = CalculateLightViewMatrix(lightIndex);
+    gPerFrameConstants.viewMatrix           = CalculateLightViewMatrix(snapshot, lightIndex);
     gPerFrameConstants.projectionMatrix     = CalculateLightProjectionMatrix(lightIndex);
     gPerFrameConstants.viewProjectionMatrix = gPerFrameConstants.viewMatrix * gPerFrameConstants.projectionMatrix;
     UpdateConstantBuffer(gPerFrameConstantBuffer, gPerFrameConstants);
@@ -458,12 +542,14 @@ void RenderDepthBufferFromLight(int lightIndex)
     gD3DContext->RSSetState(gCullFrontState);
 
     // Render models - no state changes required between each object in this situation (no textures used in this step)
-    gFloor->Render();
-    gTeapot->Render();
-    gSphere->Render();
-    gCube->Render();
-    gTroll->Render();
-
+    gModels.Get(gFloor)->Render();
+    gModels.Get(gTeapot)->Render(snapshot.teapotMatrix);
+    gModels.Get(gSphere)->Render();
+    gModels.Get(gCube)->Render();
+    gModels.Get(gTroll)->Render();
+
+    // Stress scene instances, if there are any
+    RenderStressSceneDepth(snapshot.stress);
 }
 
 
@@ -471,8 +557,10 @@ void RenderDepthBufferFromLight(int lightIndex)
 // Render everything in the scene from the given camera
 // This code is common between rendering the main scene and rendering the scene in the portal
 // See RenderScene function below
-void RenderSceneFromCamera(Camera* camera)
+void RenderSceneFromCamera(const SceneSnapshot& snapshot, Camera* camera)
 {
+    PROFILE_ZONE("Main pass");
+
     // Set camera matrices in the constant buffer and send over to GPU
     gPerFrameConstants.viewMatrix           = camera->ViewMatrix();
     gPerFrameConstants.projectionMatrix     = camera->ProjectionMatrix();
@@ -495,53 +583,53 @@ void RenderSceneFromCamera(Camera* camera)
     gD3DContext->OMSetDepthStencilState(gUseDepthBufferState, 0);
     gD3DContext->RSSetState(gCullBackState);
 
-    // Select the approriate textures and sampler to use in the pixel shader
-    gD3DContext->PSSetShaderResources(0, 1, &gFloorDiffuseSpecularMapSRV); // First parameter must match texture slot number in the shader
+    // Select the approriate textures and sampler to use in the pixel shader. The diffuse-specular maps are held in
+    // texture arrays, the per-model constants select which slice each model uses
+    ID3D11ShaderResourceView* floorMapSRV = gFloorDiffuseSpecularMap->SRV();
+    gD3DContext->PSSetShaderResources(0, 1, &floorMapSRV); // First parameter must match texture slot number in the shader
     gD3DContext->PSSetSamplers(0, 1, &gAnisotropic4xSampler);
 
     // Render model - it will update the model's world matrix and send it to the GPU in a constant buffer, then it will call
     // the Mesh render function, which will set up vertex & index buffer before finally calling Draw on the GPU
-    gFloor->Render();
+    gPerModelConstants.diffuseSpecularSlice = gFloorDiffuseSpecularMap->Slice();
+    gModels.Get(gFloor)->Render();
 
-    // Render other lit models, only change textures for each onee
-    gD3DContext->PSSetShaderResources(0, 1, &gTeapotDiffuseSpecularMapSRV); 
-    gTeapot->Render();
+    // Render other lit models, only change textures for each one. Textures of the same size and format share a texture
+    // array, so the bind is skipped when the array is already in place (the floor and teapot textures share one)
+    ID3D11ShaderResourceView* teapotMapSRV = gTeapotDiffuseSpecularMap->SRV();
+    if (teapotMapSRV != floorMapSRV)  gD3DContext->PSSetShaderResources(0, 1, &teapotMapSRV);
+    gPerModelConstants.diffuseSpecularSlice = gTeapotDiffuseSpecularMap->Slice();
+    gModels.Get(gTeapot)->Render(snapshot.teapotMatrix);
 
     gD3DContext->PSSetShader(gMixingTexturesPixelShader, nullptr, 0);
-    gD3DContext->PSSetShaderResources(0, 1, &gCubeDiffuseSpecularMapSRV);
-    gD3DContext->PSSetShaderResources(3, 1, &gFloorDiffuseSpecularMapSRV);
-    gCube->Render();
+    ID3D11ShaderResourceView* cubeMapSRV = gCubeDiffuseSpecularMap->SRV();
+    if (cubeMapSRV != teapotMapSRV)  gD3DContext->PSSetShaderResources(0, 1, &cubeMapSRV);
+    gD3DContext->PSSetShaderResources(3, 1, &floorMapSRV);
+    gPerModelConstants.diffuseSpecularSlice  = gCubeDiffuseSpecularMap->Slice();
+    gPerModelConstants.diffuseSpecularSlice2 = gFloorDiffuseSpecularMap->Slice();
+    gModels.Get(gCube)->Render();
 
     
     gD3DContext->PSSetShader(gScrollingPixelShader, nullptr, 0);
     gD3DContext->VSSetShader(gWigglingVertexShader, nullptr, 0);
-    gD3DContext->PSSetShaderResources(0, 1, &gSphereDiffuseSpecularMapSRV);
-    gSphere->Render();
-
-    //// Render troll and teapot - first pass ////
-    // Draw models inside out, slightly bigger and black
+    ID3D11ShaderResourceView* sphereMapSRV = gSphereDiffuseSpecularMap->SRV();
+    if (sphereMapSRV != cubeMapSRV)  gD3DContext->PSSetShaderResources(0, 1, &sphereMapSRV);
+    gPerModelConstants.diffuseSpecularSlice = gSphereDiffuseSpecularMap->Slice();
+    gModels.Get(gSphere)->Render();
 
-    // Outline drawing - slightly scales object and draws black
-    gD3DContext->VSSetShader(gCellShadingOutlineVertexShader, nullptr, 0);
-    gD3DContext->PSSetShader(gCellShadingOutlinePixelShader, nullptr, 0);
+    // Stress scene instances are lit models too, they select their own shaders and textures
+    RenderStressScene(snapshot.stress);
 
-    // States - no blending, normal depth buffer. However, use front culling to draw *inside* of model
-    gD3DContext->OMSetBlendState(gNoBlendingState, nullptr, 0xffffff);
-    gD3DContext->OMSetDepthStencilState(gUseDepthBufferState, 0);
-    gD3DContext->RSSetState(gCullFrontState);
-
-    // No textures needed, draws outline in plain colour
-
-    gTroll->Render();
-
-    //// Render troll and teapot - second pass ////
-    // Draw models right way round, normal sized and with cell shading
+    //// Render troll - first pass ////
+    // Draw the model with cell shading
 
     // Main cell shading shaders
     gD3DContext->VSSetShader(gCellShadingVertexShader, nullptr, 0);
     gD3DContext->PSSetShader(gCellShadingPixelShader, nullptr, 0);
 
-    // Switch back to the usual back face culling (not inside out)
+    // States - no blending, normal depth buffer and culling
+    gD3DContext->OMSetBlendState(gNoBlendingState, nullptr, 0xffffff);
+    gD3DContext->OMSetDepthStencilState(gUseDepthBufferState, 0);
     gD3DContext->RSSetState(gCullBackState);
 
     // Select the troll texture and sampler
@@ -549,21 +637,42 @@ void RenderSceneFromCamera(Camera* camera)
     gD3DContext->PSSetSamplers(0, 1, &gAnisotropic4xSampler);
 
     // Also, cell shading uses a special 1D "cell map", which uses point sampling
-    gD3DContext->PSSetShaderResources(1, 1, &gCellMapSRV); // First parameter must match texture slot number in the shaer
+    gD3DContext->PSSetShaderResources(4, 1, &gCellMapSRV); // First parameter must match texture slot number in the shaer (slot 4 so it doesn't replace a shadow map)
     gD3DContext->PSSetSamplers(1, 1, &gPointSampler);
 
     // Render troll model
-    gTroll->Render();
+    gModels.Get(gTroll)->Render();
+
+    //// Render troll - second pass ////
+    // Draw the outline as black quads along the troll's silhouette edges, which are found on the CPU each frame (see
+    // SilhouetteEdges.h). Only the outline is drawn, not the whole mesh again, so it costs much less than the troll itself
+
+    gD3DContext->VSSetShader(gCellShadingOutlineVertexShader, nullptr, 0);
+    gD3DContext->PSSetShader(gCellShadingOutlinePixelShader, nullptr, 0);
+
+    // States - depth is tested so outlines behind nearer surfaces are hidden, but not written. No culling, the quads can
+    // face either way. No textures needed, draws outline in plain colour
+    gD3DContext->OMSetDepthStencilState(gDepthReadOnlyState, 0);
+    gD3DContext->RSSetState(gCullNoneState);
+
+    gModels.Get(gTroll)->RenderOutline(InverseAffine(camera->ViewMatrix()).GetPosition());
 
 
     //// Render lights ////
+    // Each light is drawn as a flare facing the camera. The spotlights and the stress scene's point lights move, so they
+    // are collected into one batch of sprites each frame. The stress scene's runway lights use the same flare texture but
+    // never move, so they are drawn from a buffer written when the scene was spawned
 
-    // Select which shaders to use next
-    gD3DContext->VSSetShader(gBasicTransformVertexShader, nullptr, 0);
-    gD3DContext->PSSetShader(gLightModelPixelShader,      nullptr, 0);
+    gLightSprites.Clear();
+    for (int i = 0; i < NUM_LIGHTS; ++i)
+    {
+        // The light matrices are scaled to the size of the flares (see MakeLightMatrix)
+        const CMatrix4x4& lightMatrix = snapshot.lightMatrices[i];
+        gLightSprites.Add(lightMatrix.GetPosition(), Length(lightMatrix.GetXAxis()), snapshot.lightColours[i]);
+    }
+    AddStressSceneSprites(snapshot.stress, gLightSprites);
 
-    // Select the texture and sampler to use in the pixel shader
-    gD3DContext->PSSetShaderResources(0, 1, &gLightDiffuseMapSRV); // First parameter must match texture slot number in the shaer
+    // Select the sampler to use in the pixel shader, the sprite renderer selects the shaders and texture
     gD3DContext->PSSetSamplers(0, 1, &gAnisotropic4xSampler);
 
     // States - additive blending, read-only depth buffer and no culling (standard set-up for blending
@@ -571,12 +680,8 @@ void RenderSceneFromCamera(Camera* camera)
     gD3DContext->OMSetDepthStencilState(gDepthReadOnlyState, 0);
     gD3DContext->RSSetState(gCullNoneState);
 
-    // Render all the lights in the array
-    for (int i = 0; i < NUM_LIGHTS; ++i)
-    {
-        gPerModelConstants.objectColour = gLights[i].colour; // Set any per-model constants apart from the world matrix just before calling render (light colour here)
-        gLights[i].model->Render();
-    }
+    RenderSprites(gLightSprites, gLightDiffuseMapSRV);
+    RenderStressSceneRunwayLights(gLightDiffuseMapSRV);
 }
 
 
@@ -584,34 +689,43 @@ void RenderSceneFromCamera(Camera* camera)
 
 // Rendering the scene now renders everything twice. First it renders the scene for the portal into a texture.
 // Then it renders the main scene using the portal texture on a model.
+// Renders the latest snapshot of the scene, so can run while the simulation thread works on the next one
 void RenderScene()
 {
+    PROFILE_ZONE("RenderScene");
+    PIPELINE_CHECK(!gSimulationThread.OnWorkerThread(), "Scene rendered on the simulation thread");
+    auto submitStart = std::chrono::steady_clock::now();
+    gRenderCounters = {};
+
+    const SceneSnapshot& snapshot = gSceneSnapshots.BeginRead();
+    Camera camera = snapshot.camera; // The camera updates its matrices when asked for them, so use a copy
+
     //// Common settings ////
 
     // Set up the light information in the constant buffer
     // Don't send to the GPU yet, the function RenderSceneFromCamera will do that
-    gPerFrameConstants.light1Colour   = gLights[0].colour * gLights[0].strength;
-    gPerFrameConstants.light1Position = gLights[0].model->Position();
-    gPerFrameConstants.light1Facing   = Normalise(gLights[0].model->WorldMatrix().GetZAxis());    // Additional lighting information for spotlights
+    gPerFrameConstants.light1Colour   = snapshot.lightColours[0] * snapshot.lightStrengths[0];
+    gPerFrameConstants.light1Position = snapshot.lightMatrices[0].GetPosition();
+    gPerFrameConstants.light1Facing   = Normalise(snapshot.lightMatrices[0].GetZAxis());    // Additional lighting information for spotlights
     gPerFrameConstants.light1CosHalfAngle = cos(ToRadians(gSpotlightConeAngle / 2)); // --"--
-    gPerFrameConstants.light1ViewMatrix       = CalculateLightViewMatrix(0);         // Calculate camera-like matrices for...
-    gPerFrameConstants.light1ProjectionMatrix = CalculateLightProjectionMatrix(0);   //...lights to support shadow mapping
+    gPerFrameConstants.light1ViewMatrix       = CalculateLightViewMatrix(snapshot, 0); // Calculate camera-like matrices for...
+    gPerFrameConstants.light1ProjectionMatrix = CalculateLightProjectionMatrix(0);     //...lights to support shadow mapping
 
-    gPerFrameConstants.light2Colour = gLights[1].colour * gLights[1].strength;
-    gPerFrameConstants.light2Position = gLights[1].model->Position();
-    gPerFrameConstants.light2Facing = Normalise(gLights[1].model->WorldMatrix().GetZAxis());    // Additional lighting information for spotlights
+    gPerFrameConstants.light2Colour = snapshot.lightColours[1] * snapshot.lightStrengths[1];
+    gPerFrameConstants.light2Position = snapshot.lightMatrices[1].GetPosition();
+    gPerFrameConstants.light2Facing = Normalise(snapshot.lightMatrices[1].GetZAxis());    // Additional lighting information for spotlights
     gPerFrameConstants.light2CosHalfAngle = cos(ToRadians(gSpotlightConeAngle / 2)); // --"--
-    gPerFrameConstants.light2ViewMatrix = CalculateLightViewMatrix(1);         // Calculate camera-like matrices for...
-    gPerFrameConstants.light2ProjectionMatrix = CalculateLightProjectionMatrix(1);   //...lights to support shadow mapping
+    gPerFrameConstants.light2ViewMatrix = CalculateLightViewMatrix(snapshot, 1);       // Calculate camera-like matrices for...
+    gPerFrameConstants.light2ProjectionMatrix = CalculateLightProjectionMatrix(1);     //...lights to support shadow mapping
 
 
     gPerFrameConstants.ambientColour  = gAmbientColour;
     gPerFrameConstants.specularPower  = gSpecularPower;
-    gPerFrameConstants.cameraPosition = gCamera->Position();
+    gPerFrameConstants.cameraPosition = camera.Position();
 
-    gPerFrameConstants.wiggle = gWiggle;
-    gPerFrameConstants.shift = gShift;
-    gPerFrameConstants.fading = gFading;
+    gPerFrameConstants.wiggle = snapshot.wiggle;
+    gPerFrameConstants.shift  = snapshot.shift;
+    gPerFrameConstants.fading = snapshot.fading;
 
 
 
@@ -636,13 +750,13 @@ void RenderScene()
     gD3DContext->ClearDepthStencilView(gShadowMap1DepthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
 
     // Render the scene from the point of view of light 1 (only depth values written)
-    RenderDepthBufferFromLight(0);
+    RenderDepthBufferFromLight(snapshot, 0);
 
     gD3DContext->OMSetRenderTargets(0, nullptr, gShadowMap2DepthStencil);
     gD3DContext->ClearDepthStencilView(gShadowMap2DepthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
 
     // Render the scene from the point of view of light 2 (only depth values written)
-    RenderDepthBufferFromLight(1);
+    RenderDepthBufferFromLight(snapshot, 1);
     //**************************//
 
 
@@ -674,7 +788,7 @@ void RenderScene()
     gD3DContext->PSSetSamplers(1, 1, &gPointSampler);
 
     // Render the scene for the main window
-    RenderSceneFromCamera(gCamera);
+    RenderSceneFromCamera(snapshot, &camera);
 
     // Unbind shadow maps from shaders - prevents warnings from     DirectX when we try to render to the shadow maps again next frame
     ID3D11ShaderResourceView* nullView = nullptr;
@@ -693,8 +807,27 @@ void RenderScene()
     //// Scene completion ////
 
     // When drawing to the off-screen back buffer is complete, we "present" the image to the front buffer (the screen)
-    // Set first parameter to 1 to lock to vsync (typically 60fps)
-    gSwapChain->Present(lockFPS ? 1 : 0, 0);
+    // Set first parameter to 1 to lock to vsync (typically 60fps). The benchmark always runs at full speed
+    FramePacer::Clock::time_point inputTime = snapshot.inputTime;
+    gSceneSnapshots.EndRead();
+    std::chrono::duration<float> submitTime = std::chrono::steady_clock::now() - submitStart;
+    gSubmitTime = submitTime.count();
+
+    // With a frame rate cap, wait until it is time for this frame to be shown
+    {
+        PROFILE_ZONE("Frame pacing");
+        gFramePacer.BeforePresent();
+    }
+    PROFILE_ZONE("Present"); // Includes waiting for vsync and for the GPU to catch up
+    gSwapChain->Present(gFramePacer.Vsync() ? 1 : 0, 0);
+    gFramePacer.AfterPresent(inputTime);
+}
+
+
+// CPU time in seconds spent by the last RenderScene sending work to the GPU, not including Present
+float LastSubmitTime()
+{
+    return gSubmitTime;
 }
 
 
@@ -702,11 +835,51 @@ void RenderScene()
 // Scene Update
 //--------------------------------------------------------------------------------------
 
-// Update models and camera. frameTime is the time passed since the last frame
+// Ask for the mip level of a texture that a model needs this frame. The most detailed part of the model is the nearest
+// point of its bounding sphere, and the mip level is chosen so that there is about one texel per pixel there
+void RequestTextureDetail(Model* model, StreamedTexture* texture)
+{
+    Mesh* mesh = model->GetMesh();
+    CVector3 scale = model->Scale();
+    float minScale = std::min(scale.x, std::min(scale.y, scale.z));
+    float maxScale = std::max(scale.x, std::max(scale.y, scale.z));
+    float radius = mesh->BoundingRadius() * maxScale;
+
+    // Models behind the camera don't need any detail
+    CVector3 toModel = model->Position() - gCamera->Position();
+    if (Dot(toModel, gCamera->WorldMatrix().GetZAxis()) < -radius)  return;
+
+    // Screen pixels per world unit at the nearest point of the model and texels per world unit over the model's surface
+    // (the least scaled direction has the most texels per unit)
+    float distance = std::max(gCamera->NearClip(), Length(toModel) - radius);
+    float pixelsPerUnit = gViewportWidth * 0.5f / (std::tan(gCamera->FOV() * 0.5f) * distance);
+    float texelsPerUnit = std::max(texture->Width(), texture->Height()) * mesh->UVDensity() / minScale;
+
+    // Each mip level halves the texels per unit
+    float texelsPerPixel = texelsPerUnit / pixelsPerUnit;
+    texture->RequestMip(texelsPerPixel > 1.0f ? static_cast<uint32_t>(std::log2(texelsPerPixel)) : 0);
+}
+
+
+// Advance the simulation (models, lights, camera and effects) by one step. frameTime is the length of the step
 void UpdateScene(float frameTime)
 {
+    PROFILE_ZONE("UpdateScene");
+
+    // Remember where everything that moves was, rendering is between there and the result of this step
+    gModels.Get(gTeapot)->StartStep();
+    for (int i = 0; i < NUM_LIGHTS; ++i)
+    {
+        gLights[i].previousPosition = gLights[i].position;
+        gLights[i].previousTarget   = gLights[i].target;
+    }
+    gCamera->StartStep();
+    gPreviousWiggle = gWiggle;
+    gPreviousShift  = gShift;
+    gPreviousFading = gFading;
+
 	// Control teapot (will update its world matrix)
-	gTeapot->Control(frameTime, Key_I, Key_K, Key_J, Key_L, Key_U, Key_O, Key_Period, Key_Comma );
+	gModels.Get(gTeapot)->Control(frameTime, Key_I, Key_K, Key_J, Key_L, Key_U, Key_O, Key_Period, Key_Comma );
 
 
     // Change the lights
@@ -726,17 +899,76 @@ void UpdateScene(float frameTime)
     // Orbit the light - a bit of a cheat with the static variable [ask the tutor if you want to know what this is]
 	static float rotate = 0.0f;
     static bool go = true;
-	gLights[0].model->SetPosition( gTeapot->Position() + CVector3{ cos(rotate) * gLightOrbit, 10, sin(rotate) * gLightOrbit } );
-	gLights[0].model->FaceTarget(gTeapot->Position());
+	gLights[0].position = gModels.Get(gTeapot)->Position() + CVector3{ cos(rotate) * gLightOrbit, 10, sin(rotate) * gLightOrbit };
+	gLights[0].target = gModels.Get(gTeapot)->Position();
     if (go)  rotate -= gLightOrbitSpeed * frameTime;
     if (KeyHit(Key_1))  go = !go;
 
 	// Control camera (will update its view matrix)
 	gCamera->Control(frameTime, Key_Up, Key_Down, Key_Left, Key_Right, Key_W, Key_S, Key_A, Key_D );
 
+    // Stress scene instances and lights (the benchmark also takes over the camera)
+    UpdateStressScene(frameTime, gCamera);
+}
+
+
+// Take a snapshot of everything rendering needs, with moving models interpolation of the way (0 to 1) between where
+// they were before the last simulation step and where they are now. Call on the simulation thread after its steps
+void SnapshotScene(float interpolation)
+{
+    PROFILE_ZONE("SnapshotScene");
+
+    SceneSnapshot& snapshot = gSceneSnapshots.BeginWrite();
+    snapshot.teapotMatrix = gModels.Get(gTeapot)->InterpolatedMatrix(interpolation);
+    for (int i = 0; i < NUM_LIGHTS; ++i)
+    {
+        const Light& light = gLights[i];
+        CVector3 position = light.previousPosition + (light.position - light.previousPosition) * interpolation;
+        CVector3 target   = light.previousTarget   + (light.target   - light.previousTarget)   * interpolation;
+        snapshot.lightMatrices[i]  = MakeLightMatrix(position, target, light.scale);
+        snapshot.lightColours[i]   = gLights[i].colour;
+        snapshot.lightStrengths[i] = gLights[i].strength;
+    }
+    snapshot.camera = gCamera->Interpolated(interpolation);
+    snapshot.inputTime = gFramePacer.InputTime();
+
+    snapshot.wiggle = Lerp(gPreviousWiggle, gWiggle, interpolation);
+    snapshot.shift  = Lerp(gPreviousShift,  gShift,  interpolation);
+    snapshot.fading = Lerp(gPreviousFading, gFading, interpolation);
+
+    SnapshotStressScene(interpolation, snapshot.stress);
+    gSceneSnapshots.EndWrite();
+}
+
+
+// Update everything that is done once per rendered frame rather than in simulation steps: texture streaming, app
+// controls and the window title. frameTime is the time passed since the last frame
+void UpdateFrame(float frameTime)
+{
+    PROFILE_ZONE("UpdateFrame");
+    PIPELINE_CHECK(!gSimulationThread.Busy(), "Frame updated while the simulation is running");
+
+    // Stream in the texture detail needed for the new model and camera positions (the cube also uses the floor texture)
+    RequestTextureDetail(gModels.Get(gFloor),  gFloorDiffuseSpecularMap);
+    RequestTextureDetail(gModels.Get(gTeapot), gTeapotDiffuseSpecularMap);
+    RequestTextureDetail(gModels.Get(gCube),   gCubeDiffuseSpecularMap);
+    RequestTextureDetail(gModels.Get(gCube),   gFloorDiffuseSpecularMap);
+    RequestTextureDetail(gModels.Get(gSphere), gSphereDiffuseSpecularMap);
+    RequestStressSceneTextures();
+    gTextureStreamer.Update();
+
+
+    // Cycle through the frame pacing modes: vsync, frame rate cap, low latency frame rate cap and uncapped
+    if (KeyHit(Key_P))
+    {
+        int nextMode = (static_cast<int>(gFramePacer.Mode()) + 1) % static_cast<int>(PacingMode::Count);
+        gFramePacer.SetMode(static_cast<PacingMode>(nextMode));
+    }
 
-    // Toggle FPS limiting
-    if (KeyHit(Key_P))  lockFPS = !lockFPS;
+#if PROFILER_ENABLED
+    // Capture the profiler zones for the next few seconds, view Profile.json in chrome://tracing or https://ui.perfetto.dev
+    if (KeyHit(Key_F9))  Profiler::Instance().StartCapture(300, "Profile");
+#endif
 
     // Show frame time / FPS in the window title //
     const float fpsUpdateTime = 0.5f; // How long between updates (in seconds)
@@ -746,14 +978,39 @@ void UpdateScene(float frameTime)
     ++frameCount;
     if (totalFrameTime > fpsUpdateTime)
     {
-        // Displays FPS rounded to nearest int, and frame time (more useful for developers) in milliseconds to 2 decimal places
+        // The title is written into a fixed buffer so updating it doesn't use the heap. Displays FPS rounded to nearest
+        // int, and frame time (more useful for developers) in milliseconds to 2 decimal places
+        char windowTitle[512];
+        size_t length = 0;
+        auto append = [&](const char* format, auto... values)
+        {
+            int written = std::snprintf(windowTitle + length, sizeof(windowTitle) - length, format, values...);
+            if (written > 0)  length = std::min(length + written, sizeof(windowTitle) - 1);
+        };
         float avgFrameTime = totalFrameTime / frameCount;
-        std::ostringstream frameTimeMs;
-        frameTimeMs.precision(2);
-        frameTimeMs << std::fixed << avgFrameTime * 1000;
-        std::string windowTitle = "CO2409: Assignment - Frame Time: " + frameTimeMs.str() +
-                                  "ms, FPS: " + std::to_string(static_cast<int>(1 / avgFrameTime + 0.5f));
-        SetWindowTextA(gHWnd, windowTitle.c_str());
+        append("CO2409: Assignment - Frame Time: %.2fms, FPS: %d, Textures: %zuKB", avgFrameTime * 1000,
+               static_cast<int>(1 / avgFrameTime + 0.5f), gTextureStreamer.ResidentBytes() / 1024);
+
+        // Averages hide stutter, so also show the slowest frames
+        TimingSummary frameStats = gFrameStats.Summarise(FrameTiming::Frame);
+        append(", p99: %.2fms, Max: %.2fms", frameStats.p99, frameStats.max);
+
+        // Frame pacing mode, how closely the frame rate cap is kept to and how long input takes to reach the screen
+        PacingSummary pacing = gFramePacer.Summarise();
+        append(", %s", PacingModeName(gFramePacer.Mode()));
+        if (gFramePacer.Mode() == PacingMode::Capped || gFramePacer.Mode() == PacingMode::LowLatency)
+        {
+            append(" %dfps (error %.2fms)", static_cast<int>(gFramePacer.TargetFPS() + 0.5f), pacing.meanError);
+        }
+        append(", Latency: %.2fms", pacing.meanLatency);
+#if PROFILER_ENABLED
+        // CPU time of the last frame (from the previous frame's profiler zones)
+        append(", Update: %.2fms, Render: %.2fms", Profiler::Instance().LastFrameMilliseconds("UpdateScene") +
+                                                   Profiler::Instance().LastFrameMilliseconds("UpdateFrame"),
+                                                   Profiler::Instance().LastFrameMilliseconds("RenderScene"));
+        if (Profiler::Instance().Capturing())  append(" [Capturing profile]");
+#endif
+        SetWindowTextA(gHWnd, windowTitle);
         totalFrameTime = 0;
         frameCount = 0;
     }
@@ -26,10 +26,27 @@ void ReleaseResources();
 // Scene Render and Update
 //--------------------------------------------------------------------------------------
 
+// Render the latest snapshot of the scene (see SnapshotScene). Can run while the simulation thread is updating the
+// scene and taking the next snapshot
 void RenderScene();
 
-// frameTime is the time passed since the last frame
+// Advance the simulation (models, lights, camera and effects) by one step. frameTime is the length of the step, which
+// is fixed so the simulation doesn't depend on the frame rate
 void UpdateScene(float frameTime);
 
+// Take a snapshot of everything rendering needs, with the moving models and camera interpolation of the way (0 to 1)
+// between where they were before the last simulation step and where they are now (see FixedTimestep.h). Call after the
+// simulation steps of a frame, on the same thread. There must be a snapshot before the first RenderScene
+void SnapshotScene(float interpolation);
+
+// Update everything that is done once per rendered frame rather than in simulation steps: texture streaming, app
+// controls and the window title. frameTime is the time passed since the last frame. Call while the simulation isn't
+// running, it uses the live scene
+void UpdateFrame(float frameTime);
+
+// CPU time in seconds spent by the last RenderScene sending work to the GPU, not including Present (which waits for
+// vsync and for the GPU to catch up)
+float LastSubmitTime();
+
 
 #endif //_SCENE_H_INCLUDED_
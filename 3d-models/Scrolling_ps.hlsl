@@ -11,8 +11,9 @@
 //--------------------------------------------------------------------------------------
 // The later exercises will introduce textures although we will not look at them properly until later labs
 
-Texture2D DiffuseMap : register(t0); // A diffuse map is the main texture for a model - the t0 indicates it
-                                        // is in slot 0 (each shader can have only a fixed number of textures)
+Texture2DArray DiffuseMap : register(t0); // A diffuse map is the main texture for a model - the t0 indicates it
+                                          // is in slot 0 (each shader can have only a fixed number of textures)
+                                          // It is a texture array shared with other models, gDiffuseSpecularSlice selects the slice
 SamplerState Bilinear : register(s0); // A sampler is a filter for a texture like bilinear, trilinear or anisotropic
                                         // The s0 means use slot 0. There are a fixed number of slots for samplers.
 
@@ -27,7 +28,7 @@ float4 main(SimplePixelShaderInput input) : SV_Target
 {
     input.uv.y += shift;
 
-    float3 textureColour = DiffuseMap.Sample(Bilinear, input.uv); // This declares a local colour variable and samples
+    float3 textureColour = DiffuseMap.Sample(Bilinear, float3(input.uv, gDiffuseSpecularSlice)); // This declares a local colour variable and samples
                                                                     // the texture at the location given by the
                                                                     // UVs using trilinear filtering (the filtering mode
                                                                     // is defined earlier)
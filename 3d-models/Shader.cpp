@@ -4,8 +4,11 @@
 //--------------------------------------------------------------------------------------
 
 #include "Shader.h"
+#include "AssetPackage.h"
+#include "MemoryTracker.h"
 #include <fstream>
 #include <vector>
+#include <map>
 #include <d3dcompiler.h>
 
 //--------------------------------------------------------------------------------------
@@ -17,8 +20,7 @@
 // Vertex and pixel shader DirectX objects
 ID3D11VertexShader* gPixelLightingVertexShader = nullptr;
 ID3D11PixelShader*  gPixelLightingPixelShader  = nullptr;
-ID3D11VertexShader* gBasicTransformVertexShader = nullptr; // Used before light model and depth-only pixel shader
-ID3D11PixelShader*  gLightModelPixelShader  = nullptr;
+ID3D11VertexShader* gBasicTransformVertexShader = nullptr; // Used before the depth-only pixel shader
 ID3D11PixelShader* gDepthOnlyPixelShader = nullptr;
 ID3D11VertexShader* gWigglingVertexShader = nullptr;
 ID3D11PixelShader* gScrollingPixelShader = nullptr;
@@ -27,6 +29,15 @@ ID3D11VertexShader* gCellShadingVertexShader = nullptr;
 ID3D11PixelShader* gCellShadingPixelShader = nullptr;
 ID3D11VertexShader* gCellShadingOutlineVertexShader = nullptr;
 ID3D11PixelShader* gCellShadingOutlinePixelShader = nullptr;
+ID3D11VertexShader* gSpriteVertexShader = nullptr; // Used for light flares, see SpriteRenderer.h
+ID3D11PixelShader*  gSpritePixelShader  = nullptr;
+
+// Pixel shader permutations compiled so far, keyed by shader name and defines. The pixel lighting, mixing textures and
+// cell shading pixel shaders above are all permutations of Lighting_ps and are owned by this map
+std::map<std::string, ID3D11PixelShader*> gPixelShaderPermutations;
+
+// Compiled permutations are kept on disk so they are only compiled once
+ShaderCache gShaderCache;
 
 
 
@@ -43,26 +54,28 @@ bool LoadShaders()
     // To load them for use, include them here without the extension. Use the correct function for each.
     // Ensure you release the shaders in the ShutdownDirect3D function below
     gPixelLightingVertexShader = LoadVertexShader("ShadowMapping_vs"); // Note how the shader files are named to show what type they are
-    gPixelLightingPixelShader = LoadPixelShader("ShadowMapping_ps");
+    // The lit pixel shaders are permutations of one shader, each compiled with only the features it needs
+    gPixelLightingPixelShader  = LoadPixelShaderPermutation(gPixelLightingPermutation);
+    gMixingTexturesPixelShader = LoadPixelShaderPermutation(gMixingTexturesPermutation);
+    gCellShadingPixelShader    = LoadPixelShaderPermutation(gCellShadingPermutation);
     gBasicTransformVertexShader = LoadVertexShader("BasicTransform_vs");
-    gLightModelPixelShader = LoadPixelShader("LightModel_ps");
     gDepthOnlyPixelShader = LoadPixelShader("DepthOnly_ps");
     gWigglingVertexShader = LoadVertexShader("Wiggling_vs");
     gScrollingPixelShader = LoadPixelShader("Scrolling_ps");
-    gMixingTexturesPixelShader = LoadPixelShader("MixingTextures_ps");
     gCellShadingVertexShader = LoadVertexShader("CellShading_vs");
-    gCellShadingPixelShader = LoadPixelShader("CellShading_ps");
     gCellShadingOutlineVertexShader = LoadVertexShader("CellShadingOutline_vs");
     gCellShadingOutlinePixelShader = LoadPixelShader("CellShadingOutline_ps");
+    gSpriteVertexShader = LoadVertexShader("Sprite_vs");
+    gSpritePixelShader  = LoadPixelShader("Sprite_ps");
 
 
     if (gPixelLightingVertexShader == nullptr || gPixelLightingPixelShader == nullptr || gWigglingVertexShader == nullptr ||
-        gBasicTransformVertexShader == nullptr || gLightModelPixelShader == nullptr || gDepthOnlyPixelShader == nullptr ||
+        gBasicTransformVertexShader == nullptr || gDepthOnlyPixelShader == nullptr ||
         gScrollingPixelShader == nullptr || gMixingTexturesPixelShader == nullptr || gCellShadingVertexShader == nullptr ||
         gCellShadingPixelShader == nullptr || gCellShadingOutlineVertexShader == nullptr ||
-        gCellShadingOutlinePixelShader == nullptr)
+        gCellShadingOutlinePixelShader == nullptr || gSpriteVertexShader == nullptr || gSpritePixelShader == nullptr)
     {
-        gLastError = "Error loading shaders";
+        gLastError = "Error loading shaders" + (gLastError.empty() ? "" : ": " + gLastError);
         return false;
     }
 
@@ -73,17 +86,24 @@ bool LoadShaders()
 void ReleaseShaders()
 {
     if (gDepthOnlyPixelShader)        gDepthOnlyPixelShader->Release();
-    if (gLightModelPixelShader)       gLightModelPixelShader->Release();
     if (gBasicTransformVertexShader)  gBasicTransformVertexShader->Release();
-    if (gPixelLightingPixelShader)    gPixelLightingPixelShader->Release();
     if (gPixelLightingVertexShader)   gPixelLightingVertexShader->Release();
     if (gWigglingVertexShader)        gWigglingVertexShader->Release();
     if (gScrollingPixelShader)        gScrollingPixelShader->Release();
-    if (gMixingTexturesPixelShader)   gMixingTexturesPixelShader->Release();
     if (gCellShadingVertexShader)     gCellShadingVertexShader->Release();
-    if (gCellShadingPixelShader)      gCellShadingPixelShader->Release();
     if (gCellShadingOutlineVertexShader) gCellShadingOutlineVertexShader->Release();
     if (gCellShadingOutlinePixelShader) gCellShadingOutlinePixelShader->Release();
+    if (gSpriteVertexShader)          gSpriteVertexShader->Release();
+    if (gSpritePixelShader)           gSpritePixelShader->Release();
+
+    for (auto& permutation : gPixelShaderPermutations)
+    {
+        if (permutation.second)  permutation.second->Release();
+    }
+    gPixelShaderPermutations.clear();
+    gPixelLightingPixelShader  = nullptr;
+    gMixingTexturesPixelShader = nullptr;
+    gCellShadingPixelShader    = nullptr;
 }
 
 
@@ -92,6 +112,15 @@ void ReleaseShaders()
 // to this function. The returned pointer needs to be released before quitting. Returns nullptr on failure. 
 ID3D11VertexShader* LoadVertexShader(std::string shaderName)
 {
+    // Use the bytecode straight from the asset package if it has been cooked into it
+    const PackageEntry* cooked = gAssetPackage.Find(shaderName + ".cso", AssetType::Shader);
+    if (cooked != nullptr)
+    {
+        ID3D11VertexShader* shader;
+        HRESULT hr = gD3DDevice->CreateVertexShader(gAssetPackage.Data(*cooked), static_cast<SIZE_T>(cooked->size), nullptr, &shader);
+        return SUCCEEDED(hr) ? shader : nullptr;
+    }
+
     // Open compiled shader object file
     std::ifstream shaderFile(shaderName + ".cso", std::ios::in | std::ios::binary | std::ios::ate);
     if (!shaderFile.is_open())
@@ -126,6 +155,15 @@ ID3D11VertexShader* LoadVertexShader(std::string shaderName)
 // Basically the same code as above but for pixel shaders
 ID3D11PixelShader* LoadPixelShader(std::string shaderName)
 {
+    // Use the bytecode straight from the asset package if it has been cooked into it
+    const PackageEntry* cooked = gAssetPackage.Find(shaderName + ".cso", AssetType::Shader);
+    if (cooked != nullptr)
+    {
+        ID3D11PixelShader* shader;
+        HRESULT hr = gD3DDevice->CreatePixelShader(gAssetPackage.Data(*cooked), static_cast<SIZE_T>(cooked->size), nullptr, &shader);
+        return SUCCEEDED(hr) ? shader : nullptr;
+    }
+
     // Open compiled shader object file
     std::ifstream shaderFile(shaderName + ".cso", std::ios::in | std::ios::binary | std::ios::ate);
     if (!shaderFile.is_open())
@@ -154,6 +192,87 @@ ID3D11PixelShader* LoadPixelShader(std::string shaderName)
     return shader;
 }
 
+// Get a permutation of a pixel shader: the shader "shaderName.hlsl" compiled with the permutation's preprocessor keys.
+// The source is compiled at runtime so must not be compiled by the project. The bytecode is taken from the asset
+// package if the permutation has been cooked into it. Otherwise the permutation is compiled the first time it is asked
+// for and the bytecode is kept in the shader cache folder so later runs don't compile it again. The same permutation is
+// returned for repeated calls, and is released by ReleaseShaders (don't release it yourself). Returns nullptr on
+// failure with the compiler errors in gLastError
+ID3D11PixelShader* LoadPixelShaderPermutation(const ShaderPermutation& permutation)
+{
+    std::string permutationName = ShaderPermutationName(permutation);
+    auto existing = gPixelShaderPermutations.find(permutationName);
+    if (existing != gPixelShaderPermutations.end())  return existing->second;
+
+    // The cooker compiles every permutation the app uses (AppShaderPermutations), so normally there's nothing to compile
+    const PackageEntry* cooked = gAssetPackage.Find(ShaderPermutationAssetName(permutation), AssetType::Shader);
+    if (cooked != nullptr)
+    {
+        ID3D11PixelShader* shader;
+        HRESULT hr = gD3DDevice->CreatePixelShader(gAssetPackage.Data(*cooked), static_cast<SIZE_T>(cooked->size), nullptr, &shader);
+        if (FAILED(hr))
+        {
+            gLastError = "Error creating " + permutationName;
+            return nullptr;
+        }
+        gPixelShaderPermutations[permutationName] = shader;
+        return shader;
+    }
+
+    std::string sourceName = permutation.shaderName + ".hlsl";
+    std::string source;
+    if (!LoadShaderSource(sourceName, source))
+    {
+        gLastError = "Error reading shader source " + sourceName;
+        return nullptr;
+    }
+
+    // The cache key covers the source, defines and compile settings, so any change to them compiles a new permutation
+    uint64_t key = ShaderCacheKey(source, permutation.defines, PERMUTATION_ENTRY_POINT, PERMUTATION_TARGET,
+                                  PERMUTATION_COMPILE_FLAGS);
+
+    std::vector<uint8_t> byteCode;
+    if (!gShaderCache.Load(key, byteCode))
+    {
+        std::vector<D3D_SHADER_MACRO> macros;
+        for (auto& define : permutation.defines.List())  macros.push_back({ define.first.c_str(), define.second.c_str() });
+        macros.push_back({ nullptr, nullptr });
+
+        ID3DBlob* compiledShader = nullptr;
+        ID3DBlob* errors = nullptr;
+        HRESULT hr = D3DCompile(source.data(), source.size(), sourceName.c_str(), macros.data(), nullptr,
+                                PERMUTATION_ENTRY_POINT, PERMUTATION_TARGET, PERMUTATION_COMPILE_FLAGS, 0, &compiledShader, &errors);
+        if (FAILED(hr))
+        {
+            gLastError = "Error compiling " + permutationName;
+            if (errors)
+            {
+                gLastError += "\n" + std::string(static_cast<const char*>(errors->GetBufferPointer()), errors->GetBufferSize());
+                errors->Release();
+            }
+            return nullptr;
+        }
+        if (errors)  errors->Release(); // Warnings only
+
+        const uint8_t* compiledData = static_cast<const uint8_t*>(compiledShader->GetBufferPointer());
+        byteCode.assign(compiledData, compiledData + compiledShader->GetBufferSize());
+        compiledShader->Release();
+
+        gShaderCache.Store(key, byteCode.data(), byteCode.size()); // Failing to store only means compiling again next run
+    }
+
+    ID3D11PixelShader* shader;
+    HRESULT hr = gD3DDevice->CreatePixelShader(byteCode.data(), byteCode.size(), nullptr, &shader);
+    if (FAILED(hr))
+    {
+        gLastError = "Error creating " + permutationName;
+        return nullptr;
+    }
+
+    gPixelShaderPermutations[permutationName] = shader;
+    return shader;
+}
+
 // Very advanced topic: When creating a vertex layout for geometry (see Scene.cpp), you need the signature
 // (bytecode) of a shader that uses that vertex layout. This is an annoying requirement and tends to create
 // unnecessary coupling between shaders and vertex buffers.
@@ -209,7 +328,7 @@ ID3DBlob* CreateSignatureForVertexLayout(const D3D11_INPUT_ELEMENT_DESC vertexLa
 // buffer the same size as the structure. That makes updating values from C++ to shader easy - see the main code.
 
 // Create and return a constant buffer of the given size
-// The returned pointer needs to be released before quitting. Returns nullptr on failure. 
+// The returned pointer needs to be released before quitting, with ReleaseTracked. Returns nullptr on failure. 
 ID3D11Buffer* CreateConstantBuffer(int size)
 {
     D3D11_BUFFER_DESC cbDesc;
@@ -225,6 +344,7 @@ ID3D11Buffer* CreateConstantBuffer(int size)
         return nullptr;
     }
 
+    TrackMemory(MemoryCategory::ConstantBuffers, MemoryHeap::GPU, cbDesc.ByteWidth);
     return constantBuffer;
 }
 
@@ -6,6 +6,7 @@
 #define _SHADER_H_INCLUDED_
 
 #include "Common.h"
+#include "ShaderPermutation.h"
 
 //--------------------------------------------------------------------------------------
 // Global Variables
@@ -18,7 +19,6 @@
 extern ID3D11VertexShader* gPixelLightingVertexShader;
 extern ID3D11PixelShader*  gPixelLightingPixelShader;
 extern ID3D11VertexShader* gBasicTransformVertexShader;
-extern ID3D11PixelShader*  gLightModelPixelShader;
 extern ID3D11PixelShader*  gDepthOnlyPixelShader;
 extern ID3D11VertexShader* gWigglingVertexShader;
 extern ID3D11PixelShader*  gScrollingPixelShader;
@@ -27,6 +27,8 @@ extern ID3D11VertexShader* gCellShadingVertexShader;
 extern ID3D11PixelShader*  gCellShadingPixelShader;
 extern ID3D11PixelShader* gCellShadingOutlinePixelShader;
 extern ID3D11VertexShader* gCellShadingOutlineVertexShader;
+extern ID3D11VertexShader* gSpriteVertexShader;
+extern ID3D11PixelShader*  gSpritePixelShader;
 
 
 
@@ -46,7 +48,8 @@ void ReleaseShaders();
 //--------------------------------------------------------------------------------------
 
 // Create and return a constant buffer of the given size
-// The returned pointer needs to be released before quitting. Returns nullptr on failure
+// The returned pointer needs to be released before quitting, with ReleaseTracked as its memory is counted in the
+// ConstantBuffers category (see GraphicsHelpers.h). Returns nullptr on failure
 ID3D11Buffer* CreateConstantBuffer(int size);
 
 
@@ -59,6 +62,12 @@ ID3D11Buffer* CreateConstantBuffer(int size);
 ID3D11VertexShader* LoadVertexShader(std::string shaderName);
 ID3D11PixelShader*  LoadPixelShader (std::string shaderName);
 
+// Get a permutation of a pixel shader: the shader "shaderName.hlsl" compiled with the permutation's preprocessor keys.
+// The source is compiled at runtime so must not be compiled by the project. Permutations are taken from the asset
+// package when cooked into it, otherwise compiled on first use and cached on disk (see ShaderPermutation.h). The
+// returned shader is released by ReleaseShaders. Returns nullptr on failure with the compiler errors in gLastError
+ID3D11PixelShader* LoadPixelShaderPermutation(const ShaderPermutation& permutation);
+
 // Helper function. Returns nullptr on failure.
 ID3DBlob* CreateSignatureForVertexLayout(const D3D11_INPUT_ELEMENT_DESC vertexLayout[], int numElements);
 
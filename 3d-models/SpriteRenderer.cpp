@@ -0,0 +1,178 @@
+//--------------------------------------------------------------------------------------
+// Drawing sprite batches
+//--------------------------------------------------------------------------------------
+
+#include "SpriteRenderer.h"
+#include "Shader.h"          // Sprite shaders and helper function CreateSignatureForVertexLayout
+#include "GraphicsHelpers.h" // Render counters, memory accounting
+#include "Profiler.h"
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+
+namespace
+{
+    ID3D11InputLayout* gSpriteLayout       = nullptr;
+    ID3D11Buffer*      gSpriteVertexBuffer = nullptr;
+    ID3D11Buffer*      gSpriteIndexBuffer  = nullptr;
+
+    // Set the sprite shaders, the texture and the input assembler state to draw sprites from the given vertex buffer
+    void SetSpriteState(ID3D11Buffer* vertexBuffer, ID3D11ShaderResourceView* texture)
+    {
+        gD3DContext->VSSetShader(gSpriteVertexShader, nullptr, 0);
+        gD3DContext->PSSetShader(gSpritePixelShader,  nullptr, 0);
+        gD3DContext->PSSetShaderResources(0, 1, &texture);
+
+        UINT stride = sizeof(SpriteVertex);
+        UINT offset = 0;
+        gD3DContext->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+        gD3DContext->IASetInputLayout(gSpriteLayout);
+        gD3DContext->IASetIndexBuffer(gSpriteIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
+        gD3DContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        gRenderCounters.stateChanges += 7;
+    }
+}
+
+
+// Create the vertex and index buffers shared by all sprite batches. Call after the shaders are loaded. Returns true on
+// success
+bool InitSpriteRenderer()
+{
+    // Describe the sprite vertices (SpriteVertex in SpriteBatch.h) to DirectX
+    D3D11_INPUT_ELEMENT_DESC vertexElements[] =
+    {
+        { "Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(SpriteVertex, position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "Size",     0, DXGI_FORMAT_R32_FLOAT,       0, offsetof(SpriteVertex, size),     D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "Colour",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(SpriteVertex, colour),   D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "Rotation", 0, DXGI_FORMAT_R32_FLOAT,       0, offsetof(SpriteVertex, rotation), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    };
+    const int numElements = sizeof(vertexElements) / sizeof(vertexElements[0]);
+    auto shaderSignature = CreateSignatureForVertexLayout(vertexElements, numElements);
+    if (shaderSignature == nullptr)  return false;
+    HRESULT hr = gD3DDevice->CreateInputLayout(vertexElements, numElements, shaderSignature->GetBufferPointer(),
+                                               shaderSignature->GetBufferSize(), &gSpriteLayout);
+    shaderSignature->Release();
+    if (FAILED(hr))  return false;
+
+    // The sprites are rewritten every time they are drawn, so the vertex buffer is dynamic
+    D3D11_BUFFER_DESC bufferDesc;
+    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+    bufferDesc.ByteWidth = MAX_SPRITES_PER_DRAW * SPRITE_VERTICES_PER_SPRITE * sizeof(SpriteVertex);
+    bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    bufferDesc.MiscFlags = 0;
+    if (FAILED(gD3DDevice->CreateBuffer(&bufferDesc, nullptr, &gSpriteVertexBuffer)))  return false;
+    TrackMemory(MemoryCategory::Meshes, MemoryHeap::GPU, bufferDesc.ByteWidth);
+
+    // The indices are the same for every batch: two triangles for each sprite
+    std::vector<uint16_t> spriteIndices(MAX_SPRITES_PER_DRAW * SPRITE_INDICES_PER_SPRITE);
+    for (uint32_t sprite = 0; sprite < MAX_SPRITES_PER_DRAW; ++sprite)
+    {
+        uint16_t first = static_cast<uint16_t>(sprite * SPRITE_VERTICES_PER_SPRITE);
+        uint16_t* index = &spriteIndices[sprite * SPRITE_INDICES_PER_SPRITE];
+        index[0] = first;      index[1] = first + 1;  index[2] = first + 2;
+        index[3] = first + 2;  index[4] = first + 1;  index[5] = first + 3;
+    }
+
+    D3D11_SUBRESOURCE_DATA initData;
+    bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    bufferDesc.ByteWidth = static_cast<UINT>(spriteIndices.size() * sizeof(uint16_t));
+    bufferDesc.CPUAccessFlags = 0;
+    initData.pSysMem = spriteIndices.data();
+    if (FAILED(gD3DDevice->CreateBuffer(&bufferDesc, &initData, &gSpriteIndexBuffer)))  return false;
+    TrackMemory(MemoryCategory::Meshes, MemoryHeap::GPU, bufferDesc.ByteWidth);
+
+    return true;
+}
+
+
+// Release the sprite buffers
+void ReleaseSpriteRenderer()
+{
+    ReleaseTracked(gSpriteIndexBuffer,  MemoryCategory::Meshes);
+    ReleaseTracked(gSpriteVertexBuffer, MemoryCategory::Meshes);
+    if (gSpriteLayout)  gSpriteLayout->Release();
+    gSpriteLayout = nullptr;
+}
+
+
+// Draw a batch of sprites facing the camera with the given texture, multiplied by each sprite's colour. Sets the sprite
+// shaders and texture. The per-frame constants and the sampler must already be set, and the states, which are usually
+// additive blending, read-only depth and no culling, so sprites can be drawn in any order
+void RenderSprites(const SpriteBatch& sprites, ID3D11ShaderResourceView* texture)
+{
+    if (sprites.Empty() || gSpriteVertexBuffer == nullptr)  return;
+    PROFILE_ZONE("Sprites");
+    SetSpriteState(gSpriteVertexBuffer, texture);
+
+    // Write as many sprites as the buffer holds and draw them, until the whole batch is drawn
+    for (uint32_t first = 0; first < sprites.Size(); first += MAX_SPRITES_PER_DRAW)
+    {
+        uint32_t numSprites = std::min(MAX_SPRITES_PER_DRAW, sprites.Size() - first);
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (FAILED(gD3DContext->Map(gSpriteVertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))  return;
+        sprites.WriteVertices(first, numSprites, static_cast<SpriteVertex*>(mapped.pData));
+        gD3DContext->Unmap(gSpriteVertexBuffer, 0);
+
+        gD3DContext->DrawIndexed(numSprites * SPRITE_INDICES_PER_SPRITE, 0, 0);
+        ++gRenderCounters.drawCalls;
+        gRenderCounters.triangles += numSprites * 2;
+    }
+}
+
+
+
+// Write a batch of sprites into a new static buffer, releasing any sprites it held before. An empty batch leaves no
+// buffer. Returns true on success
+bool CreateStaticSprites(const SpriteBatch& sprites, StaticSprites& staticSprites)
+{
+    ReleaseStaticSprites(staticSprites);
+    if (sprites.Empty())  return true;
+
+    std::vector<SpriteVertex> vertices(sprites.Size() * SPRITE_VERTICES_PER_SPRITE);
+    sprites.WriteVertices(0, sprites.Size(), vertices.data());
+
+    D3D11_BUFFER_DESC bufferDesc;
+    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    bufferDesc.ByteWidth = static_cast<UINT>(vertices.size() * sizeof(SpriteVertex));
+    bufferDesc.CPUAccessFlags = 0;
+    bufferDesc.MiscFlags = 0;
+    D3D11_SUBRESOURCE_DATA initData;
+    initData.pSysMem = vertices.data();
+    if (FAILED(gD3DDevice->CreateBuffer(&bufferDesc, &initData, &staticSprites.vertexBuffer)))  return false;
+    TrackMemory(MemoryCategory::Meshes, MemoryHeap::GPU, bufferDesc.ByteWidth);
+
+    staticSprites.numSprites = sprites.Size();
+    return true;
+}
+
+
+// Release the buffer of static sprites
+void ReleaseStaticSprites(StaticSprites& staticSprites)
+{
+    ReleaseTracked(staticSprites.vertexBuffer, MemoryCategory::Meshes);
+    staticSprites.numSprites = 0;
+}
+
+
+// Draw static sprites with the given texture, in the same way and with the same requirements as RenderSprites
+void RenderStaticSprites(const StaticSprites& staticSprites, ID3D11ShaderResourceView* texture)
+{
+    if (staticSprites.vertexBuffer == nullptr || gSpriteIndexBuffer == nullptr)  return;
+    PROFILE_ZONE("Static sprites");
+    SetSpriteState(staticSprites.vertexBuffer, texture);
+
+    // The shared indices only reach MAX_SPRITES_PER_DRAW sprites, so larger buffers are drawn in parts, each part
+    // offsetting the indices to its first vertex
+    for (uint32_t first = 0; first < staticSprites.numSprites; first += MAX_SPRITES_PER_DRAW)
+    {
+        uint32_t numSprites = std::min(MAX_SPRITES_PER_DRAW, staticSprites.numSprites - first);
+        gD3DContext->DrawIndexed(numSprites * SPRITE_INDICES_PER_SPRITE, 0, first * SPRITE_VERTICES_PER_SPRITE);
+        ++gRenderCounters.drawCalls;
+        gRenderCounters.triangles += numSprites * 2;
+    }
+}
@@ -0,0 +1,53 @@
+//--------------------------------------------------------------------------------------
+// Drawing sprite batches
+//--------------------------------------------------------------------------------------
+// Draws the sprites of a SpriteBatch (see SpriteBatch.h) with one texture. The sprites are
+// written into a dynamic vertex buffer each time and drawn together, so a batch costs one
+// draw call however many sprites it has (up to MAX_SPRITES_PER_DRAW, larger batches are
+// drawn in several parts). The lights and their flares are drawn this way rather than as a
+// model each, which needed a constant buffer update and a draw call per light. Sprites that
+// never move can be written once into a static buffer of their own instead (StaticSprites).
+
+#ifndef _SPRITE_RENDERER_H_INCLUDED_
+#define _SPRITE_RENDERER_H_INCLUDED_
+
+#include "Common.h"
+#include "SpriteBatch.h"
+
+
+// Sprites drawn in one call at most, the most whose vertices can be reached with 16-bit indices
+const uint32_t MAX_SPRITES_PER_DRAW = 65536 / SPRITE_VERTICES_PER_SPRITE;
+
+
+// Create the vertex and index buffers shared by all sprite batches. Call after the shaders are loaded. Returns true on
+// success
+bool InitSpriteRenderer();
+
+// Release the sprite buffers
+void ReleaseSpriteRenderer();
+
+// Draw a batch of sprites facing the camera with the given texture, multiplied by each sprite's colour. Sets the sprite
+// shaders and texture. The per-frame constants and the sampler must already be set, and the states, which are usually
+// additive blending, read-only depth and no culling, so sprites can be drawn in any order
+void RenderSprites(const SpriteBatch& sprites, ID3D11ShaderResourceView* texture);
+
+
+// Sprites written once into an immutable vertex buffer, so drawing them doesn't rewrite any vertices
+struct StaticSprites
+{
+    ID3D11Buffer* vertexBuffer = nullptr;
+    uint32_t      numSprites   = 0;
+};
+
+// Write a batch of sprites into a new static buffer, releasing any sprites it held before. An empty batch leaves no
+// buffer. Returns true on success
+bool CreateStaticSprites(const SpriteBatch& sprites, StaticSprites& staticSprites);
+
+// Release the buffer of static sprites
+void ReleaseStaticSprites(StaticSprites& staticSprites);
+
+// Draw static sprites with the given texture, in the same way and with the same requirements as RenderSprites
+void RenderStaticSprites(const StaticSprites& staticSprites, ID3D11ShaderResourceView* texture);
+
+
+#endif //_SPRITE_RENDERER_H_INCLUDED_
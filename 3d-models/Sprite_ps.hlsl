@@ -0,0 +1,27 @@
+//--------------------------------------------------------------------------------------
+// Pixel shader for camera-facing sprites
+//--------------------------------------------------------------------------------------
+// Samples the sprite texture and tints it with the sprite's colour
+
+#include "Common.hlsli" // Shaders can also use include files - note the extension
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+Texture2D    SpriteMap  : register(t0); // The same texture for every sprite in a batch
+SamplerState TexSampler : register(s0);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(SpritePixelShaderInput input) : SV_Target
+{
+    // Ignoring any alpha in the texture, sprites are drawn with additive blending where black shows nothing
+    float3 spriteMapColour = SpriteMap.Sample(TexSampler, input.uv).rgb;
+
+    return float4(input.colour * spriteMapColour, 1.0f);
+}
@@ -0,0 +1,35 @@
+//--------------------------------------------------------------------------------------
+// Vertex shader for camera-facing sprites
+//--------------------------------------------------------------------------------------
+
+#include "Common.hlsli" // Shaders can also use include files - note the extension
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+// Sprites are drawn as quads of four vertices that all carry the whole sprite (see SpriteBatch.h). The vertex number
+// picks the corner: 0 top-left, 1 top-right, 2 bottom-left, 3 bottom-right. The corner is placed in view space, so the
+// quad always faces the camera and no camera vectors need to be written into the vertices on the CPU
+SpritePixelShaderInput main(SpriteVertex sprite, uint vertexId : SV_VertexID)
+{
+    SpritePixelShaderInput output; // This is the data the pixel shader requires from this vertex shader
+
+    float2 corner = float2((vertexId & 1) ? 0.5f : -0.5f, (vertexId & 2) ? -0.5f : 0.5f);
+
+    // Spin the corner around the centre of the sprite
+    float sinRotation, cosRotation;
+    sincos(sprite.rotation, sinRotation, cosRotation);
+    float2 offset = float2(corner.x * cosRotation - corner.y * sinRotation, corner.x * sinRotation + corner.y * cosRotation);
+
+    // Move the centre into view space, where x and y are across and up the screen, then out to the corner
+    float4 viewPosition = mul(gViewMatrix, float4(sprite.position, 1));
+    viewPosition.xy += offset * sprite.size;
+    output.projectedPosition = mul(gProjectionMatrix, viewPosition);
+
+    output.uv     = float2(corner.x + 0.5f, 0.5f - corner.y);
+    output.colour = sprite.colour;
+
+    return output; // Ouput data sent down the pipeline (to the pixel shader)
+}
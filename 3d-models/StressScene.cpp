@@ -0,0 +1,648 @@
+//--------------------------------------------------------------------------------------
+// Stress scene and scalability benchmark
+//--------------------------------------------------------------------------------------
+
+#include "StressScene.h"
+#include "Mesh.h"
+#include "MeshImport.h"
+#include "MeshPrimitives.h"
+#include "Model.h"
+#include "Shader.h"
+#include "SpriteRenderer.h"
+#include "Common.h"
+#include "GraphicsHelpers.h"
+#include "TextureStreamer.h"
+#include "FrameStats.h"
+#include "Profiler.h"
+#include "Allocators.h"
+#include "Pipeline.h"
+#include "MathHelpers.h"
+
+#include <psapi.h> // Process memory use
+#include <vector>
+#include <random>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+//--------------------------------------------------------------------------------------
+// Stress Scene Data
+//--------------------------------------------------------------------------------------
+
+// The point light constants sent to the GPU, see Common.h. Filled from a snapshot when rendering
+PointLightConstants gPointLightConstants;
+ID3D11Buffer*       gPointLightConstantBuffer = nullptr;
+
+// Meshes loaded for the main scene in Scene.cpp, which outlive the stress scene
+extern Mesh* gTeapotMesh;
+extern Mesh* gTrollMesh;
+
+namespace
+{
+    // The meshes used by the instances and the texture used with each, instances take each one in turn. A mesh with
+    // sphere segments is a generated sphere with that many segments and rings rather than a file (the name is only used
+    // in error messages), so its detail can be changed here. A mesh the main scene has already loaded is used from there
+    // rather than loaded again
+    struct StressMesh
+    {
+        const char*  meshFile;
+        unsigned int sphereSegments;
+        Mesh* const* sceneMesh;
+        const char*  textureFile;
+    };
+    const StressMesh STRESS_MESHES[] =
+    {
+        { "Models/Teapot.x",         0,  &gTeapotMesh, "Textures/PatternDiffuseSpecular.dds" },
+        { "Generated sphere",        24, nullptr,      "Textures/GrassDiffuseSpecular.dds"   },
+        { "Models/Troll.x",          0,  &gTrollMesh,  "Textures/TrollDiffuseSpecular.dds"   },
+        { "Models/CargoContainer.x", 0,  nullptr,      "Textures/CargoA.dds"                 },
+    };
+    const uint32_t NUM_STRESS_MESHES = sizeof(STRESS_MESHES) / sizeof(STRESS_MESHES[0]);
+
+    const float    INSTANCE_SPACING = 20.0f; // Distance between instances in the grid, the other patterns cover the same area
+    const float    INSTANCE_RADIUS  = 6.0f;  // Each mesh is scaled so its bounding sphere has this radius
+    const float    MAX_SPIN_SPEED   = 1.0f;  // Radians per second
+    const uint32_t NUM_CLUSTERS     = 8;
+
+    // Instances are small on screen, so half-size textures are plenty. Keeps the stress textures well inside the
+    // texture streaming budget along with the main scene's textures
+    const uint32_t INSTANCE_TEXTURE_MIP = 1;
+
+    const float POINT_LIGHT_STRENGTH   = 20.0f;
+    const float POINT_LIGHT_MIN_HEIGHT = 8.0f;
+    const float POINT_LIGHT_MAX_HEIGHT = 20.0f;
+
+    // Runway lights run down the gaps between the columns of the grid, whatever the pattern. They light nothing, only
+    // their flares are drawn, and each flare is a sprite so all of them together cost one draw call
+    const float RUNWAY_LIGHT_SPACING = 4.0f;
+    const float RUNWAY_LIGHT_SIZE    = 1.5f;
+    const float RUNWAY_LIGHT_HEIGHT  = 0.5f;
+
+
+    // Instances are rendered with a snapshot of the model's interpolated world matrix, see SnapshotStressScene
+    struct StressInstance
+    {
+        Model model;
+        float spinSpeed;
+    };
+
+    // Instances are kept together by mesh, so the texture only changes once per mesh in each pass. Each mesh has a pool
+    // of instances, so spawning a scene doesn't allocate, and instances are never copied as the scene grows
+    const uint32_t MAX_INSTANCES_PER_MESH = (MAX_STRESS_INSTANCES + NUM_STRESS_MESHES - 1) / NUM_STRESS_MESHES;
+    struct StressGroup
+    {
+        Mesh*            mesh     = nullptr;
+        bool             ownsMesh = false; // Otherwise the mesh is the main scene's
+        StreamedTexture* texture  = nullptr;
+        ObjectPool<StressInstance, MAX_INSTANCES_PER_MESH> instances;
+    };
+    StressGroup gStressGroups[NUM_STRESS_MESHES];
+
+    struct OrbitingLight
+    {
+        float    orbitRadius;
+        float    angle;
+        float    previousAngle; // At the start of the last simulation step
+        float    speed; // Radians per second
+        float    height;
+        CVector3 colour;
+    };
+    std::vector<OrbitingLight> gOrbitingLights;
+
+    // They never move, so they are only laid out and written to a vertex buffer when the scene is spawned
+    StaticSprites gRunwayLights;
+
+    // Width of the square holding the instances, which is centred on the origin
+    float gStressExtent = 0;
+
+    // The lit pixel shader permutation with point lights, owned by the shader permutation map in Shader.cpp
+    ID3D11PixelShader* gStressPixelShader = nullptr;
+    bool               gStressLoaded = false;
+}
+
+// How far the camera is along its path in the current part of the benchmark, 0 to 1 (see below)
+float BenchmarkPathProgress();
+
+
+//--------------------------------------------------------------------------------------
+// Stress scene
+//--------------------------------------------------------------------------------------
+
+// Get a pattern from its name ("grid", "clustered" or "random"). Returns false if the name is not recognised
+bool ParseStressPattern(const std::string& name, StressPattern& pattern)
+{
+    if      (name == "grid")       pattern = StressPattern::Grid;
+    else if (name == "clustered")  pattern = StressPattern::Clustered;
+    else if (name == "random")     pattern = StressPattern::Random;
+    else                           return false;
+    return true;
+}
+
+const char* StressPatternName(StressPattern pattern)
+{
+    switch (pattern)
+    {
+    case StressPattern::Grid:       return "grid";
+    case StressPattern::Clustered:  return "clustered";
+    default:                        return "random";
+    }
+}
+
+
+// Load the meshes, textures, shader and constant buffer used by the stress scene. Returns false on failure with the
+// reason in gLastError
+bool LoadStressScene()
+{
+    if (gStressLoaded)  return true;
+
+    try
+    {
+        for (uint32_t i = 0; i < NUM_STRESS_MESHES; ++i)
+        {
+            if (gStressGroups[i].mesh != nullptr)  continue;
+
+            const StressMesh& stressMesh = STRESS_MESHES[i];
+            gStressGroups[i].ownsMesh = true;
+            if (stressMesh.sceneMesh != nullptr && *stressMesh.sceneMesh != nullptr)
+            {
+                gStressGroups[i].mesh = *stressMesh.sceneMesh;
+                gStressGroups[i].ownsMesh = false;
+            }
+            else if (stressMesh.sphereSegments != 0)
+            {
+                MeshData sphere;
+                GenerateUVSphere(1.0f, stressMesh.sphereSegments, stressMesh.sphereSegments, false, sphere);
+                gStressGroups[i].mesh = new Mesh(stressMesh.meshFile, sphere);
+            }
+            else
+            {
+                gStressGroups[i].mesh = new Mesh(stressMesh.meshFile);
+            }
+        }
+    }
+    catch (std::runtime_error e)
+    {
+        gMeshStagingPool.Trim();
+        gLastError = e.what();
+        return false;
+    }
+    gMeshStagingPool.Trim();
+
+    for (uint32_t i = 0; i < NUM_STRESS_MESHES; ++i)
+    {
+        gStressGroups[i].texture = gTextureStreamer.Load(STRESS_MESHES[i].textureFile);
+        if (gStressGroups[i].texture == nullptr)
+        {
+            gLastError = std::string("Error loading texture ") + STRESS_MESHES[i].textureFile;
+            return false;
+        }
+    }
+
+    gStressPixelShader = LoadPixelShaderPermutation(gStressPermutation);
+    if (gStressPixelShader == nullptr)  return false;
+
+    if (gPointLightConstantBuffer == nullptr)  gPointLightConstantBuffer = CreateConstantBuffer(sizeof(gPointLightConstants));
+    if (gPointLightConstantBuffer == nullptr)
+    {
+        gLastError = "Error creating point light constant buffer";
+        return false;
+    }
+
+    gStressLoaded = true;
+    return true;
+}
+
+
+// Replace the stress scene with the given number of instances (up to MAX_STRESS_INSTANCES) and point lights (up to
+// MAX_POINT_LIGHTS). The same seed always gives the same scene. The meshes, textures and shader are loaded the first time
+// this is called, the teapot and troll meshes are the main scene's. Returns false on failure with the reason in gLastError
+bool SpawnStressScene(uint32_t numInstances, uint32_t numPointLights, StressPattern pattern, uint32_t seed /*= 1*/)
+{
+    PROFILE_FUNCTION();
+
+    if (!LoadStressScene())  return false;
+    ClearStressScene();
+    numInstances = std::min(numInstances, MAX_STRESS_INSTANCES);
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // The grid is as square as possible, the other patterns cover the same area
+    uint32_t gridSide = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(numInstances))));
+    gStressExtent = gridSide * INSTANCE_SPACING;
+    float halfExtent = gStressExtent * 0.5f;
+    std::uniform_real_distribution<float> anywhere(-halfExtent, halfExtent);
+
+    // Clusters are placed away from the edges, each spreads over about a cluster's share of the area
+    std::vector<CVector3> clusterCentres;
+    for (uint32_t i = 0; i < NUM_CLUSTERS; ++i)  clusterCentres.push_back({ anywhere(random) * 0.75f, 0, anywhere(random) * 0.75f });
+    std::normal_distribution<float> clusterSpread(0.0f, gStressExtent / (2.0f * std::sqrt(static_cast<float>(NUM_CLUSTERS))));
+
+    for (uint32_t i = 0; i < numInstances; ++i)
+    {
+        CVector3 position;
+        if (pattern == StressPattern::Grid)
+        {
+            position = { (i % gridSide - (gridSide - 1) * 0.5f) * INSTANCE_SPACING, 0,
+                         (i / gridSide - (gridSide - 1) * 0.5f) * INSTANCE_SPACING };
+        }
+        else if (pattern == StressPattern::Clustered)
+        {
+            const CVector3& centre = clusterCentres[random() % NUM_CLUSTERS];
+            position = { centre.x + clusterSpread(random), 0, centre.z + clusterSpread(random) };
+        }
+        else
+        {
+            position = { anywhere(random), 0, anywhere(random) };
+        }
+
+        StressGroup& group = gStressGroups[i % NUM_STRESS_MESHES];
+        float radius = group.mesh->BoundingRadius();
+        Model model(group.mesh, position, { 0, unit(random) * 2.0f * PI, 0 }, radius > 0 ? INSTANCE_RADIUS / radius : 1.0f);
+        float spinSpeed = (unit(random) * 2.0f - 1.0f) * MAX_SPIN_SPEED;
+        group.instances.Create(StressInstance{ model, spinSpeed });
+    }
+
+    numPointLights = std::min(numPointLights, static_cast<uint32_t>(MAX_POINT_LIGHTS));
+    for (uint32_t i = 0; i < numPointLights; ++i)
+    {
+        OrbitingLight light;
+        light.orbitRadius = unit(random) * halfExtent;
+        light.angle       = unit(random) * 2.0f * PI;
+        light.previousAngle = light.angle;
+        light.speed       = (unit(random) + 0.5f) * (i % 2 == 0 ? 0.4f : -0.4f);
+        light.height      = POINT_LIGHT_MIN_HEIGHT + unit(random) * (POINT_LIGHT_MAX_HEIGHT - POINT_LIGHT_MIN_HEIGHT);
+        light.colour      = CVector3{ 0.3f + unit(random) * 0.7f, 0.3f + unit(random) * 0.7f, 0.3f + unit(random) * 0.7f } * POINT_LIGHT_STRENGTH;
+        gOrbitingLights.push_back(light);
+    }
+
+    // White runway lights along the outside edges of the grid and amber ones between the columns. Each has a different
+    // rotation so the flares don't all look the same
+    if (numInstances > 0)
+    {
+        uint32_t lightsPerRow = static_cast<uint32_t>(gStressExtent / RUNWAY_LIGHT_SPACING) + 1;
+        SpriteBatch runwayLights;
+        runwayLights.Reserve((gridSide + 1) * lightsPerRow);
+        for (uint32_t row = 0; row <= gridSide; ++row)
+        {
+            float x = row * INSTANCE_SPACING - halfExtent;
+            CVector3 colour = (row == 0 || row == gridSide) ? CVector3{ 1.0f, 1.0f, 0.9f } : CVector3{ 1.0f, 0.6f, 0.1f };
+            for (uint32_t i = 0; i < lightsPerRow; ++i)
+            {
+                runwayLights.Add({ x, RUNWAY_LIGHT_HEIGHT, i * RUNWAY_LIGHT_SPACING - halfExtent }, RUNWAY_LIGHT_SIZE, colour, i * 0.7f);
+            }
+        }
+        if (!CreateStaticSprites(runwayLights, gRunwayLights))
+        {
+            gLastError = "Error creating stress scene runway lights";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Remove all the stress scene instances and point lights
+void ClearStressScene()
+{
+    PIPELINE_CHECK(!gSimulationThread.Busy(), "Stress scene changed while the simulation is running");
+    for (auto& group : gStressGroups)  group.instances.Clear();
+    gOrbitingLights.clear();
+    ReleaseStaticSprites(gRunwayLights);
+    gStressExtent = 0;
+}
+
+
+bool StressSceneActive()
+{
+    for (auto& group : gStressGroups)
+    {
+        if (group.instances.Size() > 0)  return true;
+    }
+    return !gOrbitingLights.empty();
+}
+
+
+// Spin the instances and orbit the point lights by one simulation step. Flies the camera around the scene while the
+// benchmark is running
+void UpdateStressScene(float frameTime, Camera* camera)
+{
+    if (!StressSceneActive())  return;
+    PROFILE_ZONE("Update stress scene");
+
+    for (auto& group : gStressGroups)
+    {
+        group.instances.ForEach([frameTime](StressInstance& instance)
+        {
+            instance.model.StartStep();
+            CVector3 rotation = instance.model.Rotation();
+            rotation.y += instance.spinSpeed * frameTime;
+            instance.model.SetRotation(rotation);
+        });
+    }
+
+    for (auto& light : gOrbitingLights)
+    {
+        light.previousAngle = light.angle;
+        light.angle += light.speed * frameTime;
+    }
+
+    // Fly once around the scene in each part of the benchmark, looking at the centre from above
+    if (BenchmarkRunning() && camera != nullptr)
+    {
+        float angle = BenchmarkPathProgress() * 2.0f * PI;
+        float radius = gStressExtent * 0.5f + 80.0f;
+        CVector3 position = { std::sin(angle) * radius, gStressExtent * 0.35f + 40.0f, -std::cos(angle) * radius };
+        CVector3 toCentre = CVector3{ 0, 0, 0 } - position;
+        camera->SetPosition(position);
+        camera->SetRotation({ std::atan2(-toCentre.y, std::sqrt(toCentre.x * toCentre.x + toCentre.z * toCentre.z)),
+                              std::atan2(toCentre.x, toCentre.z), 0 });
+    }
+}
+
+
+// Fill a snapshot with the instances and point lights interpolation of the way (0 to 1) between where they were before
+// the last simulation step and where they are now. The snapshot's memory is reused from one fill to the next
+void SnapshotStressScene(float interpolation, StressSceneSnapshot& snapshot)
+{
+    PROFILE_ZONE("Snapshot stress scene");
+
+    snapshot.worldMatrices.resize(NUM_STRESS_MESHES);
+    for (uint32_t i = 0; i < NUM_STRESS_MESHES; ++i)
+    {
+        std::vector<CMatrix4x4>& worldMatrices = snapshot.worldMatrices[i];
+        worldMatrices.resize(gStressGroups[i].instances.Size());
+        CMatrix4x4* worldMatrix = worldMatrices.data();
+        gStressGroups[i].instances.ForEach([&](StressInstance& instance)
+        {
+            *worldMatrix++ = instance.model.InterpolatedMatrix(interpolation);
+        });
+    }
+
+    snapshot.numPointLights = static_cast<uint32_t>(gOrbitingLights.size());
+    for (uint32_t i = 0; i < gOrbitingLights.size(); ++i)
+    {
+        OrbitingLight& light = gOrbitingLights[i];
+        float angle = Lerp(light.previousAngle, light.angle, interpolation);
+        snapshot.pointLights[i].position = { std::cos(angle) * light.orbitRadius, light.height, std::sin(angle) * light.orbitRadius };
+        snapshot.pointLights[i].colour   = light.colour;
+    }
+}
+
+
+// Ask for the texture detail used by the instances, call each frame before the texture streamer is updated
+void RequestStressSceneTextures()
+{
+    PIPELINE_CHECK(!gSimulationThread.Busy(), "Stress scene textures requested while the simulation is running");
+    for (auto& group : gStressGroups)
+    {
+        if (group.instances.Size() > 0)  group.texture->RequestMip(INSTANCE_TEXTURE_MIP);
+    }
+}
+
+
+// Whether a snapshot has anything to render
+bool SnapshotActive(const StressSceneSnapshot& snapshot)
+{
+    for (auto& worldMatrices : snapshot.worldMatrices)
+    {
+        if (!worldMatrices.empty())  return true;
+    }
+    return snapshot.numPointLights > 0;
+}
+
+
+// Send the world matrix of each instance of a mesh to the GPU and draw it. Only uses the group's mesh, which doesn't
+// change while the simulation is running
+void RenderStressGroup(const StressGroup& group, const std::vector<CMatrix4x4>& worldMatrices)
+{
+    for (auto& worldMatrix : worldMatrices)
+    {
+        gPerModelConstants.worldMatrix = worldMatrix;
+        UpdateConstantBuffer(gPerModelConstantBuffer, gPerModelConstants);
+        group.mesh->Render();
+    }
+}
+
+
+// Render the instances in a snapshot into a shadow map, the depth-only shaders must already be set
+void RenderStressSceneDepth(const StressSceneSnapshot& snapshot)
+{
+    if (!SnapshotActive(snapshot))  return;
+    PROFILE_ZONE("Stress scene depth");
+
+    // The per-model constant buffer only needs binding once, it is updated for each instance
+    gD3DContext->VSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
+    gD3DContext->PSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
+    gRenderCounters.stateChanges += 2;
+
+    for (uint32_t i = 0; i < snapshot.worldMatrices.size(); ++i)  RenderStressGroup(gStressGroups[i], snapshot.worldMatrices[i]);
+}
+
+
+// Render the instances in a snapshot lit by the spotlights and point lights. The per-frame constants, shadow maps and
+// samplers must already be set for the main pass
+void RenderStressScene(const StressSceneSnapshot& snapshot)
+{
+    if (!SnapshotActive(snapshot))  return;
+    PROFILE_ZONE("Stress scene");
+
+    std::copy(snapshot.pointLights, snapshot.pointLights + snapshot.numPointLights, gPointLightConstants.pointLights);
+    gPointLightConstants.numPointLights = snapshot.numPointLights;
+    UpdateConstantBuffer(gPointLightConstantBuffer, gPointLightConstants);
+    gD3DContext->PSSetConstantBuffers(2, 1, &gPointLightConstantBuffer);
+    gD3DContext->VSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
+    gD3DContext->PSSetConstantBuffers(1, 1, &gPerModelConstantBuffer);
+    gD3DContext->VSSetShader(gPixelLightingVertexShader, nullptr, 0);
+    gD3DContext->PSSetShader(gStressPixelShader, nullptr, 0);
+    gRenderCounters.stateChanges += 5;
+
+    // Textures of the same size share a texture array, so only bind each array once
+    ID3D11ShaderResourceView* boundSRV = nullptr;
+    for (uint32_t i = 0; i < snapshot.worldMatrices.size(); ++i)
+    {
+        const StressGroup& group = gStressGroups[i];
+        if (snapshot.worldMatrices[i].empty())  continue;
+
+        ID3D11ShaderResourceView* textureSRV = group.texture->SRV();
+        if (textureSRV != boundSRV)
+        {
+            gD3DContext->PSSetShaderResources(0, 1, &textureSRV);
+            boundSRV = textureSRV;
+            ++gRenderCounters.stateChanges;
+        }
+        gPerModelConstants.diffuseSpecularSlice = group.texture->Slice();
+        RenderStressGroup(group, snapshot.worldMatrices[i]);
+    }
+}
+
+
+// Add the stress scene's point light flares in a snapshot to a batch of sprites drawn with the light flare texture
+void AddStressSceneSprites(const StressSceneSnapshot& snapshot, SpriteBatch& sprites)
+{
+    // Point light flares are the same size as the main scene's light of the same strength, and their colour doesn't
+    // include the strength
+    float pointLightSize = std::pow(POINT_LIGHT_STRENGTH, 0.7f);
+    for (uint32_t i = 0; i < snapshot.numPointLights; ++i)
+    {
+        const PointLight& light = snapshot.pointLights[i];
+        sprites.Add(light.position, pointLightSize, light.colour * (1.0f / POINT_LIGHT_STRENGTH));
+    }
+}
+
+
+// Draw the rows of small runway lights laid along the grid with the light flare texture. The sprite states must already
+// be set as for RenderSprites
+void RenderStressSceneRunwayLights(ID3D11ShaderResourceView* flareTexture)
+{
+    RenderStaticSprites(gRunwayLights, flareTexture);
+}
+
+
+// Release everything loaded by the stress scene
+void ReleaseStressScene()
+{
+    ClearStressScene();
+    for (auto& group : gStressGroups)
+    {
+        if (group.ownsMesh)  delete group.mesh;
+        group.mesh = nullptr;
+        group.texture = nullptr; // Released by the texture streamer
+    }
+    ReleaseTracked(gPointLightConstantBuffer, MemoryCategory::ConstantBuffers);
+    gPointLightConstantBuffer = nullptr;
+    gStressPixelShader = nullptr; // Released by ReleaseShaders
+    gStressLoaded = false;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+    // The sweep runs every number of instances with each number of point lights
+    const uint32_t BENCHMARK_INSTANCES[]    = { 100, 250, 500, 1000, 2000, 4000, 8000 };
+    const uint32_t BENCHMARK_POINT_LIGHTS[] = { 0, 8, MAX_POINT_LIGHTS };
+    const uint32_t NUM_BENCHMARK_INSTANCES  = sizeof(BENCHMARK_INSTANCES) / sizeof(BENCHMARK_INSTANCES[0]);
+    const uint32_t NUM_BENCHMARK_CONFIGS    = NUM_BENCHMARK_INSTANCES * sizeof(BENCHMARK_POINT_LIGHTS) / sizeof(BENCHMARK_POINT_LIGHTS[0]);
+
+    // Frames at the start of each part that are left out of the results (texture streaming, caches warming up), then the
+    // frames measured. The camera path takes the whole time
+    const uint32_t BENCHMARK_WARM_UP_FRAMES = 30;
+    const uint32_t BENCHMARK_FRAMES         = 240;
+
+    struct Benchmark
+    {
+        bool          running = false;
+        StressPattern pattern = StressPattern::Grid;
+        std::ofstream file;
+        uint32_t      config = 0;
+        uint32_t      frame  = 0;
+        FrameStats    stats{BENCHMARK_FRAMES, BENCHMARK_WARM_UP_FRAMES}; // Render times are submission times here
+    };
+    Benchmark gBenchmark;
+
+
+    // Spawn the stress scene for the current part of the sweep and start measuring it
+    bool StartBenchmarkConfig()
+    {
+        uint32_t numInstances   = BENCHMARK_INSTANCES[gBenchmark.config % NUM_BENCHMARK_INSTANCES];
+        uint32_t numPointLights = BENCHMARK_POINT_LIGHTS[gBenchmark.config / NUM_BENCHMARK_INSTANCES];
+        if (!SpawnStressScene(numInstances, numPointLights, gBenchmark.pattern))  return false;
+
+        gBenchmark.frame = 0;
+        gBenchmark.stats.Reset();
+        return true;
+    }
+
+
+    // Write the results of the current part of the sweep, the render counters are from the last frame
+    void WriteBenchmarkRow()
+    {
+        TimingSummary update = gBenchmark.stats.Summarise(FrameTiming::Update);
+        TimingSummary submit = gBenchmark.stats.Summarise(FrameTiming::Render);
+        TimingSummary frame  = gBenchmark.stats.Summarise(FrameTiming::Frame);
+
+        PROCESS_MEMORY_COUNTERS_EX memory = {};
+        GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&memory), sizeof(memory));
+        const double MB = 1024.0 * 1024.0;
+
+        std::ofstream& file = gBenchmark.file;
+        file << StressPatternName(gBenchmark.pattern) << ','
+             << BENCHMARK_INSTANCES[gBenchmark.config % NUM_BENCHMARK_INSTANCES] << ','
+             << BENCHMARK_POINT_LIGHTS[gBenchmark.config / NUM_BENCHMARK_INSTANCES] << ','
+             << update.samples << ','
+             << update.mean << ',' << update.p99 << ',' << submit.mean << ',' << submit.p99 << ',' << frame.mean << ',' << frame.p99 << ','
+             << gRenderCounters.drawCalls << ',' << gRenderCounters.triangles << ',' << gRenderCounters.stateChanges << ','
+             << gRenderCounters.constantBufferUpdates << ','
+             << memory.WorkingSetSize / MB << ',' << memory.PrivateUsage / MB << ',' << gTextureStreamer.ResidentBytes() / MB << '\n';
+        file.flush(); // Keep the results so far if the app is closed before the end
+    }
+}
+
+
+// How far the camera is along its path in the current part of the benchmark, 0 to 1
+float BenchmarkPathProgress()
+{
+    return static_cast<float>(gBenchmark.frame) / (BENCHMARK_WARM_UP_FRAMES + BENCHMARK_FRAMES);
+}
+
+
+// Start the benchmark sweep with the given instance layout, the results are written to fileName. Returns false on
+// failure with the reason in gLastError
+bool StartBenchmark(StressPattern pattern, const std::string& fileName /*= "Benchmark.csv"*/)
+{
+    gBenchmark.file.open(fileName);
+    if (!gBenchmark.file.is_open())
+    {
+        gLastError = "Error creating " + fileName;
+        return false;
+    }
+    gBenchmark.file.setf(std::ios::fixed);
+    gBenchmark.file.precision(3);
+    gBenchmark.file << "pattern,instances,point_lights,frames,update_mean_ms,update_p99_ms,submit_mean_ms,submit_p99_ms,"
+                       "frame_mean_ms,frame_p99_ms,draw_calls,triangles,state_changes,cb_updates,working_set_mb,private_mb,"
+                       "texture_mb\n";
+
+    gBenchmark.pattern = pattern;
+    gBenchmark.config  = 0;
+    if (!StartBenchmarkConfig())
+    {
+        gBenchmark.file.close();
+        return false;
+    }
+    gBenchmark.running = true;
+    return true;
+}
+
+
+bool BenchmarkRunning()
+{
+    return gBenchmark.running;
+}
+
+
+// Call after each frame while the benchmark is running with the frame time and the CPU time spent updating the scene
+// and sending the frame to the GPU (not including Present), all in seconds. Moves on to the next part of the sweep as
+// needed. Returns false once the sweep is complete and the results written
+bool BenchmarkFrame(float frameTime, float updateTime, float submitTime)
+{
+    if (!gBenchmark.running)  return false;
+
+    gBenchmark.stats.AddFrame(frameTime, updateTime, submitTime);
+    if (++gBenchmark.frame < BENCHMARK_WARM_UP_FRAMES + BENCHMARK_FRAMES)  return true;
+
+    WriteBenchmarkRow();
+    if (++gBenchmark.config < NUM_BENCHMARK_CONFIGS && StartBenchmarkConfig())  return true;
+
+    gBenchmark.file.close();
+    gBenchmark.running = false;
+    ClearStressScene();
+    return false;
+}
@@ -0,0 +1,115 @@
+//--------------------------------------------------------------------------------------
+// Stress scene and scalability benchmark
+//--------------------------------------------------------------------------------------
+// The stress scene adds large numbers of model instances (teapots, spheres, trolls and cargo
+// containers) and unshadowed point lights to the main scene, laid out in a grid, in clusters
+// or at random, with rows of runway lights between the grid's columns. The instances spin
+// every frame and are drawn in the shadow map passes and the main pass like the rest of the
+// scene, so the CPU cost of the update and of sending the work to the GPU grows with their
+// number.
+//
+// The benchmark sweeps the number of instances and point lights. For each combination it flies
+// the camera once around the scene with a fixed timestep and vsync off, then writes a row of
+// scaling results: update and submission times (mean and p99), frame time, the render counters
+// of a frame (draw calls, triangles, state changes, constant buffer updates) and the memory
+// used by the process. Run the app with -benchmark grid|clustered|random, it closes when the
+// sweep is done, leaving the results in Benchmark.csv.
+
+#ifndef _STRESS_SCENE_H_INCLUDED_
+#define _STRESS_SCENE_H_INCLUDED_
+
+#include "Camera.h"
+#include "Common.h"
+#include "SpriteBatch.h"
+#include "CMatrix4x4.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------------
+// Stress scene
+//--------------------------------------------------------------------------------------
+
+// How the instances are laid out
+enum class StressPattern
+{
+    Grid,      // Evenly spaced rows
+    Clustered, // Tight groups around a few points, so some parts of the screen are much busier than others
+    Random,    // Spread evenly at random over the same area as the grid
+};
+
+// Get a pattern from its name ("grid", "clustered" or "random"). Returns false if the name is not recognised
+bool ParseStressPattern(const std::string& name, StressPattern& pattern);
+const char* StressPatternName(StressPattern pattern);
+
+
+// Most instances in the stress scene, enough for the largest benchmark. They are kept in fixed-size pools
+const uint32_t MAX_STRESS_INSTANCES = 8192;
+
+// Replace the stress scene with the given number of instances (up to MAX_STRESS_INSTANCES) and point lights (up to
+// MAX_POINT_LIGHTS). The same seed always gives the same scene. The meshes, textures and shader are loaded the first time
+// this is called, the teapot and troll meshes are the main scene's. Returns false on failure with the reason in gLastError
+bool SpawnStressScene(uint32_t numInstances, uint32_t numPointLights, StressPattern pattern, uint32_t seed = 1);
+
+// Remove all the stress scene instances and point lights
+void ClearStressScene();
+
+// Spin the instances and orbit the point lights by one simulation step. Flies the camera around the scene while the
+// benchmark is running
+void UpdateStressScene(float frameTime, Camera* camera);
+
+// Everything the renderer needs from the stress scene, so it can render while the simulation moves on (see Pipeline.h)
+struct StressSceneSnapshot
+{
+    std::vector<std::vector<CMatrix4x4>> worldMatrices; // For each mesh, the world matrix of each instance
+    PointLight pointLights[MAX_POINT_LIGHTS];
+    uint32_t   numPointLights = 0;
+};
+
+// Fill a snapshot with the instances and point lights interpolation of the way (0 to 1) between where they were before
+// the last simulation step and where they are now. The snapshot's memory is reused from one fill to the next
+void SnapshotStressScene(float interpolation, StressSceneSnapshot& snapshot);
+
+// Ask for the texture detail used by the instances, call each frame before the texture streamer is updated
+void RequestStressSceneTextures();
+
+// Render the instances in a snapshot into a shadow map, the depth-only shaders must already be set
+void RenderStressSceneDepth(const StressSceneSnapshot& snapshot);
+
+// Render the instances in a snapshot lit by the spotlights and point lights. The per-frame constants, shadow maps and
+// samplers must already be set for the main pass
+void RenderStressScene(const StressSceneSnapshot& snapshot);
+
+// Add the stress scene's point light flares in a snapshot to a batch of sprites drawn with the light flare texture
+void AddStressSceneSprites(const StressSceneSnapshot& snapshot, SpriteBatch& sprites);
+
+// Draw the rows of small runway lights laid along the grid with the light flare texture. The sprite states must already
+// be set as for RenderSprites. Runway lights are only flares, they don't light anything, but there are thousands of them
+// in the larger scenes so they are written to a static vertex buffer once when the scene is spawned
+void RenderStressSceneRunwayLights(ID3D11ShaderResourceView* flareTexture);
+
+// Release everything loaded by the stress scene, once nothing is rendering it
+void ReleaseStressScene();
+
+
+//--------------------------------------------------------------------------------------
+// Benchmark
+//--------------------------------------------------------------------------------------
+
+// The scene is updated with this timestep while the benchmark is running, so every run follows the same camera path
+const float BENCHMARK_TIMESTEP = 1.0f / 60.0f;
+
+// Start the benchmark sweep with the given instance layout, the results are written to fileName. Returns false on
+// failure with the reason in gLastError
+bool StartBenchmark(StressPattern pattern, const std::string& fileName = "Benchmark.csv");
+
+bool BenchmarkRunning();
+
+// Call after each frame while the benchmark is running with the frame time and the CPU time spent updating the scene
+// and sending the frame to the GPU (not including Present), all in seconds. Moves on to the next part of the sweep as
+// needed. Returns false once the sweep is complete and the results written
+bool BenchmarkFrame(float frameTime, float updateTime, float submitTime);
+
+
+#endif //_STRESS_SCENE_H_INCLUDED_
@@ -0,0 +1,27 @@
+//--------------------------------------------------------------------------------------
+// Minimal checks for the unit tests
+//--------------------------------------------------------------------------------------
+// Each test is a program that runs its checks and returns non-zero if any failed (see CMakeLists.txt)
+
+#ifndef _CHECK_H_INCLUDED_
+#define _CHECK_H_INCLUDED_
+
+#include <cstdio>
+
+
+// Failed checks so far in this test program
+inline int gNumFailedChecks = 0;
+
+// Report a failed check with where it is, and carry on so one run shows every failure
+#define CHECK(condition) \
+    do { if (!(condition)) { std::printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition);  ++gNumFailedChecks; } } while (false)
+
+// Return from main with this, 0 if every check passed
+inline int CheckResult(const char* testName)
+{
+    std::printf("%s: %s\n", testName, gNumFailedChecks == 0 ? "passed" : "FAILED");
+    return gNumFailedChecks == 0 ? 0 : 1;
+}
+
+
+#endif //_CHECK_H_INCLUDED_
@@ -0,0 +1,218 @@
+//--------------------------------------------------------------------------------------
+// DDS parser tests - the shipped textures, a DX10 round trip and damaged files
+//--------------------------------------------------------------------------------------
+
+#include "Check.h"
+#include "DDSFile.h"
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstring>
+
+
+namespace
+{
+    // The .dds textures in Textures/, all uncompressed BGRA with a legacy header and a full mip chain
+    struct ShippedTexture
+    {
+        const char* file;
+        uint32_t    size;
+        uint32_t    mipLevels;
+        size_t      fileBytes;
+    };
+    const ShippedTexture SHIPPED_TEXTURES[] =
+    {
+        { "Textures/CargoA.dds",                  512, 10, 1398228 },
+        { "Textures/GrassDiffuseSpecular.dds",    512, 10, 1398228 },
+        { "Textures/PatternDiffuseSpecular.dds",  512, 10, 1398228 },
+        { "Textures/StoneDiffuseSpecular.dds",   1024, 11, 5592532 },
+        { "Textures/TrollDiffuseSpecular.dds",   1024, 11, 5592532 },
+        { "Textures/WoodDiffuseSpecular.dds",     512, 10, 1398228 },
+    };
+
+    const size_t HEADER_OFFSET = sizeof(DDS_MAGIC);
+    const size_t DX10_OFFSET   = HEADER_OFFSET + sizeof(DDSHeader);
+
+
+    std::vector<uint8_t> ReadFile(const char* fileName)
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Copy of a file with one 32-bit value replaced
+    std::vector<uint8_t> Patch(std::vector<uint8_t> file, size_t offset, uint32_t value)
+    {
+        std::memcpy(file.data() + offset, &value, sizeof(value));
+        return file;
+    }
+
+    // 1 if parsed, 0 if rejected, -1 if the parser threw
+    int Parse(const std::vector<uint8_t>& file, DDSTexture& texture)
+    {
+        try
+        {
+            return ParseDDS(file.data(), file.size(), texture) ? 1 : 0;
+        }
+        catch (...)
+        {
+            return -1;
+        }
+    }
+
+    // Whether every subresource of a parsed texture lies inside the file
+    bool SubresourcesInFile(const DDSTexture& texture, const std::vector<uint8_t>& file)
+    {
+        for (auto& subresource : texture.subresources)
+        {
+            size_t offset = subresource.data - file.data();
+            size_t bytes  = static_cast<size_t>(subresource.slicePitch) * subresource.depth;
+            if (subresource.data < file.data() || offset > file.size() || bytes > file.size() - offset)  return false;
+        }
+        return true;
+    }
+
+
+    // Each shipped texture's header fields and the pitch, size and position of every mip
+    void TestShippedTextures()
+    {
+        for (auto& shipped : SHIPPED_TEXTURES)
+        {
+            std::vector<uint8_t> file = ReadFile(shipped.file);
+            CHECK(file.size() == shipped.fileBytes);
+            if (file.size() != shipped.fileBytes)  continue;
+
+            DDSTexture texture;
+            CHECK(Parse(file, texture) == 1);
+            CHECK(texture.format    == DXGI_FORMAT_B8G8R8A8_UNORM);
+            CHECK(texture.dimension == DDS_DIMENSION_TEXTURE2D);
+            CHECK(texture.width     == shipped.size);
+            CHECK(texture.height    == shipped.size);
+            CHECK(texture.depth     == 1);
+            CHECK(texture.mipLevels == shipped.mipLevels);
+            CHECK(texture.arraySize == 1);
+            CHECK(!texture.cubeMap);
+            CHECK(texture.subresources.size() == shipped.mipLevels);
+            if (texture.subresources.size() != shipped.mipLevels)  continue;
+
+            // The mips follow the header one after another and fill the rest of the file exactly
+            const uint8_t* expectedData = file.data() + HEADER_OFFSET + sizeof(DDSHeader);
+            for (uint32_t mip = 0; mip < texture.mipLevels; ++mip)
+            {
+                const DDSSubresource& subresource = texture.subresources[mip];
+                uint32_t mipSize = std::max(1u, shipped.size >> mip);
+                CHECK(subresource.data       == expectedData);
+                CHECK(subresource.width      == mipSize);
+                CHECK(subresource.height     == mipSize);
+                CHECK(subresource.depth      == 1);
+                CHECK(subresource.rowPitch   == mipSize * 4);
+                CHECK(subresource.slicePitch == mipSize * mipSize * 4);
+                expectedData += subresource.slicePitch;
+            }
+            CHECK(expectedData == file.data() + file.size());
+        }
+    }
+
+
+    // Writing a parsed texture gives a DX10 file that parses to the same description and pixel data
+    void TestWriteDDS()
+    {
+        std::vector<uint8_t> file = ReadFile(SHIPPED_TEXTURES[0].file);
+        DDSTexture texture;
+        CHECK(Parse(file, texture) == 1);
+
+        std::vector<uint8_t> written;
+        WriteDDS(written, texture);
+        CHECK(written.size() == file.size() + sizeof(DDSHeaderDX10));
+
+        DDSTexture reparsed;
+        CHECK(Parse(written, reparsed) == 1);
+        CHECK(reparsed.format    == texture.format);
+        CHECK(reparsed.width     == texture.width);
+        CHECK(reparsed.height    == texture.height);
+        CHECK(reparsed.mipLevels == texture.mipLevels);
+        CHECK(reparsed.arraySize == texture.arraySize);
+        CHECK(reparsed.subresources.size() == texture.subresources.size());
+        for (size_t i = 0; i < reparsed.subresources.size() && i < texture.subresources.size(); ++i)
+        {
+            const DDSSubresource& a = texture.subresources[i];
+            const DDSSubresource& b = reparsed.subresources[i];
+            CHECK(a.rowPitch == b.rowPitch && a.slicePitch == b.slicePitch);
+            CHECK(std::memcmp(a.data, b.data, a.slicePitch) == 0);
+        }
+    }
+
+
+    // Damaged copies of a legacy and a DX10 file are rejected without an exception. Headers with random values written
+    // over them may be accepted, but only if every subresource is inside the file
+    void TestDamagedFiles()
+    {
+        std::vector<uint8_t> legacy = ReadFile(SHIPPED_TEXTURES[0].file);
+        DDSTexture texture;
+        CHECK(Parse(legacy, texture) == 1);
+        std::vector<uint8_t> dx10;
+        WriteDDS(dx10, texture);
+
+        for (auto* file : { &legacy, &dx10 })
+        {
+            bool isDX10 = (file == &dx10);
+            std::vector<std::vector<uint8_t>> damaged;
+
+            // Cut short anywhere in the headers, and by one byte of pixel data
+            size_t headerBytes = isDX10 ? DX10_OFFSET + sizeof(DDSHeaderDX10) : DX10_OFFSET;
+            for (size_t size : { size_t(0), size_t(3), HEADER_OFFSET, HEADER_OFFSET + 10, headerBytes - 1, headerBytes, file->size() - 1 })
+            {
+                damaged.push_back(std::vector<uint8_t>(file->begin(), file->begin() + size));
+            }
+
+            damaged.push_back(Patch(*file, 0, 0x12345678)); // Not "DDS "
+            damaged.push_back(Patch(*file, HEADER_OFFSET + offsetof(DDSHeader, size), 100));
+            damaged.push_back(Patch(*file, HEADER_OFFSET + offsetof(DDSHeader, mipMapCount), 32));
+            damaged.push_back(Patch(*file, HEADER_OFFSET + offsetof(DDSHeader, width), 0));
+            damaged.push_back(Patch(*file, HEADER_OFFSET + offsetof(DDSHeader, width), 0x7fffffff));
+            damaged.push_back(Patch(*file, HEADER_OFFSET + offsetof(DDSHeader, height), 0xffffffff));
+            if (isDX10)
+            {
+                size_t arraySize = DX10_OFFSET + offsetof(DDSHeaderDX10, arraySize);
+                damaged.push_back(Patch(*file, DX10_OFFSET + offsetof(DDSHeaderDX10, dxgiFormat), 0xbad));
+                damaged.push_back(Patch(*file, arraySize, 0));
+                damaged.push_back(Patch(*file, arraySize, 2));
+                damaged.push_back(Patch(*file, arraySize, 0x7fffffff));
+                damaged.push_back(Patch(Patch(*file, arraySize, 0x7fffffff),
+                                        DX10_OFFSET + offsetof(DDSHeaderDX10, miscFlag), DDS_MISC_TEXTURECUBE));
+            }
+            for (auto& damagedFile : damaged)
+            {
+                DDSTexture damagedTexture;
+                CHECK(Parse(damagedFile, damagedTexture) == 0);
+            }
+
+            std::mt19937 random(isDX10 ? 2 : 1);
+            std::uniform_int_distribution<size_t> headerWord(1, headerBytes / 4 - 1);
+            std::vector<uint8_t> corrupt = *file;
+            for (int i = 0; i < 10000; ++i)
+            {
+                size_t offset = headerWord(random) * 4;
+                uint32_t value = static_cast<uint32_t>(random());
+                std::memcpy(corrupt.data() + offset, &value, sizeof(value));
+                DDSTexture corruptTexture;
+                int result = Parse(corrupt, corruptTexture);
+                CHECK(result >= 0);
+                if (result == 1)  CHECK(SubresourcesInFile(corruptTexture, corrupt));
+                std::memcpy(corrupt.data() + offset, file->data() + offset, sizeof(value));
+            }
+        }
+    }
+}
+
+
+int main()
+{
+    TestShippedTextures();
+    TestWriteDDS();
+    TestDamagedFiles();
+    return CheckResult("DDSFileTest");
+}
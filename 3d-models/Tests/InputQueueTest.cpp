@@ -0,0 +1,145 @@
+//--------------------------------------------------------------------------------------
+// Input queue tests - the lock-free ring on one thread, then with a producer and consumer thread
+//--------------------------------------------------------------------------------------
+
+#include "Check.h"
+#include "InputQueue.h"
+
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+
+namespace
+{
+    // Larger than any atomic so a half-written item would show up as a bad check value
+    struct Item
+    {
+        uint32_t sequence;
+        uint32_t payload[6];
+        uint32_t check;
+    };
+
+    Item MakeItem(uint32_t sequence)
+    {
+        Item item;
+        item.sequence = sequence;
+        item.check = sequence;
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            item.payload[i] = sequence * 2654435761u + i;
+            item.check ^= item.payload[i];
+        }
+        return item;
+    }
+
+    bool ItemIsWhole(const Item& item)
+    {
+        uint32_t check = item.sequence;
+        for (uint32_t i = 0; i < 6; ++i)  check ^= item.payload[i];
+        return check == item.check && item.payload[0] == item.sequence * 2654435761u;
+    }
+
+
+    // Items come out in the order they went in, across many trips round the ring. A full queue drops the new item,
+    // keeping the ones already queued, and counts it
+    void TestOneThread()
+    {
+        SPSCQueue<uint32_t, 8> queue;
+        uint32_t item = 0;
+        CHECK(!queue.Pop(item));
+
+        uint32_t next = 0, expected = 0;
+        for (uint32_t round = 0; round < 1000; ++round)
+        {
+            // A varying number each time so the full and empty points land on every position of the ring
+            uint32_t count = 1 + round % 8;
+            for (uint32_t i = 0; i < count; ++i)  CHECK(queue.Push(next++));
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                CHECK(queue.Pop(item));
+                CHECK(item == expected++);
+            }
+            CHECK(!queue.Pop(item));
+        }
+        CHECK(queue.Dropped() == 0);
+
+        for (uint32_t i = 0; i < 8; ++i)  CHECK(queue.Push(100 + i));
+        CHECK(!queue.Push(200));
+        CHECK(!queue.Push(201));
+        CHECK(queue.Dropped() == 2);
+        CHECK(queue.Pop(item) && item == 100);
+        CHECK(queue.Push(108));
+        CHECK(!queue.Push(202));
+        CHECK(queue.Dropped() == 3);
+        for (uint32_t i = 1; i <= 8; ++i)  CHECK(queue.Pop(item) && item == 100 + i);
+        CHECK(!queue.Pop(item));
+    }
+
+
+    // A producer thread pushes numbered items into a small queue while a consumer pops them. If retry is set the
+    // producer keeps trying when the queue is full so every item must arrive, otherwise full pushes are dropped and the
+    // items that arrive plus those counted as dropped must account for all of them. Either way the consumer must see
+    // whole items in increasing order
+    void TestThreads(bool retry)
+    {
+        const uint32_t NUM_ITEMS = 2000000;
+        SPSCQueue<Item, 16> queue;
+        uint32_t numFailedPushes = 0;
+
+        std::thread producer([&]()
+        {
+            for (uint32_t sequence = 0; sequence < NUM_ITEMS; ++sequence)
+            {
+                // Pause now and then so the consumer catches up between bursts that overflow the queue
+                if (!retry && sequence % 256 == 0)  std::this_thread::yield();
+                Item item = MakeItem(sequence);
+                while (!queue.Push(item))
+                {
+                    ++numFailedPushes;
+                    if (!retry)  break;
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        uint32_t numReceived = 0, numBroken = 0, numOutOfOrder = 0;
+        int64_t last = -1;
+        while (true)
+        {
+            Item item;
+            if (!queue.Pop(item))
+            {
+                // Stop when every item has arrived or been dropped, otherwise wait for the producer
+                if (last == NUM_ITEMS - 1 || (!retry && numReceived + queue.Dropped() == NUM_ITEMS))  break;
+                std::this_thread::yield();
+                continue;
+            }
+            ++numReceived;
+            if (!ItemIsWhole(item))  ++numBroken;
+            if (static_cast<int64_t>(item.sequence) <= last || (retry && item.sequence != last + 1))  ++numOutOfOrder;
+            last = item.sequence;
+            if (retry && last == NUM_ITEMS - 1)  break;
+        }
+        producer.join();
+
+        Item item;
+        CHECK(!queue.Pop(item));
+        CHECK(numBroken == 0);
+        CHECK(numOutOfOrder == 0);
+        CHECK(queue.Dropped() == numFailedPushes);
+        if (retry)  CHECK(numReceived == NUM_ITEMS);
+        else        CHECK(numReceived + queue.Dropped() == NUM_ITEMS);
+        std::printf("%s: %u received, %u dropped or retried\n", retry ? "Retrying producer" : "Dropping producer",
+                    numReceived, numFailedPushes);
+    }
+}
+
+
+int main()
+{
+    TestOneThread();
+    TestThreads(true);
+    TestThreads(false);
+    return CheckResult("InputQueueTest");
+}
@@ -0,0 +1,208 @@
+//--------------------------------------------------------------------------------------
+// Mesh codec tests - round trips of generated meshes, compression ratio and damaged data
+//--------------------------------------------------------------------------------------
+
+#include "Check.h"
+#include "MeshCodec.h"
+#include "MeshPrimitives.h"
+
+#include <vector>
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+
+
+namespace
+{
+    struct TestMesh
+    {
+        const char* name;
+        MeshData    meshData;
+    };
+
+    // Generated meshes of each vertex layout, including some large enough to be split into several chunks
+    std::vector<TestMesh> MakeTestMeshes()
+    {
+        std::vector<TestMesh> meshes(7);
+        meshes[0].name = "UV sphere";          GenerateUVSphere(10, 30, 30, false, meshes[0].meshData);
+        meshes[1].name = "UV sphere tangents"; GenerateUVSphere(10, 30, 30, true,  meshes[1].meshData);
+        meshes[2].name = "Ico sphere";         GenerateIcoSphere(3, 5, true, meshes[2].meshData);
+        meshes[3].name = "Box";                GenerateBox({ 4, 6, 8 }, 5, false, meshes[3].meshData);
+        meshes[4].name = "Cylinder";           GenerateCylinder(3, 10, 24, 4, false, meshes[4].meshData);
+        meshes[5].name = "Torus";              GenerateTorus(10, 3, 256, 128, true, meshes[5].meshData);
+        meshes[6].name = "Plane";              GeneratePlane(2000, 2000, 300, 300, 60, false, meshes[6].meshData);
+        return meshes;
+    }
+
+    const float* VertexFloats(const MeshData& mesh, uint32_t vertex, unsigned int offset)
+    {
+        return reinterpret_cast<const float*>(mesh.vertices + static_cast<size_t>(vertex) * mesh.vertexSize + offset);
+    }
+
+    // Angle in degrees between a decoded vector and the original made unit length
+    float AngleError(const float* original, const float* decoded)
+    {
+        double length = std::sqrt(original[0] * original[0] + original[1] * original[1] + original[2] * original[2]);
+        double cosine = (original[0] * decoded[0] + original[1] * decoded[1] + original[2] * decoded[2]) / length;
+        return static_cast<float>(std::acos(std::min(1.0, std::max(-1.0, cosine))) * 180 / 3.14159265358979);
+    }
+
+
+    // Decoding gives the same triangles, and vertices within the quantisation of the settings: half a step of each
+    // component's grid for positions and UVs (the steps are in the header), and a few octahedral steps for normals
+    void CheckRoundTrip(const char* name, const MeshData& encoded, const std::vector<uint8_t>& packed,
+                        const MeshCodecSettings& settings, unsigned int numThreads)
+    {
+        MeshData decoded;
+        try
+        {
+            DecodeMesh(packed.data(), packed.size(), decoded, numThreads);
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::printf("%s: %s\n", name, e.what());
+            CHECK(false);
+            return;
+        }
+        CHECK(decoded.flags       == encoded.flags);
+        CHECK(decoded.vertexSize  == encoded.vertexSize);
+        CHECK(decoded.numVertices == encoded.numVertices);
+        CHECK(decoded.numIndices  == encoded.numIndices);
+        if (decoded.numVertices != encoded.numVertices || decoded.numIndices != encoded.numIndices)  return;
+        CHECK(std::memcmp(decoded.indices, encoded.indices, static_cast<size_t>(encoded.numIndices) * 4) == 0);
+
+        CompressedMeshHeader header;
+        std::memcpy(&header, packed.data(), sizeof(header));
+        MeshVertexLayout layout = GetMeshVertexLayout(encoded.flags);
+        float maxNormalError = 8 * 180 / 3.14159265f / static_cast<float>((1u << settings.normalBits) - 1);
+        float positionError = 0, uvError = 0, normalError = 0;
+        for (uint32_t v = 0; v < encoded.numVertices; ++v)
+        {
+            // Errors over the bound, so 0 when within it. Rounding of the decoded offset + value * scale is allowed too
+            auto excess = [&](const float* a, const float* b, unsigned int component, unsigned int i)
+            {
+                float rounding = (std::fabs(a[i]) + std::fabs(header.offset[component])) * 4 * FLT_EPSILON;
+                return std::fabs(a[i] - b[i]) - header.scale[component] / 2 - rounding;
+            };
+            const float* a = VertexFloats(encoded, v, layout.positionOffset);
+            const float* b = VertexFloats(decoded, v, layout.positionOffset);
+            for (unsigned int i = 0; i < 3; ++i)  positionError = std::max(positionError, excess(a, b, i, i));
+            if (encoded.flags & MeshHasUVs)
+            {
+                a = VertexFloats(encoded, v, layout.uvOffset);
+                b = VertexFloats(decoded, v, layout.uvOffset);
+                for (unsigned int i = 0; i < 2; ++i)  uvError = std::max(uvError, excess(a, b, header.numComponents - 2 + i, i));
+            }
+            normalError = std::max(normalError, AngleError(VertexFloats(encoded, v, layout.normalOffset),
+                                                           VertexFloats(decoded, v, layout.normalOffset)));
+            if (encoded.flags & MeshHasTangents)
+            {
+                normalError = std::max(normalError, AngleError(VertexFloats(encoded, v, layout.tangentOffset),
+                                                               VertexFloats(decoded, v, layout.tangentOffset)));
+            }
+        }
+        if (positionError > 0 || uvError > 0 || normalError > maxNormalError)
+        {
+            std::printf("%s: position %g, UV %g over the bound, normal %g degrees\n", name, positionError, uvError, normalError);
+        }
+        CHECK(positionError <= 0);
+        CHECK(uvError <= 0);
+        CHECK(normalError <= maxNormalError);
+    }
+
+
+    // Every mesh decodes back on one thread and on several, and with the default settings is smaller than its
+    // uncompressed vertices and indices by a ratio of at least MIN_RATIO
+    void TestRoundTrips()
+    {
+        const double MIN_RATIO = 2.75;
+        MeshCodecSettings lowPrecision;
+        lowPrecision.positionBits = 10;
+        lowPrecision.normalBits   = 8;
+        lowPrecision.uvBits       = 10;
+
+        for (auto& mesh : MakeTestMeshes())
+        {
+            size_t raw = static_cast<size_t>(mesh.meshData.numVertices) * mesh.meshData.vertexSize +
+                         static_cast<size_t>(mesh.meshData.numIndices) * 4;
+            std::vector<uint8_t> packed;
+            EncodeMesh(mesh.meshData, MeshCodecSettings(), packed);
+            CheckRoundTrip(mesh.name, mesh.meshData, packed, MeshCodecSettings(), 1);
+            CheckRoundTrip(mesh.name, mesh.meshData, packed, MeshCodecSettings(), 0);
+            double ratio = static_cast<double>(raw) / packed.size();
+            std::printf("%-20s %7u vertices %8u indices, ratio %.2f\n", mesh.name, mesh.meshData.numVertices,
+                        mesh.meshData.numIndices, ratio);
+            CHECK(ratio >= MIN_RATIO);
+
+            // Encoding again with fewer bits gives the same triangles, as they are already in order, and smaller data
+            std::vector<uint8_t> smaller;
+            EncodeMesh(mesh.meshData, lowPrecision, smaller);
+            CheckRoundTrip(mesh.name, mesh.meshData, smaller, lowPrecision, 1);
+            CHECK(smaller.size() < packed.size());
+        }
+    }
+
+
+    // 1 if decoded, 0 if rejected with a runtime_error. A decoded mesh must still have every index in range
+    int Decode(const std::vector<uint8_t>& data)
+    {
+        MeshData decoded;
+        try
+        {
+            DecodeMesh(data.data(), data.size(), decoded, 1);
+        }
+        catch (const std::runtime_error&)
+        {
+            return 0;
+        }
+        const uint32_t* indices = reinterpret_cast<const uint32_t*>(decoded.indices);
+        for (uint32_t i = 0; i < decoded.numIndices; ++i)  if (indices[i] >= decoded.numVertices)  return -1;
+        return 1;
+    }
+
+    // Data cut short anywhere is rejected. Data with bits flipped is either rejected or decodes to some mesh with valid
+    // indices, and never reads or writes out of bounds (which needs a sanitizer build to catch)
+    void TestDamagedData()
+    {
+        MeshData meshData;
+        GenerateUVSphere(10, 12, 8, true, meshData);
+        std::vector<uint8_t> packed;
+        EncodeMesh(meshData, MeshCodecSettings(), packed);
+        CHECK(Decode(packed) == 1);
+
+        for (size_t size = 0; size < packed.size(); ++size)
+        {
+            CHECK(Decode(std::vector<uint8_t>(packed.begin(), packed.begin() + size)) == 0);
+        }
+
+        std::mt19937 random(1);
+        std::vector<uint8_t> damaged = packed;
+        for (size_t bit = 0; bit < packed.size() * 8; ++bit)
+        {
+            damaged[bit / 8] ^= 1 << (bit % 8);
+            CHECK(Decode(damaged) >= 0);
+            damaged[bit / 8] = packed[bit / 8];
+        }
+        for (int i = 0; i < 2000; ++i)
+        {
+            damaged = packed;
+            for (int flip = 0; flip < 8; ++flip)
+            {
+                size_t bit = random() % (packed.size() * 8);
+                damaged[bit / 8] ^= 1 << (bit % 8);
+            }
+            CHECK(Decode(damaged) >= 0);
+        }
+    }
+}
+
+
+int main()
+{
+    TestRoundTrips();
+    TestDamagedData();
+    return CheckResult("MeshCodecTest");
+}
@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------------------
+// Mesh import memory test - the process peak memory of importing one model
+//--------------------------------------------------------------------------------------
+// Usage: MeshImportTest model
+// The process peak can't be reset, so each model is tested in a process of its own (see CMakeLists.txt)
+
+#include "Check.h"
+#include "MeshImport.h"
+#include "MemoryTracker.h"
+
+#include <fstream>
+#include <string>
+
+
+namespace
+{
+    // Allowance for assimp's own copy of the model and its working memory while it imports it: its parsed copy of the
+    // file, the aiScene built from that and the tables used by the post-processing steps. A mesh with several more full
+    // copies of its vertices resident at once, as when the import built separate arrays before the staging block, goes
+    // over it
+    const size_t ASSIMP_BYTES_PER_TRIANGLE = 512;
+
+    // Allowance for the heap growing in large steps
+    const size_t SLACK_BYTES = 4 * 1024 * 1024;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::printf("Usage: MeshImportTest model\n");
+        return 1;
+    }
+    std::string model = argv[1];
+
+    // Import a small model first so assimp's one-off set-up is already in the peak
+    {
+        MeshData warmUp;
+        ImportMesh("Models/Cube.x", false, warmUp);
+    }
+    gMeshStagingPool.Trim();
+
+    size_t fileBytes = static_cast<size_t>(std::ifstream(model, std::ios::binary | std::ios::ate).tellg());
+    size_t peakBefore = ProcessPeakMemory();
+    MeshData meshData;
+    ImportMesh(model, false, meshData);
+    size_t peakAfter = ProcessPeakMemory();
+
+    CHECK(peakBefore > 0);
+    CHECK(meshData.numVertices > 0);
+    CHECK(meshData.numIndices > 0 && meshData.numIndices % 3 == 0);
+    const uint32_t* indices = reinterpret_cast<const uint32_t*>(meshData.indices);
+    bool indicesInRange = true;
+    for (unsigned int i = 0; i < meshData.numIndices; ++i)  indicesInRange = indicesInRange && indices[i] < meshData.numVertices;
+    CHECK(indicesInRange);
+
+    // At its peak the import holds the file, assimp's copy of the mesh and the staging block, nothing more
+    size_t numTriangles = meshData.numIndices / 3;
+    size_t budget = fileBytes + meshData.staging.Capacity() + numTriangles * ASSIMP_BYTES_PER_TRIANGLE + SLACK_BYTES;
+    size_t growth = peakAfter - peakBefore;
+    std::printf("%s: %u vertices, %zu triangles, staging %.2f MB, peak grew %.2f MB (budget %.2f MB)\n", model.c_str(),
+                meshData.numVertices, numTriangles, meshData.staging.Capacity() / (1024.0 * 1024.0),
+                growth / (1024.0 * 1024.0), budget / (1024.0 * 1024.0));
+    CHECK(growth <= budget);
+
+    return CheckResult("MeshImportTest");
+}
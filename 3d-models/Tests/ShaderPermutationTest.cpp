@@ -0,0 +1,165 @@
+//--------------------------------------------------------------------------------------
+// Shader permutation tests - permutation keys, names, cache keys, the cache folder and source loading
+//--------------------------------------------------------------------------------------
+
+#include "Check.h"
+#include "ShaderPermutation.h"
+#include "AssetPackage.h"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <set>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+
+namespace
+{
+    // Keys are sorted by name whatever order they are set in, and setting a key again replaces it
+    void TestDefines()
+    {
+        ShaderDefines defines = { {"SHADOWS", 1}, {"LIGHT_COUNT", 2}, {"CELL_SHADING", 0} };
+        ShaderDefines reordered;
+        reordered.Set("CELL_SHADING", 0).Set("LIGHT_COUNT", 3).Set("SHADOWS", 1).Set("LIGHT_COUNT", 2);
+
+        CHECK(defines.ToString() == "CELL_SHADING=0 LIGHT_COUNT=2 SHADOWS=1");
+        CHECK(reordered.ToString() == defines.ToString());
+        CHECK(defines.List().size() == 3);
+        CHECK(defines.List()[0].first == "CELL_SHADING" && defines.List()[0].second == "0");
+        CHECK(defines.Get("LIGHT_COUNT") == 2);
+        CHECK(defines.Get("TEXTURE_MIXING") == 0);
+        CHECK(defines.Get("TEXTURE_MIXING", 7) == 7);
+        CHECK(ShaderDefines().ToString().empty());
+    }
+
+
+    // Names used for the loaded permutations and their assets in the package. Every permutation the app uses must have
+    // a source that loads and an asset name of its own, or the cooker would store one over another
+    void TestNames()
+    {
+        ShaderPermutation permutation = { "Lighting_ps", { {"SHADOWS", 1}, {"LIGHT_COUNT", 2} } };
+        CHECK(ShaderPermutationName(permutation) == "Lighting_ps (LIGHT_COUNT=2 SHADOWS=1)");
+        CHECK(ShaderPermutationAssetName(permutation) == "Lighting_ps (LIGHT_COUNT=2 SHADOWS=1).cso");
+        CHECK(ShaderPermutationName(gPixelLightingPermutation) == ShaderPermutationName(permutation));
+
+        std::vector<ShaderPermutation> permutations = AppShaderPermutations();
+        CHECK(permutations.size() == 4);
+        std::set<std::string> assetNames;
+        for (auto& appPermutation : permutations)
+        {
+            assetNames.insert(PackageAssetName(ShaderPermutationAssetName(appPermutation)));
+            std::string source;
+            CHECK(LoadShaderSource(appPermutation.shaderName + ".hlsl", source));
+        }
+        CHECK(assetNames.size() == permutations.size());
+    }
+
+
+    // The key changes with every part that affects the bytecode, including text moving from one part to the next
+    void TestCacheKey()
+    {
+        const std::string SOURCE = "float4 main() : SV_Target { return 0; }";
+        ShaderDefines defines = { {"LIGHT_COUNT", 2}, {"SHADOWS", 1} };
+        uint64_t key = ShaderCacheKey(SOURCE, defines, "main", "ps_5_0", 0);
+
+        CHECK(ShaderCacheKey(SOURCE, { {"SHADOWS", 1}, {"LIGHT_COUNT", 2} }, "main", "ps_5_0", 0) == key);
+        CHECK(ShaderCacheKey(SOURCE + " ", defines, "main", "ps_5_0", 0) != key);
+        CHECK(ShaderCacheKey(SOURCE, { {"LIGHT_COUNT", 1}, {"SHADOWS", 1} }, "main", "ps_5_0", 0) != key);
+        CHECK(ShaderCacheKey(SOURCE, { {"LIGHT_COUNT", 2} }, "main", "ps_5_0", 0) != key);
+        CHECK(ShaderCacheKey(SOURCE, defines, "main2", "ps_5_0", 0) != key);
+        CHECK(ShaderCacheKey(SOURCE, defines, "main", "ps_4_0", 0) != key);
+        CHECK(ShaderCacheKey(SOURCE, defines, "main", "ps_5_0", PERMUTATION_COMPILE_FLAGS) != key);
+        CHECK(ShaderCacheKey(SOURCE, defines, "mainp", "s_5_0", 0) != key);
+        CHECK(ShaderCacheKey(SOURCE, { {"LIGHT_COUNT2", 1} }, "main", "ps_5_0", 0) !=
+              ShaderCacheKey(SOURCE, { {"LIGHT_COUNT", 21} }, "main", "ps_5_0", 0));
+    }
+
+
+    // Folder for the file tests, emptied first
+    fs::path TestFolder(const char* name)
+    {
+        fs::path folder = fs::temp_directory_path() / name;
+        fs::remove_all(folder);
+        fs::create_directories(folder);
+        return folder;
+    }
+
+    void WriteFile(const fs::path& fileName, const std::string& text)
+    {
+        fs::create_directories(fileName.parent_path());
+        std::ofstream(fileName, std::ios::out | std::ios::binary | std::ios::trunc) << text;
+    }
+
+
+    // Bytecode is stored under the key's file name and read back, with nothing left behind from the temporary file
+    void TestCache()
+    {
+        fs::path folder = TestFolder("ShaderPermutationTest_Cache") / "ShaderCache";
+        ShaderCache cache(folder.generic_string());
+        CHECK(cache.FileName(0x0123456789abcdefull) == folder.generic_string() + "/0123456789abcdef.cso");
+        CHECK(ShaderCache().FileName(1) == "ShaderCache/0000000000000001.cso");
+
+        std::vector<uint8_t> bytecode;
+        CHECK(!cache.Load(42, bytecode));
+
+        const uint8_t DATA[] = { 0x44, 0x58, 0x42, 0x43, 0, 1, 2, 3 };
+        CHECK(cache.Store(42, DATA, sizeof(DATA))); // Creates the folder
+        CHECK(cache.Load(42, bytecode));
+        CHECK(bytecode == std::vector<uint8_t>(DATA, DATA + sizeof(DATA)));
+        CHECK(!cache.Load(43, bytecode));
+
+        int numFiles = 0;
+        for (auto& file : fs::directory_iterator(folder))  { ++numFiles;  CHECK(file.path().extension() == ".cso"); }
+        CHECK(numFiles == 1);
+        fs::remove_all(folder.parent_path());
+    }
+
+
+    // Included files are pasted in once each, relative to the file including them, with #line directives back to the
+    // original files. A change to an included file changes the cache key
+    void TestSourceLoading()
+    {
+        fs::path folder = TestFolder("ShaderPermutationTest_Source");
+        WriteFile(folder / "Main.hlsl",           "#include \"Include/A.hlsl\"\n  #  include \"Common.hlsl\"\r\nmain\n");
+        WriteFile(folder / "Include/A.hlsl",      "#include \"../Common.hlsl\"\na\n");
+        WriteFile(folder / "Common.hlsl",         "common\n");
+
+        std::string mainName   = (folder / "Main.hlsl").generic_string();
+        std::string aName      = (folder / "Include/A.hlsl").generic_string();
+        std::string commonName = (folder / "Common.hlsl").generic_string();
+        std::string source;
+        CHECK(LoadShaderSource(mainName, source));
+        std::string expected = "#line 1 \"" + mainName + "\"\n" +
+                                   "#line 1 \"" + aName + "\"\n" +
+                                       "#line 1 \"" + commonName + "\"\n" + "common\n" +
+                                   "#line 2 \"" + aName + "\"\n" + "a\n" +
+                               "#line 2 \"" + mainName + "\"\n" +
+                               "#line 3 \"" + mainName + "\"\n" + "main\n";
+        CHECK(source == expected);
+
+        ShaderDefines defines;
+        uint64_t key = ShaderCacheKey(source, defines, PERMUTATION_ENTRY_POINT, PERMUTATION_TARGET, PERMUTATION_COMPILE_FLAGS);
+        WriteFile(folder / "Common.hlsl", "common changed\n");
+        CHECK(LoadShaderSource(mainName, source));
+        CHECK(ShaderCacheKey(source, defines, PERMUTATION_ENTRY_POINT, PERMUTATION_TARGET, PERMUTATION_COMPILE_FLAGS) != key);
+
+        fs::remove(folder / "Include/A.hlsl");
+        CHECK(!LoadShaderSource(mainName, source));
+        CHECK(!LoadShaderSource((folder / "Missing.hlsl").generic_string(), source));
+        fs::remove_all(folder);
+    }
+}
+
+
+int main()
+{
+    TestDefines();
+    TestNames();
+    TestCacheKey();
+    TestCache();
+    TestSourceLoading();
+    return CheckResult("ShaderPermutationTest");
+}
@@ -0,0 +1,201 @@
+//--------------------------------------------------------------------------------------
+// Silhouette edge tests - the extracted edges against a brute force search over many viewpoints
+//--------------------------------------------------------------------------------------
+
+#include "Check.h"
+#include "SilhouetteEdges.h"
+#include "MeshPrimitives.h"
+
+#include <vector>
+#include <map>
+#include <set>
+#include <array>
+#include <utility>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+    using EdgeKey = std::pair<uint32_t, uint32_t>; // Welded positions of the two ends, smallest first
+
+    bool SamePosition(const CVector3& a, const CVector3& b)  { return a.x == b.x && a.y == b.y && a.z == b.z; }
+
+    // A straightforward version of the search written separately from SilhouetteEdges.cpp: weld positions with a map,
+    // find each edge's triangles, then test every triangle in double precision for every viewpoint
+    class BruteForceSilhouette
+    {
+    public:
+        BruteForceSilhouette(const MeshData& meshData)
+        {
+            MeshVertexLayout layout = GetMeshVertexLayout(meshData.flags);
+            std::vector<uint32_t> welded(meshData.numVertices);
+            for (uint32_t v = 0; v < meshData.numVertices; ++v)
+            {
+                const float* p = reinterpret_cast<const float*>(meshData.vertices + v * meshData.vertexSize + layout.positionOffset);
+                welded[v] = Weld(CVector3{ p[0], p[1], p[2] }, true);
+            }
+
+            const uint32_t* indices = reinterpret_cast<const uint32_t*>(meshData.indices);
+            for (uint32_t i = 0; i + 2 < meshData.numIndices; i += 3)
+            {
+                std::array<uint32_t, 3> corners = { welded[indices[i]], welded[indices[i + 1]], welded[indices[i + 2]] };
+                if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])  continue;
+                uint32_t triangle = static_cast<uint32_t>(mTriangles.size());
+                mTriangles.push_back(corners);
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    uint32_t a = corners[corner], b = corners[(corner + 1) % 3];
+                    mEdgeTriangles[{ std::min(a, b), std::max(a, b) }].push_back(triangle);
+                }
+            }
+        }
+
+        // Welded number of a position, optionally adding it if it is new
+        uint32_t Weld(const CVector3& position, bool add = false)
+        {
+            std::array<float, 3> key = { position.x + 0.0f, position.y + 0.0f, position.z + 0.0f };
+            auto found = mPositionIndex.find(key);
+            if (found != mPositionIndex.end())  return found->second;
+            if (!add)  return UINT32_MAX;
+            mPositions.push_back(key);
+            return mPositionIndex[key] = static_cast<uint32_t>(mPositions.size() - 1);
+        }
+
+        // Silhouette edges seen from a viewpoint: edges of exactly two triangles facing different ways, and open edges of
+        // triangles facing the viewpoint. Edges next to a triangle seen nearly edge-on (where float and double precision
+        // may disagree) go in the uncertain set
+        void Find(const CVector3& viewpoint, std::set<EdgeKey>& edges, std::set<EdgeKey>& uncertain)
+        {
+            edges.clear();
+            uncertain.clear();
+            std::vector<int> facing(mTriangles.size()); // 1 facing, 0 facing away, -1 uncertain
+            for (size_t t = 0; t < mTriangles.size(); ++t)
+            {
+                double p[3][3];
+                for (int c = 0; c < 3; ++c)  for (int i = 0; i < 3; ++i)  p[c][i] = mPositions[mTriangles[t][c]][i];
+                double e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+                double e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+                double n[3]  = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+                double v[3]  = { viewpoint.x - p[0][0], viewpoint.y - p[0][1], viewpoint.z - p[0][2] };
+                double distance = n[0] * v[0] + n[1] * v[1] + n[2] * v[2];
+                double scale = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) *
+                               (std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]) +
+                                std::sqrt(p[0][0] * p[0][0] + p[0][1] * p[0][1] + p[0][2] * p[0][2]));
+                facing[t] = std::fabs(distance) <= scale * 1e-5 ? -1 : (distance > 0 ? 1 : 0);
+            }
+
+            for (auto& edge : mEdgeTriangles)
+            {
+                const std::vector<uint32_t>& triangles = edge.second;
+                if (triangles.size() > 2)  continue; // Not in the meshes tested here
+                int a = facing[triangles[0]];
+                int b = triangles.size() == 2 ? facing[triangles[1]] : 0;
+                if (a < 0 || b < 0)  uncertain.insert(edge.first);
+                else if (a != b)     edges.insert(edge.first);
+            }
+        }
+
+        size_t NumEdges() const      { return mEdgeTriangles.size(); }
+        size_t NumTriangles() const  { return mTriangles.size(); }
+
+    private:
+        std::map<std::array<float, 3>, uint32_t>    mPositionIndex;
+        std::vector<std::array<float, 3>>           mPositions;
+        std::vector<std::array<uint32_t, 3>>        mTriangles;
+        std::map<EdgeKey, std::vector<uint32_t>>    mEdgeTriangles;
+    };
+
+
+    // Compare the extracted edges with brute force from random viewpoints, near and far, outside the mesh and inside it.
+    // Apart from edges brute force isn't sure of, the sets must be the same. The result must be in edge order, and the
+    // same with one thread or several
+    void TestMesh(const char* name, const MeshData& meshData, float size, int numViewpoints)
+    {
+        MeshVertexLayout layout = GetMeshVertexLayout(meshData.flags);
+        EdgeAdjacency adjacency;
+        adjacency.Build(meshData.vertices, meshData.vertexSize, layout.positionOffset, meshData.numVertices,
+                        reinterpret_cast<const uint32_t*>(meshData.indices), meshData.numIndices);
+        BruteForceSilhouette bruteForce(meshData);
+        CHECK(adjacency.NumTriangles() == bruteForce.NumTriangles());
+        CHECK(adjacency.NumEdges() == bruteForce.NumEdges());
+
+        SilhouetteExtractor oneThread(1), manyThreads(4);
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        size_t numCompared = 0, numUncertain = 0, numMismatched = 0;
+        for (int i = 0; i < numViewpoints; ++i)
+        {
+            float distance = size * (i % 4 == 0 ? 0.1f : i % 4 == 1 ? 0.7f : i % 4 == 2 ? 3.0f : 50.0f);
+            CVector3 viewpoint = { unit(random) * distance, unit(random) * distance, unit(random) * distance };
+
+            const std::vector<uint32_t>& edges = oneThread.Extract(adjacency, viewpoint);
+            CHECK(std::is_sorted(edges.begin(), edges.end()) && std::adjacent_find(edges.begin(), edges.end()) == edges.end());
+            CHECK(manyThreads.Extract(adjacency, viewpoint) == edges);
+
+            std::set<EdgeKey> expected, uncertain;
+            bruteForce.Find(viewpoint, expected, uncertain);
+            std::set<EdgeKey> found;
+            for (uint32_t edge : edges)
+            {
+                uint32_t a = bruteForce.Weld(adjacency.EdgeStart(edge));
+                uint32_t b = bruteForce.Weld(adjacency.EdgeEnd(edge));
+                EdgeKey key = { std::min(a, b), std::max(a, b) };
+                if (uncertain.count(key) == 0)  found.insert(key);
+            }
+            if (found != expected)  ++numMismatched;
+            numCompared += expected.size();
+            numUncertain += uncertain.size();
+        }
+        std::printf("%-10s %7zu triangles, %zu silhouette edges compared, %zu uncertain\n", name, bruteForce.NumTriangles(),
+                    numCompared, numUncertain);
+        CHECK(numMismatched == 0);
+        CHECK(numUncertain * 100 < numCompared); // Too many would mean the comparison checks little
+    }
+
+
+    // The outline quads have two corners at each end of the edge, on opposite sides
+    void TestOutlineQuads()
+    {
+        MeshData meshData;
+        GenerateBox({ 1, 2, 3 }, 1, false, meshData);
+        MeshVertexLayout layout = GetMeshVertexLayout(meshData.flags);
+        EdgeAdjacency adjacency;
+        adjacency.Build(meshData.vertices, meshData.vertexSize, layout.positionOffset, meshData.numVertices,
+                        reinterpret_cast<const uint32_t*>(meshData.indices), meshData.numIndices);
+        CHECK(adjacency.NumOpenEdges() == 0);
+
+        SilhouetteExtractor extractor(1);
+        const std::vector<uint32_t>& edges = extractor.Extract(adjacency, { 10, 20, 30 });
+        CHECK(edges.size() == 6); // Seen from a corner a box's outline is a hexagon
+        std::vector<OutlineVertex> vertices(edges.size() * OUTLINE_VERTICES_PER_EDGE);
+        WriteOutlineQuads(adjacency, edges.data(), static_cast<uint32_t>(edges.size()), vertices.data());
+        for (size_t i = 0; i < edges.size(); ++i)
+        {
+            const OutlineVertex* quad = &vertices[i * OUTLINE_VERTICES_PER_EDGE];
+            const CVector3& start = adjacency.EdgeStart(edges[i]);
+            const CVector3& end   = adjacency.EdgeEnd(edges[i]);
+            CHECK(SamePosition(quad[0].position, start) && SamePosition(quad[1].position, start));
+            CHECK(SamePosition(quad[2].position, end)   && SamePosition(quad[3].position, end));
+            CHECK(SamePosition(quad[0].otherEnd, end)   && SamePosition(quad[2].otherEnd, start));
+            CHECK(quad[0].side == -quad[1].side && quad[2].side == -quad[3].side);
+        }
+    }
+}
+
+
+int main()
+{
+    MeshData torus, sphere, plane, bigTorus;
+    GenerateTorus(10, 3, 64, 32, false, torus);
+    GenerateUVSphere(5, 40, 20, true, sphere); // With tangents, a different vertex layout
+    GeneratePlane(20, 20, 16, 16, 1, false, plane); // Open edges all round
+    GenerateTorus(10, 3, 512, 256, false, bigTorus); // Large enough to be split between threads
+    TestMesh("Torus", torus, 13, 1000);
+    TestMesh("UV sphere", sphere, 5, 500);
+    TestMesh("Plane", plane, 10, 500);
+    TestMesh("Big torus", bigTorus, 13, 16);
+    TestOutlineQuads();
+    return CheckResult("SilhouetteEdgesTest");
+}
@@ -0,0 +1,195 @@
+//--------------------------------------------------------------------------------------
+// Texture array allocator tests - slices, pages for each key, full pages and random use
+//--------------------------------------------------------------------------------------
+
+#include "Check.h"
+#include "TextureArrayAllocator.h"
+
+#include <vector>
+#include <set>
+#include <random>
+#include <utility>
+#include <algorithm>
+
+
+namespace
+{
+    const TextureArrayKey KEY_512  = { DXGI_FORMAT_B8G8R8A8_UNORM, 512,  512,  10 };
+    const TextureArrayKey KEY_1024 = { DXGI_FORMAT_B8G8R8A8_UNORM, 1024, 1024, 11 };
+
+    bool operator==(TextureArraySlot a, TextureArraySlot b)  { return a.page == b.page && a.slice == b.slice; }
+
+
+    // Slices are given out lowest first and freed slices are reused, lowest first again
+    void TestSlices()
+    {
+        TextureArrayAllocator allocator(8);
+        for (uint32_t slice = 0; slice < 5; ++slice)  CHECK((allocator.Allocate(KEY_512) == TextureArraySlot{ 0, slice }));
+        CHECK(allocator.NumPages() == 1);
+        CHECK(allocator.UsedSlices(0) == 5);
+        CHECK(allocator.ArraySize(0) == 5);
+
+        allocator.Free({ 0, 3 });
+        allocator.Free({ 0, 1 });
+        CHECK(allocator.UsedSlices(0) == 3);
+        CHECK(allocator.ArraySize(0) == 5); // Gaps below the last slice in use don't shrink the array
+        allocator.Free({ 0, 4 });
+        CHECK(allocator.ArraySize(0) == 3);
+
+        CHECK((allocator.Allocate(KEY_512) == TextureArraySlot{ 0, 1 }));
+        CHECK((allocator.Allocate(KEY_512) == TextureArraySlot{ 0, 3 }));
+        CHECK((allocator.Allocate(KEY_512) == TextureArraySlot{ 0, 4 }));
+        CHECK(allocator.UsedSlices(0) == 5);
+
+        // Freeing twice, or a slot that was never given out, changes nothing
+        allocator.Free({ 0, 2 });
+        allocator.Free({ 0, 2 });
+        allocator.Free({ 0, 7 });
+        allocator.Free({ 0, 8 });
+        allocator.Free({ 5, 0 });
+        CHECK(allocator.UsedSlices(0) == 4);
+        CHECK(allocator.NumPages() == 1);
+
+        allocator.Clear();
+        CHECK(allocator.NumPages() == 0);
+        CHECK((allocator.Allocate(KEY_1024) == TextureArraySlot{ 0, 0 }));
+    }
+
+
+    // Each key has pages of its own. Keys differing in any field don't share, and an emptied page is reused for any key
+    void TestKeys()
+    {
+        TextureArrayAllocator allocator(4);
+        TextureArrayKey otherFormat = KEY_512;  otherFormat.format    = DXGI_FORMAT_BC1_UNORM;
+        TextureArrayKey otherWidth  = KEY_512;  otherWidth.width      = 256;
+        TextureArrayKey otherHeight = KEY_512;  otherHeight.height    = 256;
+        TextureArrayKey otherMips   = KEY_512;  otherMips.mipLevels   = 1;
+        const TextureArrayKey KEYS[] = { KEY_512, otherFormat, otherWidth, otherHeight, otherMips };
+
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            for (uint32_t k = 0; k < 5; ++k)  CHECK((allocator.Allocate(KEYS[k]) == TextureArraySlot{ k, i }));
+        }
+        CHECK(allocator.NumPages() == 5);
+        for (uint32_t k = 0; k < 5; ++k)
+        {
+            CHECK(allocator.PageKey(k) == KEYS[k]);
+            CHECK(allocator.UsedSlices(k) == 2);
+        }
+
+        allocator.Free({ 2, 0 });
+        allocator.Free({ 2, 1 });
+        CHECK(allocator.UsedSlices(2) == 0);
+        CHECK(allocator.ArraySize(2) == 0);
+        CHECK((allocator.Allocate(KEY_1024) == TextureArraySlot{ 2, 0 }));
+        CHECK(allocator.PageKey(2) == KEY_1024);
+        CHECK(allocator.NumPages() == 5);
+
+        // The old key of the reused page now needs a page of its own
+        CHECK((allocator.Allocate(otherWidth) == TextureArraySlot{ 5, 0 }));
+    }
+
+
+    // A full page sends allocations to the next page with the key, or a new one. Slices freed in a full page are
+    // used again before any later page
+    void TestFullPages()
+    {
+        const uint32_t SLICES = 3;
+        TextureArrayAllocator allocator(SLICES);
+        for (uint32_t i = 0; i < SLICES * 3; ++i)
+        {
+            CHECK((allocator.Allocate(KEY_512) == TextureArraySlot{ i / SLICES, i % SLICES }));
+        }
+        CHECK(allocator.NumPages() == 3);
+        for (uint32_t page = 0; page < 3; ++page)
+        {
+            CHECK(allocator.UsedSlices(page) == SLICES);
+            CHECK(allocator.ArraySize(page) == SLICES);
+        }
+
+        allocator.Free({ 1, 2 });
+        allocator.Free({ 2, 0 });
+        CHECK((allocator.Allocate(KEY_512) == TextureArraySlot{ 1, 2 }));
+        CHECK((allocator.Allocate(KEY_512) == TextureArraySlot{ 2, 0 }));
+        CHECK((allocator.Allocate(KEY_512) == TextureArraySlot{ 3, 0 }));
+
+        // One slice per page is the smallest allocator, every texture gets a page
+        TextureArrayAllocator single(1);
+        for (uint32_t i = 0; i < 4; ++i)  CHECK((single.Allocate(KEY_512) == TextureArraySlot{ i, 0 }));
+        single.Free({ 1, 0 });
+        CHECK((single.Allocate(KEY_1024) == TextureArraySlot{ 1, 0 }));
+        CHECK(single.NumPages() == 4);
+
+        // The largest pages Direct3D allows
+        TextureArrayAllocator large(2048);
+        for (uint32_t i = 0; i < 2048; ++i)  large.Allocate(KEY_512);
+        CHECK(large.NumPages() == 1 && large.UsedSlices(0) == 2048 && large.ArraySize(0) == 2048);
+        CHECK((large.Allocate(KEY_512) == TextureArraySlot{ 1, 0 }));
+    }
+
+
+    // Random allocations and frees of several keys never give out a slot twice, never put a texture in a page of another
+    // key, and the allocator's counts agree with the slots given out
+    void TestRandomUse()
+    {
+        const uint32_t SLICES = 8;
+        const TextureArrayKey KEYS[] = { KEY_512, KEY_1024, { DXGI_FORMAT_BC3_UNORM, 512, 512, 10 } };
+        TextureArrayAllocator allocator(SLICES);
+        std::vector<std::pair<TextureArraySlot, uint32_t>> live; // Slot and key index
+        std::set<std::pair<uint32_t, uint32_t>> inUse; // Page and slice of each slot in live
+        std::mt19937 random(1);
+
+        size_t maxLive = 0;
+        for (int step = 0; step < 20000; ++step)
+        {
+            // Grow to a few hundred textures then shrink, then repeat
+            bool growing = (step / 2500) % 2 == 0;
+            if (live.empty() || random() % 100 < (growing ? 70u : 30u))
+            {
+                uint32_t key = random() % 3;
+                TextureArraySlot slot = allocator.Allocate(KEYS[key]);
+                CHECK(inUse.insert({ slot.page, slot.slice }).second);
+                CHECK(allocator.PageKey(slot.page) == KEYS[key]);
+                live.push_back({ slot, key });
+            }
+            else
+            {
+                size_t index = random() % live.size();
+                allocator.Free(live[index].first);
+                inUse.erase({ live[index].first.page, live[index].first.slice });
+                live[index] = live.back();
+                live.pop_back();
+            }
+            maxLive = std::max(maxLive, live.size());
+        }
+
+        std::vector<uint32_t> used(allocator.NumPages(), 0), arraySize(allocator.NumPages(), 0);
+        for (auto& texture : live)
+        {
+            TextureArraySlot slot = texture.first;
+            CHECK(slot.page < allocator.NumPages() && slot.slice < SLICES);
+            if (slot.page >= allocator.NumPages())  continue;
+            CHECK(allocator.PageKey(slot.page) == KEYS[texture.second]);
+            ++used[slot.page];
+            arraySize[slot.page] = std::max(arraySize[slot.page], slot.slice + 1);
+        }
+        for (uint32_t page = 0; page < allocator.NumPages(); ++page)
+        {
+            CHECK(allocator.UsedSlices(page) == used[page]);
+            CHECK(allocator.ArraySize(page) == arraySize[page]);
+        }
+
+        // Freed slices and pages are reused, so there are never many more pages than the most textures ever needed
+        CHECK(allocator.NumPages() <= maxLive / SLICES + 3 * 4);
+    }
+}
+
+
+int main()
+{
+    TestSlices();
+    TestKeys();
+    TestFullPages();
+    TestRandomUse();
+    return CheckResult("TextureArrayAllocatorTest");
+}
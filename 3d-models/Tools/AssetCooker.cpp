@@ -0,0 +1,872 @@
+//--------------------------------------------------------------------------------------
+// Asset cooker - offline tool that converts the app's loose asset files into a single package
+//--------------------------------------------------------------------------------------
+// Usage: AssetCooker [-j threads] [-f] [-v] [-tc none|fast|quality] [-mips none|box|kaiser|lanczos] [-ac] [-mc none|quantised]
+//                    [output package]
+//        AssetCooker -benchimport [repeats]
+//        AssetCooker -benchmeshcodec [repeats]
+//   Run from the folder containing the app, i.e. the one holding Models/, Textures/, the compiled .cso shaders
+//   and the .hlsl shader sources
+//   output package  Defaults to Assets.pak, which is the name the app looks for in InitGeometry
+//   -j threads      Number of worker threads, defaults to the number of hardware threads
+//   -f              Force a full rebuild, ignoring the previous package
+//   -v              List every asset as it is processed (with the PSNR of compressed textures)
+//   -tc             Texture compression for decoded images, defaults to fast (see CookImage)
+//   -mips           Mip-map filter for decoded images, defaults to kaiser
+//   -ac             Preserve alpha test coverage in the mip-maps of decoded images with alpha
+//   -mc             Mesh compression, defaults to quantised (see MeshCodec.h). none stores meshes uncompressed
+//   -benchimport    Don't cook anything, instead time the import of every model with each of assimp's file access methods,
+//                   and show the staging memory each import leaves and the process peak memory. For .glb models the
+//                   mapped and memory columns are the native glTF importer (GlbImport.h) rather than assimp
+//   -benchmeshcodec Don't cook anything, instead compress every model, check it decodes back to the import within the
+//                   quantisation error, and show the compression ratio and the time to encode and decode it
+//
+// What is cooked (see AssetPackage.h for the package format):
+//   Models/*.x/.glb      Imported with the same code as the app (MeshImport.cpp) and compressed (MeshCodec.h), or stored in
+//                        the final vertex/index layout with -mc none. Compressed meshes are decoded again and checked
+//                        against the import before they are stored. Cooked without tangents, which is how the app loads
+//                        every mesh
+//   Textures/*.dds       Stored unchanged
+//   Textures/*.png/.jpg  Decoded with WIC and stored as block compressed DDS with a full mip chain, so the app never has
+//                        to decode image files or generate mip-maps
+//   *.cso                Compiled shaders, stored unchanged
+//   Shader permutations  Every pixel shader permutation the app uses (AppShaderPermutations in ShaderPermutation.h),
+//                        compiled from the .hlsl source so the app doesn't compile any at runtime
+//
+// Builds are incremental. Each asset records a hash of its source file contents and the cook settings used. Any asset
+// whose hash matches the entry in the previous package is copied from there instead of being cooked again.
+
+#include "AssetPackage.h"
+#include "MeshImport.h"
+#include "MeshCodec.h"
+#include "GlbImport.h"
+#include "MappedIOSystem.h"
+#include "DDSFile.h"
+#include "TextureCompress.h"
+#include "MipGenerator.h"
+#include "MemoryTracker.h"
+#include "ShaderPermutation.h"
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <wincodec.h>
+#include <wrl/client.h>
+#include <d3dcompiler.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cfloat>
+#include <exception>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+using Microsoft::WRL::ComPtr;
+
+
+// Increase this whenever the cooked output of any asset type changes, it forces every asset to be cooked again
+const uint32_t COOKER_VERSION = 4;
+
+// Compression of images decoded by CookImage, chosen with the -tc option
+enum class TextureCompression : uint32_t
+{
+    None,
+    Fast,    // BC1, or BC3 for images with alpha, using the fast encoder preset
+    Quality, // BC7 using the quality encoder preset
+};
+
+TextureCompression gTextureCompression = TextureCompression::Fast;
+
+// Mip-map generation for images decoded by CookImage, chosen with the -mips and -ac options
+bool      gGenerateMips          = true;
+MipFilter gMipFilter             = MipFilter::Kaiser;
+bool      gPreserveAlphaCoverage = false;
+
+// Mesh compression, chosen with the -mc option
+bool              gCompressMeshes = true;
+MeshCodecSettings gMeshCodecSettings;
+
+
+//--------------------------------------------------------------------------------------
+// Cook jobs
+//--------------------------------------------------------------------------------------
+
+// One asset to be cooked. Each job is processed by a single worker thread so needs no locking
+struct CookJob
+{
+    std::string sourceFile; // Path to the source file on disk
+    std::string assetName;  // Normalised name used in the package
+    AssetType   type;
+
+    uint64_t             sourceHash = 0;
+    std::vector<uint8_t> blob;           // Cooked data
+    bool                 reused = false; // True if the blob was copied from the previous package
+    std::string          info;           // Details of the cooked result for verbose output
+    std::string          error;          // Non-empty if the asset failed to cook
+
+    ShaderPermutation    permutation;    // For shader permutations only, which are compiled from sourceFile
+};
+
+
+// Add a job for every file in the given folder with one of the given extensions (case insensitive)
+void AddJobs(std::vector<CookJob>& jobs, const fs::path& folder, AssetType type, const std::vector<std::string>& extensions)
+{
+    std::error_code error;
+    for (auto& file : fs::directory_iterator(folder, error))
+    {
+        if (!file.is_regular_file())  continue;
+
+        std::string extension = PackageAssetName(file.path().extension().string());
+        if (std::find(extensions.begin(), extensions.end(), extension) == extensions.end())  continue;
+
+        CookJob job;
+        job.sourceFile = file.path().generic_string();
+        job.assetName  = PackageAssetName(job.sourceFile);
+        job.type       = type;
+        jobs.push_back(std::move(job));
+    }
+}
+
+
+// Read an entire file into memory, returns false on failure
+bool ReadWholeFile(const std::string& fileName, std::vector<uint8_t>& data)
+{
+    std::ifstream file(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open())  return false;
+
+    std::streamoff fileSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+    data.resize(static_cast<size_t>(fileSize));
+    file.read(reinterpret_cast<char*>(data.data()), fileSize);
+    return !file.fail();
+}
+
+
+bool HasExtension(const std::string& assetName, const char* extension)
+{
+    size_t length = std::strlen(extension);
+    return assetName.size() >= length && assetName.compare(assetName.size() - length, length, extension) == 0;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Meshes
+//--------------------------------------------------------------------------------------
+
+// Largest differences between a mesh and the result of compressing and decoding it
+struct MeshCodecErrors
+{
+    bool  sameTriangles;
+    float position; // Fraction of the largest dimension of the mesh
+    float normal;   // Degrees, normals and tangents
+    float uv;       // Fraction of the largest range of UVs
+};
+
+MeshCodecErrors CompareDecodedMesh(const MeshData& original, const MeshData& decoded)
+{
+    MeshCodecErrors errors = {};
+    errors.sameTriangles = decoded.flags == original.flags && decoded.numVertices == original.numVertices &&
+                           decoded.numIndices == original.numIndices &&
+                           std::memcmp(decoded.indices, original.indices, static_cast<size_t>(original.numIndices) * 4) == 0;
+    if (!errors.sameTriangles)  return errors;
+
+    MeshVertexLayout layout = GetMeshVertexLayout(original.flags);
+    auto floats = [&](const MeshData& mesh, uint32_t vertex, unsigned int offset)
+    {
+        return reinterpret_cast<const float*>(mesh.vertices + static_cast<size_t>(vertex) * layout.vertexSize + offset);
+    };
+
+    // Largest difference in a range of floats as a fraction of the largest range of the original values. Float rounding
+    // is left out, it is bigger than the quantisation for values far from 0 compared to their range
+    auto rangeError = [&](unsigned int offset, unsigned int count)
+    {
+        float minimum[3], maximum[3], error = 0;
+        for (uint32_t v = 0; v < original.numVertices; ++v)
+        {
+            const float* a = floats(original, v, offset);
+            const float* b = floats(decoded,  v, offset);
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                minimum[i] = (v == 0) ? a[i] : std::min(minimum[i], a[i]);
+                maximum[i] = (v == 0) ? a[i] : std::max(maximum[i], a[i]);
+                error = std::max(error, std::fabs(a[i] - b[i]) - std::fabs(a[i]) * 4 * FLT_EPSILON);
+            }
+        }
+        float range = 0;
+        for (unsigned int i = 0; i < count && original.numVertices > 0; ++i)  range = std::max(range, maximum[i] - minimum[i]);
+        return (range > 0) ? error / range : error;
+    };
+
+    // Angle between the decoded vectors and the original ones made unit length
+    auto angleError = [&](unsigned int offset)
+    {
+        double largest = 0;
+        for (uint32_t v = 0; v < original.numVertices; ++v)
+        {
+            const float* a = floats(original, v, offset);
+            const float* b = floats(decoded,  v, offset);
+            double length = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+            if (length == 0)  continue;
+            double cosine = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) / length;
+            largest = std::max(largest, std::acos(std::min(1.0, std::max(-1.0, cosine))));
+        }
+        return static_cast<float>(largest * 180 / 3.14159265358979);
+    };
+
+    errors.position = rangeError(layout.positionOffset, 3);
+    errors.normal   = angleError(layout.normalOffset);
+    if (original.flags & MeshHasTangents)  errors.normal = std::max(errors.normal, angleError(layout.tangentOffset));
+    if (original.flags & MeshHasUVs)       errors.uv = rangeError(layout.uvOffset, 2);
+    return errors;
+}
+
+// Whether the errors are what the quantisation of the settings can give: a step of the position and UV grids, and
+// about four octahedral steps for normals
+bool MeshCodecErrorsExpected(const MeshCodecErrors& errors, const MeshCodecSettings& settings)
+{
+    auto step = [](unsigned int bits) { return 1.0f / static_cast<float>((1u << std::min(std::max(bits, 1u), 16u)) - 1); };
+    return errors.sameTriangles && errors.position <= step(settings.positionBits) && errors.uv <= step(settings.uvBits) &&
+           errors.normal <= 8 * step(settings.normalBits) * 180 / 3.14159265f;
+}
+
+
+// Import a mesh and store it compressed (see MeshCodec.h), or as a CookedMeshHeader followed by the vertex and index data
+void CookMesh(CookJob& job)
+{
+    MeshData meshData;
+    ImportMesh(job.sourceFile, false, meshData);
+
+    // Decode the compressed mesh again so a mesh that doesn't survive compression fails to cook rather than to load
+    if (job.type == AssetType::CompressedMesh)
+    {
+        size_t rawBytes = static_cast<size_t>(meshData.numVertices) * meshData.vertexSize + static_cast<size_t>(meshData.numIndices) * 4;
+        EncodeMesh(meshData, gMeshCodecSettings, job.blob);
+        MeshData decoded;
+        DecodeMesh(job.blob.data(), job.blob.size(), decoded, 1);
+        MeshCodecErrors errors = CompareDecodedMesh(meshData, decoded);
+        if (!MeshCodecErrorsExpected(errors, gMeshCodecSettings))
+        {
+            throw std::runtime_error("Compressed mesh does not match the import of " + job.sourceFile);
+        }
+
+        char info[128];
+        std::snprintf(info, sizeof(info), "%.2f:1, errors position %.1e, normal %.3f deg, UV %.1e",
+                      static_cast<double>(rawBytes) / job.blob.size(), errors.position, errors.normal, errors.uv);
+        job.info = info;
+        return;
+    }
+
+    CookedMeshHeader header;
+    header.vertexSize  = meshData.vertexSize;
+    header.numVertices = meshData.numVertices;
+    header.numIndices  = meshData.numIndices;
+    header.flags       = meshData.flags;
+
+    size_t vertexBytes = static_cast<size_t>(meshData.numVertices) * meshData.vertexSize;
+    size_t indexBytes  = static_cast<size_t>(meshData.numIndices) * 4;
+    job.blob.resize(sizeof(header) + vertexBytes + indexBytes);
+    std::memcpy(job.blob.data(), &header, sizeof(header));
+    std::memcpy(job.blob.data() + sizeof(header), meshData.vertices, vertexBytes);
+    std::memcpy(job.blob.data() + sizeof(header) + vertexBytes, meshData.indices, indexBytes);
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Textures
+//--------------------------------------------------------------------------------------
+
+// Decode a PNG/JPG (or any other WIC supported format) from memory to 32-bit RGBA, generate mip-maps, block compress it
+// and store it as DDS
+void CookImage(CookJob& job, const std::vector<uint8_t>& source, IWICImagingFactory* factory)
+{
+    ComPtr<IWICStream> stream;
+    ComPtr<IWICBitmapDecoder> decoder;
+    ComPtr<IWICBitmapFrameDecode> frame;
+    ComPtr<IWICFormatConverter> converter;
+    UINT width, height;
+    if (FAILED(factory->CreateStream(&stream)) ||
+        FAILED(stream->InitializeFromMemory(const_cast<BYTE*>(source.data()), static_cast<DWORD>(source.size()))) ||
+        FAILED(factory->CreateDecoderFromStream(stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand, &decoder)) ||
+        FAILED(decoder->GetFrame(0, &frame)) ||
+        FAILED(frame->GetSize(&width, &height)) ||
+        FAILED(factory->CreateFormatConverter(&converter)) ||
+        FAILED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0,
+                                     WICBitmapPaletteTypeCustom)))
+    {
+        throw std::runtime_error("Error decoding image " + job.sourceFile);
+    }
+
+    uint32_t rowPitch = width * 4;
+    std::vector<uint8_t> pixels(static_cast<size_t>(rowPitch) * height);
+    if (FAILED(converter->CopyPixels(nullptr, rowPitch, static_cast<UINT>(pixels.size()), pixels.data())))
+    {
+        throw std::runtime_error("Error decoding image " + job.sourceFile);
+    }
+
+    bool hasAlpha = false;
+    for (size_t alpha = 3; alpha < pixels.size() && !hasAlpha; alpha += 4)  hasAlpha = (pixels[alpha] != 255);
+
+    // Generate the mip chain here rather than leaving it to the GPU at load time, which can't be done for compressed
+    // textures. Single threaded as the cooker already has a thread per asset
+    std::vector<MipLevel> mips;
+    if (gGenerateMips)
+    {
+        MipOptions mipOptions;
+        mipOptions.filter = gMipFilter;
+        mipOptions.sRGB   = true;
+        mipOptions.preserveAlphaCoverage = gPreserveAlphaCoverage && hasAlpha;
+        GenerateMips(pixels.data(), width, height, rowPitch, mipOptions, mips);
+    }
+    else
+    {
+        mips.push_back({ width, height, std::move(pixels) });
+    }
+
+    DDSTexture dds;
+    dds.format    = DXGI_FORMAT_R8G8B8A8_UNORM;
+    dds.width     = width;
+    dds.height    = height;
+    dds.mipLevels = static_cast<uint32_t>(mips.size());
+    for (auto& mip : mips)
+    {
+        dds.subresources.push_back({ mip.pixels.data(), mip.width, mip.height, 1, mip.width * 4, mip.width * 4 * mip.height });
+    }
+
+    // Block compressed textures must be a multiple of 4 pixels in size, other images are left uncompressed
+    std::vector<std::vector<uint8_t>> blocks(mips.size());
+    if (gTextureCompression != TextureCompression::None && width % 4 == 0 && height % 4 == 0)
+    {
+        CompressQuality quality = CompressQuality::Fast;
+        DXGI_FORMAT format = hasAlpha ? DXGI_FORMAT_BC3_UNORM : DXGI_FORMAT_BC1_UNORM;
+        if (gTextureCompression == TextureCompression::Quality)
+        {
+            quality = CompressQuality::Quality;
+            format = DXGI_FORMAT_BC7_UNORM;
+        }
+
+        // PSNR is reported for the top level
+        double psnr = 0;
+        dds.format = format;
+        for (size_t level = 0; level < mips.size(); ++level)
+        {
+            MipLevel& mip = mips[level];
+            uint32_t blockRowPitch, numBlockRows;
+            GetSurfaceInfo(format, mip.width, mip.height, blockRowPitch, numBlockRows);
+            blocks[level].resize(static_cast<size_t>(blockRowPitch) * numBlockRows);
+            CompressTexture(format, mip.pixels.data(), mip.width, mip.height, mip.width * 4, blocks[level].data(), quality, 1,
+                            level == 0 ? &psnr : nullptr);
+            dds.subresources[level] = { blocks[level].data(), mip.width, mip.height, 1, blockRowPitch, blockRowPitch * numBlockRows };
+        }
+
+        char info[64];
+        std::snprintf(info, sizeof(info), "%s, PSNR %.2f dB",
+                      format == DXGI_FORMAT_BC1_UNORM ? "BC1" : format == DXGI_FORMAT_BC3_UNORM ? "BC3" : "BC7", psnr);
+        job.info = info;
+    }
+
+    WriteDDS(job.blob, dds);
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Shader permutations
+//--------------------------------------------------------------------------------------
+
+// Add a job for every pixel shader permutation the app uses (see ShaderPermutation.h). These are compiled from the
+// shader source rather than read from a .cso file
+void AddShaderPermutationJobs(std::vector<CookJob>& jobs)
+{
+    for (auto& permutation : AppShaderPermutations())
+    {
+        CookJob job;
+        job.sourceFile  = permutation.shaderName + ".hlsl";
+        job.assetName   = PackageAssetName(ShaderPermutationAssetName(permutation));
+        job.type        = AssetType::Shader;
+        job.permutation = permutation;
+        jobs.push_back(std::move(job));
+    }
+}
+
+
+// Compile a shader permutation with the same settings as LoadPixelShaderPermutation. The source hash covers the
+// permutation's shader cache key, which covers the source with its include files, the keys and the compile settings
+void CookShaderPermutation(CookJob& job, const AssetPackage& previous)
+{
+    std::string source;
+    if (!LoadShaderSource(job.sourceFile, source))
+    {
+        job.error = "Cannot read " + job.sourceFile + " or a file it includes";
+        return;
+    }
+    uint64_t key = ShaderCacheKey(source, job.permutation.defines, PERMUTATION_ENTRY_POINT, PERMUTATION_TARGET,
+                                  PERMUTATION_COMPILE_FLAGS);
+    uint32_t settings[2] = { COOKER_VERSION, static_cast<uint32_t>(job.type) };
+    job.sourceHash = HashBytes(&key, sizeof(key), HashBytes(settings, sizeof(settings)));
+    job.info = ShaderPermutationName(job.permutation);
+
+    const PackageEntry* old = previous.Find(job.assetName, job.type);
+    if (old != nullptr && old->sourceHash == job.sourceHash)
+    {
+        job.blob.assign(previous.Data(*old), previous.Data(*old) + old->size);
+        job.reused = true;
+        return;
+    }
+
+    std::vector<D3D_SHADER_MACRO> macros;
+    for (auto& define : job.permutation.defines.List())  macros.push_back({ define.first.c_str(), define.second.c_str() });
+    macros.push_back({ nullptr, nullptr });
+
+    ComPtr<ID3DBlob> compiledShader;
+    ComPtr<ID3DBlob> errors;
+    HRESULT hr = D3DCompile(source.data(), source.size(), job.sourceFile.c_str(), macros.data(), nullptr,
+                            PERMUTATION_ENTRY_POINT, PERMUTATION_TARGET, PERMUTATION_COMPILE_FLAGS, 0, &compiledShader, &errors);
+    if (FAILED(hr))
+    {
+        job.error = "Error compiling " + job.info;
+        if (errors)  job.error += "\n" + std::string(static_cast<const char*>(errors->GetBufferPointer()), errors->GetBufferSize());
+        return;
+    }
+    const uint8_t* compiledData = static_cast<const uint8_t*>(compiledShader->GetBufferPointer());
+    job.blob.assign(compiledData, compiledData + compiledShader->GetBufferSize());
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Cooking
+//--------------------------------------------------------------------------------------
+
+// Process one job: hash the source, reuse the previous cooked data if the hash is unchanged, otherwise cook it
+void ProcessJob(CookJob& job, const AssetPackage& previous, IWICImagingFactory* factory)
+{
+    if (!job.permutation.shaderName.empty())
+    {
+        CookShaderPermutation(job, previous);
+        return;
+    }
+
+    std::vector<uint8_t> source;
+    if (!ReadWholeFile(job.sourceFile, source))
+    {
+        job.error = "Cannot read " + job.sourceFile;
+        return;
+    }
+
+    // The hash covers everything the cooked output depends on: cooker version, asset type, settings and the source contents
+    if (job.type == AssetType::Mesh && gCompressMeshes)  job.type = AssetType::CompressedMesh;
+    bool isImage = (job.type == AssetType::Texture && !HasExtension(job.assetName, ".dds"));
+    uint32_t settings[5] = { COOKER_VERSION, static_cast<uint32_t>(job.type), 0, 0, 0 };
+    if (isImage)
+    {
+        settings[2] = static_cast<uint32_t>(gTextureCompression);
+        settings[3] = gGenerateMips ? static_cast<uint32_t>(gMipFilter) + 1 : 0;
+        settings[4] = gPreserveAlphaCoverage ? 1 : 0;
+    }
+    else if (job.type == AssetType::CompressedMesh)
+    {
+        settings[2] = gMeshCodecSettings.positionBits;
+        settings[3] = gMeshCodecSettings.normalBits;
+        settings[4] = gMeshCodecSettings.uvBits;
+    }
+    job.sourceHash = HashBytes(source.data(), source.size(), HashBytes(settings, sizeof(settings)));
+
+    const PackageEntry* old = previous.Find(job.assetName, job.type);
+    if (old != nullptr && old->sourceHash == job.sourceHash)
+    {
+        job.blob.assign(previous.Data(*old), previous.Data(*old) + old->size);
+        job.reused = true;
+        return;
+    }
+
+    try
+    {
+        if (job.type == AssetType::Mesh || job.type == AssetType::CompressedMesh)
+        {
+            CookMesh(job);
+        }
+        else if (isImage)
+        {
+            if (factory == nullptr)  throw std::runtime_error("WIC is not available to decode " + job.sourceFile);
+            CookImage(job, source, factory);
+        }
+        else // DDS textures and compiled shaders are already in their runtime form
+        {
+            job.blob = std::move(source);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        job.error = e.what();
+    }
+}
+
+
+// Write the package file: header, aligned blobs, table of contents sorted by name hash, then the string table
+bool WritePackage(const std::string& fileName, std::vector<CookJob>& jobs)
+{
+    std::vector<PackageEntry> entries(jobs.size());
+    std::string strings;
+
+    auto alignUp = [](uint64_t value) { return (value + PACKAGE_ALIGNMENT - 1) & ~(PACKAGE_ALIGNMENT - 1); };
+
+    uint64_t offset = alignUp(sizeof(PackageHeader));
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        entries[i].nameHash   = HashBytes(jobs[i].assetName.data(), jobs[i].assetName.size());
+        entries[i].sourceHash = jobs[i].sourceHash;
+        entries[i].offset     = offset;
+        entries[i].size       = jobs[i].blob.size();
+        entries[i].type       = static_cast<uint32_t>(jobs[i].type);
+        entries[i].nameOffset = static_cast<uint32_t>(strings.size());
+        strings.append(jobs[i].assetName.c_str(), jobs[i].assetName.size() + 1);
+        offset = alignUp(offset + jobs[i].blob.size());
+    }
+
+    PackageHeader header = {};
+    header.magic             = PACKAGE_MAGIC;
+    header.version           = PACKAGE_VERSION;
+    header.numEntries        = static_cast<uint32_t>(entries.size());
+    header.stringTableSize   = static_cast<uint32_t>(strings.size());
+    header.tocOffset         = offset;
+    header.stringTableOffset = offset + entries.size() * sizeof(PackageEntry);
+
+    std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())  return false;
+
+    const char padding[PACKAGE_ALIGNMENT] = {};
+    auto padTo = [&](uint64_t position) { file.write(padding, static_cast<std::streamsize>(position - file.tellp())); };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        padTo(entries[i].offset);
+        file.write(reinterpret_cast<const char*>(jobs[i].blob.data()), static_cast<std::streamsize>(jobs[i].blob.size()));
+    }
+    padTo(header.tocOffset);
+
+    // Sort the table of contents (not the blobs) so the runtime can binary search it
+    std::sort(entries.begin(), entries.end(), [](const PackageEntry& a, const PackageEntry& b) { return a.nameHash < b.nameHash; });
+    file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(PackageEntry)));
+    file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+    return !file.fail();
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Import benchmark
+//--------------------------------------------------------------------------------------
+
+// Time the import of every model with assimp's default stdio file access, with memory-mapped files and from a
+// registered block of memory (as if the model was in a package). Each import is repeated and the best time kept
+// so the results compare the file access rather than page cache misses or other noise. Also shows the size of each
+// model's staging block, which is all that is left when the import returns, and the process peak memory before and
+// after all the imports (see ProcessPeakMemory, Tests/MeshImportTest.cpp checks the peak of one import). For .glb
+// models the mapped and memory times are the native importer, so the stdio time (assimp) shows what it saves
+int BenchmarkImport(int repeats)
+{
+    std::vector<CookJob> jobs;
+    AddJobs(jobs, "Models", AssetType::Mesh, { ".x", ".glb" });
+    if (jobs.empty())
+    {
+        std::cerr << "No models found - run AssetCooker from the folder containing Models/\n";
+        return 1;
+    }
+
+    std::cout << "Best of " << repeats << " imports (ms) and staging memory (MB):\n";
+    std::cout << "  stdio      mapped     memory     staging    model\n";
+    double totals[3] = { 0, 0, 0 };
+    size_t peakBefore = ProcessPeakMemory();
+    for (auto& job : jobs)
+    {
+        std::vector<uint8_t> source;
+        if (!ReadWholeFile(job.sourceFile, source))
+        {
+            std::cerr << "FAILED  " << job.sourceFile << ": cannot read file\n";
+            continue;
+        }
+
+        // Register the file contents under a different name from the file so the memory path really is used
+        std::string memoryName = "memory/" + job.sourceFile;
+        RegisterMemoryFile(memoryName, source.data(), source.size());
+
+        bool glb = HasExtension(job.assetName, ".glb");
+        double best[3] = { 1e30, 1e30, 1e30 };
+        double stagingMB = 0;
+        try
+        {
+            for (int repeat = 0; repeat < repeats; ++repeat)
+            {
+                for (int method = 0; method < 3; ++method)
+                {
+                    MeshData meshData;
+                    auto importStart = std::chrono::steady_clock::now();
+                    if      (method == 0)  ImportMesh(job.sourceFile, false, meshData, false);
+                    else if (method == 1)  ImportMesh(job.sourceFile, false, meshData, true);
+                    else if (glb)          ImportGlbMesh(source.data(), source.size(), job.sourceFile, false, meshData);
+                    else                   ImportMesh(memoryName,     false, meshData, true);
+                    std::chrono::duration<double, std::milli> importTime = std::chrono::steady_clock::now() - importStart;
+                    best[method] = std::min(best[method], importTime.count());
+                    stagingMB = meshData.staging.Capacity() / (1024.0 * 1024.0);
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "FAILED  " << job.sourceFile << ": " << e.what() << "\n";
+            UnregisterMemoryFile(memoryName);
+            continue;
+        }
+        UnregisterMemoryFile(memoryName);
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "  %-10.3f %-10.3f %-10.3f %-10.2f %s (%zu bytes)\n", best[0], best[1], best[2], stagingMB,
+                      job.assetName.c_str(), source.size());
+        std::cout << line;
+        for (int method = 0; method < 3; ++method)  totals[method] += best[method];
+    }
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "  %-10.3f %-10.3f %-10.3f %-10s total\n", totals[0], totals[1], totals[2], "");
+    std::cout << line;
+    std::snprintf(line, sizeof(line), "Process peak memory %.2f MB before the imports, %.2f MB after\n",
+                  peakBefore / (1024.0 * 1024.0), ProcessPeakMemory() / (1024.0 * 1024.0));
+    std::cout << line;
+    return 0;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Mesh codec benchmark
+//--------------------------------------------------------------------------------------
+
+// Compress every model as it would be cooked, decode it again and check the result is the import with the errors the
+// quantisation allows. Shows the size of the uncompressed cooked mesh (vertices and indices) and of the compressed one,
+// and the time to encode and to decode it on one thread and on all of them (best of repeats, as decoding a small mesh
+// takes microseconds). Returns non-zero if any model fails
+int BenchmarkMeshCodec(int repeats)
+{
+    std::vector<CookJob> jobs;
+    AddJobs(jobs, "Models", AssetType::Mesh, { ".x", ".glb" });
+    if (jobs.empty())
+    {
+        std::cerr << "No models found - run AssetCooker from the folder containing Models/\n";
+        return 1;
+    }
+
+    std::cout << "Best of " << repeats << " decodes, sizes (KB), times (ms) and decoded output (GB/s):\n";
+    std::cout << "  raw        packed     ratio  encode     decode 1   GB/s   decode N   GB/s   position  normal  UV        model\n";
+    size_t totalRaw = 0, totalPacked = 0;
+    int numFailed = 0;
+    for (auto& job : jobs)
+    {
+        MeshData meshData;
+        std::vector<uint8_t> packed;
+        double encodeTime = 0, best[2] = { 1e30, 1e30 };
+        MeshCodecErrors errors;
+        try
+        {
+            ImportMesh(job.sourceFile, false, meshData);
+
+            auto encodeStart = std::chrono::steady_clock::now();
+            EncodeMesh(meshData, gMeshCodecSettings, packed);
+            encodeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - encodeStart).count();
+
+            for (int repeat = 0; repeat < repeats; ++repeat)
+            {
+                for (int threads = 0; threads < 2; ++threads)
+                {
+                    MeshData decoded;
+                    auto decodeStart = std::chrono::steady_clock::now();
+                    DecodeMesh(packed.data(), packed.size(), decoded, threads == 0 ? 1 : 0);
+                    std::chrono::duration<double, std::milli> decodeTime = std::chrono::steady_clock::now() - decodeStart;
+                    best[threads] = std::min(best[threads], decodeTime.count());
+                    if (repeat == 0 && threads == 0)  errors = CompareDecodedMesh(meshData, decoded);
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "FAILED  " << job.sourceFile << ": " << e.what() << "\n";
+            ++numFailed;
+            continue;
+        }
+
+        size_t raw = static_cast<size_t>(meshData.numVertices) * meshData.vertexSize + static_cast<size_t>(meshData.numIndices) * 4;
+        totalRaw    += raw;
+        totalPacked += packed.size();
+        char line[256];
+        std::snprintf(line, sizeof(line), "  %-10.1f %-10.1f %-6.2f %-10.3f %-10.3f %-6.2f %-10.3f %-6.2f %-9.1e %-7.3f %-9.1e %s\n",
+                      raw / 1024.0, packed.size() / 1024.0, static_cast<double>(raw) / packed.size(), encodeTime,
+                      best[0], raw / (best[0] * 1e6), best[1], raw / (best[1] * 1e6), errors.position, errors.normal, errors.uv,
+                      job.assetName.c_str());
+        std::cout << line;
+        if (!MeshCodecErrorsExpected(errors, gMeshCodecSettings))
+        {
+            std::cerr << "FAILED  " << job.sourceFile << ": " << (errors.sameTriangles ? "vertices" : "triangles")
+                      << " do not match after decoding\n";
+            ++numFailed;
+        }
+    }
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "  %-10.1f %-10.1f %-6.2f total\n", totalRaw / 1024.0, totalPacked / 1024.0,
+                  totalPacked > 0 ? static_cast<double>(totalRaw) / totalPacked : 0.0);
+    std::cout << line;
+    return numFailed > 0 ? 1 : 0;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Entry point
+//--------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    std::string outputFile = "Assets.pak";
+    unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    bool force = false;
+    bool verbose = false;
+
+    if (argc > 1 && std::string(argv[1]) == "-benchimport")
+    {
+        return BenchmarkImport(argc > 2 ? std::max(1, std::atoi(argv[2])) : 10);
+    }
+    if (argc > 1 && std::string(argv[1]) == "-benchmeshcodec")
+    {
+        return BenchmarkMeshCodec(argc > 2 ? std::max(1, std::atoi(argv[2])) : 100);
+    }
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        std::string option = argv[arg];
+        if      (option == "-f")  force = true;
+        else if (option == "-v")  verbose = true;
+        else if (option == "-j" && arg + 1 < argc)  numThreads = std::max(1, std::atoi(argv[++arg]));
+        else if (option == "-tc" && arg + 1 < argc && std::string(argv[arg + 1]) == "none")     { gTextureCompression = TextureCompression::None;    ++arg; }
+        else if (option == "-tc" && arg + 1 < argc && std::string(argv[arg + 1]) == "fast")     { gTextureCompression = TextureCompression::Fast;    ++arg; }
+        else if (option == "-tc" && arg + 1 < argc && std::string(argv[arg + 1]) == "quality")  { gTextureCompression = TextureCompression::Quality; ++arg; }
+        else if (option == "-mips" && arg + 1 < argc && std::string(argv[arg + 1]) == "none")     { gGenerateMips = false; ++arg; }
+        else if (option == "-mips" && arg + 1 < argc && std::string(argv[arg + 1]) == "box")      { gMipFilter = MipFilter::Box;     ++arg; }
+        else if (option == "-mips" && arg + 1 < argc && std::string(argv[arg + 1]) == "kaiser")   { gMipFilter = MipFilter::Kaiser;  ++arg; }
+        else if (option == "-mips" && arg + 1 < argc && std::string(argv[arg + 1]) == "lanczos")  { gMipFilter = MipFilter::Lanczos; ++arg; }
+        else if (option == "-ac")  gPreserveAlphaCoverage = true;
+        else if (option == "-mc" && arg + 1 < argc && std::string(argv[arg + 1]) == "none")       { gCompressMeshes = false; ++arg; }
+        else if (option == "-mc" && arg + 1 < argc && std::string(argv[arg + 1]) == "quantised")  { gCompressMeshes = true;  ++arg; }
+        else if (option[0] != '-')  outputFile = option;
+        else
+        {
+            std::cerr << "Usage: AssetCooker [-j threads] [-f] [-v] [-tc none|fast|quality] [-mips none|box|kaiser|lanczos] [-ac] [-mc none|quantised]\n";
+            std::cerr << "                   [output package]\n";
+            std::cerr << "       AssetCooker -benchimport [repeats]\n";
+            std::cerr << "       AssetCooker -benchmeshcodec [repeats]\n";
+            return 1;
+        }
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Gather everything to cook
+    std::vector<CookJob> jobs;
+    AddJobs(jobs, "Models",   AssetType::Mesh,    { ".x", ".glb" });
+    AddJobs(jobs, "Textures", AssetType::Texture, { ".dds", ".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff" });
+    AddJobs(jobs, ".",        AssetType::Shader,  { ".cso" });
+    AddShaderPermutationJobs(jobs);
+    if (jobs.empty())
+    {
+        std::cerr << "No assets found - run AssetCooker from the folder containing Models/, Textures/ and the compiled shaders\n";
+        return 1;
+    }
+
+    // The previous package provides cooked data for unchanged assets
+    AssetPackage previous;
+    if (!force)  previous.Open(outputFile);
+
+    // Cook in parallel. Each worker takes the next unprocessed job until there are none left
+    std::atomic<size_t> nextJob(0);
+    auto worker = [&]()
+    {
+        // WIC is COM based, each thread needs its own COM initialisation and factory
+        HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        ComPtr<IWICImagingFactory> factory;
+        CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+
+        for (size_t job = nextJob++; job < jobs.size(); job = nextJob++)
+        {
+            ProcessJob(jobs[job], previous, factory.Get());
+        }
+
+        factory.Reset();
+        if (SUCCEEDED(comResult))  CoUninitialize();
+    };
+
+    numThreads = std::min(numThreads, static_cast<unsigned int>(jobs.size()));
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < numThreads; ++i)  threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)  thread.join();
+
+    // Report results, nothing is written if any asset failed
+    int numCooked = 0, numReused = 0, numFailed = 0;
+    for (auto& job : jobs)
+    {
+        if (!job.error.empty())
+        {
+            std::cerr << "FAILED  " << job.assetName << ": " << job.error << "\n";
+            ++numFailed;
+            continue;
+        }
+        if (job.reused)  ++numReused;
+        else             ++numCooked;
+        if (verbose)
+        {
+            std::cout << (job.reused ? "reused  " : "cooked  ") << job.assetName << " (" << job.blob.size() << " bytes";
+            if (!job.info.empty())  std::cout << ", " << job.info;
+            std::cout << ")\n";
+        }
+    }
+    if (numFailed > 0)
+    {
+        std::cerr << numFailed << " asset(s) failed to cook, " << outputFile << " not written\n";
+        return 1;
+    }
+
+    // Write to a temporary file then replace the old package, which has to be unmapped first
+    std::string tempFile = outputFile + ".tmp";
+    if (!WritePackage(tempFile, jobs))
+    {
+        std::cerr << "Error writing " << tempFile << "\n";
+        return 1;
+    }
+    previous.Close();
+    std::error_code error;
+    fs::rename(tempFile, outputFile, error);
+    if (error)
+    {
+        std::cerr << "Error replacing " << outputFile << ": " << error.message() << "\n";
+        return 1;
+    }
+
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << outputFile << ": " << jobs.size() << " assets (" << numCooked << " cooked, " << numReused << " unchanged), "
+              << fs::file_size(outputFile, error) / 1024 << " KB, " << seconds << "s on " << numThreads << " thread(s)\n";
+    return 0;
+}
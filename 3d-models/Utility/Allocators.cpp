@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------------------------
+// Arena and pool allocators
+//--------------------------------------------------------------------------------------
+
+#include "Allocators.h"
+
+#include <cstdlib>
+#include <algorithm>
+
+
+LinearAllocator::LinearAllocator(size_t blockSize, MemoryCategory category /*= MemoryCategory::General*/)
+    : mBlockSize(blockSize), mCategory(category)
+{
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    RunDestructors();
+    FreeBlocks();
+}
+
+
+// Allocate uninitialised memory. alignment must be a power of two. Never fails, the heap is used if the current
+// block is full (or throws std::bad_alloc if that fails)
+void* LinearAllocator::Allocate(size_t size, size_t alignment /*= alignof(std::max_align_t)*/)
+{
+    uintptr_t next    = reinterpret_cast<uintptr_t>(mNext);
+    uintptr_t aligned = (next + alignment - 1) & ~(alignment - 1);
+    if (mBlocks == nullptr || aligned + size > reinterpret_cast<uintptr_t>(mEnd))
+    {
+        AddBlock(size + alignment);
+        next    = reinterpret_cast<uintptr_t>(mNext);
+        aligned = (next + alignment - 1) & ~(alignment - 1);
+    }
+
+    mNext = reinterpret_cast<char*>(aligned + size);
+    ++mStats.allocations;
+    mStats.bytesUsed += (aligned - next) + size;
+    mStats.peakBytesUsed = std::max(mStats.peakBytesUsed, mStats.bytesUsed);
+    return reinterpret_cast<void*>(aligned);
+}
+
+
+// Destroy the objects made with New (newest first) and make all the memory available again. Pointers into the arena
+// must not be used after this
+void LinearAllocator::Reset()
+{
+    RunDestructors();
+
+    // If more than one block was needed, replace them with one block big enough for all of them so the same amount of
+    // use won't need the heap again
+    if (mBlocks != nullptr && mBlocks->next != nullptr)
+    {
+        size_t capacity = mStats.capacity;
+        FreeBlocks();
+        AddBlock(capacity);
+    }
+    else if (mBlocks != nullptr)
+    {
+        mNext = reinterpret_cast<char*>(mBlocks + 1);
+    }
+
+    mStats.allocations = 0;
+    mStats.bytesUsed   = 0;
+    ++mStats.resets;
+}
+
+
+void LinearAllocator::AddDestructor(void* object, void (*destroy)(void*))
+{
+    Destructor* destructor = new (Allocate(sizeof(Destructor), alignof(Destructor))) Destructor;
+    destructor->destroy = destroy;
+    destructor->object  = object;
+    destructor->next    = mDestructors;
+    mDestructors = destructor;
+}
+
+
+// Start a new block with space for at least minSize bytes
+void LinearAllocator::AddBlock(size_t minSize)
+{
+    size_t size = std::max(minSize, mBlockSize);
+    Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + size));
+    if (block == nullptr)  throw std::bad_alloc();
+
+    block->next = mBlocks;
+    block->size = size;
+    mBlocks = block;
+    mNext   = reinterpret_cast<char*>(block + 1);
+    mEnd    = mNext + size;
+
+    mStats.capacity += size;
+    ++mStats.heapAllocations;
+    TrackMemory(mCategory, MemoryHeap::CPU, sizeof(Block) + size);
+}
+
+
+void LinearAllocator::FreeBlocks()
+{
+    while (mBlocks != nullptr)
+    {
+        Block* next = mBlocks->next;
+        UntrackMemory(mCategory, MemoryHeap::CPU, sizeof(Block) + mBlocks->size);
+        std::free(mBlocks);
+        mBlocks = next;
+    }
+    mNext = mEnd = nullptr;
+    mStats.capacity = 0;
+}
+
+
+void LinearAllocator::RunDestructors()
+{
+    for (Destructor* destructor = mDestructors; destructor != nullptr; destructor = destructor->next)
+    {
+        destructor->destroy(destructor->object);
+    }
+    mDestructors = nullptr;
+}
@@ -0,0 +1,294 @@
+//--------------------------------------------------------------------------------------
+// Arena and pool allocators
+//--------------------------------------------------------------------------------------
+// LinearAllocator (an arena) takes memory from large blocks by moving a pointer along and
+// frees it all at once with Reset, for load-time data and per-frame lists (gFrameArena).
+// ObjectPool holds a fixed number of objects of one type, created and destroyed in any order
+// without the heap and referred to by handles that detect use after destruction. Both count
+// their allocations so the heap traffic that remains can be seen.
+
+#ifndef _ALLOCATORS_H_INCLUDED_
+#define _ALLOCATORS_H_INCLUDED_
+
+#include "MemoryTracker.h"
+
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------------
+// Linear allocator
+//--------------------------------------------------------------------------------------
+
+// Allocation counts of a LinearAllocator, since it was created unless noted
+struct ArenaStats
+{
+    uint64_t allocations;     // Number of allocations made since the last Reset
+    size_t   bytesUsed;       // Bytes allocated since the last Reset, including padding for alignment
+    size_t   peakBytesUsed;   // Most bytes used between two Resets
+    size_t   capacity;        // Total size of the blocks currently held
+    uint64_t heapAllocations; // Number of blocks taken from the heap
+    uint64_t resets;
+};
+
+
+// Takes memory from large blocks by moving a pointer along, everything is freed at once by Reset. Not thread-safe,
+// each arena must only be used by one thread at a time
+class LinearAllocator
+{
+public:
+    // The first block is allocated when first needed, with at least blockSize bytes. The blocks are counted against
+    // the given memory category (they come from malloc so operator new doesn't see them)
+    explicit LinearAllocator(size_t blockSize, MemoryCategory category = MemoryCategory::General);
+    ~LinearAllocator();
+
+    LinearAllocator(const LinearAllocator&) = delete;
+    LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+
+    // Allocate uninitialised memory. alignment must be a power of two. Never fails, the heap is used if the current
+    // block is full (or throws std::bad_alloc if that fails)
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Create an object in the arena. Its destructor is called by Reset, or when the arena is destroyed. If the
+    // constructor throws the exception is passed on, and the memory is simply unused until Reset
+    template <class T, class... Args>
+    T* New(Args&&... args)
+    {
+        T* object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value)  AddDestructor(object, [](void* p) { static_cast<T*>(p)->~T(); });
+        return object;
+    }
+
+    // Allocate an array of a type that needs no destructor, e.g. numbers, pointers or plain structures. The values are
+    // default-initialised, i.e. left uninitialised for plain types
+    template <class T>
+    T* NewArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Only types without a destructor can be put in an arena array");
+        return new (Allocate(sizeof(T) * count, alignof(T))) T[count];
+    }
+
+
+    // Destroy the objects made with New (newest first) and make all the memory available again. Pointers into the arena
+    // must not be used after this
+    void Reset();
+
+    const ArenaStats& Stats()  { return mStats; }
+
+
+private:
+    struct Block
+    {
+        Block* next; // Older block
+        size_t size; // Bytes of memory following this header
+    };
+
+    struct Destructor
+    {
+        void      (*destroy)(void*);
+        void*       object;
+        Destructor* next; // Object created before this one
+    };
+
+    void AddDestructor(void* object, void (*destroy)(void*));
+    void AddBlock(size_t minSize);
+    void FreeBlocks();
+    void RunDestructors();
+
+    size_t         mBlockSize;
+    MemoryCategory mCategory;
+    Block*         mBlocks      = nullptr; // Newest block, the one being allocated from
+    char*          mNext        = nullptr; // Next free byte in the newest block
+    char*          mEnd         = nullptr; // End of the newest block
+    Destructor*    mDestructors = nullptr; // Newest first, kept in the arena itself
+
+    ArenaStats mStats = {};
+};
+
+
+// Standard library allocator that takes its memory from a LinearAllocator, for temporary containers. Memory is only
+// given back when the arena is reset, so reserve space up front where the size is known rather than letting a vector
+// grow (each growth leaves the old buffer unused in the arena)
+template <class T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator(LinearAllocator& arena) : mArena(&arena)  {}
+    template <class U> ArenaAllocator(const ArenaAllocator<U>& other) : mArena(other.Arena())  {}
+
+    T*   allocate(size_t count)  { return static_cast<T*>(mArena->Allocate(sizeof(T) * count, alignof(T))); }
+    void deallocate(T*, size_t)  {}
+
+    LinearAllocator* Arena() const  { return mArena; }
+
+private:
+    LinearAllocator* mArena;
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)  { return a.Arena() == b.Arena(); }
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)  { return a.Arena() != b.Arena(); }
+
+
+// The arena for temporary data used during a frame, reset at the start of each frame. Main thread only
+extern LinearAllocator gFrameArena;
+
+// A vector whose memory comes from the frame arena, e.g. FrameVector<Model*> list(gFrameArena). Only valid until the
+// end of the frame
+template <class T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+
+
+//--------------------------------------------------------------------------------------
+// Object pool
+//--------------------------------------------------------------------------------------
+
+// Refers to an object in an ObjectPool. A default handle is null and refers to nothing
+template <class T>
+struct PoolHandle
+{
+    uint32_t index      = 0;
+    uint32_t generation = 0; // Generation of the pool slot when the object was created, never 0 for a valid handle
+
+    bool IsNull() const  { return generation == 0; }
+};
+
+
+// Allocation counts of an ObjectPool
+struct PoolStats
+{
+    uint32_t live;           // Objects in the pool now
+    uint32_t peakLive;       // Most objects there have been in the pool at once
+    uint64_t creates;
+    uint64_t failedCreates;  // Creates that failed because the pool was full
+    uint64_t staleLookups;   // Gets with a handle to an object that has been destroyed
+};
+
+
+// Fixed number of objects of one type, created and destroyed in any order without using the heap. The objects never
+// move while they exist. Not thread-safe
+template <class T, uint32_t Capacity>
+class ObjectPool
+{
+public:
+    using Handle = PoolHandle<T>;
+
+    ObjectPool()
+    {
+        for (uint32_t i = 0; i < Capacity; ++i)
+        {
+            mGenerations[i] = 1;
+            mNextFree[i] = i + 1;
+        }
+    }
+
+    ~ObjectPool()  { Clear(); }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+
+    // Create an object, returns a null handle if the pool is full. If the constructor throws the exception is passed on
+    template <class... Args>
+    Handle Create(Args&&... args)
+    {
+        if (mFirstFree == Capacity)
+        {
+            ++mStats.failedCreates;
+            return Handle();
+        }
+
+        uint32_t index = mFirstFree;
+        new (Slot(index)) T(std::forward<Args>(args)...);
+        mFirstFree = mNextFree[index];
+        mNextFree[index] = IN_USE;
+
+        ++mStats.creates;
+        if (++mStats.live > mStats.peakLive)  mStats.peakLive = mStats.live;
+        Handle handle;
+        handle.index = index;
+        handle.generation = mGenerations[index];
+        return handle;
+    }
+
+    // Destroy an object. Does nothing for a null handle or one to an object already destroyed
+    void Destroy(Handle handle)
+    {
+        T* object = Get(handle);
+        if (object == nullptr)  return;
+
+        object->~T();
+        if (++mGenerations[handle.index] == 0)  mGenerations[handle.index] = 1; // Generation 0 is kept for null handles
+        mNextFree[handle.index] = mFirstFree;
+        mFirstFree = handle.index;
+        --mStats.live;
+    }
+
+    // Destroy all the objects
+    void Clear()
+    {
+        for (uint32_t i = 0; i < Capacity; ++i)
+        {
+            if (mNextFree[i] == IN_USE)  Destroy(HandleAt(i));
+        }
+    }
+
+
+    // The object a handle refers to, or nullptr if the handle is null or the object has been destroyed
+    T* Get(Handle handle)
+    {
+        if (handle.IsNull() || handle.index >= Capacity)  return nullptr;
+        if (handle.generation != mGenerations[handle.index] || mNextFree[handle.index] != IN_USE)
+        {
+            ++mStats.staleLookups;
+            return nullptr;
+        }
+        return Slot(handle.index);
+    }
+
+    // Call a function with each object in the pool, in slot order
+    template <class Function>
+    void ForEach(Function function)
+    {
+        for (uint32_t i = 0; i < Capacity; ++i)
+        {
+            if (mNextFree[i] == IN_USE)  function(*Slot(i));
+        }
+    }
+
+    uint32_t         Size()  { return mStats.live; }
+    const PoolStats& Stats() { return mStats; }
+
+
+private:
+    static const uint32_t IN_USE = UINT32_MAX; // In mNextFree for a slot holding an object
+
+    T* Slot(uint32_t index)  { return reinterpret_cast<T*>(mStorage + index * sizeof(T)); }
+
+    Handle HandleAt(uint32_t index)
+    {
+        Handle handle;
+        handle.index = index;
+        handle.generation = mGenerations[index];
+        return handle;
+    }
+
+    alignas(T) unsigned char mStorage[Capacity * sizeof(T)];
+    uint32_t mGenerations[Capacity];
+    uint32_t mNextFree[Capacity]; // Free slots form a list through this, IN_USE for slots that hold an object
+    uint32_t mFirstFree = 0;      // Capacity when the pool is full
+
+    PoolStats mStats = {};
+};
+
+
+#endif //_ALLOCATORS_H_INCLUDED_
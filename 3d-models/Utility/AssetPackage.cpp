@@ -0,0 +1,138 @@
+//--------------------------------------------------------------------------------------
+// Asset package - a single file holding all the cooked assets used by the app
+//--------------------------------------------------------------------------------------
+
+#include "AssetPackage.h"
+
+#include <algorithm>
+#include <cctype>
+
+
+// The package used by the app, see AssetPackage.h
+AssetPackage gAssetPackage;
+
+
+//--------------------------------------------------------------------------------------
+// Helper functions
+//--------------------------------------------------------------------------------------
+
+// 64-bit FNV-1a hash of a block of memory. Pass the result of a previous call as the seed to
+// hash several blocks as if they were one
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed /*= HASH_SEED*/)
+{
+    const uint64_t FNV_PRIME = 1099511628211ull;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+
+// Convert a file name to the name used for the asset in a package - lower case with forward slashes
+// and no leading "./", so "Models\Troll.x", "./models/troll.x" and "Models/troll.x" are all the same asset
+std::string PackageAssetName(const std::string& fileName)
+{
+    std::string name = fileName;
+    for (auto& c : name)
+    {
+        c = (c == '\\') ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    while (name.compare(0, 2, "./") == 0)  name.erase(0, 2);
+    return name;
+}
+
+
+// Hash used to look up an asset name in the table of contents. Normalises the name first as above
+uint64_t HashAssetName(const std::string& fileName)
+{
+    std::string name = PackageAssetName(fileName);
+    return HashBytes(name.data(), name.size());
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Runtime access to a package
+//--------------------------------------------------------------------------------------
+
+// Memory-map a package file and validate its header, returns false on failure
+bool AssetPackage::Open(const std::string& fileName)
+{
+    Close();
+    if (!mFile.Open(fileName))  return false;
+
+    // Check everything the header refers to is inside the file before trusting any of it
+    const uint8_t* data = mFile.Data();
+    size_t size = mFile.Size();
+    if (size < sizeof(PackageHeader))  { Close(); return false; }
+
+    auto header = reinterpret_cast<const PackageHeader*>(data);
+    if (header->magic != PACKAGE_MAGIC || header->version != PACKAGE_VERSION ||
+        header->tocOffset > size || header->numEntries > (size - header->tocOffset) / sizeof(PackageEntry) ||
+        header->stringTableOffset > size || header->stringTableSize > size - header->stringTableOffset)
+    {
+        mFile.Close();
+        return false;
+    }
+
+    auto entries = reinterpret_cast<const PackageEntry*>(data + header->tocOffset);
+    for (uint32_t i = 0; i < header->numEntries; ++i)
+    {
+        if (entries[i].offset > size || entries[i].size > size - entries[i].offset ||
+            entries[i].nameOffset >= header->stringTableSize)
+        {
+            mFile.Close();
+            return false;
+        }
+    }
+
+    // Loading is now just fixing up pointers into the mapping
+    mHeader  = header;
+    mEntries = entries;
+    mStrings = reinterpret_cast<const char*>(data + header->stringTableOffset);
+    return true;
+}
+
+
+// Unmap the package, all pointers into it become invalid
+void AssetPackage::Close()
+{
+    mFile.Close();
+    mHeader  = nullptr;
+    mEntries = nullptr;
+    mStrings = nullptr;
+}
+
+
+// Find an asset by its original file name (e.g. "Models/Troll.x"). Returns nullptr if the
+// asset is not in the package or no package is open
+const PackageEntry* AssetPackage::Find(const std::string& fileName) const
+{
+    if (!IsOpen())  return nullptr;
+
+    std::string name = PackageAssetName(fileName);
+    uint64_t nameHash = HashBytes(name.data(), name.size());
+
+    // Table of contents is sorted by name hash. Compare names too in the unlikely event of a hash collision
+    const PackageEntry* end = mEntries + mHeader->numEntries;
+    const PackageEntry* entry = std::lower_bound(mEntries, end, nameHash,
+                                                 [](const PackageEntry& e, uint64_t hash) { return e.nameHash < hash; });
+    for (; entry != end && entry->nameHash == nameHash; ++entry)
+    {
+        if (name == Name(*entry))  return entry;
+    }
+    return nullptr;
+}
+
+
+// Same as above but also requires the asset to be of the given type
+const PackageEntry* AssetPackage::Find(const std::string& fileName, AssetType type) const
+{
+    const PackageEntry* entry = Find(fileName);
+    return (entry != nullptr && entry->type == static_cast<uint32_t>(type)) ? entry : nullptr;
+}
@@ -0,0 +1,136 @@
+//--------------------------------------------------------------------------------------
+// Asset package - a single file holding all the cooked assets used by the app
+//--------------------------------------------------------------------------------------
+// Packages are written offline by the AssetCooker tool (Tools/AssetCooker.cpp). At runtime
+// the package is memory-mapped and assets are used directly from the mapping: looking up
+// an asset is a binary search in the table of contents and its data is just a pointer
+// into the file. No parsing and only one file open for the whole app.
+//
+// File layout (all offsets are from the start of the file):
+//   PackageHeader
+//   Asset data blobs, each aligned to PACKAGE_ALIGNMENT
+//   Table of contents - numEntries PackageEntry structures, sorted by nameHash
+//   String table      - null-terminated asset names referenced by PackageEntry::nameOffset
+
+#ifndef _ASSET_PACKAGE_H_INCLUDED_
+#define _ASSET_PACKAGE_H_INCLUDED_
+
+#include "MappedFile.h"
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+
+//--------------------------------------------------------------------------------------
+// Package file format
+//--------------------------------------------------------------------------------------
+
+const uint32_t PACKAGE_MAGIC     = 0x4B415033; // "3PAK" when viewed as bytes on little-endian machines
+const uint32_t PACKAGE_VERSION   = 1;
+const uint64_t PACKAGE_ALIGNMENT = 64;         // Blobs are aligned to a cache line, which suits SIMD loads and GPU uploads
+
+// What a blob in the package contains
+enum class AssetType : uint32_t
+{
+    Mesh           = 1, // CookedMeshHeader followed by vertex data then 32-bit index data
+    Texture        = 2, // A complete DDS file, ready for texture creation
+    Shader         = 3, // Compiled shader bytecode (contents of a .cso file)
+    CompressedMesh = 4, // Mesh compressed by EncodeMesh, starting with a CompressedMeshHeader (see MeshCodec.h)
+};
+
+struct PackageHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numEntries;
+    uint32_t stringTableSize;
+    uint64_t tocOffset;
+    uint64_t stringTableOffset;
+};
+
+struct PackageEntry
+{
+    uint64_t nameHash;   // HashAssetName of the asset name, the table of contents is sorted on this
+    uint64_t sourceHash; // Hash of the source file and cook settings - lets the cooker skip unchanged assets
+    uint64_t offset;     // Position of the blob in the file
+    uint64_t size;       // Size of the blob in bytes
+    uint32_t type;       // AssetType
+    uint32_t nameOffset; // Asset name position in the string table
+};
+
+// Header at the start of a cooked mesh blob. Vertex data follows immediately, in the layout
+// described by flags (see MeshImport.h), then numIndices 32-bit indices
+struct CookedMeshHeader
+{
+    uint32_t vertexSize;
+    uint32_t numVertices;
+    uint32_t numIndices;
+    uint32_t flags;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Helper functions
+//--------------------------------------------------------------------------------------
+
+// 64-bit FNV-1a hash of a block of memory. Pass the result of a previous call as the seed to
+// hash several blocks as if they were one
+const uint64_t HASH_SEED = 14695981039346656037ull;
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = HASH_SEED);
+
+// Convert a file name to the name used for the asset in a package - lower case with forward slashes
+// and no leading "./", so "Models\Troll.x", "./models/troll.x" and "Models/troll.x" are all the same asset
+std::string PackageAssetName(const std::string& fileName);
+
+// Hash used to look up an asset name in the table of contents. Normalises the name first as above
+uint64_t HashAssetName(const std::string& fileName);
+
+
+//--------------------------------------------------------------------------------------
+// Runtime access to a package
+//--------------------------------------------------------------------------------------
+
+class AssetPackage
+{
+public:
+    // Memory-map a package file and validate its header, returns false on failure
+    bool Open(const std::string& fileName);
+
+    // Unmap the package, all pointers into it become invalid
+    void Close();
+
+    bool IsOpen() const  { return mHeader != nullptr; }
+
+    // Find an asset by its original file name (e.g. "Models/Troll.x"). Returns nullptr if the
+    // asset is not in the package or no package is open
+    const PackageEntry* Find(const std::string& fileName) const;
+
+    // Same as above but also requires the asset to be of the given type
+    const PackageEntry* Find(const std::string& fileName, AssetType type) const;
+
+    // Pointer to the data for an entry, valid until the package is closed
+    const uint8_t* Data(const PackageEntry& entry) const  { return mFile.Data() + entry.offset; }
+
+    // Normalised name of an entry
+    const char* Name(const PackageEntry& entry) const  { return mStrings + entry.nameOffset; }
+
+    // Access to the whole table of contents
+    uint32_t            NumEntries() const  { return mHeader ? mHeader->numEntries : 0; }
+    const PackageEntry* Entries()    const  { return mEntries; }
+
+
+private:
+    MappedFile           mFile;
+    const PackageHeader* mHeader  = nullptr;
+    const PackageEntry*  mEntries = nullptr;
+    const char*          mStrings = nullptr;
+};
+
+
+// The package used by the app. Loaders check it before falling back to loose files, so the app
+// still runs when no package has been cooked. Opened in InitGeometry
+extern AssetPackage gAssetPackage;
+
+
+#endif //_ASSET_PACKAGE_H_INCLUDED_
@@ -0,0 +1,391 @@
+//--------------------------------------------------------------------------------------
+// DDS texture file parsing and writing
+//--------------------------------------------------------------------------------------
+
+#include "DDSFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+//--------------------------------------------------------------------------------------
+// Format helpers
+//--------------------------------------------------------------------------------------
+
+// Bits per pixel of the given format, 0 if not supported. Block compressed formats give their average (4 or 8)
+uint32_t BitsPerPixel(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        return 128;
+
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R32G32_FLOAT:
+        return 64;
+
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_R16G16_FLOAT:
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R32_TYPELESS: // Shadow maps
+    case DXGI_FORMAT_D32_FLOAT:
+    case DXGI_FORMAT_R32_FLOAT:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        return 32;
+
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_B5G6R5_UNORM:
+    case DXGI_FORMAT_B5G5R5A1_UNORM:
+        return 16;
+
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_A8_UNORM:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return 8;
+
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        return 4;
+
+    default:
+        return 0;
+    }
+}
+
+
+// True for the BC1-BC7 formats, which store 4x4 pixel blocks of 8 or 16 bytes
+bool IsBlockCompressed(DXGI_FORMAT format)
+{
+    return (format >= DXGI_FORMAT_BC1_UNORM && format <= DXGI_FORMAT_BC5_SNORM) ||
+           (format >= DXGI_FORMAT_BC6H_UF16 && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+
+// Size of one mip surface of the given format and dimensions: the bytes in each row and the number of rows.
+// For block compressed formats these are rows of 4x4 blocks. Returns false if the format is not supported
+bool GetSurfaceInfo(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t& rowPitch, uint32_t& numRows)
+{
+    uint32_t bitsPerPixel = BitsPerPixel(format);
+    if (bitsPerPixel == 0)  return false;
+
+    if (IsBlockCompressed(format))
+    {
+        uint32_t blockBytes = bitsPerPixel * 2; // 16 pixels per block
+        rowPitch = std::max(1u, (width  + 3) / 4) * blockBytes;
+        numRows  = std::max(1u, (height + 3) / 4);
+    }
+    else
+    {
+        rowPitch = (width * bitsPerPixel + 7) / 8;
+        numRows  = height;
+    }
+    return true;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Parsing
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+    // The largest Direct3D 11 texture in any direction
+    const uint32_t MAX_DDS_DIMENSION = 16384;
+
+    uint32_t MakeFourCC(char a, char b, char c, char d)
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    bool HasMasks(const DDSPixelFormat& ddspf, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return ddspf.rBitMask == r && ddspf.gBitMask == g && ddspf.bBitMask == b && ddspf.aBitMask == a;
+    }
+
+    // Format of a file without a DX10 header, identified from its legacy pixel format description
+    DXGI_FORMAT GetLegacyFormat(const DDSPixelFormat& ddspf)
+    {
+        if (ddspf.flags & DDPF_FOURCC)
+        {
+            uint32_t fourCC = ddspf.fourCC;
+            if (fourCC == MakeFourCC('D','X','T','1'))  return DXGI_FORMAT_BC1_UNORM;
+            if (fourCC == MakeFourCC('D','X','T','2') || fourCC == MakeFourCC('D','X','T','3'))  return DXGI_FORMAT_BC2_UNORM;
+            if (fourCC == MakeFourCC('D','X','T','4') || fourCC == MakeFourCC('D','X','T','5'))  return DXGI_FORMAT_BC3_UNORM;
+            if (fourCC == MakeFourCC('A','T','I','1') || fourCC == MakeFourCC('B','C','4','U'))  return DXGI_FORMAT_BC4_UNORM;
+            if (fourCC == MakeFourCC('B','C','4','S'))  return DXGI_FORMAT_BC4_SNORM;
+            if (fourCC == MakeFourCC('A','T','I','2') || fourCC == MakeFourCC('B','C','5','U'))  return DXGI_FORMAT_BC5_UNORM;
+            if (fourCC == MakeFourCC('B','C','5','S'))  return DXGI_FORMAT_BC5_SNORM;
+
+            // Old D3DFORMAT values stored as a FourCC
+            switch (fourCC)
+            {
+            case 36:  return DXGI_FORMAT_R16G16B16A16_UNORM;
+            case 111: return DXGI_FORMAT_R16_FLOAT;
+            case 112: return DXGI_FORMAT_R16G16_FLOAT;
+            case 113: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+            case 114: return DXGI_FORMAT_R32_FLOAT;
+            case 115: return DXGI_FORMAT_R32G32_FLOAT;
+            case 116: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+            default:  return DXGI_FORMAT_UNKNOWN;
+            }
+        }
+
+        if (ddspf.flags & DDPF_RGB)
+        {
+            if (ddspf.rgbBitCount == 32)
+            {
+                if (HasMasks(ddspf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))  return DXGI_FORMAT_R8G8B8A8_UNORM;
+                if (HasMasks(ddspf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))  return DXGI_FORMAT_B8G8R8A8_UNORM;
+                if (HasMasks(ddspf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000))  return DXGI_FORMAT_B8G8R8X8_UNORM;
+                if (HasMasks(ddspf, 0x000003ff, 0x000ffc00, 0x3ff00000, 0xc0000000))  return DXGI_FORMAT_R10G10B10A2_UNORM;
+                if (HasMasks(ddspf, 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))  return DXGI_FORMAT_R16G16_UNORM;
+                if (HasMasks(ddspf, 0xffffffff, 0x00000000, 0x00000000, 0x00000000))  return DXGI_FORMAT_R32_FLOAT;
+            }
+            else if (ddspf.rgbBitCount == 16)
+            {
+                if (HasMasks(ddspf, 0x7c00, 0x03e0, 0x001f, 0x8000))  return DXGI_FORMAT_B5G5R5A1_UNORM;
+                if (HasMasks(ddspf, 0xf800, 0x07e0, 0x001f, 0x0000))  return DXGI_FORMAT_B5G6R5_UNORM;
+            }
+            return DXGI_FORMAT_UNKNOWN; // 24-bit and other unusual layouts aren't supported by Direct3D 11
+        }
+
+        if (ddspf.flags & DDPF_LUMINANCE)
+        {
+            if (ddspf.rgbBitCount == 8  && HasMasks(ddspf, 0x00ff, 0, 0, 0x0000))  return DXGI_FORMAT_R8_UNORM;
+            if (ddspf.rgbBitCount == 16 && HasMasks(ddspf, 0xffff, 0, 0, 0x0000))  return DXGI_FORMAT_R16_UNORM;
+            if (ddspf.rgbBitCount == 16 && HasMasks(ddspf, 0x00ff, 0, 0, 0xff00))  return DXGI_FORMAT_R8G8_UNORM;
+            return DXGI_FORMAT_UNKNOWN;
+        }
+
+        if ((ddspf.flags & DDPF_ALPHA) && ddspf.rgbBitCount == 8)  return DXGI_FORMAT_A8_UNORM;
+
+        return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+
+// Read the DDS file held in the given memory. Fills in the texture description and subresource table, with subresource
+// data pointing into the memory, so the memory must stay valid while the table is in use. Returns false if the file is
+// not a valid DDS file or uses a pixel format that isn't supported
+bool ParseDDS(const uint8_t* data, size_t size, DDSTexture& texture)
+{
+    texture = DDSTexture();
+
+    // Headers (memcpy as the data may have any alignment)
+    uint32_t magic;
+    DDSHeader header;
+    if (size < sizeof(magic) + sizeof(header))  return false;
+    std::memcpy(&magic, data, sizeof(magic));
+    std::memcpy(&header, data + sizeof(magic), sizeof(header));
+    if (magic != DDS_MAGIC || header.size != sizeof(DDSHeader) || header.ddspf.size != sizeof(DDSPixelFormat))  return false;
+    size_t offset = sizeof(magic) + sizeof(header);
+
+    texture.width     = header.width;
+    texture.height    = header.height;
+    texture.mipLevels = std::max(1u, header.mipMapCount);
+
+    if ((header.ddspf.flags & DDPF_FOURCC) && header.ddspf.fourCC == DDS_FOURCC_DX10)
+    {
+        DDSHeaderDX10 dx10;
+        if (size < offset + sizeof(dx10))  return false;
+        std::memcpy(&dx10, data + offset, sizeof(dx10));
+        offset += sizeof(dx10);
+
+        texture.format    = static_cast<DXGI_FORMAT>(dx10.dxgiFormat);
+        texture.dimension = dx10.resourceDimension;
+        texture.arraySize = dx10.arraySize;
+        if (texture.arraySize == 0)  return false;
+
+        switch (texture.dimension)
+        {
+        case DDS_DIMENSION_TEXTURE1D:
+            texture.height = 1; // Some writers put garbage in the unused dimensions
+            break;
+
+        case DDS_DIMENSION_TEXTURE2D:
+            if (dx10.miscFlag & DDS_MISC_TEXTURECUBE)
+            {
+                if (texture.arraySize > UINT32_MAX / 6)  return false;
+                texture.cubeMap = true;
+                texture.arraySize *= 6;
+            }
+            break;
+
+        case DDS_DIMENSION_TEXTURE3D:
+            if (!(header.flags & DDSD_DEPTH) || texture.arraySize != 1)  return false;
+            texture.depth = header.depth;
+            break;
+
+        default:
+            return false;
+        }
+    }
+    else
+    {
+        texture.format = GetLegacyFormat(header.ddspf);
+
+        if (header.flags & DDSD_DEPTH)
+        {
+            texture.dimension = DDS_DIMENSION_TEXTURE3D;
+            texture.depth = header.depth;
+        }
+        else if (header.caps2 & DDSCAPS2_CUBEMAP)
+        {
+            // Partial cube maps can't be created in Direct3D 11
+            if ((header.caps2 & DDSCAPS2_CUBEMAP_FACES) != DDSCAPS2_CUBEMAP_FACES)  return false;
+            texture.cubeMap = true;
+            texture.arraySize = 6;
+        }
+    }
+
+    if (BitsPerPixel(texture.format) == 0)  return false;
+    if (texture.width == 0 || texture.height == 0 || texture.depth == 0)  return false;
+
+    // No Direct3D 11 texture is larger than this in any direction, which also keeps the pitches inside 32 bits
+    if (texture.width > MAX_DDS_DIMENSION || texture.height > MAX_DDS_DIMENSION || texture.depth > MAX_DDS_DIMENSION)  return false;
+
+    // A full mip chain ends at 1x1x1, more levels than that means a corrupt header
+    uint32_t largest = std::max(texture.width, std::max(texture.height, texture.depth));
+    uint32_t maxMipLevels = 1;
+    while (largest > 1)  { largest >>= 1; ++maxMipLevels; }
+    if (texture.mipLevels > maxMipLevels)  return false;
+
+    // Check every subresource lies within the file before building the table, so a corrupt array size can't make the
+    // table huge. Each array slice holds the same mip chain
+    uint64_t arraySliceBytes = 0;
+    {
+        uint32_t width  = texture.width;
+        uint32_t height = texture.height;
+        uint32_t depth  = texture.depth;
+        for (uint32_t mip = 0; mip < texture.mipLevels; ++mip)
+        {
+            uint32_t rowPitch, numRows;
+            GetSurfaceInfo(texture.format, width, height, rowPitch, numRows);
+            uint64_t slicePitch = static_cast<uint64_t>(rowPitch) * numRows;
+            if (slicePitch > UINT32_MAX)  return false;
+            arraySliceBytes += slicePitch * depth;
+            width  = std::max(1u, width  / 2);
+            height = std::max(1u, height / 2);
+            depth  = std::max(1u, depth  / 2);
+        }
+    }
+    if (arraySliceBytes > size - offset || texture.arraySize > (size - offset) / arraySliceBytes)  return false;
+
+
+    // Build the subresource table
+    texture.subresources.resize(static_cast<size_t>(texture.mipLevels) * texture.arraySize);
+    DDSSubresource* subresource = texture.subresources.data();
+    for (uint32_t arraySlice = 0; arraySlice < texture.arraySize; ++arraySlice)
+    {
+        uint32_t width  = texture.width;
+        uint32_t height = texture.height;
+        uint32_t depth  = texture.depth;
+        for (uint32_t mip = 0; mip < texture.mipLevels; ++mip)
+        {
+            uint32_t rowPitch, numRows;
+            GetSurfaceInfo(texture.format, width, height, rowPitch, numRows);
+            uint32_t slicePitch = rowPitch * numRows;
+
+            subresource->data       = data + offset;
+            subresource->width      = width;
+            subresource->height     = height;
+            subresource->depth      = depth;
+            subresource->rowPitch   = rowPitch;
+            subresource->slicePitch = slicePitch;
+            ++subresource;
+
+            offset += static_cast<size_t>(slicePitch) * depth;
+            width  = std::max(1u, width  / 2);
+            height = std::max(1u, height / 2);
+            depth  = std::max(1u, depth  / 2);
+        }
+    }
+
+    return true;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Writing
+//--------------------------------------------------------------------------------------
+
+// Write a DDS file to memory, always with a DX10 extension header. Takes the texture description and the data from its
+// subresource table, which must be complete and use the pitches given by GetSurfaceInfo
+void WriteDDS(std::vector<uint8_t>& dds, const DDSTexture& texture)
+{
+    DDSHeader header = {};
+    header.size        = sizeof(DDSHeader);
+    header.flags       = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT;
+    header.height      = texture.height;
+    header.width       = texture.width;
+    header.depth       = texture.depth;
+    header.mipMapCount = texture.mipLevels;
+    header.ddspf.size   = sizeof(DDSPixelFormat);
+    header.ddspf.flags  = DDPF_FOURCC;
+    header.ddspf.fourCC = DDS_FOURCC_DX10;
+    header.caps         = DDSCAPS_TEXTURE;
+
+    if (!texture.subresources.empty())
+    {
+        header.flags |= DDSD_PITCH;
+        header.pitchOrLinearSize = texture.subresources[0].rowPitch;
+    }
+    if (texture.mipLevels > 1)
+    {
+        header.flags |= DDSD_MIPMAPCOUNT;
+        header.caps  |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+    }
+    if (texture.dimension == DDS_DIMENSION_TEXTURE3D)
+    {
+        header.flags |= DDSD_DEPTH;
+        header.caps  |= DDSCAPS_COMPLEX;
+        header.caps2 |= DDSCAPS2_VOLUME;
+    }
+    if (texture.cubeMap)
+    {
+        header.caps  |= DDSCAPS_COMPLEX;
+        header.caps2 |= DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_FACES;
+    }
+
+    DDSHeaderDX10 dx10 = {};
+    dx10.dxgiFormat        = texture.format;
+    dx10.resourceDimension = texture.dimension;
+    dx10.miscFlag          = texture.cubeMap ? DDS_MISC_TEXTURECUBE : 0;
+    dx10.arraySize         = texture.cubeMap ? texture.arraySize / 6 : texture.arraySize;
+
+    size_t dataBytes = 0;
+    for (auto& subresource : texture.subresources)  dataBytes += static_cast<size_t>(subresource.slicePitch) * subresource.depth;
+
+    dds.resize(sizeof(DDS_MAGIC) + sizeof(header) + sizeof(dx10) + dataBytes);
+    uint8_t* out = dds.data();
+    std::memcpy(out, &DDS_MAGIC, sizeof(DDS_MAGIC));  out += sizeof(DDS_MAGIC);
+    std::memcpy(out, &header, sizeof(header));        out += sizeof(header);
+    std::memcpy(out, &dx10, sizeof(dx10));            out += sizeof(dx10);
+    for (auto& subresource : texture.subresources)
+    {
+        size_t bytes = static_cast<size_t>(subresource.slicePitch) * subresource.depth;
+        std::memcpy(out, subresource.data, bytes);
+        out += bytes;
+    }
+}
@@ -0,0 +1,204 @@
+//--------------------------------------------------------------------------------------
+// DDS texture file parsing and writing
+//--------------------------------------------------------------------------------------
+// ParseDDS reads the headers of a DDS file (including DX10 headers, block compression, mips,
+// arrays, cube maps and volumes) and builds a table of every subresource pointing straight into
+// the given memory, so textures are created from a memory-mapped file with no copy.
+
+#ifndef _DDS_FILE_H_INCLUDED_
+#define _DDS_FILE_H_INCLUDED_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <dxgiformat.h>
+#else
+// The DXGI formats that DDS files in this app may use, with the same values as in dxgiformat.h
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN             = 0,
+    DXGI_FORMAT_R32G32B32A32_FLOAT  = 2,
+    DXGI_FORMAT_R16G16B16A16_FLOAT  = 10,
+    DXGI_FORMAT_R16G16B16A16_UNORM  = 11,
+    DXGI_FORMAT_R32G32_FLOAT        = 16,
+    DXGI_FORMAT_R10G10B10A2_UNORM   = 24,
+    DXGI_FORMAT_R8G8B8A8_UNORM      = 28,
+    DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+    DXGI_FORMAT_R16G16_FLOAT        = 34,
+    DXGI_FORMAT_R16G16_UNORM        = 35,
+    DXGI_FORMAT_R32_TYPELESS        = 39,
+    DXGI_FORMAT_D32_FLOAT           = 40,
+    DXGI_FORMAT_R32_FLOAT           = 41,
+    DXGI_FORMAT_R8G8_UNORM          = 49,
+    DXGI_FORMAT_R16_FLOAT           = 54,
+    DXGI_FORMAT_R16_UNORM           = 56,
+    DXGI_FORMAT_R8_UNORM            = 61,
+    DXGI_FORMAT_A8_UNORM            = 65,
+    DXGI_FORMAT_BC1_UNORM           = 71,
+    DXGI_FORMAT_BC1_UNORM_SRGB      = 72,
+    DXGI_FORMAT_BC2_UNORM           = 74,
+    DXGI_FORMAT_BC2_UNORM_SRGB      = 75,
+    DXGI_FORMAT_BC3_UNORM           = 77,
+    DXGI_FORMAT_BC3_UNORM_SRGB      = 78,
+    DXGI_FORMAT_BC4_UNORM           = 80,
+    DXGI_FORMAT_BC4_SNORM           = 81,
+    DXGI_FORMAT_BC5_UNORM           = 83,
+    DXGI_FORMAT_BC5_SNORM           = 84,
+    DXGI_FORMAT_B5G6R5_UNORM        = 85,
+    DXGI_FORMAT_B5G5R5A1_UNORM      = 86,
+    DXGI_FORMAT_B8G8R8A8_UNORM      = 87,
+    DXGI_FORMAT_B8G8R8X8_UNORM      = 88,
+    DXGI_FORMAT_B8G8R8A8_UNORM_SRGB = 91,
+    DXGI_FORMAT_B8G8R8X8_UNORM_SRGB = 93,
+    DXGI_FORMAT_BC6H_UF16           = 95,
+    DXGI_FORMAT_BC6H_SF16           = 96,
+    DXGI_FORMAT_BC7_UNORM           = 98,
+    DXGI_FORMAT_BC7_UNORM_SRGB      = 99,
+};
+#endif
+
+
+//--------------------------------------------------------------------------------------
+// DDS file format
+//--------------------------------------------------------------------------------------
+// A DDS file is DDS_MAGIC, DDSHeader, an optional DDSHeaderDX10 (if ddspf.fourCC is DDS_FOURCC_DX10),
+// then the data for each subresource in turn: every mip of the first array slice, then every mip of
+// the next and so on. Each mip is stored as its depth slices one after another with no padding
+
+const uint32_t DDS_MAGIC        = 0x20534444; // "DDS "
+const uint32_t DDS_FOURCC_DX10  = 0x30315844; // "DX10"
+
+// DDSHeader::flags
+const uint32_t DDSD_CAPS        = 0x1;
+const uint32_t DDSD_HEIGHT      = 0x2;
+const uint32_t DDSD_WIDTH       = 0x4;
+const uint32_t DDSD_PITCH       = 0x8;
+const uint32_t DDSD_PIXELFORMAT = 0x1000;
+const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+const uint32_t DDSD_DEPTH       = 0x800000;
+
+// DDSPixelFormat::flags
+const uint32_t DDPF_ALPHA       = 0x2;
+const uint32_t DDPF_FOURCC      = 0x4;
+const uint32_t DDPF_RGB         = 0x40;
+const uint32_t DDPF_LUMINANCE   = 0x20000;
+
+// DDSHeader::caps and caps2
+const uint32_t DDSCAPS_COMPLEX         = 0x8;
+const uint32_t DDSCAPS_TEXTURE         = 0x1000;
+const uint32_t DDSCAPS_MIPMAP          = 0x400000;
+const uint32_t DDSCAPS2_CUBEMAP        = 0x200;
+const uint32_t DDSCAPS2_CUBEMAP_FACES  = 0xFC00;
+const uint32_t DDSCAPS2_VOLUME         = 0x200000;
+
+// DDSHeaderDX10::resourceDimension, same values as D3D11_RESOURCE_DIMENSION
+const uint32_t DDS_DIMENSION_TEXTURE1D = 2;
+const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+const uint32_t DDS_DIMENSION_TEXTURE3D = 4;
+
+// DDSHeaderDX10::miscFlag
+const uint32_t DDS_MISC_TEXTURECUBE    = 0x4;
+
+
+#pragma pack(push, 1)
+struct DDSPixelFormat
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct DDSHeader
+{
+    uint32_t       size;
+    uint32_t       flags;
+    uint32_t       height;
+    uint32_t       width;
+    uint32_t       pitchOrLinearSize;
+    uint32_t       depth;
+    uint32_t       mipMapCount;
+    uint32_t       reserved1[11];
+    DDSPixelFormat ddspf;
+    uint32_t       caps;
+    uint32_t       caps2;
+    uint32_t       caps3;
+    uint32_t       caps4;
+    uint32_t       reserved2;
+};
+
+struct DDSHeaderDX10
+{
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+#pragma pack(pop)
+
+
+
+//--------------------------------------------------------------------------------------
+// Parsed textures
+//--------------------------------------------------------------------------------------
+
+// One mip level of one array slice. Matches the contents of a D3D11_SUBRESOURCE_DATA plus the dimensions
+struct DDSSubresource
+{
+    const uint8_t* data;       // Points into the memory given to ParseDDS
+    uint32_t       width;
+    uint32_t       height;
+    uint32_t       depth;
+    uint32_t       rowPitch;   // Bytes from one row of pixels (or of 4x4 blocks for block compressed formats) to the next
+    uint32_t       slicePitch; // Bytes from one depth slice to the next
+};
+
+struct DDSTexture
+{
+    DXGI_FORMAT format    = DXGI_FORMAT_UNKNOWN;
+    uint32_t    dimension = DDS_DIMENSION_TEXTURE2D;
+    uint32_t    width     = 0;
+    uint32_t    height    = 1;
+    uint32_t    depth     = 1;
+    uint32_t    mipLevels = 1;
+    uint32_t    arraySize = 1; // Number of 2D textures, so six times the number of cube maps
+    bool        cubeMap   = false;
+
+    // Table of mipLevels * arraySize subresources in Direct3D subresource order (mip + arraySlice * mipLevels)
+    std::vector<DDSSubresource> subresources;
+};
+
+
+// Read the DDS file held in the given memory. Fills in the texture description and subresource table, with subresource
+// data pointing into the memory, so the memory must stay valid while the table is in use. Returns false if the file is
+// not a valid DDS file or uses a pixel format that isn't supported
+bool ParseDDS(const uint8_t* data, size_t size, DDSTexture& texture);
+
+// Write a DDS file to memory, always with a DX10 extension header. Takes the texture description and the data from its
+// subresource table, which must be complete and use the pitches given by GetSurfaceInfo
+void WriteDDS(std::vector<uint8_t>& dds, const DDSTexture& texture);
+
+
+//--------------------------------------------------------------------------------------
+// Format helpers
+//--------------------------------------------------------------------------------------
+
+// Bits per pixel of the given format, 0 if not supported. Block compressed formats give their average (4 or 8)
+uint32_t BitsPerPixel(DXGI_FORMAT format);
+
+// True for the BC1-BC7 formats, which store 4x4 pixel blocks of 8 or 16 bytes
+bool IsBlockCompressed(DXGI_FORMAT format);
+
+// Size of one mip surface of the given format and dimensions: the bytes in each row and the number of rows.
+// For block compressed formats these are rows of 4x4 blocks. Returns false if the format is not supported
+bool GetSurfaceInfo(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t& rowPitch, uint32_t& numRows);
+
+
+#endif //_DDS_FILE_H_INCLUDED_
@@ -0,0 +1,46 @@
+//--------------------------------------------------------------------------------------
+// Fixed timestep simulation
+//--------------------------------------------------------------------------------------
+
+#include "FixedTimestep.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Steps are timestep seconds long, at most maxSteps steps are run in a frame
+FixedTimestep::FixedTimestep(float timestep, uint32_t maxSteps)
+    : mTimestep(timestep), mMaxSteps(std::max(1u, maxSteps))
+{
+}
+
+
+// Forget any time not yet simulated and dropped
+void FixedTimestep::Reset()
+{
+    mAccumulator = 0;
+    mDroppedTime = 0;
+}
+
+
+// Add the time passed since the last frame (seconds) and return the number of steps to run for this frame
+uint32_t FixedTimestep::Advance(float frameTime)
+{
+    mAccumulator += std::max(0.0f, frameTime);
+
+    uint32_t steps = 0;
+    while (mAccumulator >= mTimestep && steps < mMaxSteps)
+    {
+        mAccumulator -= mTimestep;
+        ++steps;
+    }
+
+    // Drop whole steps that didn't fit, keeping the fraction of a step so the interpolation carries on smoothly
+    if (mAccumulator >= mTimestep)
+    {
+        float remainder = std::fmod(mAccumulator, mTimestep);
+        mDroppedTime += mAccumulator - remainder;
+        mAccumulator = remainder;
+    }
+    return steps;
+}
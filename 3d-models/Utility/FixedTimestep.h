@@ -0,0 +1,47 @@
+//--------------------------------------------------------------------------------------
+// Fixed timestep simulation
+//--------------------------------------------------------------------------------------
+// The scene is simulated in steps of a fixed length rather than once per frame, so it doesn't
+// depend on the frame rate. Real time is added to an accumulator each frame and as many steps
+// run as fit, up to a limit so a long frame slows the simulation rather than stalling the app.
+// The leftover time renders models part way between the last two steps.
+
+#ifndef _FIXED_TIMESTEP_H_INCLUDED_
+#define _FIXED_TIMESTEP_H_INCLUDED_
+
+#include <cstdint>
+
+
+class FixedTimestep
+{
+public:
+    // Steps are timestep seconds long, at most maxSteps steps are run in a frame
+    FixedTimestep(float timestep, uint32_t maxSteps);
+
+    // Forget any time not yet simulated and dropped
+    void Reset();
+
+    // Add the time passed since the last frame (seconds) and return the number of steps to run for this frame
+    uint32_t Advance(float frameTime);
+
+
+    // Length of a step in seconds
+    float Timestep() const  { return mTimestep; }
+
+    // How far the current time is between the last step and the next, 0 to 1. Render the moving models this far
+    // between where they were before the last step and where they are now
+    float Interpolation() const  { return mAccumulator / mTimestep; }
+
+    // Total time dropped because more than maxSteps steps were needed in a frame, in seconds
+    double DroppedTime() const  { return mDroppedTime; }
+
+
+private:
+    float    mTimestep;
+    uint32_t mMaxSteps;
+    float    mAccumulator = 0; // Time passed that has not been simulated yet, less than one step after Advance
+    double   mDroppedTime = 0;
+};
+
+
+#endif //_FIXED_TIMESTEP_H_INCLUDED_
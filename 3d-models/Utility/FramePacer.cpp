@@ -0,0 +1,182 @@
+//--------------------------------------------------------------------------------------
+// Frame pacing
+//--------------------------------------------------------------------------------------
+
+#include "FramePacer.h"
+
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+    // Sleeps are made in slices of this length, so the overshoot of each is measured and the spin at the end stays short
+    const std::chrono::milliseconds SLEEP_SLICE(1);
+
+    // Starting guess for how much a sleep overshoots, refined by measurement
+    const std::chrono::milliseconds INITIAL_SLEEP_OVERSHOOT(2);
+
+    // The low latency mode starts frames this much earlier than predicted, to allow for small variations
+    const std::chrono::microseconds LOW_LATENCY_MARGIN(1000);
+
+    // The recent maximums of work time and sleep overshoot decay by this fraction each time they are measured
+    const int MAXIMUM_DECAY = 64;
+
+    bool IsCapped(PacingMode mode)
+    {
+        return mode == PacingMode::Capped || mode == PacingMode::LowLatency;
+    }
+
+    // Convert a duration to seconds
+    float Seconds(FramePacer::Clock::duration duration)
+    {
+        return std::chrono::duration<float>(duration).count();
+    }
+}
+
+
+const char* PacingModeName(PacingMode mode)
+{
+    switch (mode)
+    {
+        case PacingMode::Vsync:      return "Vsync";
+        case PacingMode::Capped:     return "Capped";
+        case PacingMode::LowLatency: return "Low latency";
+        case PacingMode::Uncapped:   return "Uncapped";
+        default:                     return "Unknown";
+    }
+}
+
+
+
+FramePacer::FramePacer(PacingMode mode /*= PacingMode::Vsync*/, float targetFPS /*= 60.0f*/)
+    : mMode(mode), mPresentWait(0), mPredictedWork(0), mSleepOvershoot(INITIAL_SLEEP_OVERSHOOT)
+{
+    SetTargetFPS(targetFPS);
+}
+
+
+// Change the mode and, for the capped modes, the frame rate to cap at. Restarts the measurements
+void FramePacer::SetMode(PacingMode mode)
+{
+    mMode = mode;
+    mPresentTime = Clock::time_point();
+    mWaitedForStart = false;
+    mNumErrors    = mNumLatencies = 0;
+    mNextError    = mNextLatency  = 0;
+}
+
+void FramePacer::SetTargetFPS(float targetFPS)
+{
+    mTargetFPS = std::max(targetFPS, 1.0f);
+    mFramePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / mTargetFPS));
+    SetMode(mMode);
+}
+
+
+// Call at the start of each frame before reading input. In the low latency mode, the first call of a frame waits
+// until the frame needs to start and returns true, so input that arrived while waiting can be read before calling
+// again. Returns false when the frame should go ahead
+bool FramePacer::WaitForFrameStart()
+{
+    if (mMode != PacingMode::LowLatency || mWaitedForStart || mPresentTime == Clock::time_point())  return false;
+
+    // Start just soon enough for recent frames to have finished in time
+    mWaitedForStart = true;
+    Clock::time_point startTime = mPresentTime - mPredictedWork - LOW_LATENCY_MARGIN;
+    if (startTime <= Clock::now())  return false;
+    WaitUntil(startTime);
+    return true;
+}
+
+
+// Call once the frame's input has been read, returns the time it was read
+FramePacer::Clock::time_point FramePacer::InputRead()
+{
+    mFrameStart = Clock::now();
+    return mFrameStart;
+}
+
+
+// Call just before Present. In the capped modes waits until the frame's present time
+void FramePacer::BeforePresent()
+{
+    mPresentWait = Clock::duration::zero();
+    if (IsCapped(mMode) && mPresentTime != Clock::time_point())
+    {
+        Clock::time_point waitStart = Clock::now();
+        WaitUntil(mPresentTime);
+        mPresentWait = Clock::now() - waitStart;
+    }
+}
+
+
+// Call just after Present, with the time the input used by the presented frame was read (this can be an earlier
+// frame's input if the simulation runs ahead of rendering, see Pipeline.h)
+void FramePacer::AfterPresent(Clock::time_point inputTime)
+{
+    Clock::time_point now = Clock::now();
+    mWaitedForStart = false;
+
+    mLatencies[mNextLatency] = Seconds(now - inputTime);
+    mNextLatency = (mNextLatency + 1) % NUM_SAMPLES;
+    mNumLatencies = std::min(mNumLatencies + 1, NUM_SAMPLES);
+
+    if (!IsCapped(mMode))  return;
+
+    // Measure how far off target this frame was, and predict how long the next frame will take from reading input
+    bool knownTarget = mPresentTime != Clock::time_point();
+    if (knownTarget)
+    {
+        mErrors[mNextError] = Seconds(now - mPresentTime);
+        mNextError = (mNextError + 1) % NUM_SAMPLES;
+        mNumErrors = std::min(mNumErrors + 1, NUM_SAMPLES);
+    }
+    mPredictedWork = std::max(now - mFrameStart - mPresentWait, mPredictedWork - mPredictedWork / MAXIMUM_DECAY);
+
+    // Frames stay on an even cadence from the first one. If a frame is more than a whole period late, the cadence starts
+    // again from it rather than rushing the following frames out to catch up
+    mPresentTime = (knownTarget ? mPresentTime : now) + mFramePeriod;
+    if (mPresentTime <= now)  mPresentTime = now + mFramePeriod;
+}
+
+
+// Measurements over recent frames
+PacingSummary FramePacer::Summarise()
+{
+    PacingSummary summary = {};
+    for (uint32_t i = 0; i < mNumErrors; ++i)
+    {
+        float error = std::fabs(mErrors[i]) * 1000.0f;
+        summary.meanError += error / mNumErrors;
+        summary.maxError = std::max(summary.maxError, error);
+    }
+    for (uint32_t i = 0; i < mNumLatencies; ++i)
+    {
+        float latency = mLatencies[i] * 1000.0f;
+        summary.meanLatency += latency / mNumLatencies;
+        summary.maxLatency = std::max(summary.maxLatency, latency);
+    }
+    return summary;
+}
+
+
+// Wait until the given time, sleeping for most of the wait then spinning for the rest. Adjusts to how much sleeps
+// overshoot on this system
+void FramePacer::WaitUntil(Clock::time_point time)
+{
+    // Sleep in short slices while even an overshooting slice would finish in time
+    Clock::time_point now = Clock::now();
+    while (time - now > SLEEP_SLICE + mSleepOvershoot)
+    {
+        std::this_thread::sleep_for(SLEEP_SLICE);
+        Clock::time_point woken = Clock::now();
+        Clock::duration overshoot = woken - now - SLEEP_SLICE;
+        mSleepOvershoot = std::max(overshoot, mSleepOvershoot - mSleepOvershoot / MAXIMUM_DECAY);
+        now = woken;
+    }
+
+    // Spin for the rest, letting other threads (e.g. the simulation) use the core
+    while (Clock::now() < time)  std::this_thread::yield();
+}
@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------------------
+// Frame pacing
+//--------------------------------------------------------------------------------------
+// Controls when frames are started and presented. With vsync off it can cap the frame rate
+// exactly, sleeping then spinning for the last part of the wait as sleeps overshoot (by an
+// amount measured as the app runs). Low latency mode moves most of the wait to before input
+// is read. The pacer also measures pacing error and the latency from input to present.
+
+#ifndef _FRAME_PACER_H_INCLUDED_
+#define _FRAME_PACER_H_INCLUDED_
+
+#include <chrono>
+#include <cstdint>
+
+
+enum class PacingMode
+{
+    Vsync,      // Present waits for the monitor
+    Capped,     // Exact frame rate cap, waiting just before Present
+    LowLatency, // Exact frame rate cap, waiting before input is read
+    Uncapped,   // As fast as possible
+    Count,
+};
+
+const char* PacingModeName(PacingMode mode);
+
+
+// Recent pacing measurements, all in milliseconds
+struct PacingSummary
+{
+    float meanError; // Mean of how far (early or late) frames were presented from their target time, capped modes only
+    float maxError;
+    float meanLatency; // Mean time from reading a frame's input to Present returning
+    float maxLatency;
+};
+
+
+class FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FramePacer(PacingMode mode = PacingMode::Vsync, float targetFPS = 60.0f);
+
+    // Change the mode and, for the capped modes, the frame rate to cap at. Restarts the measurements
+    void SetMode(PacingMode mode);
+    void SetTargetFPS(float targetFPS);
+
+    PacingMode Mode()       { return mMode; }
+    float      TargetFPS()  { return mTargetFPS; }
+
+    // Whether Present should wait for vsync
+    bool Vsync()  { return mMode == PacingMode::Vsync; }
+
+
+    // Call at the start of each frame before reading input. In the low latency mode, the first call of a frame waits
+    // until the frame needs to start and returns true, so input that arrived while waiting can be read before calling
+    // again. Returns false when the frame should go ahead
+    bool WaitForFrameStart();
+
+    // Call once the frame's input has been read, returns the time it was read
+    Clock::time_point InputRead();
+
+    // The time the current frame's input was read
+    Clock::time_point InputTime()  { return mFrameStart; }
+
+    // Call just before Present. In the capped modes waits until the frame's present time
+    void BeforePresent();
+
+    // Call just after Present, with the time the input used by the presented frame was read (this can be an earlier
+    // frame's input if the simulation runs ahead of rendering, see Pipeline.h)
+    void AfterPresent(Clock::time_point inputTime);
+
+
+    // Measurements over recent frames
+    PacingSummary Summarise();
+
+
+    // Wait until the given time, sleeping for most of the wait then spinning for the rest. Adjusts to how much sleeps
+    // overshoot on this system
+    void WaitUntil(Clock::time_point time);
+
+
+private:
+    static const uint32_t NUM_SAMPLES = 120; // Number of recent frames to measure over
+
+    PacingMode mMode;
+    float      mTargetFPS;
+
+    Clock::duration   mFramePeriod;
+    Clock::time_point mPresentTime; // When the current frame should be presented, or a default time if not known yet
+    Clock::time_point mFrameStart;  // When the current frame's input was read
+    Clock::duration   mPresentWait; // How long BeforePresent waited this frame
+    bool              mWaitedForStart = false;
+
+    // Longest recent time from reading input to presenting (not counting the wait), decaying slowly so one slow frame isn't predicted forever.
+    // Used to decide when the low latency mode starts frames
+    Clock::duration mPredictedWork;
+
+    // Longest recent overshoot of a sleep, decaying slowly in the same way
+    Clock::duration mSleepOvershoot;
+
+    // Recent pacing errors and latencies in seconds, in rings
+    float    mErrors[NUM_SAMPLES];
+    float    mLatencies[NUM_SAMPLES];
+    uint32_t mNumErrors    = 0;
+    uint32_t mNumLatencies = 0;
+    uint32_t mNextError    = 0;
+    uint32_t mNextLatency  = 0;
+};
+
+
+// The frame pacer used by the app
+extern FramePacer gFramePacer;
+
+
+#endif //_FRAME_PACER_H_INCLUDED_
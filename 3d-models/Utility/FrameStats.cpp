@@ -0,0 +1,180 @@
+//--------------------------------------------------------------------------------------
+// Frame time statistics
+//--------------------------------------------------------------------------------------
+
+#include "FrameStats.h"
+#include "Timer.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+
+
+const float FrameStats::JITTER_BUCKET_LIMITS[NUM_JITTER_BUCKETS - 1] = { 0.25f, 0.5f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f };
+
+namespace
+{
+    const char* TIMING_NAMES[] = { "frame", "update", "render" };
+
+    // Nearest-rank percentile of sorted values
+    float Percentile(const std::vector<float>& sorted, float percent)
+    {
+        size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * sorted.size()));
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+}
+
+
+// Keep statistics for the most recent windowSize frames, ignoring the first warmUpFrames
+FrameStats::FrameStats(uint32_t windowSize /*= 8192*/, uint32_t warmUpFrames /*= 60*/)
+    : mSamples(std::max(1u, windowSize)), mWarmUpFrames(warmUpFrames), mWarmUpLeft(warmUpFrames),
+      mJitter(std::max(1u, windowSize))
+{
+}
+
+
+// Forget all frames and start the warm-up again
+void FrameStats::Reset()
+{
+    mNext  = 0;
+    mCount = 0;
+    mWarmUpLeft = mWarmUpFrames;
+    mLastFrameTime = -1.0f;
+}
+
+
+// Record the times of a frame, all in seconds
+void FrameStats::AddFrame(float frameTime, float updateTime, float renderTime)
+{
+    float frameMs = frameTime * 1000.0f;
+    float jitter = mLastFrameTime >= 0.0f ? std::fabs(frameMs - mLastFrameTime) : -1.0f; // -1 when there is no previous frame
+    mLastFrameTime = frameMs;
+
+    if (mWarmUpLeft > 0)
+    {
+        --mWarmUpLeft;
+        return;
+    }
+
+    Sample& sample = mSamples[mNext];
+    sample.times[static_cast<int>(FrameTiming::Frame)]  = frameMs;
+    sample.times[static_cast<int>(FrameTiming::Update)] = updateTime * 1000.0f;
+    sample.times[static_cast<int>(FrameTiming::Render)] = renderTime * 1000.0f;
+    mJitter[mNext] = jitter;
+
+    mNext = (mNext + 1) % static_cast<uint32_t>(mSamples.size());
+    mCount = std::min(mCount + 1, static_cast<uint32_t>(mSamples.size()));
+}
+
+
+// Statistics for one of the times over the window (all zero if there are no frames)
+TimingSummary FrameStats::Summarise(FrameTiming timing) const
+{
+    TimingSummary summary = {};
+    if (mCount == 0)  return summary;
+
+    std::vector<float>& values = mSorted;
+    values.resize(mCount);
+    double sum = 0;
+    for (uint32_t i = 0; i < mCount; ++i)
+    {
+        values[i] = Oldest(i).times[static_cast<int>(timing)];
+        sum += values[i];
+    }
+    double mean = sum / mCount;
+
+    // Variance about the mean found above rather than from a running sum of squares, which loses precision
+    double squares = 0;
+    for (auto value : values)  squares += (value - mean) * (value - mean);
+
+    std::sort(values.begin(), values.end());
+    summary.samples  = mCount;
+    summary.mean     = static_cast<float>(mean);
+    summary.variance = static_cast<float>(squares / mCount);
+    summary.min      = values.front();
+    summary.p50      = Percentile(values, 50.0f);
+    summary.p90      = Percentile(values, 90.0f);
+    summary.p99      = Percentile(values, 99.0f);
+    summary.p999     = Percentile(values, 99.9f);
+    summary.max      = values.back();
+    return summary;
+}
+
+
+// Number of frames in the window whose frame time differed from the previous frame's by an amount in each bucket
+std::vector<uint32_t> FrameStats::JitterHistogram() const
+{
+    std::vector<uint32_t> histogram(NUM_JITTER_BUCKETS, 0);
+    for (uint32_t i = 0; i < mCount; ++i)
+    {
+        float jitter = OldestJitter(i);
+        if (jitter < 0.0f)  continue;
+
+        uint32_t bucket = 0;
+        while (bucket < NUM_JITTER_BUCKETS - 1 && jitter >= JITTER_BUCKET_LIMITS[bucket])  ++bucket;
+        ++histogram[bucket];
+    }
+    return histogram;
+}
+
+
+// Write each frame in the window as a row of comma separated times in milliseconds. Returns false on failure
+bool FrameStats::WriteCSV(const std::string& fileName) const
+{
+    std::ofstream file(fileName);
+    if (!file.is_open())  return false;
+
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    file << "frame,frame_ms,update_ms,render_ms,jitter_ms\n";
+    for (uint32_t i = 0; i < mCount; ++i)
+    {
+        const Sample& sample = Oldest(i);
+        file << i;
+        for (auto time : sample.times)  file << ',' << time;
+        float jitter = OldestJitter(i);
+        file << ',';
+        if (jitter >= 0.0f)  file << jitter;
+        file << '\n';
+    }
+    return !file.fail();
+}
+
+
+// Write the statistics and jitter histogram as JSON. Returns false on failure
+bool FrameStats::WriteJSON(const std::string& fileName) const
+{
+    std::ofstream file(fileName);
+    if (!file.is_open())  return false;
+
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    file << "{\n  \"frames\": " << mCount << ",\n  \"warm_up_frames\": " << mWarmUpFrames << ",\n";
+    for (int timing = 0; timing < static_cast<int>(FrameTiming::Count); ++timing)
+    {
+        TimingSummary summary = Summarise(static_cast<FrameTiming>(timing));
+        file << "  \"" << TIMING_NAMES[timing] << "_ms\": { \"mean\": " << summary.mean
+             << ", \"variance\": " << summary.variance << ", \"min\": " << summary.min << ", \"p50\": " << summary.p50
+             << ", \"p90\": " << summary.p90 << ", \"p99\": " << summary.p99 << ", \"p99.9\": " << summary.p999
+             << ", \"max\": " << summary.max << " },\n";
+    }
+
+    // Histogram buckets are labelled with their upper limit
+    file << "  \"jitter_histogram_ms\": {";
+    std::vector<uint32_t> histogram = JitterHistogram();
+    for (uint32_t bucket = 0; bucket < NUM_JITTER_BUCKETS; ++bucket)
+    {
+        file << (bucket > 0 ? ", " : " ") << '"';
+        if (bucket < NUM_JITTER_BUCKETS - 1)  file << "<" << JITTER_BUCKET_LIMITS[bucket];
+        else                                  file << ">=" << JITTER_BUCKET_LIMITS[bucket - 1];
+        file << "\": " << histogram[bucket];
+    }
+    file << " },\n";
+
+    // Times shorter than a few steps of the clock can't be measured accurately
+    const TimerClockInfo& clock = GetTimerClockInfo(TimerClock::Steady);
+    file << "  \"clock\": { \"name\": \"" << TimerClockName(TimerClock::Steady) << "\", \"resolution_ns\": " << clock.resolution
+         << ", \"overhead_ns\": " << clock.overhead << " }\n}\n";
+
+    return !file.fail();
+}
@@ -0,0 +1,110 @@
+//--------------------------------------------------------------------------------------
+// Frame time statistics
+//--------------------------------------------------------------------------------------
+// Keeps the frame, update and render times of recent frames and reports percentiles (p50 to
+// p99.9), maximum, variance and a histogram of frame to frame jitter, which show stutter that
+// averages hide. The first frames after start-up are ignored as warm-up.
+
+#ifndef _FRAME_STATS_H_INCLUDED_
+#define _FRAME_STATS_H_INCLUDED_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+// The times recorded for each frame
+enum class FrameTiming
+{
+    Frame,  // Time from the start of one frame to the start of the next
+    Update, // Time spent in UpdateScene
+    Render, // Time spent in RenderScene (includes Present, so waiting for vsync when it is on)
+    Count,
+};
+
+
+// Statistics of one of the times over the window, all in milliseconds
+struct TimingSummary
+{
+    uint32_t samples;
+    float    mean;
+    float    variance; // Milliseconds squared
+    float    min;
+    float    p50;
+    float    p90;
+    float    p99;
+    float    p999;
+    float    max;
+};
+
+
+class FrameStats
+{
+public:
+    // Jitter histogram bucket upper limits in milliseconds, the last bucket holds everything above the last limit
+    static const uint32_t NUM_JITTER_BUCKETS = 8;
+    static const float    JITTER_BUCKET_LIMITS[NUM_JITTER_BUCKETS - 1];
+
+    // Keep statistics for the most recent windowSize frames, ignoring the first warmUpFrames
+    explicit FrameStats(uint32_t windowSize = 8192, uint32_t warmUpFrames = 60);
+
+    // Change the number of warm-up frames, takes effect from the next Reset
+    void SetWarmUpFrames(uint32_t warmUpFrames)  { mWarmUpFrames = warmUpFrames; }
+
+    // Forget all frames and start the warm-up again
+    void Reset();
+
+    // Record the times of a frame, all in seconds
+    void AddFrame(float frameTime, float updateTime, float renderTime);
+
+
+    // Number of frames in the window
+    uint32_t NumFrames() const  { return mCount; }
+
+    // Statistics for one of the times over the window (all zero if there are no frames)
+    TimingSummary Summarise(FrameTiming timing) const;
+
+    // Number of frames in the window whose frame time differed from the previous frame's by an amount in each bucket
+    std::vector<uint32_t> JitterHistogram() const;
+
+
+    // Write each frame in the window as a row of comma separated times in milliseconds. Returns false on failure
+    bool WriteCSV(const std::string& fileName) const;
+
+    // Write the statistics and jitter histogram as JSON. Returns false on failure
+    bool WriteJSON(const std::string& fileName) const;
+
+
+private:
+    // Times of a frame in milliseconds
+    struct Sample
+    {
+        float times[static_cast<int>(FrameTiming::Count)];
+    };
+
+    // The window is a ring buffer, the oldest frame is at mNext once the window is full
+    std::vector<Sample> mSamples;
+    uint32_t            mNext  = 0;
+    uint32_t            mCount = 0;
+
+    uint32_t mWarmUpFrames;
+    uint32_t mWarmUpLeft;
+
+    // Frame time (ms) of the previous frame, for jitter. Each sample's jitter is stored with it in mJitter
+    float              mLastFrameTime = -1.0f;
+    std::vector<float> mJitter;
+
+    // Sorted copy of one of the times, kept so Summarise reuses its memory rather than allocating each time
+    mutable std::vector<float> mSorted;
+
+    // Sample i in age order, oldest first
+    const Sample& Oldest(uint32_t i) const  { return mSamples[(mNext + mSamples.size() - mCount + i) % mSamples.size()]; }
+    float         OldestJitter(uint32_t i) const  { return mJitter[(mNext + mJitter.size() - mCount + i) % mJitter.size()]; }
+};
+
+
+// Frame time statistics of the app, collected by the main loop
+extern FrameStats gFrameStats;
+
+
+#endif //_FRAME_STATS_H_INCLUDED_
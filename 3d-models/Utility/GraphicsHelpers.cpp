@@ -4,25 +4,166 @@
 
 #include "GraphicsHelpers.h"
 #include "../Shader.h"
+#include "AssetPackage.h"
+#include "MappedFile.h"
+#include "DDSFile.h"
+#include <vector>
 #include <cmath>
+#include <algorithm>
 #include <cctype>
 #include <atlbase.h> // C-string to unicode conversion function CA2CT
 
+// Counts of the work sent to the GPU in the current frame
+RenderCounters gRenderCounters = {};
+
+
 //--------------------------------------------------------------------------------------
 // Texture Loading
 //--------------------------------------------------------------------------------------
 
-// Using Microsoft's open source DirectX Tool Kit (DirectXTK) to simplify texture loading
-// This function requires you to pass a ID3D11Resource* (e.g. &gTilesDiffuseMap), which manages the GPU memory for the
-// texture and also a ID3D11ShaderResourceView* (e.g. &gTilesDiffuseMapSRV), which allows us to use the texture in shaders
-// The function will fill in these pointers with usable data. Returns false on failure
-bool LoadTexture(std::string filename, ID3D11Resource** texture, ID3D11ShaderResourceView** textureSRV)
+// Create a texture and shader resource view from a parsed DDS file. The subresource table points into the memory holding
+// the file (e.g. a mapped file), so Direct3D reads the pixel data straight from there with no intermediate copy
+bool CreateDDSTexture(const DDSTexture& dds, ID3D11Resource** texture, ID3D11ShaderResourceView** textureSRV)
+{
+    std::vector<D3D11_SUBRESOURCE_DATA> initData(dds.subresources.size());
+    for (size_t i = 0; i < dds.subresources.size(); ++i)
+    {
+        initData[i].pSysMem          = dds.subresources[i].data;
+        initData[i].SysMemPitch      = dds.subresources[i].rowPitch;
+        initData[i].SysMemSlicePitch = dds.subresources[i].slicePitch;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = dds.format;
+
+    HRESULT result = E_FAIL;
+    *texture = nullptr;
+    if (dds.dimension == DDS_DIMENSION_TEXTURE1D)
+    {
+        D3D11_TEXTURE1D_DESC textureDesc = {};
+        textureDesc.Width     = dds.width;
+        textureDesc.MipLevels = dds.mipLevels;
+        textureDesc.ArraySize = dds.arraySize;
+        textureDesc.Format    = dds.format;
+        textureDesc.Usage     = D3D11_USAGE_IMMUTABLE;
+        textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        ID3D11Texture1D* texture1D;
+        result = gD3DDevice->CreateTexture1D(&textureDesc, initData.data(), &texture1D);
+        if (SUCCEEDED(result))  *texture = texture1D;
+
+        if (dds.arraySize > 1)
+        {
+            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE1DARRAY;
+            srvDesc.Texture1DArray.MipLevels = dds.mipLevels;
+            srvDesc.Texture1DArray.ArraySize = dds.arraySize;
+        }
+        else
+        {
+            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE1D;
+            srvDesc.Texture1D.MipLevels = dds.mipLevels;
+        }
+    }
+    else if (dds.dimension == DDS_DIMENSION_TEXTURE2D)
+    {
+        D3D11_TEXTURE2D_DESC textureDesc = {};
+        textureDesc.Width      = dds.width;
+        textureDesc.Height     = dds.height;
+        textureDesc.MipLevels  = dds.mipLevels;
+        textureDesc.ArraySize  = dds.arraySize;
+        textureDesc.Format     = dds.format;
+        textureDesc.SampleDesc.Count = 1;
+        textureDesc.Usage      = D3D11_USAGE_IMMUTABLE;
+        textureDesc.BindFlags  = D3D11_BIND_SHADER_RESOURCE;
+        textureDesc.MiscFlags  = dds.cubeMap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+        ID3D11Texture2D* texture2D;
+        result = gD3DDevice->CreateTexture2D(&textureDesc, initData.data(), &texture2D);
+        if (SUCCEEDED(result))  *texture = texture2D;
+
+        if (dds.cubeMap && dds.arraySize > 6)
+        {
+            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+            srvDesc.TextureCubeArray.MipLevels = dds.mipLevels;
+            srvDesc.TextureCubeArray.NumCubes  = dds.arraySize / 6;
+        }
+        else if (dds.cubeMap)
+        {
+            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+            srvDesc.TextureCube.MipLevels = dds.mipLevels;
+        }
+        else if (dds.arraySize > 1)
+        {
+            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+            srvDesc.Texture2DArray.MipLevels = dds.mipLevels;
+            srvDesc.Texture2DArray.ArraySize = dds.arraySize;
+        }
+        else
+        {
+            srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+            srvDesc.Texture2D.MipLevels = dds.mipLevels;
+        }
+    }
+    else if (dds.dimension == DDS_DIMENSION_TEXTURE3D)
+    {
+        D3D11_TEXTURE3D_DESC textureDesc = {};
+        textureDesc.Width     = dds.width;
+        textureDesc.Height    = dds.height;
+        textureDesc.Depth     = dds.depth;
+        textureDesc.MipLevels = dds.mipLevels;
+        textureDesc.Format    = dds.format;
+        textureDesc.Usage     = D3D11_USAGE_IMMUTABLE;
+        textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        ID3D11Texture3D* texture3D;
+        result = gD3DDevice->CreateTexture3D(&textureDesc, initData.data(), &texture3D);
+        if (SUCCEEDED(result))  *texture = texture3D;
+
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE3D;
+        srvDesc.Texture3D.MipLevels = dds.mipLevels;
+    }
+    if (FAILED(result))  return false;
+
+    if (FAILED(gD3DDevice->CreateShaderResourceView(*texture, &srvDesc, textureSRV)))
+    {
+        (*texture)->Release();
+        *texture = nullptr;
+        return false;
+    }
+    return true;
+}
+
+
+// Create a texture from a file or the asset package, for LoadTexture below
+static bool LoadTextureResource(const std::string& filename, ID3D11Resource** texture, ID3D11ShaderResourceView** textureSRV)
 {
+    // Textures in the asset package have all been cooked to DDS, so they are created straight from the mapped package
+    // data without opening or decoding any files. Cooked textures without mip-maps are left to DirectXTK, which generates
+    // the missing mip-maps on the GPU when given the context
+    const PackageEntry* cooked = gAssetPackage.Find(filename, AssetType::Texture);
+    if (cooked != nullptr)
+    {
+        DDSTexture dds;
+        if (ParseDDS(gAssetPackage.Data(*cooked), static_cast<size_t>(cooked->size), dds) && dds.mipLevels > 1)
+        {
+            return CreateDDSTexture(dds, texture, textureSRV);
+        }
+        return SUCCEEDED(DirectX::CreateDDSTextureFromMemory(gD3DDevice, gD3DContext, gAssetPackage.Data(*cooked),
+                                                             static_cast<size_t>(cooked->size), texture, textureSRV));
+    }
+
     // DDS files need a different function from other files
     std::string dds = ".dds"; // So check the filename extension (case insensitive)
     if (filename.size() >= 4 &&
         std::equal(dds.rbegin(), dds.rend(), filename.rbegin(), [](unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); }))
     {
+        // The mapping only needs to last until the texture is created, Direct3D has its own copy of the data after that
+        MappedFile file;
+        DDSTexture ddsTexture;
+        if (file.Open(filename))
+        {
+            file.Prefetch();
+            if (ParseDDS(file.Data(), file.Size(), ddsTexture))  return CreateDDSTexture(ddsTexture, texture, textureSRV);
+        }
+
+        // Leave anything the parser doesn't support to DirectXTK
         return SUCCEEDED(DirectX::CreateDDSTextureFromFile(gD3DDevice, CA2CT(filename.c_str()), texture, textureSRV));
     }
     else
@@ -32,6 +173,70 @@ bool LoadTexture(std::string filename, ID3D11Resource** texture, ID3D11ShaderRes
 }
 
 
+// DDS files are read with our own parser (DDSFile.h) over a memory-mapped file and created with CreateDDSTexture above, so
+// no copy of the file is ever made in memory. Other file types use Microsoft's open source DirectX Tool Kit (DirectXTK).
+// This function requires you to pass a ID3D11Resource* (e.g. &gTilesDiffuseMap), which manages the GPU memory for the
+// texture and also a ID3D11ShaderResourceView* (e.g. &gTilesDiffuseMapSRV), which allows us to use the texture in shaders
+// The function will fill in these pointers with usable data. Returns false on failure
+bool LoadTexture(std::string filename, ID3D11Resource** texture, ID3D11ShaderResourceView** textureSRV)
+{
+    if (!LoadTextureResource(filename, texture, textureSRV))  return false;
+    TrackMemory(MemoryCategory::Textures, MemoryHeap::GPU, ResourceBytes(*texture));
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Memory accounting
+//--------------------------------------------------------------------------------------
+
+// GPU memory used by a buffer or texture, worked out from its description (the driver may round it up a little).
+// Returns 0 for formats the size isn't known for
+size_t ResourceBytes(ID3D11Resource* resource)
+{
+    // Total size of the mips of a texture, for one array slice
+    auto mipChainBytes = [](DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipLevels)
+    {
+        size_t bytes = 0;
+        for (uint32_t mip = 0; mip < mipLevels; ++mip)
+        {
+            uint32_t rowPitch, numRows;
+            if (!GetSurfaceInfo(format, std::max(1u, width >> mip), std::max(1u, height >> mip), rowPitch, numRows))  return size_t(0);
+            bytes += static_cast<size_t>(rowPitch) * numRows * std::max(1u, depth >> mip);
+        }
+        return bytes;
+    };
+
+    D3D11_RESOURCE_DIMENSION dimension;
+    resource->GetType(&dimension);
+    if (dimension == D3D11_RESOURCE_DIMENSION_BUFFER)
+    {
+        D3D11_BUFFER_DESC desc;
+        static_cast<ID3D11Buffer*>(resource)->GetDesc(&desc);
+        return desc.ByteWidth;
+    }
+    if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE1D)
+    {
+        D3D11_TEXTURE1D_DESC desc;
+        static_cast<ID3D11Texture1D*>(resource)->GetDesc(&desc);
+        return mipChainBytes(desc.Format, desc.Width, 1, 1, desc.MipLevels) * desc.ArraySize;
+    }
+    if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+    {
+        D3D11_TEXTURE2D_DESC desc;
+        static_cast<ID3D11Texture2D*>(resource)->GetDesc(&desc);
+        return mipChainBytes(desc.Format, desc.Width, desc.Height, 1, desc.MipLevels) * desc.ArraySize;
+    }
+    if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
+    {
+        D3D11_TEXTURE3D_DESC desc;
+        static_cast<ID3D11Texture3D*>(resource)->GetDesc(&desc);
+        return mipChainBytes(desc.Format, desc.Width, desc.Height, desc.Depth, desc.MipLevels);
+    }
+    return 0;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Camera Helpers
 //--------------------------------------------------------------------------------------
@@ -10,9 +10,28 @@
 #include <DDSTextureLoader.h>
 
 #include "CMatrix4x4.h"
+#include "DDSFile.h"
+#include "MemoryTracker.h"
 #include "../Common.h"
 
 
+//--------------------------------------------------------------------------------------
+// Render counters
+//--------------------------------------------------------------------------------------
+
+// Counts of the work sent to the GPU in a frame, reset at the start of RenderScene. Shows how the work grows with the
+// size of the scene (see the benchmark in StressScene.h). Work is counted where it is sent: constant buffer updates
+// below, draw calls and input assembler states in Mesh::Render, other states by the code that sets them
+struct RenderCounters
+{
+    uint32_t drawCalls;
+    uint64_t triangles;
+    uint32_t stateChanges; // Shaders, textures, constant buffer bindings, vertex/index buffers etc.
+    uint32_t constantBufferUpdates;
+};
+extern RenderCounters gRenderCounters;
+
+
 //--------------------------------------------------------------------------------------
 // Constant buffers
 //--------------------------------------------------------------------------------------
@@ -27,6 +46,7 @@ void UpdateConstantBuffer(ID3D11Buffer* buffer, const T& bufferData)
     gD3DContext->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &cb);
     memcpy(cb.pData, &bufferData, sizeof(T));
     gD3DContext->Unmap(buffer, 0);
+    ++gRenderCounters.constantBufferUpdates;
 }
 
 
@@ -34,12 +54,37 @@ void UpdateConstantBuffer(ID3D11Buffer* buffer, const T& bufferData)
 // Texture Loading
 //--------------------------------------------------------------------------------------
 
-// Using Microsoft's open source DirectX Tool Kit (DirectXTK) to simplify file loading
+// DDS files are loaded with our own zero-copy parser, other formats use Microsoft's open source DirectX Tool Kit (DirectXTK)
 // This function requires you to pass a ID3D11Resource* (e.g. &gTilesDiffuseMap), which manages the GPU memory for the
 // texture and also a ID3D11ShaderResourceView* (e.g. &gTilesDiffuseMapSRV), which allows us to use the texture in shaders
-// The function will fill in these pointers with usable data. Returns false on failure
+// The function will fill in these pointers with usable data. Returns false on failure. The texture's memory is counted
+// in the Textures category, release it with ReleaseTracked
 bool LoadTexture(std::string filename, ID3D11Resource** texture, ID3D11ShaderResourceView** textureSRV);
 
+// Create a texture and shader resource view from a parsed DDS file (see DDSFile.h). The pixel data is read straight
+// from wherever the DDS file is held, which only needs to stay valid until this function returns. Returns false on failure
+bool CreateDDSTexture(const DDSTexture& dds, ID3D11Resource** texture, ID3D11ShaderResourceView** textureSRV);
+
+
+//--------------------------------------------------------------------------------------
+// Memory accounting
+//--------------------------------------------------------------------------------------
+
+// GPU memory used by a buffer or texture, worked out from its description (the driver may round it up a little).
+// Returns 0 for formats the size isn't known for
+size_t ResourceBytes(ID3D11Resource* resource);
+
+// Release a resource whose memory was counted in a category with TrackMemory (see MemoryTracker.h), and set the
+// pointer to nullptr. Does nothing for a nullptr
+template <class T>
+void ReleaseTracked(T*& resource, MemoryCategory category)
+{
+    if (resource == nullptr)  return;
+    UntrackMemory(category, MemoryHeap::GPU, ResourceBytes(resource));
+    resource->Release();
+    resource = nullptr;
+}
+
 
 //--------------------------------------------------------------------------------------
 // Camera helpers
@@ -4,16 +4,28 @@
 //--------------------------------------------------------------------------------------
 
 #include "Input.h"
+#include "InputQueue.h"
+#include "InputRecorder.h"
+
+#include <vector>
 
 
 //////////////////////////////////
 // Globals
 
-// Current state of all keys (and mouse buttons)
-KeyState gKeyStates[NumKeyCodes];
+// Input events waiting to be taken at the start of the next frame. Plenty for the events of one frame
+const uint32_t INPUT_QUEUE_SIZE = 1024;
+SPSCQueue<TimedInputEvent, INPUT_QUEUE_SIZE> gInputQueue;
+
+// Key states and mouse position for the current frame, and for the current simulation step
+InputFrame gFrameInput;
+InputFrame gStepInput;
+
+// Events taken from the queue that haven't been given to a simulation step yet, oldest first
+std::vector<TimedInputEvent> gStepEvents;
 
-// Current position of mouse
-int gMouseX, gMouseY;
+// The key states the input functions use, the frame's or the current step's
+const InputFrame* gInput = &gFrameInput;
 
 
 
@@ -23,42 +35,94 @@ int gMouseX, gMouseY;
 void InitInput()
 {
     // Initialise input data
-    for (int i = 0; i < NumKeyCodes; ++i)
-    {
-        gKeyStates[i] = NotPressed;
-    }
-
-    gMouseX = gMouseY = 0;
+    TimedInputEvent event;
+    while (gInputQueue.Pop(event)) {}
+    gFrameInput.Reset();
+    gStepInput.Reset();
+    gStepEvents.clear();
+    gInput = &gFrameInput;
 }
 
 
 //////////////////////////////////
 // Events
 
-// Event called to indicate that a key has been pressed down
-void KeyDownEvent(KeyCode Key)
+// Queue an input event that happened at the given time, bypassing the input recorder (e.g. an event being replayed,
+// see InputRecorder.h)
+void ApplyInputEvent(const InputEvent& event, InputClock::time_point time)
 {
-    if (gKeyStates[Key] == NotPressed)
-    {
-        gKeyStates[Key] = Pressed;
-    }
-    else
+    gInputQueue.Push({ event, time });
+}
+
+// Number of input events lost because too many arrived in one frame for the queue
+uint32_t DroppedInputEvents()
+{
+    return gInputQueue.Dropped();
+}
+
+// Pass a real input event to the input recorder, and queue it unless a replay is in control of the input.
+// Escape always works so a replay can be stopped
+static void RealInputEvent(const InputEvent& event)
+{
+    InputClock::time_point time = InputClock::now();
+    if (gInputRecorder.OnInputEvent(event, time) || (event.type != InputEventType::MouseMove && event.key == Key_Escape))
     {
-        gKeyStates[Key] = Held;
+        ApplyInputEvent(event, time);
     }
 }
 
+// Event called to indicate that a key has been pressed down
+void KeyDownEvent(KeyCode Key)
+{
+    RealInputEvent({ InputEventType::KeyDown, static_cast<uint8_t>(Key), 0, 0 });
+}
+
 // Event called to indicate that a key has been lifted up
 void KeyUpEvent(KeyCode Key)
 {
-   gKeyStates[Key] = NotPressed;
+    RealInputEvent({ InputEventType::KeyUp, static_cast<uint8_t>(Key), 0, 0 });
 }
 
 // Event called to indicate that the mouse has been moved
 void MouseMoveEvent(int X, int Y)
 {
-    gMouseX = X;
-    gMouseY = Y;
+    RealInputEvent({ InputEventType::MouseMove, 0, static_cast<int16_t>(X), static_cast<int16_t>(Y) });
+}
+
+
+//////////////////////////////////
+// Frames and simulation steps
+
+// Take the input events queued since the last frame, call at the start of each frame before anything reads input.
+// The input functions then give the key states for the frame: a key is hit if it went down during the frame
+void BeginInputFrame()
+{
+    gFrameInput.Begin();
+    TimedInputEvent event;
+    while (gInputQueue.Pop(event))
+    {
+        gFrameInput.Apply(event.event);
+        gStepEvents.push_back(event);
+    }
+    gInput = &gFrameInput;
+}
+
+// Start a simulation step that ends at the given time, giving it the events up to then that earlier steps haven't had.
+// Until EndInputSteps, the input functions give the key states for this step, so each key press is seen by exactly one
+// step. Events after the end of the last step in a frame are kept for the first step of the next frame
+void BeginInputStep(InputClock::time_point stepEnd)
+{
+    gStepInput.Begin();
+    auto event = gStepEvents.begin();
+    for (; event != gStepEvents.end() && event->time <= stepEnd; ++event)  gStepInput.Apply(event->event);
+    gStepEvents.erase(gStepEvents.begin(), event);
+    gInput = &gStepInput;
+}
+
+// Go back to the key states for the frame after the simulation steps
+void EndInputSteps()
+{
+    gInput = &gFrameInput;
 }
 
 
@@ -67,15 +131,11 @@ void MouseMoveEvent(int X, int Y)
 
 // Returns true when a given key or button is first pressed down. Use
 // for one-off actions or toggles. Example key codes: Key_A or
-// Mouse_LButton, see input.h for a full list.
+// Mouse_LButton, see input.h for a full list. True for the whole
+// frame (or simulation step) the key went down in.
 bool KeyHit(KeyCode eKeyCode)
 {
-    if (gKeyStates[eKeyCode] == Pressed)
-    {
-        gKeyStates[eKeyCode] = Held;
-        return true;
-    }
-    return false;
+    return gInput->Hit(eKeyCode);
 }
 
 // Returns true as long as a given key or button is held down. Use for
@@ -83,23 +143,18 @@ bool KeyHit(KeyCode eKeyCode)
 // Mouse_LButton, see input.h for a full list.
 bool KeyHeld(KeyCode eKeyCode)
 {
-    if (gKeyStates[eKeyCode] == NotPressed)
-    {
-        return false;
-    }
-    gKeyStates[eKeyCode] = Held;
-    return true;
+    return gInput->Held(eKeyCode);
 }
 
     
 // Returns current X position of mouse
 int GetMouseX()
 {
-    return gMouseX;
+    return gInput->MouseX();
 }
 
 // Returns current Y position of mouse
 int GetMouseY()
 {
-    return gMouseY;
+    return gInput->MouseY();
 }
@@ -2,11 +2,18 @@
 // Key/mouse input functions
 // Used in the same way as the TL-Engine
 //--------------------------------------------------------------------------------------
+// Input events are timestamped and queued as they arrive, then taken from the queue at the
+// start of each frame. KeyHit and KeyHeld give the key states of the frame, or of the current
+// simulation step while the simulation is running (see InputQueue.h). Reading the key states
+// doesn't change them, so any number of places can check the same key.
 
 // Prevent this include file being included multiple times
 #ifndef _INPUT_H_DEFINED_
 #define _INPUT_H_DEFINED_
 
+#include "InputRecorder.h"
+#include <cstdint>
+
 
 //////////////////////////////////
 // Constants
@@ -181,13 +188,37 @@ void KeyUpEvent(KeyCode Key);
 // Event called to indicate that the mouse has been moved
 void MouseMoveEvent(int X, int Y);
 
+// Queue an input event that happened at the given time, bypassing the input recorder (e.g. an event being replayed,
+// see InputRecorder.h)
+void ApplyInputEvent(const InputEvent& event, InputClock::time_point time);
+
+// Number of input events lost because too many arrived in one frame for the queue
+uint32_t DroppedInputEvents();
+
+
+//////////////////////////////////
+// Frames and simulation steps
+
+// Take the input events queued since the last frame, call at the start of each frame before anything reads input.
+// The input functions then give the key states for the frame: a key is hit if it went down during the frame
+void BeginInputFrame();
+
+// Start a simulation step that ends at the given time, giving it the events up to then that earlier steps haven't had.
+// Until EndInputSteps, the input functions give the key states for this step, so each key press is seen by exactly one
+// step. Events after the end of the last step in a frame are kept for the first step of the next frame
+void BeginInputStep(InputClock::time_point stepEnd);
+
+// Go back to the key states for the frame after the simulation steps
+void EndInputSteps();
+
 
 //////////////////////////////////
 // Input functions
 
 // Returns true when a given key or button is first pressed down. Use
 // for one-off actions or toggles. Example key codes: Key_A or
-// Mouse_LButton, see input.h for a full list.
+// Mouse_LButton, see input.h for a full list. True for the whole
+// frame (or simulation step) the key went down in.
 bool KeyHit(KeyCode eKeyCode);
 
 // Returns true as long as a given key or button is held down. Use for
@@ -0,0 +1,45 @@
+//--------------------------------------------------------------------------------------
+// Timestamped input event queue
+//--------------------------------------------------------------------------------------
+
+#include "InputQueue.h"
+
+
+// All keys up and the mouse at 0,0
+void InputFrame::Reset()
+{
+    for (int i = 0; i < NumKeyCodes; ++i)
+    {
+        mDown[i] = false;
+        mHit[i]  = false;
+    }
+    mMouseX = mMouseY = 0;
+}
+
+
+// Start the next frame or step: no keys have been hit yet, keys that are down stay held
+void InputFrame::Begin()
+{
+    for (int i = 0; i < NumKeyCodes; ++i)  mHit[i] = false;
+}
+
+
+// Apply an event in the frame or step
+void InputFrame::Apply(const InputEvent& event)
+{
+    if (event.type == InputEventType::KeyDown)
+    {
+        // Windows repeats key down messages while a key is held, only the first one is a hit
+        if (!mDown[event.key])  mHit[event.key] = true;
+        mDown[event.key] = true;
+    }
+    else if (event.type == InputEventType::KeyUp)
+    {
+        mDown[event.key] = false;
+    }
+    else
+    {
+        mMouseX = event.x;
+        mMouseY = event.y;
+    }
+}
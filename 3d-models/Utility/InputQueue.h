@@ -0,0 +1,124 @@
+//--------------------------------------------------------------------------------------
+// Timestamped input event queue
+//--------------------------------------------------------------------------------------
+// Input events are queued with the time they happened as they arrive from the window, in a
+// lock-free ring for one producer and one consumer, and taken out at the start of each frame.
+// Key states are worked out from the events, and a frame with several simulation steps gives
+// each step the events from its part of the frame (see BeginInputStep in Input.h).
+
+#ifndef _INPUT_QUEUE_H_INCLUDED_
+#define _INPUT_QUEUE_H_INCLUDED_
+
+#include "Input.h"
+#include "InputRecorder.h"
+#include <atomic>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------------
+// Single producer, single consumer queue
+//--------------------------------------------------------------------------------------
+
+// Fixed-size ring of items, where one thread pushes and another pops without locks. Capacity must be a power of two.
+// The read and write positions are kept on separate cache lines so the two threads don't slow each other down
+template <class T, uint32_t Capacity>
+class SPSCQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Queue capacity must be a power of two");
+
+public:
+    // Add an item, only call from the producer thread. Returns false (and counts the item as dropped) if the queue is full
+    bool Push(const T& item)
+    {
+        uint32_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mTailCache == Capacity)
+        {
+            mTailCache = mTail.load(std::memory_order_acquire);
+            if (head - mTailCache == Capacity)
+            {
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        mItems[head & (Capacity - 1)] = item;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Take the oldest item, only call from the consumer thread. Returns false if the queue is empty
+    bool Pop(T& item)
+    {
+        uint32_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail == mHeadCache)
+        {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+            if (tail == mHeadCache)  return false;
+        }
+        item = mItems[tail & (Capacity - 1)];
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Number of items that have been dropped because the queue was full
+    uint32_t Dropped()  { return mDropped.load(std::memory_order_relaxed); }
+
+
+private:
+    // Positions only ever increase, wrapping at 2^32. Each thread keeps a copy of the other's position, which it only
+    // reloads when the queue looks full or empty
+    alignas(64) std::atomic<uint32_t> mHead{0}; // Written by the producer
+    uint32_t                          mTailCache = 0;
+    alignas(64) std::atomic<uint32_t> mTail{0}; // Written by the consumer
+    uint32_t                          mHeadCache = 0;
+    alignas(64) std::atomic<uint32_t> mDropped{0};
+    T                                 mItems[Capacity];
+};
+
+
+
+//--------------------------------------------------------------------------------------
+// Input events and key states
+//--------------------------------------------------------------------------------------
+
+struct TimedInputEvent
+{
+    InputEvent             event;
+    InputClock::time_point time;
+};
+
+
+// The key states and mouse position for a frame or simulation step, worked out from the events during it
+class InputFrame
+{
+public:
+    InputFrame()  { Reset(); }
+
+    // All keys up and the mouse at 0,0
+    void Reset();
+
+    // Start the next frame or step: no keys have been hit yet, keys that are down stay held
+    void Begin();
+
+    // Apply an event in the frame or step
+    void Apply(const InputEvent& event);
+
+
+    // A key went down during the frame or step
+    bool Hit(KeyCode key) const  { return mHit[key]; }
+
+    // A key is down, or went down during the frame or step (so a tap shorter than a frame is still held for one frame)
+    bool Held(KeyCode key) const  { return mDown[key] || mHit[key]; }
+
+    int MouseX() const  { return mMouseX; }
+    int MouseY() const  { return mMouseY; }
+
+
+private:
+    bool mDown[NumKeyCodes];
+    bool mHit[NumKeyCodes];
+    int  mMouseX;
+    int  mMouseY;
+};
+
+
+#endif //_INPUT_QUEUE_H_INCLUDED_
@@ -0,0 +1,147 @@
+//--------------------------------------------------------------------------------------
+// Recording and replay of input and frame times
+//--------------------------------------------------------------------------------------
+
+#include "InputRecorder.h"
+
+#include <fstream>
+#include <algorithm>
+
+
+// The app's input recorder, used by the input functions
+InputRecorder gInputRecorder;
+
+
+// Start recording, any earlier recording is discarded
+void InputRecorder::StartRecording()
+{
+    mMode = Mode::Recording;
+    mFrameTimes.clear();
+    mFrameEventCounts.clear();
+    mEvents.clear();
+    mEventTimes.clear();
+    mPendingEvents = 0;
+    mPendingTimes.clear();
+}
+
+
+// Stop recording and write the recording to a file. Returns false on failure
+bool InputRecorder::SaveRecording(const std::string& fileName)
+{
+    if (mMode != Mode::Recording)  return false;
+    mMode = Mode::Off;
+
+    // Events since the last frame never affected the scene so are left out
+    mEvents.resize(mEvents.size() - mPendingEvents);
+    mPendingEvents = 0;
+    mPendingTimes.clear();
+
+    std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())  return false;
+
+    InputRecordingHeader header = { INPUT_RECORDING_ID, INPUT_RECORDING_VERSION, NumFrames(),
+                                    static_cast<uint32_t>(mEvents.size()) };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(mFrameTimes.data()), mFrameTimes.size() * sizeof(float));
+    file.write(reinterpret_cast<const char*>(mFrameEventCounts.data()), mFrameEventCounts.size() * sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(mEvents.data()), mEvents.size() * sizeof(InputEvent));
+    file.write(reinterpret_cast<const char*>(mEventTimes.data()), mEventTimes.size() * sizeof(float));
+    return !file.fail();
+}
+
+
+// Load a recording and start replaying it. The recorded frame times are used unless a fixed timestep (in seconds)
+// is given. Returns false if the file can't be read
+bool InputRecorder::StartReplay(const std::string& fileName, float fixedTimestep /*= 0.0f*/)
+{
+    mMode = Mode::Off;
+
+    std::ifstream file(fileName, std::ios::in | std::ios::binary);
+    if (!file.is_open())  return false;
+
+    InputRecordingHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (file.fail() || header.id != INPUT_RECORDING_ID || header.version < 1 || header.version > INPUT_RECORDING_VERSION)  return false;
+
+    mFrameTimes.resize(header.numFrames);
+    mFrameEventCounts.resize(header.numFrames);
+    mEvents.resize(header.numEvents);
+    mEventTimes.assign(header.numEvents, 0.0f);
+    file.read(reinterpret_cast<char*>(mFrameTimes.data()), mFrameTimes.size() * sizeof(float));
+    if (header.version >= 3)
+    {
+        file.read(reinterpret_cast<char*>(mFrameEventCounts.data()), mFrameEventCounts.size() * sizeof(uint32_t));
+    }
+    else
+    {
+        std::vector<uint16_t> counts(header.numFrames);
+        file.read(reinterpret_cast<char*>(counts.data()), counts.size() * sizeof(uint16_t));
+        std::copy(counts.begin(), counts.end(), mFrameEventCounts.begin());
+    }
+    file.read(reinterpret_cast<char*>(mEvents.data()), mEvents.size() * sizeof(InputEvent));
+    if (header.version >= 2)  file.read(reinterpret_cast<char*>(mEventTimes.data()), mEventTimes.size() * sizeof(float));
+    if (file.fail())  return false;
+
+    // Check the event counts match the events so replay can't read past the end
+    uint64_t totalEvents = 0;
+    for (auto count : mFrameEventCounts)  totalEvents += count;
+    if (totalEvents != header.numEvents)  return false;
+
+    mMode = Mode::Replaying;
+    mReplayFrame = 0;
+    mReplayEvent = 0;
+    mFixedTimestep = fixedTimestep;
+    return true;
+}
+
+
+// Pass every real input event here with the time it happened. Recorded when recording. Returns false if the event
+// should be ignored because a replay is in control of the input
+bool InputRecorder::OnInputEvent(const InputEvent& event, InputClock::time_point time)
+{
+    if (mMode == Mode::Replaying)  return false;
+
+    if (mMode == Mode::Recording)
+    {
+        mEvents.push_back(event);
+        mPendingTimes.push_back(time);
+        ++mPendingEvents;
+    }
+    return true;
+}
+
+
+// Call at the start of each frame, before the scene update, with the measured frame time and the time the frame's
+// input was read. When recording, stores the frame time and the input events since the previous frame. When
+// replaying, passes the frame's recorded input events to the apply function, at the same times relative to the
+// frame as they were recorded, and replaces the frame time with the recorded (or fixed) one. Returns false (and
+// stops replaying) when a replay has run out of frames
+bool InputRecorder::BeginFrame(float& frameTime, InputClock::time_point inputTime,
+                               void (*apply)(const InputEvent& event, InputClock::time_point time))
+{
+    if (mMode == Mode::Recording)
+    {
+        mFrameTimes.push_back(frameTime);
+        mFrameEventCounts.push_back(mPendingEvents);
+        for (auto time : mPendingTimes)  mEventTimes.push_back(std::chrono::duration<float>(time - inputTime).count());
+        mPendingEvents = 0;
+        mPendingTimes.clear();
+    }
+    else if (mMode == Mode::Replaying)
+    {
+        if (mReplayFrame == NumFrames())
+        {
+            mMode = Mode::Off;
+            return false;
+        }
+
+        for (uint32_t event = 0; event < mFrameEventCounts[mReplayFrame]; ++event, ++mReplayEvent)
+        {
+            auto offset = std::chrono::duration_cast<InputClock::duration>(std::chrono::duration<float>(mEventTimes[mReplayEvent]));
+            apply(mEvents[mReplayEvent], inputTime + offset);
+        }
+        frameTime = mFixedTimestep > 0.0f ? mFixedTimestep : mFrameTimes[mReplayFrame];
+        ++mReplayFrame;
+    }
+    return true;
+}
@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------------------
+// Recording and replay of input and frame times
+//--------------------------------------------------------------------------------------
+// Records the frame time and input events of every frame of a run, with when each event
+// happened in its frame, and replays them with the recorded or a fixed timestep, so the scene
+// goes through exactly the same states however fast the machine is and runs can be compared.
+
+#ifndef _INPUT_RECORDER_H_INCLUDED_
+#define _INPUT_RECORDER_H_INCLUDED_
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+
+// Input events are timestamped with this clock
+using InputClock = std::chrono::steady_clock;
+
+// An input event as passed to the input functions in Input.h. 6 bytes, stored as is in recordings
+enum class InputEventType : uint8_t
+{
+    KeyDown,
+    KeyUp,
+    MouseMove,
+};
+
+struct InputEvent
+{
+    InputEventType type;
+    uint8_t        key;  // KeyCode for key events
+    int16_t        x;    // Mouse position for mouse move events
+    int16_t        y;
+};
+
+
+// Recording file. The header is followed by numFrames float frame times (seconds), then numFrames uint32_t counts of
+// the events before each frame, then numEvents InputEvents, then numEvents float times (seconds) of each event relative
+// to when its frame's input was read. Versions 1 and 2 have uint16_t event counts, and version 1 files have no event
+// times, their events are replayed at the frame time
+const uint32_t INPUT_RECORDING_ID      = 0x43524e49; // "INRC"
+const uint32_t INPUT_RECORDING_VERSION = 3;
+
+struct InputRecordingHeader
+{
+    uint32_t id;
+    uint32_t version;
+    uint32_t numFrames;
+    uint32_t numEvents;
+};
+
+
+class InputRecorder
+{
+public:
+    // Start recording, any earlier recording is discarded
+    void StartRecording();
+
+    // Stop recording and write the recording to a file. Returns false on failure
+    bool SaveRecording(const std::string& fileName);
+
+    // Load a recording and start replaying it. The recorded frame times are used unless a fixed timestep (in seconds)
+    // is given. Returns false if the file can't be read
+    bool StartReplay(const std::string& fileName, float fixedTimestep = 0.0f);
+
+    bool Recording()  { return mMode == Mode::Recording; }
+    bool Replaying()  { return mMode == Mode::Replaying; }
+
+    // Number of frames recorded or in the replay, and the frame the replay has reached
+    uint32_t NumFrames()    { return static_cast<uint32_t>(mFrameTimes.size()); }
+    uint32_t ReplayFrame()  { return mReplayFrame; }
+
+
+    // Pass every real input event here with the time it happened. Recorded when recording. Returns false if the event
+    // should be ignored because a replay is in control of the input
+    bool OnInputEvent(const InputEvent& event, InputClock::time_point time);
+
+    // Call at the start of each frame, before the scene update, with the measured frame time and the time the frame's
+    // input was read. When recording, stores the frame time and the input events since the previous frame. When
+    // replaying, passes the frame's recorded input events to the apply function, at the same times relative to the
+    // frame as they were recorded, and replaces the frame time with the recorded (or fixed) one. Returns false (and
+    // stops replaying) when a replay has run out of frames
+    bool BeginFrame(float& frameTime, InputClock::time_point inputTime,
+                    void (*apply)(const InputEvent& event, InputClock::time_point time));
+
+
+private:
+    enum class Mode
+    {
+        Off,
+        Recording,
+        Replaying,
+    };
+
+    Mode mMode = Mode::Off;
+
+    std::vector<float>      mFrameTimes;
+    std::vector<uint32_t>   mFrameEventCounts;
+    std::vector<InputEvent> mEvents;
+    std::vector<float>      mEventTimes; // Relative to the frame's input time
+
+    // Events received since the last frame when recording, every event is recorded. Their times are made relative to
+    // the frame when it starts
+    uint32_t                            mPendingEvents = 0;
+    std::vector<InputClock::time_point> mPendingTimes;
+
+    uint32_t mReplayFrame = 0;
+    uint32_t mReplayEvent = 0;
+    float    mFixedTimestep = 0.0f;
+};
+
+
+// The app's input recorder, used by the input functions
+extern InputRecorder gInputRecorder;
+
+
+#endif //_INPUT_RECORDER_H_INCLUDED_
@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------------------
+// Read-only memory-mapped file
+//--------------------------------------------------------------------------------------
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+
+// Map the given file into memory, returns false on failure
+// An already open file is closed first
+bool MappedFile::Open(const std::string& fileName)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)  return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mFile    = file;
+    mMapping = mapping;
+    mData    = static_cast<const uint8_t*>(data);
+    mSize    = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file < 0)  return false;
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file); // The mapping keeps its own reference to the file
+    if (data == MAP_FAILED)  return false;
+
+    mData = static_cast<const uint8_t*>(data);
+    mSize = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    return true;
+}
+
+
+// Hint to the OS that the whole file is about to be read from start to end, so it can start
+// reading pages in ahead of use instead of taking a page fault on each one
+void MappedFile::Prefetch() const
+{
+    if (mData == nullptr)  return;
+
+#ifdef _WIN32
+    WIN32_MEMORY_RANGE_ENTRY range = { const_cast<uint8_t*>(mData), mSize };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    madvise(const_cast<uint8_t*>(mData), mSize, MADV_SEQUENTIAL);
+    madvise(const_cast<uint8_t*>(mData), mSize, MADV_WILLNEED);
+#endif
+}
+
+
+// Unmap the file, pointers returned by Data become invalid
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (mData)     UnmapViewOfFile(mData);
+    if (mMapping)  CloseHandle(mMapping);
+    if (mFile)     CloseHandle(mFile);
+    mFile    = nullptr;
+    mMapping = nullptr;
+#else
+    if (mData)  munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+}
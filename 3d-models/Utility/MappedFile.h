@@ -0,0 +1,55 @@
+//--------------------------------------------------------------------------------------
+// Read-only memory-mapped file
+//--------------------------------------------------------------------------------------
+// Maps an entire file into memory so loaders can read it in place without copying it
+// through stream buffers first. Uses the Win32 file mapping API on Windows and mmap
+// elsewhere, so file parsing code built on top of it can also be run on Linux.
+
+#ifndef _MAPPED_FILE_H_INCLUDED_
+#define _MAPPED_FILE_H_INCLUDED_
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile();
+
+    // A mapping has a single owner
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the given file into memory, returns false on failure
+    // An already open file is closed first
+    bool Open(const std::string& fileName);
+
+    // Unmap the file, pointers returned by Data become invalid
+    void Close();
+
+    bool IsOpen() const  { return mData != nullptr; }
+
+    // Hint to the OS that the whole file is about to be read from start to end, so it can start
+    // reading pages in ahead of use instead of taking a page fault on each one
+    void Prefetch() const;
+
+    // Start of the file contents and size of the file in bytes
+    const uint8_t* Data() const  { return mData; }
+    size_t         Size() const  { return mSize; }
+
+
+private:
+    const uint8_t* mData = nullptr;
+    size_t         mSize = 0;
+
+#ifdef _WIN32
+    // Windows HANDLEs, stored as void* to keep windows.h out of this header
+    void* mFile    = nullptr;
+    void* mMapping = nullptr;
+#endif
+};
+
+
+#endif //_MAPPED_FILE_H_INCLUDED_
@@ -0,0 +1,185 @@
+//--------------------------------------------------------------------------------------
+// Memory-mapped file access for assimp
+//--------------------------------------------------------------------------------------
+
+#include "MappedIOSystem.h"
+#include "MappedFile.h"
+#include "AssetPackage.h" // For PackageAssetName
+
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
+
+
+//--------------------------------------------------------------------------------------
+// Shared state
+//--------------------------------------------------------------------------------------
+// Used by all IO systems and streams, which may be on different threads
+
+namespace
+{
+    struct MemoryFile
+    {
+        const uint8_t* data;
+        size_t         size;
+    };
+
+    std::mutex gMappedIOMutex;
+    std::unordered_map<std::string, MemoryFile> gMemoryFiles;                  // Registered blocks of memory
+    std::unordered_map<std::string, std::weak_ptr<MappedFile>> gMappedFiles;   // Files currently mapped by any open stream
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Stream
+//--------------------------------------------------------------------------------------
+
+// Read-only stream over a block of memory. Holds a reference to the mapping the memory came from (if any)
+// so the file stays mapped while the stream is open
+class MappedIOStream : public Assimp::IOStream
+{
+public:
+    MappedIOStream(std::shared_ptr<MappedFile> file, const uint8_t* data, size_t size)
+        : mFile(std::move(file)), mData(data), mSize(size)
+    {
+    }
+
+    // Copy whole items out of the mapping, like fread
+    size_t Read(void* buffer, size_t size, size_t count) override
+    {
+        if (size == 0 || count == 0)  return 0;
+
+        count = std::min(count, (mSize - mPosition) / size);
+        std::memcpy(buffer, mData + mPosition, count * size);
+        mPosition += count * size;
+        return count;
+    }
+
+    size_t Write(const void*, size_t, size_t) override
+    {
+        return 0;
+    }
+
+    // Note that assimp passes a negative offset (as a size_t) for aiOrigin_END, unsigned wrap-around gives the right result
+    aiReturn Seek(size_t offset, aiOrigin origin) override
+    {
+        size_t position;
+        if      (origin == aiOrigin_SET)  position = offset;
+        else if (origin == aiOrigin_CUR)  position = mPosition + offset;
+        else                              position = mSize + offset;
+
+        if (position > mSize)  return aiReturn_FAILURE;
+        mPosition = position;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override      { return mPosition; }
+    size_t FileSize() const override  { return mSize; }
+    void Flush() override             {}
+
+
+private:
+    std::shared_ptr<MappedFile> mFile;
+    const uint8_t*              mData;
+    size_t                      mSize;
+    size_t                      mPosition = 0;
+};
+
+
+
+//--------------------------------------------------------------------------------------
+// IO system
+//--------------------------------------------------------------------------------------
+
+// Check whether a file exists, either registered in memory or on disk
+bool MappedIOSystem::Exists(const char* file) const
+{
+    {
+        std::lock_guard<std::mutex> lock(gMappedIOMutex);
+        if (gMemoryFiles.count(PackageAssetName(file)) != 0)  return true;
+    }
+
+    struct stat fileStat;
+    return stat(file, &fileStat) == 0;
+}
+
+
+char MappedIOSystem::getOsSeparator() const
+{
+#ifdef _WIN32
+    return '\\';
+#else
+    return '/';
+#endif
+}
+
+
+// Open a file for reading. Writing is not supported and returns nullptr
+Assimp::IOStream* MappedIOSystem::Open(const char* file, const char* mode /*= "rb"*/)
+{
+    if (std::strchr(mode, 'w') != nullptr || std::strchr(mode, 'a') != nullptr || std::strchr(mode, '+') != nullptr)  return nullptr;
+
+    std::string name = PackageAssetName(file);
+    std::lock_guard<std::mutex> lock(gMappedIOMutex);
+
+    // Registered memory is served in place
+    auto memoryFile = gMemoryFiles.find(name);
+    if (memoryFile != gMemoryFiles.end())
+    {
+        return new MappedIOStream(nullptr, memoryFile->second.data, memoryFile->second.size);
+    }
+
+    // Share the mapping if another stream already has this file open
+    std::shared_ptr<MappedFile> mapping = gMappedFiles[name].lock();
+    if (!mapping)
+    {
+        mapping = std::make_shared<MappedFile>();
+        if (!mapping->Open(file))
+        {
+            gMappedFiles.erase(name);
+            return nullptr;
+        }
+        mapping->Prefetch(); // Importers read files from start to end
+        gMappedFiles[name] = mapping;
+    }
+
+    return new MappedIOStream(mapping, mapping->Data(), mapping->Size());
+}
+
+
+void MappedIOSystem::Close(Assimp::IOStream* stream)
+{
+    delete stream; // Last stream to close a file releases the mapping
+
+    // Tidy up entries for mappings that are no longer in use
+    std::lock_guard<std::mutex> lock(gMappedIOMutex);
+    for (auto mappedFile = gMappedFiles.begin(); mappedFile != gMappedFiles.end(); )
+    {
+        if (mappedFile->second.expired())  mappedFile = gMappedFiles.erase(mappedFile);
+        else                               ++mappedFile;
+    }
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Memory files
+//--------------------------------------------------------------------------------------
+
+// Serve the given block of memory as the file with the given name from every MappedIOSystem.
+// The memory is used in place and must remain valid until the file is unregistered.
+void RegisterMemoryFile(const std::string& fileName, const uint8_t* data, size_t size)
+{
+    std::lock_guard<std::mutex> lock(gMappedIOMutex);
+    gMemoryFiles[PackageAssetName(fileName)] = { data, size };
+}
+
+void UnregisterMemoryFile(const std::string& fileName)
+{
+    std::lock_guard<std::mutex> lock(gMappedIOMutex);
+    gMemoryFiles.erase(PackageAssetName(fileName));
+}
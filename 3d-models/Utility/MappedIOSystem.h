@@ -0,0 +1,46 @@
+//--------------------------------------------------------------------------------------
+// Memory-mapped file access for assimp
+//--------------------------------------------------------------------------------------
+// By default assimp reads files with buffered stdio, copying everything through the C
+// runtime's buffers with many read calls. This IO system memory-maps each file instead
+// (with a read-ahead hint) so an import is a single copy straight out of the page cache.
+// Mappings are shared, so concurrent imports of the same file (e.g. in the AssetCooker)
+// map it only once. Blocks of memory can also be registered to be served as files, which
+// lets assimp import directly from memory such as data in an asset package.
+//
+// Usage: importer.SetIOHandler(new MappedIOSystem); - the importer deletes it when finished
+
+#ifndef _MAPPED_IO_SYSTEM_H_INCLUDED_
+#define _MAPPED_IO_SYSTEM_H_INCLUDED_
+
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+
+class MappedIOSystem : public Assimp::IOSystem
+{
+public:
+    // Check whether a file exists, either registered in memory or on disk
+    bool Exists(const char* file) const override;
+
+    char getOsSeparator() const override;
+
+    // Open a file for reading. Writing is not supported and returns nullptr
+    Assimp::IOStream* Open(const char* file, const char* mode = "rb") override;
+
+    void Close(Assimp::IOStream* stream) override;
+};
+
+
+// Serve the given block of memory as the file with the given name from every MappedIOSystem.
+// The memory is used in place and must remain valid until the file is unregistered.
+// Names are matched the same way as asset package names (see PackageAssetName)
+void RegisterMemoryFile(const std::string& fileName, const uint8_t* data, size_t size);
+void UnregisterMemoryFile(const std::string& fileName);
+
+
+#endif //_MAPPED_IO_SYSTEM_H_INCLUDED_
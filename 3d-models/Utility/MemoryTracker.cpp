@@ -0,0 +1,375 @@
+//--------------------------------------------------------------------------------------
+// Memory accounting by category
+//--------------------------------------------------------------------------------------
+
+#include "MemoryTracker.h"
+
+#include <atomic>
+#include <new>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+
+namespace
+{
+    const int NUM_CATEGORIES = static_cast<int>(MemoryCategory::Count);
+    const int NUM_HEAPS      = static_cast<int>(MemoryHeap::Count);
+
+    // Counts for one category on one heap. Kept in static storage, so they are zero before any code runs, including
+    // allocations made by other globals' constructors
+    struct Counter
+    {
+        std::atomic<int64_t>  bytes;
+        std::atomic<int64_t>  peakBytes;
+        std::atomic<uint64_t> allocations;
+        std::atomic<uint64_t> frees;
+        std::atomic<int64_t>  budget;
+        std::atomic<int>      action;
+        std::atomic<bool>     reported; // Over budget has been reported, cleared once back under it
+    };
+    Counter gCounters[NUM_CATEGORIES][NUM_HEAPS];
+
+    Counter& GetCounter(MemoryCategory category, MemoryHeap heap)
+    {
+        return gCounters[static_cast<int>(category)][static_cast<int>(heap)];
+    }
+
+    void Add(Counter& counter, int64_t bytes)
+    {
+        int64_t total = counter.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        int64_t peak  = counter.peakBytes.load(std::memory_order_relaxed);
+        while (total > peak && !counter.peakBytes.compare_exchange_weak(peak, total, std::memory_order_relaxed))  {}
+    }
+
+
+    // Category of CPU allocations made by each thread, see MemoryScope
+    thread_local MemoryCategory tCurrentCategory = MemoryCategory::General;
+
+
+    void LogToStderr(const char* message)
+    {
+        std::fputs(message, stderr);
+    }
+    std::atomic<void (*)(const char*)> gLog{ LogToStderr };
+
+
+    const double MB = 1024.0 * 1024.0;
+}
+
+
+const char* MemoryCategoryName(MemoryCategory category)
+{
+    switch (category)
+    {
+        case MemoryCategory::General:          return "General";
+        case MemoryCategory::Scene:            return "Scene";
+        case MemoryCategory::Meshes:           return "Meshes";
+        case MemoryCategory::MeshStaging:      return "Mesh staging";
+        case MemoryCategory::Textures:         return "Textures";
+        case MemoryCategory::StreamedTextures: return "Streamed textures";
+        case MemoryCategory::ShadowMaps:       return "Shadow maps";
+        case MemoryCategory::ConstantBuffers:  return "Constant buffers";
+        case MemoryCategory::FrameArena:       return "Frame arena";
+        case MemoryCategory::Profiler:         return "Profiler";
+        default:                               return "Unknown";
+    }
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Accounting
+//--------------------------------------------------------------------------------------
+
+// Count memory allocated or freed in a category, e.g. when a GPU resource is created or released. Thread-safe
+void TrackMemory(MemoryCategory category, MemoryHeap heap, size_t bytes)
+{
+    Counter& counter = GetCounter(category, heap);
+    Add(counter, static_cast<int64_t>(bytes));
+    counter.allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UntrackMemory(MemoryCategory category, MemoryHeap heap, size_t bytes)
+{
+    Counter& counter = GetCounter(category, heap);
+    counter.bytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    counter.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+// Set the memory in use in a category directly, for subsystems that keep their own total
+void SetMemoryUsage(MemoryCategory category, MemoryHeap heap, size_t bytes)
+{
+    Counter& counter = GetCounter(category, heap);
+    Add(counter, static_cast<int64_t>(bytes) - counter.bytes.load(std::memory_order_relaxed));
+}
+
+
+// Current counts for a category
+MemoryUsage GetMemoryUsage(MemoryCategory category, MemoryHeap heap)
+{
+    Counter& counter = GetCounter(category, heap);
+    MemoryUsage usage;
+    usage.bytes       = counter.bytes.load(std::memory_order_relaxed);
+    usage.peakBytes   = counter.peakBytes.load(std::memory_order_relaxed);
+    usage.allocations = counter.allocations.load(std::memory_order_relaxed);
+    usage.frees       = counter.frees.load(std::memory_order_relaxed);
+    usage.budget      = counter.budget.load(std::memory_order_relaxed);
+    return usage;
+}
+
+
+// Total memory in use on a heap over all categories
+int64_t TotalMemoryUsage(MemoryHeap heap)
+{
+    int64_t total = 0;
+    for (int category = 0; category < NUM_CATEGORIES; ++category)
+    {
+        total += GetCounter(static_cast<MemoryCategory>(category), heap).bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+
+// Start measuring the peak of a category again from its current use, e.g. to find the peak of one operation
+void ResetMemoryPeak(MemoryCategory category, MemoryHeap heap)
+{
+    Counter& counter = GetCounter(category, heap);
+    counter.peakBytes.store(counter.bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+
+MemoryScope::MemoryScope(MemoryCategory category)
+    : mPrevious(tCurrentCategory)
+{
+    tCurrentCategory = category;
+}
+
+MemoryScope::~MemoryScope()
+{
+    tCurrentCategory = mPrevious;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Budgets and report
+//--------------------------------------------------------------------------------------
+
+// Set the budget of a category on a heap in bytes, 0 for no budget
+void SetMemoryBudget(MemoryCategory category, MemoryHeap heap, size_t bytes, BudgetAction action /*= BudgetAction::Log*/)
+{
+    Counter& counter = GetCounter(category, heap);
+    counter.budget.store(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    counter.action.store(static_cast<int>(action), std::memory_order_relaxed);
+    counter.reported.store(false, std::memory_order_relaxed);
+}
+
+
+// Function used to log budget messages, by default they are written to stderr
+void SetMemoryLog(void (*log)(const char* message))
+{
+    gLog.store(log != nullptr ? log : LogToStderr);
+}
+
+
+// Log (or assert) for each budget that has been exceeded since the last call. Call once a frame from one thread. Each
+// budget is only reported again once its category has gone back under it. Returns false if any budget is exceeded
+bool CheckMemoryBudgets()
+{
+    bool withinBudgets = true;
+    for (int category = 0; category < NUM_CATEGORIES; ++category)
+    {
+        for (int heap = 0; heap < NUM_HEAPS; ++heap)
+        {
+            Counter& counter = gCounters[category][heap];
+            int64_t budget = counter.budget.load(std::memory_order_relaxed);
+            int64_t bytes  = counter.bytes.load(std::memory_order_relaxed);
+            if (budget <= 0 || bytes <= budget)
+            {
+                counter.reported.store(false, std::memory_order_relaxed);
+                continue;
+            }
+
+            withinBudgets = false;
+            if (counter.reported.exchange(true, std::memory_order_relaxed))  continue;
+
+            // Formatted into a fixed buffer so the check itself doesn't allocate
+            char message[256];
+            std::snprintf(message, sizeof(message), "Memory budget exceeded: %s (%s) is using %.2fMB of its %.2fMB budget\n",
+                          MemoryCategoryName(static_cast<MemoryCategory>(category)), heap == 0 ? "CPU" : "GPU", bytes / MB, budget / MB);
+            gLog.load()(message);
+            assert(counter.action.load(std::memory_order_relaxed) != static_cast<int>(BudgetAction::Assert) && "Memory budget exceeded");
+        }
+    }
+    return withinBudgets;
+}
+
+
+// A table of the memory used by each category on each heap, with peaks and budgets
+std::string MemoryReport()
+{
+    std::string report;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-18s %-4s %10s %10s %10s %12s %12s\n", "Category", "Heap", "MB", "Peak MB", "Budget MB", "Allocations", "Frees");
+    report += line;
+    for (int heap = 0; heap < NUM_HEAPS; ++heap)
+    {
+        for (int category = 0; category < NUM_CATEGORIES; ++category)
+        {
+            MemoryUsage usage = GetMemoryUsage(static_cast<MemoryCategory>(category), static_cast<MemoryHeap>(heap));
+            if (usage.allocations == 0 && usage.peakBytes == 0 && usage.budget == 0)  continue;
+
+            char budget[32] = "-";
+            if (usage.budget > 0)  std::snprintf(budget, sizeof(budget), "%.2f%s", usage.budget / MB, usage.bytes > usage.budget ? "!" : "");
+            std::snprintf(line, sizeof(line), "%-18s %-4s %10.2f %10.2f %10s %12llu %12llu\n",
+                          MemoryCategoryName(static_cast<MemoryCategory>(category)), heap == 0 ? "CPU" : "GPU", usage.bytes / MB,
+                          usage.peakBytes / MB, budget, static_cast<unsigned long long>(usage.allocations),
+                          static_cast<unsigned long long>(usage.frees));
+            report += line;
+        }
+        std::snprintf(line, sizeof(line), "%-18s %-4s %10.2f\n", "Total", heap == 0 ? "CPU" : "GPU",
+                      TotalMemoryUsage(static_cast<MemoryHeap>(heap)) / MB);
+        report += line;
+    }
+    return report;
+}
+
+
+// Write the report to a text file. Returns false on failure
+bool WriteMemoryReport(const std::string& fileName)
+{
+    std::ofstream file(fileName);
+    if (!file.is_open())  return false;
+    file << MemoryReport();
+    return !file.fail();
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Process memory
+//--------------------------------------------------------------------------------------
+
+// Most physical memory the whole process has used at once so far (peak working set or resident set size), in bytes.
+// Unlike the categories this includes memory other modules allocate themselves, such as a DLL's own heap, and mapped
+// files. It can't be reset, so an operation only raises it if it needs more than anything before it. 0 on failure
+size_t ProcessPeakMemory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS memory = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory)))  return 0;
+    return memory.PeakWorkingSetSize;
+#else
+    rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)  return 0;
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // In kilobytes on Linux
+#endif
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Global operator new and delete
+//--------------------------------------------------------------------------------------
+#if MEMORY_TRACKING
+
+namespace
+{
+    // Put in front of every allocation, so a free knows the size and category of what it frees
+    struct AllocationHeader
+    {
+        size_t   size;
+        uint32_t offset;   // From the start of the memory given by malloc to the allocation
+        uint16_t category;
+        uint16_t check;    // Catches memory from somewhere else being freed here
+    };
+    const uint16_t HEADER_CHECK = 0xA110;
+
+    // Rounded up so allocations keep the alignment given by malloc
+    const size_t HEADER_SIZE = (sizeof(AllocationHeader) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    void* TrackedAllocate(size_t size, size_t alignment)
+    {
+        // Memory from malloc is aligned for any standard type, more alignment needs extra space to move the start along
+        size_t extra = alignment > alignof(std::max_align_t) ? alignment - 1 : 0;
+        char* memory = static_cast<char*>(std::malloc(size + HEADER_SIZE + extra));
+        if (memory == nullptr)  return nullptr;
+
+        uintptr_t start = reinterpret_cast<uintptr_t>(memory) + HEADER_SIZE;
+        if (extra > 0)  start = (start + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        char* allocation = reinterpret_cast<char*>(start);
+
+        MemoryCategory category = tCurrentCategory;
+        AllocationHeader* header = reinterpret_cast<AllocationHeader*>(allocation) - 1;
+        header->size     = size;
+        header->offset   = static_cast<uint32_t>(allocation - memory);
+        header->category = static_cast<uint16_t>(category);
+        header->check    = HEADER_CHECK;
+
+        TrackMemory(category, MemoryHeap::CPU, size);
+        return allocation;
+    }
+
+    void TrackedFree(void* allocation)
+    {
+        if (allocation == nullptr)  return;
+
+        AllocationHeader* header = static_cast<AllocationHeader*>(allocation) - 1;
+        if (header->check != HEADER_CHECK)  std::abort(); // Not allocated by TrackedAllocate, the heap is corrupt
+        header->check = 0;
+
+        UntrackMemory(static_cast<MemoryCategory>(header->category), MemoryHeap::CPU, header->size);
+        std::free(static_cast<char*>(allocation) - header->offset);
+    }
+
+    void* AllocateOrThrow(size_t size, size_t alignment)
+    {
+        // As the standard operator new, call the new handler until the allocation succeeds or there is no handler
+        for (;;)
+        {
+            void* allocation = TrackedAllocate(size, alignment);
+            if (allocation != nullptr)  return allocation;
+
+            std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr)  throw std::bad_alloc();
+            handler();
+        }
+    }
+}
+
+void* operator new  (size_t size)                                   { return AllocateOrThrow(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size)                                   { return AllocateOrThrow(size, alignof(std::max_align_t)); }
+void* operator new  (size_t size, const std::nothrow_t&) noexcept   { return TrackedAllocate(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept   { return TrackedAllocate(size, alignof(std::max_align_t)); }
+void* operator new  (size_t size, std::align_val_t alignment)       { return AllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment)       { return AllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new  (size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept  { return TrackedAllocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept  { return TrackedAllocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete  (void* allocation) noexcept                                          { TrackedFree(allocation); }
+void operator delete[](void* allocation) noexcept                                          { TrackedFree(allocation); }
+void operator delete  (void* allocation, size_t) noexcept                                  { TrackedFree(allocation); }
+void operator delete[](void* allocation, size_t) noexcept                                  { TrackedFree(allocation); }
+void operator delete  (void* allocation, const std::nothrow_t&) noexcept                   { TrackedFree(allocation); }
+void operator delete[](void* allocation, const std::nothrow_t&) noexcept                   { TrackedFree(allocation); }
+void operator delete  (void* allocation, std::align_val_t) noexcept                        { TrackedFree(allocation); }
+void operator delete[](void* allocation, std::align_val_t) noexcept                        { TrackedFree(allocation); }
+void operator delete  (void* allocation, size_t, std::align_val_t) noexcept                { TrackedFree(allocation); }
+void operator delete[](void* allocation, size_t, std::align_val_t) noexcept                { TrackedFree(allocation); }
+void operator delete  (void* allocation, std::align_val_t, const std::nothrow_t&) noexcept { TrackedFree(allocation); }
+void operator delete[](void* allocation, std::align_val_t, const std::nothrow_t&) noexcept { TrackedFree(allocation); }
+
+#endif
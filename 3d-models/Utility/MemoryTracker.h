@@ -0,0 +1,134 @@
+//--------------------------------------------------------------------------------------
+// Memory accounting by category
+//--------------------------------------------------------------------------------------
+// Counts the memory used by each part of the app (meshes, textures, shadow maps...) on the CPU
+// heap, through replaced operator new and delete and the thread's MemoryScope, and on the GPU,
+// where the code creating a resource reports it with TrackMemory. Each category can have a
+// budget for each heap, checked once a frame by CheckMemoryBudgets.
+
+#ifndef _MEMORY_TRACKER_H_INCLUDED_
+#define _MEMORY_TRACKER_H_INCLUDED_
+
+// Build with MEMORY_TRACKING defined as 0 to leave operator new and delete alone (the GPU accounting still works)
+#ifndef MEMORY_TRACKING
+#define MEMORY_TRACKING 1
+#endif
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+
+enum class MemoryCategory
+{
+    General,        // Anything not in a more specific category
+    Scene,          // Models, cameras and other scene objects
+    Meshes,         // Mesh objects and their vertex and index buffers
+    MeshStaging,    // CPU-side copies of mesh data while a mesh is being imported
+    Textures,       // Textures loaded whole
+    StreamedTextures,
+    ShadowMaps,
+    ConstantBuffers,
+    FrameArena,     // Temporary per-frame data, see Allocators.h
+    Profiler,
+    Count,
+};
+
+enum class MemoryHeap
+{
+    CPU,
+    GPU,
+    Count,
+};
+
+const char* MemoryCategoryName(MemoryCategory category);
+
+
+// What to do when a category goes over its budget
+enum class BudgetAction
+{
+    Log,    // Log a message
+    Assert, // Log a message, then stop the app in debug builds
+};
+
+
+// Memory counts of a category on one heap
+struct MemoryUsage
+{
+    int64_t  bytes;       // In use now
+    int64_t  peakBytes;   // Most in use at once
+    uint64_t allocations; // Number of allocations (or resources created) so far
+    uint64_t frees;
+    int64_t  budget;      // 0 if there is no budget
+};
+
+
+//--------------------------------------------------------------------------------------
+// Accounting
+//--------------------------------------------------------------------------------------
+
+// Count memory allocated or freed in a category, e.g. when a GPU resource is created or released. Thread-safe
+void TrackMemory(MemoryCategory category, MemoryHeap heap, size_t bytes);
+void UntrackMemory(MemoryCategory category, MemoryHeap heap, size_t bytes);
+
+// Set the memory in use in a category directly, for subsystems that keep their own total
+void SetMemoryUsage(MemoryCategory category, MemoryHeap heap, size_t bytes);
+
+// Current counts for a category
+MemoryUsage GetMemoryUsage(MemoryCategory category, MemoryHeap heap);
+
+// Total memory in use on a heap over all categories
+int64_t TotalMemoryUsage(MemoryHeap heap);
+
+// Start measuring the peak of a category again from its current use, e.g. to find the peak of one operation
+void ResetMemoryPeak(MemoryCategory category, MemoryHeap heap);
+
+
+// CPU heap allocations made by the current thread while one of these exists are counted against its category. Scopes
+// can be nested, the innermost one is used
+class MemoryScope
+{
+public:
+    explicit MemoryScope(MemoryCategory category);
+    ~MemoryScope();
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    MemoryCategory mPrevious;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Budgets and report
+//--------------------------------------------------------------------------------------
+
+// Set the budget of a category on a heap in bytes, 0 for no budget
+void SetMemoryBudget(MemoryCategory category, MemoryHeap heap, size_t bytes, BudgetAction action = BudgetAction::Log);
+
+// Function used to log budget messages, by default they are written to stderr
+void SetMemoryLog(void (*log)(const char* message));
+
+// Log (or assert) for each budget that has been exceeded since the last call. Call once a frame from one thread. Each
+// budget is only reported again once its category has gone back under it. Returns false if any budget is exceeded
+bool CheckMemoryBudgets();
+
+// A table of the memory used by each category on each heap, with peaks and budgets
+std::string MemoryReport();
+
+// Write the report to a text file. Returns false on failure
+bool WriteMemoryReport(const std::string& fileName);
+
+
+//--------------------------------------------------------------------------------------
+// Process memory
+//--------------------------------------------------------------------------------------
+
+// Most physical memory the whole process has used at once so far (peak working set or resident set size), in bytes.
+// Unlike the categories this includes memory other modules allocate themselves, such as a DLL's own heap, and mapped
+// files. It can't be reset, so an operation only raises it if it needs more than anything before it. 0 on failure
+size_t ProcessPeakMemory();
+
+
+#endif //_MEMORY_TRACKER_H_INCLUDED_
@@ -0,0 +1,302 @@
+//--------------------------------------------------------------------------------------
+// CPU mip-map generation for 8-bit RGBA images
+//--------------------------------------------------------------------------------------
+
+#include "MipGenerator.h"
+
+#include <emmintrin.h> // SSE2
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cmath>
+
+
+namespace
+{
+    //--------------------------------------------------------------------------------------
+    // Filters
+    //--------------------------------------------------------------------------------------
+
+    const float PI = 3.14159265358979f;
+    const float SINC_RADIUS  = 3.0f; // Radius of the windowed sinc filters in destination pixels
+    const float KAISER_ALPHA = 4.0f; // Kaiser window shape, higher values give less ringing but more blur
+
+    float Sinc(float x)
+    {
+        if (std::fabs(x) < 1e-6f)  return 1.0f;
+        return std::sin(PI * x) / (PI * x);
+    }
+
+    // Modified Bessel function of the first kind (order 0), used by the Kaiser window
+    float BesselI0(float x)
+    {
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 20; ++k)
+        {
+            term *= (x * 0.5f / k) * (x * 0.5f / k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Filter value at distance x, measured in destination pixels
+    float FilterWeight(MipFilter filter, float x)
+    {
+        x = std::fabs(x);
+        if (filter == MipFilter::Box)
+        {
+            if (x < 0.5f)   return 1.0f;
+            if (x == 0.5f)  return 0.5f; // Source pixels exactly on the boundary are shared
+            return 0.0f;
+        }
+
+        if (x >= SINC_RADIUS)  return 0.0f;
+        if (filter == MipFilter::Lanczos)  return Sinc(x) * Sinc(x / SINC_RADIUS);
+
+        float ratio = x / SINC_RADIUS;
+        return Sinc(x) * BesselI0(KAISER_ALPHA * std::sqrt(1.0f - ratio * ratio)) / BesselI0(KAISER_ALPHA);
+    }
+
+    float FilterRadius(MipFilter filter)
+    {
+        return filter == MipFilter::Box ? 0.5f : SINC_RADIUS;
+    }
+
+
+    // The source pixels and their weights that make up one destination pixel along one axis. Source positions past the
+    // edges are clamped to the edge pixel
+    struct FilterTap
+    {
+        uint32_t source;
+        float    weight;
+    };
+
+    // Taps for each destination pixel along an axis, shrinking sourceSize pixels to destSize
+    void BuildTaps(MipFilter filter, uint32_t sourceSize, uint32_t destSize, std::vector<std::vector<FilterTap>>& taps)
+    {
+        float scale = static_cast<float>(sourceSize) / destSize;
+        float radius = FilterRadius(filter) * scale;
+
+        taps.resize(destSize);
+        for (uint32_t dest = 0; dest < destSize; ++dest)
+        {
+            taps[dest].clear();
+            float centre = (dest + 0.5f) * scale;
+            int first = static_cast<int>(std::floor(centre - radius));
+            int last  = static_cast<int>(std::ceil(centre + radius));
+
+            float total = 0.0f;
+            for (int source = first; source <= last; ++source)
+            {
+                float weight = FilterWeight(filter, (source + 0.5f - centre) / scale);
+                if (weight == 0.0f)  continue;
+                int clamped = std::min(static_cast<int>(sourceSize) - 1, std::max(0, source));
+                taps[dest].push_back({ static_cast<uint32_t>(clamped), weight });
+                total += weight;
+            }
+            for (auto& tap : taps[dest])  tap.weight /= total;
+        }
+    }
+
+
+
+    //--------------------------------------------------------------------------------------
+    // Pixel conversion
+    //--------------------------------------------------------------------------------------
+
+    float SRGBToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSRGB(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    uint8_t ToByte(float value)
+    {
+        return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, value * 255.0f + 0.5f)));
+    }
+
+
+    // Float images use four floats per pixel (RGBA) so each pixel loads into one SSE register
+    struct FloatImage
+    {
+        uint32_t           width;
+        uint32_t           height;
+        std::vector<float> pixels;
+
+        float* Row(uint32_t y)  { return pixels.data() + static_cast<size_t>(y) * width * 4; }
+    };
+
+
+    // Call function(row) for every row, spread over threads in bands of rows, which keeps each thread working on
+    // neighbouring memory and keeps the shared counter out of the inner loop
+    template <class Function>
+    void ForEachRow(uint32_t numRows, unsigned int numThreads, Function function)
+    {
+        const uint32_t BAND_ROWS = 16;
+        uint32_t numBands = (numRows + BAND_ROWS - 1) / BAND_ROWS;
+        numThreads = std::max(1u, std::min(numThreads, numBands));
+
+        std::atomic<uint32_t> nextBand(0);
+        auto worker = [&]()
+        {
+            for (uint32_t band = nextBand++; band < numBands; band = nextBand++)
+            {
+                uint32_t end = std::min(numRows, (band + 1) * BAND_ROWS);
+                for (uint32_t row = band * BAND_ROWS; row < end; ++row)  function(row);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int thread = 1; thread < numThreads; ++thread)  threads.emplace_back(worker);
+        worker();
+        for (auto& thread : threads)  thread.join();
+    }
+
+
+    // Filter the source image down to the size of the destination image, horizontally then vertically
+    void Downsample(FloatImage& source, FloatImage& dest, MipFilter filter, unsigned int numThreads)
+    {
+        std::vector<std::vector<FilterTap>> columnTaps, rowTaps;
+        BuildTaps(filter, source.width,  dest.width,  columnTaps);
+        BuildTaps(filter, source.height, dest.height, rowTaps);
+
+        FloatImage temp;
+        temp.width  = dest.width;
+        temp.height = source.height;
+        temp.pixels.resize(static_cast<size_t>(temp.width) * temp.height * 4);
+
+        ForEachRow(source.height, numThreads, [&](uint32_t y)
+        {
+            const float* in = source.Row(y);
+            float* out = temp.Row(y);
+            for (uint32_t x = 0; x < dest.width; ++x, out += 4)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (auto& tap : columnTaps[x])
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(in + tap.source * 4), _mm_set1_ps(tap.weight)));
+                }
+                _mm_storeu_ps(out, sum);
+            }
+        });
+
+        ForEachRow(dest.height, numThreads, [&](uint32_t y)
+        {
+            float* out = dest.Row(y);
+            for (uint32_t x = 0; x < dest.width; ++x, out += 4)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (auto& tap : rowTaps[y])
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(temp.Row(tap.source) + x * 4), _mm_set1_ps(tap.weight)));
+                }
+                // Sinc filters have negative lobes, which can push values out of range
+                sum = _mm_min_ps(_mm_max_ps(sum, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                _mm_storeu_ps(out, sum);
+            }
+        });
+    }
+
+
+
+    //--------------------------------------------------------------------------------------
+    // Alpha coverage
+    //--------------------------------------------------------------------------------------
+
+    // Proportion of pixels whose alpha (multiplied by scale) passes an alpha test against the reference
+    float AlphaCoverage(const FloatImage& image, float reference, float scale)
+    {
+        size_t passed = 0;
+        size_t numPixels = static_cast<size_t>(image.width) * image.height;
+        for (size_t pixel = 0; pixel < numPixels; ++pixel)
+        {
+            if (image.pixels[pixel * 4 + 3] * scale > reference)  ++passed;
+        }
+        return static_cast<float>(passed) / numPixels;
+    }
+
+    // The alpha scale that gives a mip level the target coverage (coverage only increases with scale, so binary search)
+    float FindAlphaScale(const FloatImage& image, float reference, float targetCoverage)
+    {
+        float low = 0.0f, high = 4.0f;
+        for (int iteration = 0; iteration < 12; ++iteration)
+        {
+            float middle = (low + high) * 0.5f;
+            if (AlphaCoverage(image, reference, middle) < targetCoverage)  low = middle;
+            else                                                          high = middle;
+        }
+        return (low + high) * 0.5f;
+    }
+}
+
+
+// Generate the full mip chain (down to 1x1) for an image of 8-bit RGBA pixels. The first level is a copy of the image
+void GenerateMips(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch, const MipOptions& options,
+                  std::vector<MipLevel>& mips)
+{
+    mips.clear();
+
+    // The top level is the image itself
+    mips.push_back({ width, height, std::vector<uint8_t>(static_cast<size_t>(width) * height * 4) });
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        std::copy(pixels + static_cast<size_t>(y) * rowPitch, pixels + static_cast<size_t>(y) * rowPitch + width * 4,
+                  mips[0].pixels.data() + static_cast<size_t>(y) * width * 4);
+    }
+
+    // Convert to floating point, in linear space for sRGB images
+    float byteToFloat[256];
+    for (int i = 0; i < 256; ++i)  byteToFloat[i] = options.sRGB ? SRGBToLinear(i / 255.0f) : i / 255.0f;
+
+    FloatImage source;
+    source.width  = width;
+    source.height = height;
+    source.pixels.resize(static_cast<size_t>(width) * height * 4);
+    ForEachRow(height, options.numThreads, [&](uint32_t y)
+    {
+        const uint8_t* in = mips[0].pixels.data() + static_cast<size_t>(y) * width * 4;
+        float* out = source.Row(y);
+        for (uint32_t x = 0; x < width * 4; x += 4)
+        {
+            out[x + 0] = byteToFloat[in[x + 0]];
+            out[x + 1] = byteToFloat[in[x + 1]];
+            out[x + 2] = byteToFloat[in[x + 2]];
+            out[x + 3] = in[x + 3] / 255.0f; // Alpha is always linear
+        }
+    });
+
+    float targetCoverage = options.preserveAlphaCoverage ? AlphaCoverage(source, options.alphaReference, 1.0f) : 0.0f;
+
+
+    // Each level is filtered from the one before
+    while (source.width > 1 || source.height > 1)
+    {
+        FloatImage dest;
+        dest.width  = std::max(1u, source.width  / 2);
+        dest.height = std::max(1u, source.height / 2);
+        dest.pixels.resize(static_cast<size_t>(dest.width) * dest.height * 4);
+        Downsample(source, dest, options.filter, options.numThreads);
+
+        float alphaScale = 1.0f;
+        if (options.preserveAlphaCoverage)  alphaScale = FindAlphaScale(dest, options.alphaReference, targetCoverage);
+
+        MipLevel mip = { dest.width, dest.height, std::vector<uint8_t>(static_cast<size_t>(dest.width) * dest.height * 4) };
+        ForEachRow(dest.height, options.numThreads, [&](uint32_t y)
+        {
+            const float* in = dest.Row(y);
+            uint8_t* out = mip.pixels.data() + static_cast<size_t>(y) * dest.width * 4;
+            for (uint32_t x = 0; x < dest.width * 4; x += 4)
+            {
+                for (int c = 0; c < 3; ++c)  out[x + c] = ToByte(options.sRGB ? LinearToSRGB(in[x + c]) : in[x + c]);
+                out[x + 3] = ToByte(in[x + 3] * alphaScale);
+            }
+        });
+        mips.push_back(std::move(mip));
+
+        source = std::move(dest);
+    }
+}
@@ -0,0 +1,49 @@
+//--------------------------------------------------------------------------------------
+// CPU mip-map generation for 8-bit RGBA images
+//--------------------------------------------------------------------------------------
+// Each mip level is filtered down from the previous one with a separable filter on float
+// pixels (linear space for sRGB images), one SSE vector per pixel with rows spread over
+// threads. Used by the AssetCooker so the work is done once rather than on every load.
+
+#ifndef _MIP_GENERATOR_H_INCLUDED_
+#define _MIP_GENERATOR_H_INCLUDED_
+
+#include <vector>
+#include <cstdint>
+
+
+enum class MipFilter
+{
+    Box,     // Average of each 2x2 block of pixels - fast but blurs and aliases the most
+    Kaiser,  // Kaiser windowed sinc (radius 3), sharp with little ringing
+    Lanczos, // Lanczos-3 windowed sinc, the sharpest but may ring around hard edges
+};
+
+struct MipOptions
+{
+    MipFilter    filter    = MipFilter::Kaiser;
+    bool         sRGB      = true;  // Colours are sRGB encoded (i.e. normal images) and are filtered in linear space
+
+    // Scale the alpha of each mip so the same proportion of pixels pass an alpha test against alphaReference as in the
+    // top level. Stops alpha tested details (or shiny areas of specular maps) fading away in the distance
+    bool         preserveAlphaCoverage = false;
+    float        alphaReference        = 0.5f;
+
+    unsigned int numThreads = 1;
+};
+
+// One mip level of tightly packed 8-bit RGBA pixels
+struct MipLevel
+{
+    uint32_t             width;
+    uint32_t             height;
+    std::vector<uint8_t> pixels;
+};
+
+
+// Generate the full mip chain (down to 1x1) for an image of 8-bit RGBA pixels. The first level is a copy of the image
+void GenerateMips(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch, const MipOptions& options,
+                  std::vector<MipLevel>& mips);
+
+
+#endif //_MIP_GENERATOR_H_INCLUDED_
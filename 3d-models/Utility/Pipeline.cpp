@@ -0,0 +1,124 @@
+//--------------------------------------------------------------------------------------
+// Pipelined simulation and rendering
+//--------------------------------------------------------------------------------------
+
+#include "Pipeline.h"
+#include "Profiler.h"
+
+
+//--------------------------------------------------------------------------------------
+// Checks
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+    std::mutex  gCheckMutex;
+    std::string gCheckFailure;
+}
+
+// Record a failed check. Only the first failure is kept, it is the one most likely to show the cause
+void PipelineCheckFailed(const char* message)
+{
+    std::lock_guard<std::mutex> lock(gCheckMutex);
+    if (gCheckFailure.empty())  gCheckFailure = message;
+}
+
+// The first failed check, or an empty string if none have failed
+std::string PipelineCheckFailure()
+{
+    std::lock_guard<std::mutex> lock(gCheckMutex);
+    return gCheckFailure;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Simulation thread
+//--------------------------------------------------------------------------------------
+
+// Start the worker thread. If pipelined is false there is no worker and Run does the jobs straight away
+void SimulationThread::Start(bool pipelined /*= true*/)
+{
+    if (Pipelined() || !pipelined)  return;
+
+    mStop = false;
+    mThread = std::thread(&SimulationThread::WorkerThread, this);
+}
+
+
+// Wait for any job to finish and stop the worker thread
+void SimulationThread::Stop()
+{
+    Wait();
+    if (!Pipelined())  return;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mJobReady.notify_one();
+    mThread.join();
+}
+
+
+// Start a job, which runs on the worker thread if pipelined. Call Wait before running another job
+void SimulationThread::Run(std::function<void()> job)
+{
+    PIPELINE_CHECK(!Busy(), "Simulation job started before the last one was waited for");
+    Wait();
+
+    mBusy.store(true, std::memory_order_release);
+    if (!Pipelined())
+    {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJob    = std::move(job);
+        mHasJob = true;
+    }
+    mJobReady.notify_one();
+}
+
+
+// Wait for the current job to finish
+void SimulationThread::Wait()
+{
+    if (!Busy())  return;
+
+    if (Pipelined())
+    {
+        PROFILE_ZONE("Wait for simulation");
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJobDone.wait(lock, [this] { return !mHasJob; });
+    }
+    mBusy.store(false, std::memory_order_release);
+}
+
+
+// Run jobs until stopped
+void SimulationThread::WorkerThread()
+{
+    PROFILE_THREAD_NAME("Simulation");
+
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobReady.wait(lock, [this] { return mHasJob || mStop; });
+            if (mStop)  return;
+            job = std::move(mJob);
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mHasJob = false;
+        }
+        mJobDone.notify_one();
+    }
+}
@@ -0,0 +1,162 @@
+//--------------------------------------------------------------------------------------
+// Pipelined simulation and rendering
+//--------------------------------------------------------------------------------------
+// The next frame's simulation runs on a worker thread while the main thread renders the
+// current one. The simulation writes everything rendering needs into a snapshot and the
+// renderer only reads the latest complete one, handed over by SnapshotBuffer. With
+// PIPELINE_CHECKS on (debug builds) the hand-off and uses of the live simulation are checked.
+
+#ifndef _PIPELINE_H_INCLUDED_
+#define _PIPELINE_H_INCLUDED_
+
+#ifndef PIPELINE_CHECKS
+#if defined(_DEBUG) || !defined(NDEBUG)
+#define PIPELINE_CHECKS 1
+#else
+#define PIPELINE_CHECKS 0
+#endif
+#endif
+
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------------
+// Checks
+//--------------------------------------------------------------------------------------
+
+// Record a failed check. Only the first failure is kept, it is the one most likely to show the cause
+void PipelineCheckFailed(const char* message);
+
+// The first failed check, or an empty string if none have failed
+std::string PipelineCheckFailure();
+
+#if PIPELINE_CHECKS
+#define PIPELINE_CHECK(condition, message)   ((condition) ? (void)0 : PipelineCheckFailed(message))
+#else
+#define PIPELINE_CHECK(condition, message)   ((void)0)
+#endif
+
+
+
+//--------------------------------------------------------------------------------------
+// Snapshot buffer
+//--------------------------------------------------------------------------------------
+
+// NumBuffers copies of a snapshot, written by one thread and read by another. The writer fills a buffer and publishes
+// it, the reader always gets the latest published buffer. Two buffers are enough when the threads take turns each frame,
+// with three the writer never has to wait for the reader
+template <class T, int NumBuffers = 2>
+class SnapshotBuffer
+{
+    static_assert(NumBuffers >= 2, "Snapshots need at least two buffers");
+
+public:
+    // Get a buffer to fill, which is neither the one being read nor the latest one
+    T& BeginWrite()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        PIPELINE_CHECK(mWriting < 0, "Snapshot written twice at once");
+        int buffer = 0;
+        while (buffer < NumBuffers && (buffer == mReading || buffer == mLatest))  ++buffer;
+        PIPELINE_CHECK(buffer < NumBuffers, "No free snapshot to write, the reader has not finished with the oldest");
+        mWriting = buffer < NumBuffers ? buffer : (mLatest + 1) % NumBuffers;
+        return mBuffers[mWriting];
+    }
+
+    // Publish the buffer being written, the next read will get it
+    void EndWrite()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        PIPELINE_CHECK(mWriting >= 0, "Snapshot published without being written");
+        mLatest  = mWriting;
+        mWriting = -1;
+    }
+
+
+    // Get the latest published buffer, which stays unchanged until EndRead
+    const T& BeginRead()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        PIPELINE_CHECK(mReading < 0, "Snapshot read twice at once");
+        PIPELINE_CHECK(mLatest >= 0, "Snapshot read before one was published");
+        mReading = mLatest >= 0 ? mLatest : 0;
+        return mBuffers[mReading];
+    }
+
+    void EndRead()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        PIPELINE_CHECK(mReading >= 0, "Snapshot read finished without being started");
+        mReading = -1;
+    }
+
+
+private:
+    T          mBuffers[NumBuffers];
+    std::mutex mMutex;        // Protects the indices below, which are only changed at the start and end of a frame
+    int        mWriting = -1; // Buffer indices, -1 for none
+    int        mReading = -1;
+    int        mLatest  = -1;
+};
+
+
+
+//--------------------------------------------------------------------------------------
+// Simulation thread
+//--------------------------------------------------------------------------------------
+
+// Runs one job at a time on a worker thread, e.g. the simulation steps of a frame. Can also run the jobs on the calling
+// thread instead, to compare the frame times of the two
+class SimulationThread
+{
+public:
+    ~SimulationThread()  { Stop(); }
+
+    // Start the worker thread. If pipelined is false there is no worker and Run does the jobs straight away
+    void Start(bool pipelined = true);
+
+    // Wait for any job to finish and stop the worker thread
+    void Stop();
+
+
+    // Start a job, which runs on the worker thread if pipelined. Call Wait before running another job
+    void Run(std::function<void()> job);
+
+    // Wait for the current job to finish
+    void Wait();
+
+
+    // A job has been started and not waited for, so the simulation state is not safe to use
+    bool Busy()  { return mBusy.load(std::memory_order_acquire); }
+
+    bool Pipelined()  { return mThread.joinable(); }
+
+    // The calling thread is the worker thread
+    bool OnWorkerThread()  { return Pipelined() && std::this_thread::get_id() == mThread.get_id(); }
+
+
+private:
+    void WorkerThread();
+
+    std::thread             mThread;
+    std::mutex              mMutex;
+    std::condition_variable mJobReady;
+    std::condition_variable mJobDone;
+    std::function<void()>   mJob;         // Protected by the mutex
+    bool                    mHasJob = false;
+    bool                    mStop   = false;
+    std::atomic<bool>       mBusy{false};
+};
+
+
+// The worker thread running the simulation in the app
+extern SimulationThread gSimulationThread;
+
+
+#endif //_PIPELINE_H_INCLUDED_
@@ -0,0 +1,289 @@
+//--------------------------------------------------------------------------------------
+// Hierarchical CPU profiler
+//--------------------------------------------------------------------------------------
+
+#include "Profiler.h"
+#include "MemoryTracker.h"
+
+#include <fstream>
+#include <map>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+
+
+namespace
+{
+    bool SameName(const char* a, const char* b)
+    {
+        return a == b || std::strcmp(a, b) == 0;
+    }
+
+    // Write text as a JSON string, escaping the characters that need it
+    void WriteJSONString(std::ofstream& file, const std::string& text)
+    {
+        file << '"';
+        for (char c : text)
+        {
+            if      (c == '"' || c == '\\')  file << '\\' << c;
+            else if (c == '\n')              file << "\\n";
+            else if (static_cast<unsigned char>(c) >= 0x20)  file << c;
+        }
+        file << '"';
+    }
+
+    void WriteBinaryString(std::ofstream& file, const std::string& text)
+    {
+        uint32_t length = static_cast<uint32_t>(text.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(text.data(), length);
+    }
+}
+
+
+Profiler::Profiler()
+{
+    mFrameStart = ProfilerTicks();
+}
+
+
+Profiler& Profiler::Instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+
+ProfileThread* Profiler::RegisterThread()
+{
+    MemoryScope memoryScope(MemoryCategory::Profiler); // The thread's zone buffers
+    std::lock_guard<std::mutex> lock(mThreadsMutex);
+    uint32_t index = static_cast<uint32_t>(mThreads.size());
+    mThreads.push_back(std::make_unique<ProfileThread>(index, "Thread " + std::to_string(index)));
+    return mThreads.back().get();
+}
+
+
+// Name the calling thread in captures (threads are otherwise "Thread n")
+void Profiler::SetThreadName(const std::string& name)
+{
+    ProfileThread& thread = ThisThread();
+    std::lock_guard<std::mutex> lock(mThreadsMutex);
+    thread.SetName(name);
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Frame collection
+//--------------------------------------------------------------------------------------
+
+// Collect the zones recorded by every thread since the last call and make them the last frame. Call once per frame
+// on the main thread
+void Profiler::EndFrame()
+{
+    MemoryScope memoryScope(MemoryCategory::Profiler); // Last frame and capture lists
+    uint64_t frameEnd = ProfilerTicks();
+
+    std::vector<ProfileThread*>& threads = mDrainThreads;
+    {
+        std::lock_guard<std::mutex> lock(mThreadsMutex);
+        threads.clear();
+        for (auto& thread : mThreads)  threads.push_back(thread.get());
+    }
+
+    bool capturing = Capturing();
+    if (capturing && mCaptureFrames.empty())  mCaptureFrames.push_back(mFrameStart);
+
+    mLastFrame.clear();
+    mLastFrameDropped = 0;
+    for (auto thread : threads)
+    {
+        uint32_t threadIndex = thread->Index();
+        mLastFrameDropped += thread->TakeDropped();
+        thread->Drain([&](const ProfileEvent& event)
+        {
+            uint64_t ticks = event.end - event.start;
+            uint64_t selfTicks = ticks > event.childTicks ? ticks - event.childTicks : 0;
+
+            // Few different zones are seen each frame so a linear search is quicker than a map
+            auto stats = std::find_if(mLastFrame.begin(), mLastFrame.end(), [&](const ZoneStats& zone)
+                                      { return zone.thread == threadIndex && SameName(zone.name, event.name); });
+            if (stats == mLastFrame.end())
+            {
+                mLastFrame.push_back({ event.name, threadIndex, event.depth, 1, ticks, selfTicks, ticks, event.start });
+            }
+            else
+            {
+                // Zones are collected in the order they end, so an outer zone is seen after the zones inside it
+                if (event.start < stats->firstStart)
+                {
+                    stats->firstStart = event.start;
+                    stats->depth      = event.depth;
+                }
+                ++stats->calls;
+                stats->totalTicks += ticks;
+                stats->selfTicks  += selfTicks;
+                stats->maxTicks    = std::max(stats->maxTicks, ticks);
+            }
+
+            if (capturing)  mCaptureEvents.push_back({ event, threadIndex });
+        });
+    }
+
+    std::sort(mLastFrame.begin(), mLastFrame.end(), [](const ZoneStats& a, const ZoneStats& b)
+              { return a.thread != b.thread ? a.thread < b.thread : a.firstStart < b.firstStart; });
+    mFrameStart = frameEnd;
+
+    // Finish the capture if this was the last frame of it
+    if (capturing)
+    {
+        mCaptureFrames.push_back(frameEnd);
+        if (--mCaptureFramesLeft == 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mThreadsMutex);
+                mCaptureThreadNames.clear();
+                for (auto& thread : mThreads)  mCaptureThreadNames.push_back(thread->Name());
+            }
+            WriteChromeTrace(mCaptureFileName + ".json");
+            WriteBinary(mCaptureFileName + ".prof");
+        }
+    }
+}
+
+
+// Total time in milliseconds of the named zones on any thread last frame, 0 if there were none
+float Profiler::LastFrameMilliseconds(const std::string& name)
+{
+    uint64_t ticks = 0;
+    for (auto& zone : mLastFrame)
+    {
+        if (name == zone.name)  ticks += zone.totalTicks;
+    }
+    return static_cast<float>(ticks * 1000.0 / TicksPerSecond());
+}
+
+
+// Number of ticks in a second (see GetTimerClockInfo, the first call may wait for a short time)
+double Profiler::TicksPerSecond()
+{
+    return static_cast<double>(GetTimerClockInfo(PROFILER_CLOCK).ticksPerSecond);
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Capture
+//--------------------------------------------------------------------------------------
+
+// Start capturing every zone for the given number of frames, including any zones recorded before the first frame
+// ends. When the capture is complete it is written to "<fileName>.json" (Chrome trace) and "<fileName>.prof" (binary).
+// Ignored if a capture is already running
+void Profiler::StartCapture(uint32_t numFrames, const std::string& fileName)
+{
+    if (Capturing() || numFrames == 0)  return;
+
+    mCaptureFramesLeft = numFrames;
+    mCaptureFileName   = fileName;
+    mCaptureEvents.clear();
+    mCaptureFrames.clear();
+    mCaptureThreadNames.clear();
+}
+
+
+// Write the last completed capture as Chrome trace JSON. Return false on failure
+bool Profiler::WriteChromeTrace(const std::string& fileName)
+{
+    if (mCaptureFrames.empty() || Capturing())  return false;
+
+    std::ofstream file(fileName);
+    if (!file.is_open())  return false;
+
+    uint64_t captureStart = mCaptureFrames.front();
+    for (auto& captured : mCaptureEvents)  captureStart = std::min(captureStart, captured.event.start);
+    double microsecondsPerTick = 1e6 / TicksPerSecond();
+
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    // Frames are shown on their own row after the threads
+    uint32_t frameRow = static_cast<uint32_t>(mCaptureThreadNames.size());
+    for (uint32_t thread = 0; thread <= frameRow; ++thread)
+    {
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":";
+        WriteJSONString(file, thread < frameRow ? mCaptureThreadNames[thread] : "Frames");
+        file << "}},\n";
+    }
+    for (size_t frame = 0; frame + 1 < mCaptureFrames.size(); ++frame)
+    {
+        file << "{\"name\":\"Frame " << frame << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << frameRow
+             << ",\"ts\":" << (mCaptureFrames[frame] - captureStart) * microsecondsPerTick
+             << ",\"dur\":" << (mCaptureFrames[frame + 1] - mCaptureFrames[frame]) * microsecondsPerTick << "},\n";
+    }
+
+    for (size_t i = 0; i < mCaptureEvents.size(); ++i)
+    {
+        const ProfileEvent& event = mCaptureEvents[i].event;
+        uint64_t ticks = event.end - event.start;
+        file << "{\"name\":";
+        WriteJSONString(file, event.name);
+        file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << mCaptureEvents[i].thread
+             << ",\"ts\":" << (event.start - captureStart) * microsecondsPerTick
+             << ",\"dur\":" << ticks * microsecondsPerTick
+             << ",\"args\":{\"self_us\":" << (ticks > event.childTicks ? ticks - event.childTicks : 0) * microsecondsPerTick
+             << "}}" << (i + 1 < mCaptureEvents.size() ? ",\n" : "\n");
+    }
+    file << "]}\n";
+
+    return !file.fail();
+}
+
+
+// Write the last completed capture in the binary format described in Profiler.h. Return false on failure
+bool Profiler::WriteBinary(const std::string& fileName)
+{
+    if (mCaptureFrames.empty() || Capturing())  return false;
+
+    std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())  return false;
+
+    uint64_t captureStart = mCaptureFrames.front();
+    for (auto& captured : mCaptureEvents)  captureStart = std::min(captureStart, captured.event.start);
+
+    // Give each distinct zone name an index
+    std::vector<std::string> names;
+    std::map<std::string, uint32_t> nameIndices;
+    std::vector<ProfileFileEvent> events;
+    events.reserve(mCaptureEvents.size());
+    for (auto& captured : mCaptureEvents)
+    {
+        auto name = nameIndices.emplace(captured.event.name, static_cast<uint32_t>(names.size()));
+        if (name.second)  names.push_back(captured.event.name);
+
+        events.push_back({ captured.event.start - captureStart, captured.event.end - captured.event.start, name.first->second,
+                           static_cast<uint16_t>(captured.thread), static_cast<uint16_t>(captured.event.depth) });
+    }
+
+    ProfileFileHeader header = {};
+    header.id             = PROFILE_FILE_ID;
+    header.version        = PROFILE_FILE_VERSION;
+    header.ticksPerSecond = TicksPerSecond();
+    header.numThreads     = static_cast<uint32_t>(mCaptureThreadNames.size());
+    header.numNames       = static_cast<uint32_t>(names.size());
+    header.numFrames      = static_cast<uint32_t>(mCaptureFrames.size() - 1);
+    header.numEvents      = events.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (auto& name : mCaptureThreadNames)  WriteBinaryString(file, name);
+    for (auto& name : names)                WriteBinaryString(file, name);
+    for (auto frame : mCaptureFrames)
+    {
+        uint64_t relative = frame - captureStart;
+        file.write(reinterpret_cast<const char*>(&relative), sizeof(relative));
+    }
+    file.write(reinterpret_cast<const char*>(events.data()), events.size() * sizeof(ProfileFileEvent));
+
+    return !file.fail();
+}
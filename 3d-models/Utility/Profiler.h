@@ -0,0 +1,299 @@
+//--------------------------------------------------------------------------------------
+// Hierarchical CPU profiler
+//--------------------------------------------------------------------------------------
+// Time regions of code with PROFILE_ZONE("name") or PROFILE_FUNCTION() at the start of a scope.
+// Zones nest, and recording one is two clock reads and a write to a per-thread ring buffer with
+// no locks. PROFILE_FRAME() once a frame collects them into a summary of the last frame, and
+// captured frames can be written as Chrome trace JSON or a compact binary format.
+
+#ifndef _PROFILER_H_INCLUDED_
+#define _PROFILER_H_INCLUDED_
+
+// Build with PROFILER_ENABLED defined as 0 to remove all the zone markers from the code
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+#include "Timer.h"
+
+// Use the CPU timestamp counter where there is one, it is much quicker to read than the OS clock (see Timer.h). Define
+// as 0 to use std::chrono::steady_clock instead
+#ifndef PROFILER_USE_TSC
+#define PROFILER_USE_TSC TIMER_TSC_AVAILABLE
+#endif
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------------
+// Clock
+//--------------------------------------------------------------------------------------
+
+const TimerClock PROFILER_CLOCK = PROFILER_USE_TSC ? TimerClock::TSC : TimerClock::Steady;
+
+// Current time in profiler ticks. Use Profiler::TicksPerSecond to convert to seconds
+inline uint64_t ProfilerTicks()
+{
+    return TimerTicks(PROFILER_CLOCK);
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Per-thread recording
+//--------------------------------------------------------------------------------------
+
+// A finished zone
+struct ProfileEvent
+{
+    const char* name;       // Zone names must be string literals (or otherwise last for the life of the profiler)
+    uint64_t    start;      // Ticks
+    uint64_t    end;
+    uint64_t    childTicks; // Total time of the zones directly inside this one
+    uint32_t    depth;      // 0 for zones not inside another zone on the same thread
+};
+
+
+// The zones recorded by one thread. The thread writes finished zones into a ring buffer which the main thread empties
+// each frame. There is only ever one writer and one reader, so the buffer needs no lock, just the two atomic positions
+class ProfileThread
+{
+public:
+    static const uint32_t RING_SIZE = 8192; // Zones per frame before zones are dropped, must be a power of 2
+    static const uint32_t MAX_DEPTH = 64;   // Nesting beyond this depth is still recorded but self times are not
+
+    ProfileThread(uint32_t index, const std::string& name) : mIndex(index), mName(name) {}
+
+    // Start and end a zone, only called from the owning thread
+    void BeginZone()
+    {
+        uint32_t depth = mDepth++;
+        if (depth < MAX_DEPTH)  mChildTicks[depth] = 0;
+    }
+
+    void EndZone(const char* name, uint64_t start, uint64_t end)
+    {
+        uint32_t depth = --mDepth;
+        uint64_t childTicks = depth < MAX_DEPTH ? mChildTicks[depth] : 0;
+        if (depth > 0 && depth <= MAX_DEPTH)  mChildTicks[depth - 1] += end - start;
+
+        uint32_t write = mWrite.load(std::memory_order_relaxed);
+        if (write - mRead.load(std::memory_order_acquire) >= RING_SIZE)
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        mRing[write & (RING_SIZE - 1)] = { name, start, end, childTicks, depth };
+        mWrite.store(write + 1, std::memory_order_release);
+    }
+
+    // Pass all the zones recorded since the last call to a function, then free their space in the ring. Only called from
+    // the thread collecting the zones
+    template <class Function> void Drain(Function function)
+    {
+        uint32_t read  = mRead.load(std::memory_order_relaxed);
+        uint32_t write = mWrite.load(std::memory_order_acquire);
+        for (; read != write; ++read)  function(mRing[read & (RING_SIZE - 1)]);
+        mRead.store(write, std::memory_order_release);
+    }
+
+    // The thread's position in the profiler's list of threads and its name. Names are changed and read under the
+    // profiler's thread list lock
+    uint32_t           Index()    { return mIndex; }
+    const std::string& Name()     { return mName; }
+    void               SetName(const std::string& name)  { mName = name; }
+
+    // Number of zones lost because the ring was full, since the last call
+    uint32_t TakeDropped()  { return mDropped.exchange(0, std::memory_order_relaxed); }
+
+
+private:
+    uint32_t    mIndex;
+    std::string mName;
+
+    // Used only by the owning thread
+    uint32_t mDepth = 0;
+    uint64_t mChildTicks[MAX_DEPTH]; // Time of the zones inside the open zone at each depth
+
+    ProfileEvent          mRing[RING_SIZE];
+    std::atomic<uint32_t> mWrite{0};   // Position of the next zone to write, only changed by the owning thread
+    std::atomic<uint32_t> mRead{0};    // Position of the next zone to read, only changed by the collecting thread
+    std::atomic<uint32_t> mDropped{0};
+};
+
+
+
+//--------------------------------------------------------------------------------------
+// Profiler
+//--------------------------------------------------------------------------------------
+
+// Summary of one zone over a frame. Zones with the same name on the same thread are combined
+struct ZoneStats
+{
+    const char* name;
+    uint32_t    thread;
+    uint32_t    depth;      // Depth of the first call this frame
+    uint32_t    calls;
+    uint64_t    totalTicks; // Including zones inside this one
+    uint64_t    selfTicks;  // Excluding zones inside this one
+    uint64_t    maxTicks;   // Longest single call
+    uint64_t    firstStart; // Start of the first call, for ordering
+};
+
+
+// Binary capture file. The header is followed by:
+//  - numThreads thread names then numNames zone names, each a uint32_t length and the characters (no terminator)
+//  - numFrames + 1 uint64_t frame boundaries in ticks (start of each frame then the end of the last)
+//  - numEvents ProfileFileEvents in the order they finished on each thread
+// All times are ticks relative to the start of the capture (the earliest zone or frame start in it)
+const uint32_t PROFILE_FILE_ID      = 0x31465250; // "PRF1"
+const uint32_t PROFILE_FILE_VERSION = 1;
+
+struct ProfileFileHeader
+{
+    uint32_t id;
+    uint32_t version;
+    double   ticksPerSecond;
+    uint32_t numThreads;
+    uint32_t numNames;
+    uint32_t numFrames;
+    uint32_t padding;
+    uint64_t numEvents;
+};
+
+struct ProfileFileEvent
+{
+    uint64_t start;
+    uint64_t duration;
+    uint32_t name;   // Index into the names
+    uint16_t thread; // Index into the threads
+    uint16_t depth;
+};
+
+
+class Profiler
+{
+public:
+    Profiler();
+
+    // The recording state of the calling thread, created the first time a thread records a zone
+    static ProfileThread& ThisThread()
+    {
+        thread_local ProfileThread* thread = nullptr;
+        if (thread == nullptr)  thread = Instance().RegisterThread();
+        return *thread;
+    }
+
+    static Profiler& Instance();
+
+    // Name the calling thread in captures (threads are otherwise "Thread n")
+    void SetThreadName(const std::string& name);
+
+
+    // Collect the zones recorded by every thread since the last call and make them the last frame. Call once per frame
+    // on the main thread
+    void EndFrame();
+
+    // Summary of the zones in the last frame, sorted by thread then start time of each zone's first call
+    const std::vector<ZoneStats>& LastFrame()  { return mLastFrame; }
+
+    // Total time in milliseconds of the named zones on any thread last frame, 0 if there were none
+    float LastFrameMilliseconds(const std::string& name);
+
+    // Zones lost last frame because a thread recorded more than ProfileThread::RING_SIZE
+    uint32_t LastFrameDropped()  { return mLastFrameDropped; }
+
+
+    // Start capturing every zone for the given number of frames, including any zones recorded before the first frame
+    // ends. When the capture is complete it is written to "<fileName>.json" (Chrome trace) and "<fileName>.prof" (binary).
+    // Ignored if a capture is already running
+    void StartCapture(uint32_t numFrames, const std::string& fileName);
+    bool Capturing()  { return mCaptureFramesLeft > 0; }
+
+    // Write the last completed capture. Return false on failure
+    bool WriteChromeTrace(const std::string& fileName);
+    bool WriteBinary(const std::string& fileName);
+
+
+    // Number of ticks in a second (see GetTimerClockInfo, the first call may wait for a short time)
+    double TicksPerSecond();
+
+
+private:
+    ProfileThread* RegisterThread();
+
+    struct CapturedEvent
+    {
+        ProfileEvent event;
+        uint32_t     thread;
+    };
+
+    std::mutex                                  mThreadsMutex; // Protects the list of threads (not their contents)
+    std::vector<std::unique_ptr<ProfileThread>> mThreads;
+    std::vector<ProfileThread*>                 mDrainThreads; // Copy of the list used while collecting a frame, reused each frame
+
+    std::vector<ZoneStats> mLastFrame;
+    uint32_t               mLastFrameDropped = 0;
+    uint64_t               mFrameStart;
+
+    uint32_t                   mCaptureFramesLeft = 0;
+    std::string                mCaptureFileName;
+    std::vector<CapturedEvent> mCaptureEvents;
+    std::vector<uint64_t>      mCaptureFrames; // Frame boundaries
+    std::vector<std::string>   mCaptureThreadNames;
+};
+
+
+
+//--------------------------------------------------------------------------------------
+// Zone markers
+//--------------------------------------------------------------------------------------
+
+// Times the rest of the scope it is declared in
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name) : mName(name), mThread(Profiler::ThisThread())
+    {
+        mThread.BeginZone();
+        mStart = ProfilerTicks();
+    }
+
+    ~ProfileZone()
+    {
+        mThread.EndZone(mName, mStart, ProfilerTicks());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char*    mName;
+    ProfileThread& mThread;
+    uint64_t       mStart;
+};
+
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b)       PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_ZONE(name)          ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION()          PROFILE_ZONE(__FUNCTION__)
+#define PROFILE_FRAME()             Profiler::Instance().EndFrame()
+#define PROFILE_THREAD_NAME(name)   Profiler::Instance().SetThreadName(name)
+#else
+#define PROFILE_ZONE(name)          ((void)0)
+#define PROFILE_FUNCTION()          ((void)0)
+#define PROFILE_FRAME()             ((void)0)
+#define PROFILE_THREAD_NAME(name)   ((void)0)
+#endif
+
+
+#endif //_PROFILER_H_INCLUDED_
@@ -0,0 +1,236 @@
+//--------------------------------------------------------------------------------------
+// Shader permutations and a cache of their compiled bytecode
+//--------------------------------------------------------------------------------------
+
+#include "ShaderPermutation.h"
+#include "AssetPackage.h" // For HashBytes
+
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <set>
+#include <algorithm>
+#include <cstdio>
+
+namespace fs = std::filesystem;
+
+
+//--------------------------------------------------------------------------------------
+// Permutation keys
+//--------------------------------------------------------------------------------------
+
+ShaderDefines::ShaderDefines(std::initializer_list<std::pair<std::string, int>> defines)
+{
+    for (auto& define : defines)  Set(define.first, define.second);
+}
+
+
+// Set a key, replacing any previous value
+ShaderDefines& ShaderDefines::Set(const std::string& name, int value)
+{
+    auto position = std::lower_bound(mDefines.begin(), mDefines.end(), name,
+                                     [](const std::pair<std::string, std::string>& define, const std::string& name)
+                                     { return define.first < name; });
+    if (position != mDefines.end() && position->first == name)  position->second = std::to_string(value);
+    else                                                         mDefines.insert(position, { name, std::to_string(value) });
+    return *this;
+}
+
+
+// Value of a key, or the default if it isn't set
+int ShaderDefines::Get(const std::string& name, int defaultValue /*= 0*/) const
+{
+    for (auto& define : mDefines)
+    {
+        if (define.first == name)  return std::stoi(define.second);
+    }
+    return defaultValue;
+}
+
+
+// Readable text for the keys such as "CELL_SHADING=1 LIGHT_COUNT=2", used to name permutations
+std::string ShaderDefines::ToString() const
+{
+    std::string text;
+    for (auto& define : mDefines)
+    {
+        if (!text.empty())  text += ' ';
+        text += define.first + '=' + define.second;
+    }
+    return text;
+}
+
+
+// Readable name for a permutation such as "Lighting_ps (LIGHT_COUNT=2 SHADOWS=1)"
+std::string ShaderPermutationName(const ShaderPermutation& permutation)
+{
+    return permutation.shaderName + " (" + permutation.defines.ToString() + ")";
+}
+
+
+// Name of a permutation's compiled bytecode in the asset package, its readable name with ".cso" added
+std::string ShaderPermutationAssetName(const ShaderPermutation& permutation)
+{
+    return ShaderPermutationName(permutation) + ".cso";
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Source loading and hashing
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+    // If the line is #include "name" return true and the name
+    bool ParseInclude(const std::string& line, std::string& includeName)
+    {
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] != '#')  return false;
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)  return false;
+
+        size_t open = line.find('"', pos + 7);
+        if (open == std::string::npos)  return false;
+        size_t close = line.find('"', open + 1);
+        if (close == std::string::npos)  return false;
+
+        includeName = line.substr(open + 1, close - open - 1);
+        return true;
+    }
+
+    bool AppendSource(const fs::path& fileName, std::set<fs::path>& included, std::string& source)
+    {
+        std::ifstream file(fileName, std::ios::in | std::ios::binary);
+        if (!file.is_open())  return false;
+
+        std::string generic = fileName.generic_string();
+        source += "#line 1 \"" + generic + "\"\n";
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            ++lineNumber;
+            if (!line.empty() && line.back() == '\r')  line.pop_back();
+
+            std::string includeName;
+            if (!ParseInclude(line, includeName))
+            {
+                source += line;
+                source += '\n';
+                continue;
+            }
+
+            fs::path includePath = (fileName.parent_path() / includeName).lexically_normal();
+            if (included.insert(includePath).second)
+            {
+                if (!AppendSource(includePath, included, source))  return false;
+            }
+            source += "#line " + std::to_string(lineNumber + 1) + " \"" + generic + "\"\n";
+        }
+        return true;
+    }
+}
+
+
+// Read a shader source file with the files it includes with #include "..." pasted in (each file once only, as they
+// all have include guards or are only included once). #line directives are added so compiler errors still refer to
+// the original files. Include file names are relative to the including file. This is exactly the text the compiler
+// sees, so hashing it notices changes to any included file. Returns false if any file can't be read
+bool LoadShaderSource(const std::string& fileName, std::string& source)
+{
+    source.clear();
+    fs::path path = fs::path(fileName).lexically_normal();
+    std::set<fs::path> included = { path };
+    return AppendSource(path, included, source);
+}
+
+
+// Cache key for a shader permutation, covering everything that affects the compiled bytecode. Each part is hashed
+// with a terminating zero so text can't move from one part to the next and give the same key
+uint64_t ShaderCacheKey(const std::string& source, const ShaderDefines& defines, const std::string& entryPoint,
+                        const std::string& target, uint32_t compileFlags)
+{
+    uint64_t key = HashBytes(source.c_str(), source.size() + 1);
+    for (auto& define : defines.List())
+    {
+        key = HashBytes(define.first.c_str(),  define.first.size()  + 1, key);
+        key = HashBytes(define.second.c_str(), define.second.size() + 1, key);
+    }
+    key = HashBytes(entryPoint.c_str(), entryPoint.size() + 1, key);
+    key = HashBytes(target.c_str(),     target.size()     + 1, key);
+    return HashBytes(&compileFlags, sizeof(compileFlags), key);
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Permutations used by the app
+//--------------------------------------------------------------------------------------
+
+const ShaderPermutation gPixelLightingPermutation  = { "Lighting_ps", { {"LIGHT_COUNT", 2}, {"SHADOWS", 1} } };
+const ShaderPermutation gMixingTexturesPermutation = { "Lighting_ps", { {"LIGHT_COUNT", 2}, {"SHADOWS", 1}, {"TEXTURE_MIXING", 1} } };
+const ShaderPermutation gCellShadingPermutation    = { "Lighting_ps", { {"LIGHT_COUNT", 2}, {"SHADOWS", 0}, {"CELL_SHADING", 1},
+                                                                        {"TEXTURE_ARRAY", 0} } };
+const ShaderPermutation gStressPermutation         = { "Lighting_ps", { {"LIGHT_COUNT", 2}, {"SHADOWS", 1}, {"POINT_LIGHTS", 1} } };
+
+std::vector<ShaderPermutation> AppShaderPermutations()
+{
+    return { gPixelLightingPermutation, gMixingTexturesPermutation, gCellShadingPermutation, gStressPermutation };
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Bytecode cache
+//--------------------------------------------------------------------------------------
+
+// File name used for a key, e.g. "ShaderCache/0123456789abcdef.cso"
+std::string ShaderCache::FileName(uint64_t key) const
+{
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.cso", static_cast<unsigned long long>(key));
+    return mFolder + '/' + name;
+}
+
+
+// Read the bytecode stored for a key, returns false if there isn't any
+bool ShaderCache::Load(uint64_t key, std::vector<uint8_t>& bytecode) const
+{
+    std::ifstream file(FileName(key), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open())  return false;
+
+    std::streamoff fileSize = file.tellg();
+    if (fileSize <= 0)  return false;
+    file.seekg(0, std::ios::beg);
+    bytecode.resize(static_cast<size_t>(fileSize));
+    file.read(reinterpret_cast<char*>(bytecode.data()), fileSize);
+    return !file.fail();
+}
+
+
+// Store bytecode for a key, creating the folder if needed. Written to a temporary file then renamed, so another
+// process reading the cache never sees a partly written file. Returns false on failure
+bool ShaderCache::Store(uint64_t key, const void* bytecode, size_t size) const
+{
+    std::error_code error;
+    fs::create_directories(mFolder, error);
+
+    std::string fileName = FileName(key);
+    std::string tempName = fileName + ".tmp";
+    {
+        std::ofstream file(tempName, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())  return false;
+        file.write(static_cast<const char*>(bytecode), static_cast<std::streamsize>(size));
+        if (file.fail())  return false;
+    }
+
+    fs::rename(tempName, fileName, error);
+    if (error)
+    {
+        fs::remove(tempName, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,113 @@
+//--------------------------------------------------------------------------------------
+// Shader permutations and a cache of their compiled bytecode
+//--------------------------------------------------------------------------------------
+// One shader source is compiled into specialised permutations by setting preprocessor keys,
+// e.g. LIGHT_COUNT=2 or SHADOWS=0, so pixels don't pay for features they don't use. Compiled
+// bytecode is cached in files named by a hash of everything that affects it, so stale bytecode
+// is never used, and the permutations the app uses are cooked into the asset package.
+
+#ifndef _SHADER_PERMUTATION_H_INCLUDED_
+#define _SHADER_PERMUTATION_H_INCLUDED_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <initializer_list>
+#include <cstdint>
+
+
+// The preprocessor keys selecting a permutation. Keys are kept sorted by name so the same settings always give the same
+// permutation whatever order they were set in
+class ShaderDefines
+{
+public:
+    ShaderDefines() {}
+    ShaderDefines(std::initializer_list<std::pair<std::string, int>> defines);
+
+    // Set a key, replacing any previous value
+    ShaderDefines& Set(const std::string& name, int value);
+
+    // Value of a key, or the default if it isn't set
+    int Get(const std::string& name, int defaultValue = 0) const;
+
+    // Name and value text for each key, sorted by name, ready to pass to the compiler
+    const std::vector<std::pair<std::string, std::string>>& List() const  { return mDefines; }
+
+    // Readable text for the keys such as "CELL_SHADING=1 LIGHT_COUNT=2", used to name permutations
+    std::string ToString() const;
+
+
+private:
+    std::vector<std::pair<std::string, std::string>> mDefines;
+};
+
+
+// Read a shader source file with the files it includes with #include "..." pasted in (each file once only, as they
+// all have include guards or are only included once). #line directives are added so compiler errors still refer to
+// the original files. Include file names are relative to the including file. This is exactly the text the compiler
+// sees, so hashing it notices changes to any included file. Returns false if any file can't be read
+bool LoadShaderSource(const std::string& fileName, std::string& source);
+
+// Cache key for a shader permutation, covering everything that affects the compiled bytecode
+uint64_t ShaderCacheKey(const std::string& source, const ShaderDefines& defines, const std::string& entryPoint,
+                        const std::string& target, uint32_t compileFlags);
+
+
+// A shader source file (without the .hlsl extension) and the keys for one permutation of it
+struct ShaderPermutation
+{
+    std::string   shaderName;
+    ShaderDefines defines;
+};
+
+// Readable name for a permutation such as "Lighting_ps (LIGHT_COUNT=2 SHADOWS=1)"
+std::string ShaderPermutationName(const ShaderPermutation& permutation);
+
+// Name of a permutation's compiled bytecode in the asset package, its readable name with ".cso" added
+std::string ShaderPermutationAssetName(const ShaderPermutation& permutation);
+
+// Compile settings for permutations, the same for the app and the asset cooker. The flags are D3DCOMPILE_ flags
+const char* const PERMUTATION_ENTRY_POINT   = "main";
+const char* const PERMUTATION_TARGET        = "ps_5_0";
+const uint32_t    PERMUTATION_COMPILE_FLAGS = 1 << 15; // D3DCOMPILE_OPTIMIZATION_LEVEL3
+
+
+
+//--------------------------------------------------------------------------------------
+// Permutations used by the app
+//--------------------------------------------------------------------------------------
+// Loaded by LoadShaders and LoadStressScene. The asset cooker compiles every permutation in AppShaderPermutations
+// into the package so the app doesn't compile any at runtime, so list any new permutation there too
+
+extern const ShaderPermutation gPixelLightingPermutation;
+extern const ShaderPermutation gMixingTexturesPermutation;
+extern const ShaderPermutation gCellShadingPermutation;
+extern const ShaderPermutation gStressPermutation; // Adds point lights, see StressScene.h
+
+std::vector<ShaderPermutation> AppShaderPermutations();
+
+
+// Compiled shader bytecode stored in a folder, one file per cache key, so permutations that aren't in the asset
+// package are only compiled once. The files are plain compiled shader objects (.cso)
+class ShaderCache
+{
+public:
+    explicit ShaderCache(const std::string& folder = "ShaderCache") : mFolder(folder) {}
+
+    // File name used for a key, e.g. "ShaderCache/0123456789abcdef.cso"
+    std::string FileName(uint64_t key) const;
+
+    // Read the bytecode stored for a key, returns false if there isn't any
+    bool Load(uint64_t key, std::vector<uint8_t>& bytecode) const;
+
+    // Store bytecode for a key, creating the folder if needed. Written to a temporary file then renamed, so another
+    // process reading the cache never sees a partly written file. Returns false on failure
+    bool Store(uint64_t key, const void* bytecode, size_t size) const;
+
+
+private:
+    std::string mFolder;
+};
+
+
+#endif //_SHADER_PERMUTATION_H_INCLUDED_
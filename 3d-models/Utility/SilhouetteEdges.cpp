@@ -0,0 +1,260 @@
+//--------------------------------------------------------------------------------------
+// Silhouette edges of triangle meshes
+//--------------------------------------------------------------------------------------
+
+#include "SilhouetteEdges.h"
+
+#include <xmmintrin.h> // SSE
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <cstring>
+
+
+namespace
+{
+    const uint32_t NO_TRIANGLE = UINT32_MAX;
+
+    // Triangles and edges are split into bands of these sizes, which the threads take in turn. The triangle band is a
+    // multiple of four for SSE
+    const uint32_t TRIANGLE_BAND = 16384;
+    const uint32_t EDGE_BAND     = 16384;
+
+    // Meshes with fewer triangles than this for each thread use fewer threads, starting threads costs more than the work
+    const uint32_t MIN_TRIANGLES_PER_THREAD = 32768;
+
+
+    // Position as a key for welding. Adding 0 turns -0 into 0 so they weld together
+    struct PositionKey
+    {
+        uint32_t bits[3];
+
+        explicit PositionKey(const CVector3& p)
+        {
+            float values[3] = { p.x + 0.0f, p.y + 0.0f, p.z + 0.0f };
+            std::memcpy(bits, values, sizeof(bits));
+        }
+
+        bool operator==(const PositionKey& other) const
+        {
+            return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+        }
+    };
+
+    struct PositionKeyHash
+    {
+        size_t operator()(const PositionKey& key) const
+        {
+            uint64_t hash = key.bits[0];
+            hash = hash * 0x9E3779B97F4A7C15ull ^ key.bits[1];
+            hash = hash * 0x9E3779B97F4A7C15ull ^ key.bits[2];
+            return static_cast<size_t>(hash ^ (hash >> 29));
+        }
+    };
+
+
+    // Call function(band) for each band on up to numThreads threads
+    template <class Function>
+    void ForEachBand(uint32_t numBands, unsigned int numThreads, Function function)
+    {
+        numThreads = std::max(1u, std::min(numThreads, numBands));
+        if (numThreads == 1)
+        {
+            for (uint32_t band = 0; band < numBands; ++band)  function(band);
+            return;
+        }
+
+        std::atomic<uint32_t> nextBand(0);
+        auto worker = [&]()
+        {
+            for (uint32_t band = nextBand++; band < numBands; band = nextBand++)  function(band);
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int thread = 1; thread < numThreads; ++thread)  threads.emplace_back(worker);
+        worker();
+        for (auto& thread : threads)  thread.join();
+    }
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Edge adjacency
+//--------------------------------------------------------------------------------------
+
+// Build from a triangle list. Each vertex is vertexSize bytes with the position as three floats at positionOffset.
+// Degenerate triangles are left out. Replaces anything built before
+void EdgeAdjacency::Build(const void* vertices, uint32_t vertexSize, uint32_t positionOffset, uint32_t numVertices,
+                          const uint32_t* indices, uint32_t numIndices)
+{
+    mPositions.clear();
+    mEdgeVertices.clear();
+    mEdgeTriangles.clear();
+    mPlaneX.clear();  mPlaneY.clear();  mPlaneZ.clear();  mPlaneD.clear();
+    mNumTriangles = 0;
+    mNumOpenEdges = 0;
+
+    // Weld vertices at the same position
+    std::vector<uint32_t> welded(numVertices);
+    {
+        std::unordered_map<PositionKey, uint32_t, PositionKeyHash> positionIndex;
+        positionIndex.reserve(numVertices);
+        const unsigned char* vertex = static_cast<const unsigned char*>(vertices) + positionOffset;
+        for (uint32_t v = 0; v < numVertices; ++v, vertex += vertexSize)
+        {
+            CVector3 position;
+            std::memcpy(&position, vertex, sizeof(position));
+            auto inserted = positionIndex.emplace(PositionKey(position), static_cast<uint32_t>(mPositions.size()));
+            if (inserted.second)  mPositions.push_back(position);
+            welded[v] = inserted.first->second;
+        }
+    }
+
+    // Find the edges of each triangle, an edge met for the second time gets its second triangle. An edge shared by
+    // more than two triangles is split into more than one edge
+    std::unordered_map<uint64_t, uint32_t> edgeIndex; // Keyed on the two positions, smallest first
+    edgeIndex.reserve(numIndices);
+    for (uint32_t i = 0; i + 2 < numIndices; i += 3)
+    {
+        uint32_t corners[3] = { welded[indices[i]], welded[indices[i + 1]], welded[indices[i + 2]] };
+        if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])  continue;
+
+        const CVector3& p0 = mPositions[corners[0]];
+        CVector3 normal = Cross(mPositions[corners[1]] - p0, mPositions[corners[2]] - p0);
+        mPlaneX.push_back(normal.x);
+        mPlaneY.push_back(normal.y);
+        mPlaneZ.push_back(normal.z);
+        mPlaneD.push_back(-Dot(normal, p0));
+        uint32_t triangle = mNumTriangles++;
+
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            uint32_t a = corners[corner];
+            uint32_t b = corners[(corner + 1) % 3];
+            uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+
+            auto found = edgeIndex.find(key);
+            if (found != edgeIndex.end() && mEdgeTriangles[found->second * 2 + 1] == NO_TRIANGLE)
+            {
+                mEdgeTriangles[found->second * 2 + 1] = triangle;
+                continue;
+            }
+
+            uint32_t edge = NumEdges();
+            mEdgeVertices.push_back(a);
+            mEdgeVertices.push_back(b);
+            mEdgeTriangles.push_back(triangle);
+            mEdgeTriangles.push_back(NO_TRIANGLE);
+            edgeIndex[key] = edge;
+        }
+    }
+
+    // Pad the planes with ones that never face the viewer (0 everywhere plus -1), the first padding triangle stands in
+    // for the missing second triangle of open edges
+    uint32_t padded = PaddedTriangles() + 1;
+    mPlaneX.resize(padded, 0.0f);
+    mPlaneY.resize(padded, 0.0f);
+    mPlaneZ.resize(padded, 0.0f);
+    mPlaneD.resize(padded, -1.0f);
+    for (uint32_t edge = 0; edge < NumEdges(); ++edge)
+    {
+        if (mEdgeTriangles[edge * 2 + 1] == NO_TRIANGLE)
+        {
+            mEdgeTriangles[edge * 2 + 1] = PaddedTriangles();
+            ++mNumOpenEdges;
+        }
+    }
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Extraction
+//--------------------------------------------------------------------------------------
+
+// Uses up to numThreads threads (0 for one per hardware thread) for meshes big enough to be worth splitting
+SilhouetteExtractor::SilhouetteExtractor(unsigned int numThreads /*= 0*/)
+    : mNumThreads(numThreads != 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+
+// Find the silhouette edges of a mesh as seen from the given point in model space. Returns the edge numbers, in
+// order, valid until the next call. Makes no heap allocations once it has seen the mesh's longest silhouette
+const std::vector<uint32_t>& SilhouetteExtractor::Extract(const EdgeAdjacency& mesh, const CVector3& viewpoint)
+{
+    mEdges.clear();
+    uint32_t numEdges = mesh.NumEdges();
+    if (numEdges == 0)  return mEdges;
+
+    uint32_t padded = mesh.PaddedTriangles();
+    unsigned int numThreads = std::max(1u, std::min(mNumThreads, mesh.NumTriangles() / MIN_TRIANGLES_PER_THREAD));
+
+    // Which way each triangle faces: in front of its plane is facing the viewpoint. The padding triangles never do
+    mFacing.resize(padded + 1);
+    mFacing[padded] = 0;
+    uint32_t numTriangleBands = (padded + TRIANGLE_BAND - 1) / TRIANGLE_BAND;
+    ForEachBand(numTriangleBands, numThreads, [&](uint32_t band)
+    {
+        __m128 viewX = _mm_set1_ps(viewpoint.x);
+        __m128 viewY = _mm_set1_ps(viewpoint.y);
+        __m128 viewZ = _mm_set1_ps(viewpoint.z);
+        __m128 zero  = _mm_setzero_ps();
+
+        uint32_t end = std::min(padded, (band + 1) * TRIANGLE_BAND);
+        for (uint32_t triangle = band * TRIANGLE_BAND; triangle < end; triangle += 4)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&mesh.mPlaneX[triangle]), viewX),
+                                                    _mm_mul_ps(_mm_loadu_ps(&mesh.mPlaneY[triangle]), viewY)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&mesh.mPlaneZ[triangle]), viewZ),
+                                                    _mm_loadu_ps(&mesh.mPlaneD[triangle])));
+            int facing = _mm_movemask_ps(_mm_cmpgt_ps(distance, zero));
+            mFacing[triangle]     = facing & 1;
+            mFacing[triangle + 1] = (facing >> 1) & 1;
+            mFacing[triangle + 2] = (facing >> 2) & 1;
+            mFacing[triangle + 3] = (facing >> 3) & 1;
+        }
+    });
+
+    // Edges between triangles facing different ways. Each band keeps its own list so the result is in edge order
+    // however the bands are shared between threads
+    uint32_t numEdgeBands = (numEdges + EDGE_BAND - 1) / EDGE_BAND;
+    if (mBandEdges.size() < numEdgeBands)  mBandEdges.resize(numEdgeBands);
+    ForEachBand(numEdgeBands, numThreads, [&](uint32_t band)
+    {
+        std::vector<uint32_t>& found = mBandEdges[band];
+        found.clear();
+        const uint32_t* triangles = mesh.mEdgeTriangles.data();
+        uint32_t end = std::min(numEdges, (band + 1) * EDGE_BAND);
+        for (uint32_t edge = band * EDGE_BAND; edge < end; ++edge)
+        {
+            if (mFacing[triangles[edge * 2]] != mFacing[triangles[edge * 2 + 1]])  found.push_back(edge);
+        }
+    });
+
+    for (uint32_t band = 0; band < numEdgeBands; ++band)
+    {
+        mEdges.insert(mEdges.end(), mBandEdges[band].begin(), mBandEdges[band].end());
+    }
+    return mEdges;
+}
+
+
+// Write the quads for the given edges, OUTLINE_VERTICES_PER_EDGE vertices for each
+void WriteOutlineQuads(const EdgeAdjacency& mesh, const uint32_t* edges, uint32_t numEdges, OutlineVertex* vertices)
+{
+    // The shader pushes each corner sideways from the direction towards the other end, which is reversed at the far
+    // end, so the far end's sides are swapped to keep the quad from twisting
+    for (uint32_t i = 0; i < numEdges; ++i)
+    {
+        const CVector3& start = mesh.EdgeStart(edges[i]);
+        const CVector3& end   = mesh.EdgeEnd(edges[i]);
+        vertices[0] = { start, end,    1.0f };
+        vertices[1] = { start, end,   -1.0f };
+        vertices[2] = { end,   start, -1.0f };
+        vertices[3] = { end,   start,  1.0f };
+        vertices += OUTLINE_VERTICES_PER_EDGE;
+    }
+}
@@ -0,0 +1,97 @@
+//--------------------------------------------------------------------------------------
+// Silhouette edges of triangle meshes
+//--------------------------------------------------------------------------------------
+// Finds the outline of a mesh seen from a point: edges where a triangle facing the viewer
+// meets one facing away. EdgeAdjacency is built once per mesh, welding positions so seams
+// don't split it, and SilhouetteExtractor tests the triangles with SSE each frame, on several
+// threads for large meshes. Cartoon outlines are drawn as quads along the edges.
+
+#ifndef _SILHOUETTE_EDGES_H_INCLUDED_
+#define _SILHOUETTE_EDGES_H_INCLUDED_
+
+#include "CVector3.h"
+
+#include <vector>
+#include <cstdint>
+
+
+// One corner of an outline quad. Each edge is drawn as a quad with two corners at each end of the edge, which the
+// vertex shader pushes apart on screen (see CellShadingOutline_vs.hlsl)
+struct OutlineVertex
+{
+    CVector3 position; // The end of the edge this corner is at, in model space
+    CVector3 otherEnd; // The other end of the edge
+    float    side;     // -1 or 1, the side of the edge the corner is pushed to
+};
+
+// Each quad uses 4 vertices and 6 indices: 0 1 2, 2 1 3 (offset by 4 for each quad)
+const uint32_t OUTLINE_VERTICES_PER_EDGE = 4;
+const uint32_t OUTLINE_INDICES_PER_EDGE  = 6;
+
+
+
+//--------------------------------------------------------------------------------------
+// Edge adjacency
+//--------------------------------------------------------------------------------------
+
+class EdgeAdjacency
+{
+public:
+    // Build from a triangle list. Each vertex is vertexSize bytes with the position as three floats at positionOffset.
+    // Degenerate triangles are left out. Replaces anything built before
+    void Build(const void* vertices, uint32_t vertexSize, uint32_t positionOffset, uint32_t numVertices,
+               const uint32_t* indices, uint32_t numIndices);
+
+    uint32_t NumEdges()     const  { return static_cast<uint32_t>(mEdgeVertices.size() / 2); }
+    uint32_t NumTriangles() const  { return mNumTriangles; }
+    uint32_t NumOpenEdges() const  { return mNumOpenEdges; } // Edges with only one triangle
+
+    const CVector3& EdgeStart(uint32_t edge) const  { return mPositions[mEdgeVertices[edge * 2]];     }
+    const CVector3& EdgeEnd  (uint32_t edge) const  { return mPositions[mEdgeVertices[edge * 2 + 1]]; }
+
+private:
+    friend class SilhouetteExtractor;
+
+    std::vector<CVector3> mPositions;     // After welding
+    std::vector<uint32_t> mEdgeVertices;  // Two positions for each edge
+    std::vector<uint32_t> mEdgeTriangles; // Two triangles for each edge, open edges use the padding triangle PaddedTriangles()
+
+    // Triangle planes (nx, ny, nz, d) as separate arrays so four can be loaded at once. Padded to a multiple of four
+    // triangles (plus one for open edges) with planes that never face the viewer
+    std::vector<float> mPlaneX, mPlaneY, mPlaneZ, mPlaneD;
+
+    uint32_t mNumTriangles = 0;
+    uint32_t mNumOpenEdges = 0;
+
+    uint32_t PaddedTriangles() const  { return (mNumTriangles + 3) & ~3u; }
+};
+
+
+
+//--------------------------------------------------------------------------------------
+// Extraction
+//--------------------------------------------------------------------------------------
+
+class SilhouetteExtractor
+{
+public:
+    // Uses up to numThreads threads (0 for one per hardware thread) for meshes big enough to be worth splitting
+    explicit SilhouetteExtractor(unsigned int numThreads = 0);
+
+    // Find the silhouette edges of a mesh as seen from the given point in model space. Returns the edge numbers, in
+    // order, valid until the next call. Makes no heap allocations once it has seen the mesh's longest silhouette
+    const std::vector<uint32_t>& Extract(const EdgeAdjacency& mesh, const CVector3& viewpoint);
+
+private:
+    unsigned int                       mNumThreads;
+    std::vector<uint8_t>               mFacing;    // 1 for each triangle facing the viewpoint, 0 otherwise
+    std::vector<std::vector<uint32_t>> mBandEdges; // Edges found in each band of the edge list
+    std::vector<uint32_t>              mEdges;
+};
+
+
+// Write the quads for the given edges, OUTLINE_VERTICES_PER_EDGE vertices for each
+void WriteOutlineQuads(const EdgeAdjacency& mesh, const uint32_t* edges, uint32_t numEdges, OutlineVertex* vertices);
+
+
+#endif //_SILHOUETTE_EDGES_H_INCLUDED_
@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------------------
+// Camera-facing sprite batches
+//--------------------------------------------------------------------------------------
+
+#include "SpriteBatch.h"
+
+#include <xmmintrin.h> // SSE
+
+
+// WriteVertices writes each vertex as two groups of four floats
+static_assert(sizeof(SpriteVertex) == 8 * sizeof(float), "SpriteVertex must be two groups of four floats");
+
+
+// Remove all sprites, keeping the memory for the next ones
+void SpriteBatch::Clear()
+{
+    mX.clear();    mY.clear();      mZ.clear();     mSize.clear();
+    mRed.clear();  mGreen.clear();  mBlue.clear();  mRotation.clear();
+}
+
+
+void SpriteBatch::Reserve(uint32_t numSprites)
+{
+    mX.reserve(numSprites);    mY.reserve(numSprites);      mZ.reserve(numSprites);     mSize.reserve(numSprites);
+    mRed.reserve(numSprites);  mGreen.reserve(numSprites);  mBlue.reserve(numSprites);  mRotation.reserve(numSprites);
+}
+
+
+void SpriteBatch::Add(const CVector3& position, float size, const CVector3& colour, float rotation /*= 0*/)
+{
+    mX.push_back(position.x);  mY.push_back(position.y);    mZ.push_back(position.z);   mSize.push_back(size);
+    mRed.push_back(colour.x);  mGreen.push_back(colour.y);  mBlue.push_back(colour.z);  mRotation.push_back(rotation);
+}
+
+
+// Add all the sprites of another batch
+void SpriteBatch::Add(const SpriteBatch& sprites)
+{
+    auto append = [](std::vector<float>& to, const std::vector<float>& from)  { to.insert(to.end(), from.begin(), from.end()); };
+    append(mX,   sprites.mX);    append(mY,     sprites.mY);      append(mZ,    sprites.mZ);     append(mSize,     sprites.mSize);
+    append(mRed, sprites.mRed);  append(mGreen, sprites.mGreen);  append(mBlue, sprites.mBlue);  append(mRotation, sprites.mRotation);
+}
+
+
+// Write the vertices of numSprites sprites starting from the given one, SPRITE_VERTICES_PER_SPRITE for each
+void SpriteBatch::WriteVertices(uint32_t first, uint32_t numSprites, SpriteVertex* vertices) const
+{
+    // The vertices usually go straight into a mapped GPU buffer, which is slow to read but fast to write in order. So
+    // each vertex is written once, from front to back, and nothing is read back
+    float* output = reinterpret_cast<float*>(vertices);
+    uint32_t sprite = first;
+    uint32_t end = first + numSprites;
+
+    // Load a value from four sprites from each array, then transpose so each register holds one sprite's position and
+    // size, or colour and rotation, which is half a vertex. Each half is then stored in all four of the sprite's vertices
+    for (; sprite + 4 <= end; sprite += 4)
+    {
+        __m128 positionSize0 = _mm_loadu_ps(&mX[sprite]);
+        __m128 positionSize1 = _mm_loadu_ps(&mY[sprite]);
+        __m128 positionSize2 = _mm_loadu_ps(&mZ[sprite]);
+        __m128 positionSize3 = _mm_loadu_ps(&mSize[sprite]);
+        _MM_TRANSPOSE4_PS(positionSize0, positionSize1, positionSize2, positionSize3);
+
+        __m128 colourRotation0 = _mm_loadu_ps(&mRed[sprite]);
+        __m128 colourRotation1 = _mm_loadu_ps(&mGreen[sprite]);
+        __m128 colourRotation2 = _mm_loadu_ps(&mBlue[sprite]);
+        __m128 colourRotation3 = _mm_loadu_ps(&mRotation[sprite]);
+        _MM_TRANSPOSE4_PS(colourRotation0, colourRotation1, colourRotation2, colourRotation3);
+
+        __m128 positionSize[4]   = { positionSize0,   positionSize1,   positionSize2,   positionSize3   };
+        __m128 colourRotation[4] = { colourRotation0, colourRotation1, colourRotation2, colourRotation3 };
+        for (int i = 0; i < 4; ++i)
+        {
+            for (uint32_t corner = 0; corner < SPRITE_VERTICES_PER_SPRITE; ++corner)
+            {
+                _mm_storeu_ps(output,     positionSize[i]);
+                _mm_storeu_ps(output + 4, colourRotation[i]);
+                output += 8;
+            }
+        }
+    }
+
+    // The last few sprites one at a time
+    for (; sprite < end; ++sprite)
+    {
+        SpriteVertex vertex = { { mX[sprite], mY[sprite], mZ[sprite] }, mSize[sprite],
+                                { mRed[sprite], mGreen[sprite], mBlue[sprite] }, mRotation[sprite] };
+        SpriteVertex* spriteVertices = reinterpret_cast<SpriteVertex*>(output);
+        for (uint32_t corner = 0; corner < SPRITE_VERTICES_PER_SPRITE; ++corner)  spriteVertices[corner] = vertex;
+        output += 8 * SPRITE_VERTICES_PER_SPRITE;
+    }
+}
@@ -0,0 +1,57 @@
+//--------------------------------------------------------------------------------------
+// Camera-facing sprite batches
+//--------------------------------------------------------------------------------------
+// Sprites (camera-facing textured squares such as light flares) are collected in a SpriteBatch
+// so those sharing a texture are drawn in one call. WriteVertices converts four sprites at a
+// time with SSE into the vertex layout below, which doesn't depend on the camera.
+
+#ifndef _SPRITE_BATCH_H_INCLUDED_
+#define _SPRITE_BATCH_H_INCLUDED_
+
+#include "CVector3.h"
+
+#include <vector>
+#include <cstdint>
+
+
+// One corner of a sprite, two sets of four floats so four sprites can be transposed into place at once
+struct SpriteVertex
+{
+    CVector3 position; // Centre of the sprite in the world
+    float    size;     // Width and height in world units
+    CVector3 colour;   // Multiplies the texture colour
+    float    rotation; // Radians anticlockwise on screen
+};
+
+// Each sprite uses 4 vertices and 6 indices: 0 1 2, 2 1 3 (offset by 4 for each sprite), the same as outline quads
+const uint32_t SPRITE_VERTICES_PER_SPRITE = 4;
+const uint32_t SPRITE_INDICES_PER_SPRITE  = 6;
+
+
+class SpriteBatch
+{
+public:
+    // Remove all sprites, keeping the memory for the next ones
+    void Clear();
+
+    void Reserve(uint32_t numSprites);
+
+    void Add(const CVector3& position, float size, const CVector3& colour, float rotation = 0);
+
+    // Add all the sprites of another batch
+    void Add(const SpriteBatch& sprites);
+
+    uint32_t Size()  const  { return static_cast<uint32_t>(mX.size()); }
+    bool     Empty() const  { return mX.empty(); }
+
+    // Write the vertices of numSprites sprites starting from the given one, SPRITE_VERTICES_PER_SPRITE for each
+    void WriteVertices(uint32_t first, uint32_t numSprites, SpriteVertex* vertices) const;
+
+private:
+    // Each value in a separate array so four sprites can be loaded at once
+    std::vector<float> mX, mY, mZ, mSize;
+    std::vector<float> mRed, mGreen, mBlue, mRotation;
+};
+
+
+#endif //_SPRITE_BATCH_H_INCLUDED_
@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------------------
+// Allocation of texture array slices
+//--------------------------------------------------------------------------------------
+
+#include "TextureArrayAllocator.h"
+
+
+// Find a slot for a texture: the lowest free slice in the first page with a matching key that has room, otherwise an
+// empty page (given the new key) or else a new page
+TextureArraySlot TextureArrayAllocator::Allocate(const TextureArrayKey& key)
+{
+    uint32_t emptyPage = NumPages();
+    for (uint32_t page = 0; page < NumPages(); ++page)
+    {
+        Page& current = mPages[page];
+        if (current.numUsed == 0)
+        {
+            if (emptyPage == NumPages())  emptyPage = page;
+            continue;
+        }
+        if (current.key != key || current.numUsed == mSlicesPerPage)  continue;
+
+        for (uint32_t slice = 0; slice < mSlicesPerPage; ++slice)
+        {
+            if (!current.used[slice])
+            {
+                current.used[slice] = true;
+                ++current.numUsed;
+                return { page, slice };
+            }
+        }
+    }
+
+    if (emptyPage == NumPages())  mPages.push_back({ key, std::vector<bool>(mSlicesPerPage, false), 0 });
+    Page& page = mPages[emptyPage];
+    page.key = key;
+    page.used[0] = true;
+    page.numUsed = 1;
+    return { emptyPage, 0 };
+}
+
+
+// Free a slot, the slice will be reused by the next allocation with the same key. A page whose slices are all free
+// can be reused for any key
+void TextureArrayAllocator::Free(TextureArraySlot slot)
+{
+    if (slot.page >= NumPages() || slot.slice >= mSlicesPerPage)  return;
+
+    Page& page = mPages[slot.page];
+    if (page.used[slot.slice])
+    {
+        page.used[slot.slice] = false;
+        --page.numUsed;
+    }
+}
+
+
+// Number of slices a page's texture array needs to hold all of its slots, i.e. one more than the highest slice in use.
+// Free slices below that are gaps in the array
+uint32_t TextureArrayAllocator::ArraySize(uint32_t page) const
+{
+    const Page& current = mPages[page];
+    for (uint32_t size = mSlicesPerPage; size > 0; --size)
+    {
+        if (current.used[size - 1])  return size;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+//--------------------------------------------------------------------------------------
+// Allocation of texture array slices
+//--------------------------------------------------------------------------------------
+// Textures of the same size, format and mip count can share the slices of one Texture2DArray
+// (a "page"), so models using them need the page bound once and can be instanced together.
+// This decides the page and slice of each texture, keeping pages full and reusing free slices.
+
+#ifndef _TEXTURE_ARRAY_ALLOCATOR_H_INCLUDED_
+#define _TEXTURE_ARRAY_ALLOCATOR_H_INCLUDED_
+
+#include "DDSFile.h" // For DXGI_FORMAT
+
+#include <vector>
+#include <cstdint>
+
+
+// Textures that can share a page - every slice of a texture array has the same size, format and number of mip levels
+struct TextureArrayKey
+{
+    DXGI_FORMAT format;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    mipLevels;
+
+    bool operator==(const TextureArrayKey& other) const
+    {
+        return format == other.format && width == other.width && height == other.height && mipLevels == other.mipLevels;
+    }
+    bool operator!=(const TextureArrayKey& other) const  { return !(*this == other); }
+};
+
+// Position of a texture in the pages
+struct TextureArraySlot
+{
+    uint32_t page;
+    uint32_t slice;
+};
+
+
+class TextureArrayAllocator
+{
+public:
+    // Pages hold up to the given number of slices (Direct3D 11 allows up to 2048)
+    explicit TextureArrayAllocator(uint32_t slicesPerPage = 16) : mSlicesPerPage(slicesPerPage) {}
+
+    // Find a slot for a texture: the lowest free slice in the first page with a matching key that has room, otherwise an
+    // empty page (given the new key) or else a new page
+    TextureArraySlot Allocate(const TextureArrayKey& key);
+
+    // Free a slot, the slice will be reused by the next allocation with the same key. A page whose slices are all free
+    // can be reused for any key
+    void Free(TextureArraySlot slot);
+
+    // Forget all pages
+    void Clear()  { mPages.clear(); }
+
+
+    uint32_t               NumPages() const                { return static_cast<uint32_t>(mPages.size()); }
+    uint32_t               SlicesPerPage() const           { return mSlicesPerPage; }
+    const TextureArrayKey& PageKey(uint32_t page) const    { return mPages[page].key; }
+
+    // Number of slices in use in a page
+    uint32_t UsedSlices(uint32_t page) const  { return mPages[page].numUsed; }
+
+    // Number of slices a page's texture array needs to hold all of its slots, i.e. one more than the highest slice in use.
+    // Free slices below that are gaps in the array
+    uint32_t ArraySize(uint32_t page) const;
+
+
+private:
+    struct Page
+    {
+        TextureArrayKey   key;
+        std::vector<bool> used;    // Which slices are in use, always SlicesPerPage entries
+        uint32_t          numUsed;
+    };
+
+    uint32_t          mSlicesPerPage;
+    std::vector<Page> mPages;
+};
+
+
+#endif //_TEXTURE_ARRAY_ALLOCATOR_H_INCLUDED_
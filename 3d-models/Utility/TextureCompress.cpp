@@ -0,0 +1,645 @@
+//--------------------------------------------------------------------------------------
+// Block compression (BC1/BC3/BC4/BC5/BC7) of 8-bit RGBA images
+//--------------------------------------------------------------------------------------
+
+#include "TextureCompress.h"
+
+#include <emmintrin.h> // SSE2
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <cmath>
+#include <cfloat>
+
+
+namespace
+{
+    //--------------------------------------------------------------------------------------
+    // Shared fitting code
+    //--------------------------------------------------------------------------------------
+
+    // One 4x4 block of pixels with each channel (RGBA, 0-255) in a separate array, which suits SSE. Pixels past the edge
+    // of the image are copies of the edge pixels with a weight of 0, so they affect neither the fitting nor the error
+    struct Block
+    {
+        alignas(16) float channel[4][16];
+        alignas(16) float weight[16];
+    };
+
+    const int MAX_CHANNELS = 4;
+
+
+    // Sums, smallest and largest of the four lanes of a register
+    float HorizontalSum(__m128 v)
+    {
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    }
+
+    float HorizontalMin(__m128 v)
+    {
+        v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_min_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    }
+
+    float HorizontalMax(__m128 v)
+    {
+        v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    }
+
+    // Lanes of a where the mask is set, b elsewhere
+    __m128 Select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+
+    // Choose the nearest palette entry for every pixel in the block, comparing numChannels channels starting from
+    // firstChannel. Palette entries hold just those channels. Returns the squared error, weighted by pixel weight.
+    // This is where encoding spends most of its time, so it uses SSE to test four pixels at once
+    float FitIndices(const Block& block, int firstChannel, int numChannels, const float (*palette)[4], int paletteSize, uint8_t indices[16])
+    {
+        __m128 totalError = _mm_setzero_ps();
+        for (int pixel = 0; pixel < 16; pixel += 4)
+        {
+            __m128 values[MAX_CHANNELS];
+            for (int c = 0; c < numChannels; ++c)  values[c] = _mm_load_ps(&block.channel[firstChannel + c][pixel]);
+
+            __m128 bestError = _mm_set1_ps(FLT_MAX);
+            __m128 bestIndex = _mm_setzero_ps();
+            for (int entry = 0; entry < paletteSize; ++entry)
+            {
+                __m128 error = _mm_setzero_ps();
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    __m128 difference = _mm_sub_ps(values[c], _mm_set1_ps(palette[entry][c]));
+                    error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+                }
+                __m128 closer = _mm_cmplt_ps(error, bestError);
+                bestError = _mm_min_ps(error, bestError);
+                bestIndex = Select(closer, _mm_set1_ps(static_cast<float>(entry)), bestIndex);
+            }
+
+            alignas(16) int32_t index[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_cvttps_epi32(bestIndex));
+            for (int i = 0; i < 4; ++i)  indices[pixel + i] = static_cast<uint8_t>(index[i]);
+            totalError = _mm_add_ps(totalError, _mm_mul_ps(bestError, _mm_load_ps(&block.weight[pixel])));
+        }
+
+        return HorizontalSum(totalError);
+    }
+
+
+    // Find the line that best fits the block's colours (the principal axis, found by power iteration on the covariance
+    // matrix) and return the extreme points of the colours projected onto it. The endpoint search starts from these. The
+    // sums over the pixels use SSE, four pixels at a time, only the small power iteration is scalar
+    void PrincipalAxisEndpoints(const Block& block, int firstChannel, int numChannels, float start[4], float end[4])
+    {
+        // The block's pixels in four registers for each channel, centred on the mean once it is known
+        __m128 weight[4], values[MAX_CHANNELS][4];
+        __m128 weightSum = _mm_setzero_ps();
+        __m128 valueSum[MAX_CHANNELS];
+        for (int c = 0; c < numChannels; ++c)  valueSum[c] = _mm_setzero_ps();
+        for (int group = 0; group < 4; ++group)
+        {
+            weight[group] = _mm_load_ps(&block.weight[group * 4]);
+            weightSum = _mm_add_ps(weightSum, weight[group]);
+            for (int c = 0; c < numChannels; ++c)
+            {
+                values[c][group] = _mm_load_ps(&block.channel[firstChannel + c][group * 4]);
+                valueSum[c] = _mm_add_ps(valueSum[c], _mm_mul_ps(weight[group], values[c][group]));
+            }
+        }
+
+        float totalWeight = HorizontalSum(weightSum);
+        float mean[MAX_CHANNELS] = {};
+        for (int c = 0; c < numChannels; ++c)
+        {
+            mean[c] = HorizontalSum(valueSum[c]) / totalWeight;
+            for (int group = 0; group < 4; ++group)  values[c][group] = _mm_sub_ps(values[c][group], _mm_set1_ps(mean[c]));
+        }
+
+        float covariance[MAX_CHANNELS][MAX_CHANNELS] = {};
+        for (int i = 0; i < numChannels; ++i)
+        {
+            for (int j = i; j < numChannels; ++j)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (int group = 0; group < 4; ++group)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(weight[group], _mm_mul_ps(values[i][group], values[j][group])));
+                }
+                covariance[i][j] = covariance[j][i] = HorizontalSum(sum);
+            }
+        }
+
+        float axis[MAX_CHANNELS] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[MAX_CHANNELS] = {};
+            float largest = 0;
+            for (int i = 0; i < numChannels; ++i)
+            {
+                for (int j = 0; j < numChannels; ++j)  next[i] += covariance[i][j] * axis[j];
+                largest = std::max(largest, std::fabs(next[i]));
+            }
+            if (largest < 1e-6f)  break; // All pixels the same colour, any axis will do
+            for (int i = 0; i < numChannels; ++i)  axis[i] = next[i] / largest;
+        }
+
+        float length = 0;
+        for (int c = 0; c < numChannels; ++c)  length += axis[c] * axis[c];
+        length = std::sqrt(length);
+        for (int c = 0; c < numChannels; ++c)  axis[c] /= length;
+
+        // Project the pixels onto the axis, leaving out padding pixels
+        __m128 minT = _mm_set1_ps(FLT_MAX), maxT = _mm_set1_ps(-FLT_MAX);
+        for (int group = 0; group < 4; ++group)
+        {
+            __m128 t = _mm_setzero_ps();
+            for (int c = 0; c < numChannels; ++c)  t = _mm_add_ps(t, _mm_mul_ps(values[c][group], _mm_set1_ps(axis[c])));
+            __m128 used = _mm_cmpneq_ps(weight[group], _mm_setzero_ps());
+            minT = _mm_min_ps(minT, Select(used, t, _mm_set1_ps(FLT_MAX)));
+            maxT = _mm_max_ps(maxT, Select(used, t, _mm_set1_ps(-FLT_MAX)));
+        }
+        float minProjection = HorizontalMin(minT);
+        float maxProjection = HorizontalMax(maxT);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            start[c] = std::min(255.0f, std::max(0.0f, mean[c] + minProjection * axis[c]));
+            end[c]   = std::min(255.0f, std::max(0.0f, mean[c] + maxProjection * axis[c]));
+        }
+    }
+
+
+    // Find the endpoints with the least squared error for the given index choices (linear least squares). indexPosition
+    // gives how far each index is from start to end. Returns false if the indices don't determine the endpoints
+    bool RefineEndpoints(const Block& block, int firstChannel, int numChannels, const uint8_t indices[16], const float* indexPosition,
+                         float start[4], float end[4])
+    {
+        alignas(16) float position[16];
+        for (int pixel = 0; pixel < 16; ++pixel)  position[pixel] = indexPosition[indices[pixel]];
+
+        // Weighted sums over the pixels, four at a time. s is how far each pixel's index is from the end, t from the start
+        __m128 ssSum = _mm_setzero_ps(), stSum = _mm_setzero_ps(), ttSum = _mm_setzero_ps();
+        __m128 sxSum[MAX_CHANNELS], txSum[MAX_CHANNELS];
+        for (int c = 0; c < numChannels; ++c)  sxSum[c] = txSum[c] = _mm_setzero_ps();
+        for (int pixel = 0; pixel < 16; pixel += 4)
+        {
+            __m128 w  = _mm_load_ps(&block.weight[pixel]);
+            __m128 t  = _mm_load_ps(&position[pixel]);
+            __m128 ws = _mm_mul_ps(w, _mm_sub_ps(_mm_set1_ps(1.0f), t));
+            __m128 wt = _mm_mul_ps(w, t);
+            ssSum = _mm_add_ps(ssSum, _mm_mul_ps(ws, _mm_sub_ps(_mm_set1_ps(1.0f), t)));
+            stSum = _mm_add_ps(stSum, _mm_mul_ps(ws, t));
+            ttSum = _mm_add_ps(ttSum, _mm_mul_ps(wt, t));
+            for (int c = 0; c < numChannels; ++c)
+            {
+                __m128 x = _mm_load_ps(&block.channel[firstChannel + c][pixel]);
+                sxSum[c] = _mm_add_ps(sxSum[c], _mm_mul_ps(ws, x));
+                txSum[c] = _mm_add_ps(txSum[c], _mm_mul_ps(wt, x));
+            }
+        }
+
+        float ss = HorizontalSum(ssSum), st = HorizontalSum(stSum), tt = HorizontalSum(ttSum);
+        float sx[MAX_CHANNELS], tx[MAX_CHANNELS];
+        for (int c = 0; c < numChannels; ++c)
+        {
+            sx[c] = HorizontalSum(sxSum[c]);
+            tx[c] = HorizontalSum(txSum[c]);
+        }
+
+        float determinant = ss * tt - st * st;
+        if (std::fabs(determinant) < 1e-6f)  return false;
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            start[c] = std::min(255.0f, std::max(0.0f, (tt * sx[c] - st * tx[c]) / determinant));
+            end[c]   = std::min(255.0f, std::max(0.0f, (ss * tx[c] - st * sx[c]) / determinant));
+        }
+        return true;
+    }
+
+
+
+    //--------------------------------------------------------------------------------------
+    // BC1 colour blocks (also the colour part of BC3)
+    //--------------------------------------------------------------------------------------
+
+    uint16_t ToRGB565(const float colour[4])
+    {
+        int r = std::min(31, std::max(0, static_cast<int>(std::lround(colour[0] * 31.0f / 255.0f))));
+        int g = std::min(63, std::max(0, static_cast<int>(std::lround(colour[1] * 63.0f / 255.0f))));
+        int b = std::min(31, std::max(0, static_cast<int>(std::lround(colour[2] * 31.0f / 255.0f))));
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void FromRGB565(uint16_t rgb565, float colour[4])
+    {
+        int r = (rgb565 >> 11) & 31;
+        int g = (rgb565 >> 5) & 63;
+        int b = rgb565 & 31;
+        colour[0] = static_cast<float>((r << 3) | (r >> 2));
+        colour[1] = static_cast<float>((g << 2) | (g >> 4));
+        colour[2] = static_cast<float>((b << 3) | (b >> 2));
+    }
+
+
+    // Two RGB565 endpoints and a 2-bit index per pixel. Returns the squared error
+    float EncodeColourBlock(const Block& block, CompressQuality quality, uint8_t* output)
+    {
+        static const float INDEX_POSITION[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        float start[4], end[4];
+        PrincipalAxisEndpoints(block, 0, 3, start, end);
+
+        float bestError = FLT_MAX;
+        int iterations = (quality == CompressQuality::Quality) ? 4 : 1;
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            // Four colour mode requires colour0 > colour1, swapping the endpoints reverses the palette
+            uint16_t colour0 = ToRGB565(start);
+            uint16_t colour1 = ToRGB565(end);
+            if (colour0 < colour1)
+            {
+                std::swap(colour0, colour1);
+                std::swap(start, end);
+            }
+
+            float palette[4][4];
+            FromRGB565(colour0, palette[0]);
+            FromRGB565(colour1, palette[1]);
+            int paletteSize = 1; // Equal endpoints select three colour mode, where only the first entry is any use
+            if (colour0 != colour1)
+            {
+                paletteSize = 4;
+                for (int c = 0; c < 3; ++c)
+                {
+                    palette[2][c] = std::round((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+                    palette[3][c] = std::round((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+                }
+            }
+
+            uint8_t indices[16];
+            float error = FitIndices(block, 0, 3, palette, paletteSize, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                uint32_t indexBits = 0;
+                for (int pixel = 0; pixel < 16; ++pixel)  indexBits |= static_cast<uint32_t>(indices[pixel]) << (pixel * 2);
+                output[0] = static_cast<uint8_t>(colour0);
+                output[1] = static_cast<uint8_t>(colour0 >> 8);
+                output[2] = static_cast<uint8_t>(colour1);
+                output[3] = static_cast<uint8_t>(colour1 >> 8);
+                for (int i = 0; i < 4; ++i)  output[4 + i] = static_cast<uint8_t>(indexBits >> (i * 8));
+            }
+
+            if (!RefineEndpoints(block, 0, 3, indices, INDEX_POSITION, start, end))  break;
+        }
+        return bestError;
+    }
+
+
+
+    //--------------------------------------------------------------------------------------
+    // BC4 single channel blocks (also BC5 and the alpha part of BC3)
+    //--------------------------------------------------------------------------------------
+
+    // Two 8-bit endpoints and a 3-bit index per pixel for one channel. Returns the squared error
+    float EncodeSingleChannelBlock(const Block& block, int channel, CompressQuality quality, uint8_t* output)
+    {
+        static const float INDEX_POSITION[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+        float bestError = FLT_MAX;
+        uint8_t indices[16];
+
+        // value0 > value1 gives 8 levels from value0 to value1, otherwise 6 levels from value0 to value1 plus 0 and 255
+        auto tryEndpoints = [&](int value0, int value1)
+        {
+            float palette[8][4];
+            palette[0][0] = static_cast<float>(value0);
+            palette[1][0] = static_cast<float>(value1);
+            if (value0 > value1)
+            {
+                for (int i = 1; i < 7; ++i)  palette[i + 1][0] = std::round(((7 - i) * value0 + i * value1) / 7.0f);
+            }
+            else
+            {
+                for (int i = 1; i < 5; ++i)  palette[i + 1][0] = std::round(((5 - i) * value0 + i * value1) / 5.0f);
+                palette[6][0] = 0.0f;
+                palette[7][0] = 255.0f;
+            }
+
+            float error = FitIndices(block, channel, 1, palette, 8, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                uint64_t indexBits = 0;
+                for (int pixel = 0; pixel < 16; ++pixel)  indexBits |= static_cast<uint64_t>(indices[pixel]) << (pixel * 3);
+                output[0] = static_cast<uint8_t>(value0);
+                output[1] = static_cast<uint8_t>(value1);
+                for (int i = 0; i < 6; ++i)  output[2 + i] = static_cast<uint8_t>(indexBits >> (i * 8));
+            }
+        };
+
+        // Range of all values, and of values other than 0 and 255, leaving out padding pixels. Four pixels at a time
+        __m128 minValues = _mm_set1_ps(255.0f), maxValues = _mm_setzero_ps();
+        __m128 minInners = _mm_set1_ps(255.0f), maxInners = _mm_setzero_ps();
+        for (int pixel = 0; pixel < 16; pixel += 4)
+        {
+            __m128 value = _mm_load_ps(&block.channel[channel][pixel]);
+            __m128 used  = _mm_cmpneq_ps(_mm_load_ps(&block.weight[pixel]), _mm_setzero_ps());
+            __m128 inner = _mm_and_ps(used, _mm_and_ps(_mm_cmpgt_ps(value, _mm_setzero_ps()), _mm_cmplt_ps(value, _mm_set1_ps(255.0f))));
+            minValues = _mm_min_ps(minValues, Select(used,  value, _mm_set1_ps(255.0f)));
+            maxValues = _mm_max_ps(maxValues, Select(used,  value, _mm_setzero_ps()));
+            minInners = _mm_min_ps(minInners, Select(inner, value, _mm_set1_ps(255.0f)));
+            maxInners = _mm_max_ps(maxInners, Select(inner, value, _mm_setzero_ps()));
+        }
+        float minValue = HorizontalMin(minValues), maxValue = HorizontalMax(maxValues);
+        float minInner = HorizontalMin(minInners), maxInner = HorizontalMax(maxInners);
+
+        int high = static_cast<int>(maxValue);
+        int low  = static_cast<int>(minValue);
+        tryEndpoints(high, low);
+        if (quality == CompressQuality::Quality && high != low)
+        {
+            // The indices just chosen are still in the indices array
+            float start[4] = { static_cast<float>(high) }, end[4] = { static_cast<float>(low) };
+            for (int iteration = 0; iteration < 3; ++iteration)
+            {
+                if (!RefineEndpoints(block, channel, 1, indices, INDEX_POSITION, start, end))  break;
+                int value0 = static_cast<int>(std::lround(start[0]));
+                int value1 = static_cast<int>(std::lround(end[0]));
+                if (value0 <= value1)  break;
+                tryEndpoints(value0, value1);
+            }
+
+            // Blocks with a few values at exactly 0 or 255 may be better served by the 6 level mode
+            if (minInner <= maxInner)  tryEndpoints(static_cast<int>(minInner), static_cast<int>(maxInner));
+        }
+        return bestError;
+    }
+
+
+
+    //--------------------------------------------------------------------------------------
+    // BC7 mode 6 blocks
+    //--------------------------------------------------------------------------------------
+
+    const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // Mode 6 endpoints are 7 bits per channel plus a low bit (the "p-bit") shared by all channels of the endpoint
+    void QuantiseBC7Endpoint(const float endpoint[4], int pBit, int quantised[4])
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            quantised[c] = std::min(127, std::max(0, static_cast<int>(std::lround((endpoint[c] - pBit) * 0.5f))));
+        }
+    }
+
+    // The p-bit that gives the least error when quantising an endpoint
+    int ChooseBC7PBit(const float endpoint[4])
+    {
+        float error[2] = { 0, 0 };
+        for (int pBit = 0; pBit < 2; ++pBit)
+        {
+            int quantised[4];
+            QuantiseBC7Endpoint(endpoint, pBit, quantised);
+            for (int c = 0; c < 4; ++c)
+            {
+                float difference = endpoint[c] - (quantised[c] * 2 + pBit);
+                error[pBit] += difference * difference;
+            }
+        }
+        return error[1] < error[0] ? 1 : 0;
+    }
+
+
+    // Mode 6: one pair of RGBA endpoints and a 4-bit index per pixel. Returns the squared error
+    float EncodeBC7Block(const Block& block, CompressQuality quality, uint8_t* output)
+    {
+        static const float INDEX_POSITION[16] = { 0 / 64.0f,  4 / 64.0f,  9 / 64.0f, 13 / 64.0f, 17 / 64.0f, 21 / 64.0f, 26 / 64.0f, 30 / 64.0f,
+                                                  34 / 64.0f, 38 / 64.0f, 43 / 64.0f, 47 / 64.0f, 51 / 64.0f, 55 / 64.0f, 60 / 64.0f, 64 / 64.0f };
+
+        float start[4], end[4];
+        PrincipalAxisEndpoints(block, 0, 4, start, end);
+
+        float bestError = FLT_MAX;
+        int bestEndpoints[2][4] = {}, bestPBits[2] = {};
+        uint8_t bestIndices[16] = {};
+
+        int iterations = (quality == CompressQuality::Quality) ? 4 : 1;
+        for (int iteration = 0; iteration < iterations; ++iteration)
+        {
+            // The fast preset only tries the p-bits that best suit each endpoint, the quality preset tries every combination
+            int fastPBits = ChooseBC7PBit(start) | (ChooseBC7PBit(end) << 1);
+
+            float iterationError = FLT_MAX;
+            uint8_t iterationIndices[16];
+            for (int pBits = 0; pBits < 4; ++pBits)
+            {
+                if (quality == CompressQuality::Fast && pBits != fastPBits)  continue;
+
+                int pBit[2] = { pBits & 1, pBits >> 1 };
+                int endpoints[2][4];
+                QuantiseBC7Endpoint(start, pBit[0], endpoints[0]);
+                QuantiseBC7Endpoint(end,   pBit[1], endpoints[1]);
+
+                float palette[16][4];
+                for (int i = 0; i < 16; ++i)
+                {
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        int value0 = endpoints[0][c] * 2 + pBit[0];
+                        int value1 = endpoints[1][c] * 2 + pBit[1];
+                        palette[i][c] = static_cast<float>(((64 - BC7_WEIGHTS[i]) * value0 + BC7_WEIGHTS[i] * value1 + 32) >> 6);
+                    }
+                }
+
+                uint8_t indices[16];
+                float error = FitIndices(block, 0, 4, palette, 16, indices);
+                if (error < iterationError)
+                {
+                    iterationError = error;
+                    std::copy(indices, indices + 16, iterationIndices);
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    std::copy(&endpoints[0][0], &endpoints[0][0] + 8, &bestEndpoints[0][0]);
+                    bestPBits[0] = pBit[0];
+                    bestPBits[1] = pBit[1];
+                    std::copy(indices, indices + 16, bestIndices);
+                }
+            }
+
+            if (iteration + 1 < iterations && !RefineEndpoints(block, 0, 4, iterationIndices, INDEX_POSITION, start, end))  break;
+        }
+
+        // The top bit of the first pixel's index isn't stored (it is always 0), so swap the endpoints if it is set
+        if (bestIndices[0] >= 8)
+        {
+            std::swap(bestEndpoints[0], bestEndpoints[1]);
+            std::swap(bestPBits[0], bestPBits[1]);
+            for (int pixel = 0; pixel < 16; ++pixel)  bestIndices[pixel] = 15 - bestIndices[pixel];
+        }
+
+        // Pack the 128 bits, least significant first: mode (bit 6 set), R0 R1 G0 G1 B0 B1 A0 A1, P0 P1, then the indices
+        uint64_t bits[2] = { 0, 0 };
+        int position = 0;
+        auto write = [&](uint64_t value, int numBits)
+        {
+            for (int bit = 0; bit < numBits; ++bit, ++position)
+            {
+                bits[position >> 6] |= ((value >> bit) & 1) << (position & 63);
+            }
+        };
+        write(1 << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            write(bestEndpoints[0][c], 7);
+            write(bestEndpoints[1][c], 7);
+        }
+        write(bestPBits[0], 1);
+        write(bestPBits[1], 1);
+        write(bestIndices[0], 3);
+        for (int pixel = 1; pixel < 16; ++pixel)  write(bestIndices[pixel], 4);
+
+        for (int i = 0; i < 16; ++i)  output[i] = static_cast<uint8_t>(bits[i >> 3] >> ((i & 7) * 8));
+        return bestError;
+    }
+
+
+
+    //--------------------------------------------------------------------------------------
+    // Images
+    //--------------------------------------------------------------------------------------
+
+    // Number of channels stored by a format that CompressTexture supports, 0 for other formats
+    int NumCompressedChannels(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return 3;
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return 4;
+
+        case DXGI_FORMAT_BC4_UNORM:
+            return 1;
+
+        case DXGI_FORMAT_BC5_UNORM:
+            return 2;
+
+        default:
+            return 0;
+        }
+    }
+
+
+    // Copy a block of pixels out of the image, padding past the edges
+    void LoadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch, uint32_t blockX, uint32_t blockY, Block& block)
+    {
+        for (uint32_t y = 0; y < 4; ++y)
+        {
+            for (uint32_t x = 0; x < 4; ++x)
+            {
+                uint32_t pixelX = blockX * 4 + x;
+                uint32_t pixelY = blockY * 4 + y;
+                const uint8_t* pixel = pixels + static_cast<size_t>(std::min(pixelY, height - 1)) * rowPitch + std::min(pixelX, width - 1) * 4;
+
+                int i = y * 4 + x;
+                for (int c = 0; c < 4; ++c)  block.channel[c][i] = pixel[c];
+                block.weight[i] = (pixelX < width && pixelY < height) ? 1.0f : 0.0f;
+            }
+        }
+    }
+
+
+    // Compress one block, returns the squared error
+    float EncodeBlock(DXGI_FORMAT format, const Block& block, CompressQuality quality, uint8_t* output)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return EncodeColourBlock(block, quality, output);
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return EncodeSingleChannelBlock(block, 3, quality, output) + EncodeColourBlock(block, quality, output + 8);
+
+        case DXGI_FORMAT_BC4_UNORM:
+            return EncodeSingleChannelBlock(block, 0, quality, output);
+
+        case DXGI_FORMAT_BC5_UNORM:
+            return EncodeSingleChannelBlock(block, 0, quality, output) + EncodeSingleChannelBlock(block, 1, quality, output + 8);
+
+        default: // BC7
+            return EncodeBC7Block(block, quality, output);
+        }
+    }
+}
+
+
+// True if CompressTexture supports the given format
+bool CanCompress(DXGI_FORMAT format)
+{
+    return NumCompressedChannels(format) != 0;
+}
+
+
+// Compress an image of 8-bit RGBA pixels into blocks of the given format. Images that aren't a multiple of 4 pixels in
+// size have their edge blocks padded. The output must hold the number of bytes given by GetSurfaceInfo for the format.
+// Returns false if the format is not supported. Optionally returns the PSNR of the result compared to the source
+bool CompressTexture(DXGI_FORMAT format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch,
+                     uint8_t* output, CompressQuality quality, unsigned int numThreads /*= 1*/, double* psnr /*= nullptr*/)
+{
+    int numChannels = NumCompressedChannels(format);
+    if (numChannels == 0 || width == 0 || height == 0)  return false;
+
+    uint32_t blockBytes = BitsPerPixel(format) * 2;
+    uint32_t blocksX = (width  + 3) / 4;
+    uint32_t blocksY = (height + 3) / 4;
+
+    // Each thread takes the next unprocessed row of blocks until there are none left
+    numThreads = std::max(1u, std::min(numThreads, blocksY));
+    std::atomic<uint32_t> nextRow(0);
+    std::vector<double> threadError(numThreads, 0.0);
+    auto worker = [&](unsigned int thread)
+    {
+        Block block;
+        for (uint32_t row = nextRow++; row < blocksY; row = nextRow++)
+        {
+            uint8_t* out = output + static_cast<size_t>(row) * blocksX * blockBytes;
+            for (uint32_t column = 0; column < blocksX; ++column, out += blockBytes)
+            {
+                LoadBlock(pixels, width, height, rowPitch, column, row, block);
+                threadError[thread] += EncodeBlock(format, block, quality, out);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int thread = 1; thread < numThreads; ++thread)  threads.emplace_back(worker, thread);
+    worker(0);
+    for (auto& thread : threads)  thread.join();
+
+    if (psnr != nullptr)
+    {
+        double totalError = 0;
+        for (double error : threadError)  totalError += error;
+        double meanError = totalError / (static_cast<double>(width) * height * numChannels);
+        *psnr = (meanError > 0) ? 10.0 * std::log10(255.0 * 255.0 / meanError) : std::numeric_limits<double>::infinity();
+    }
+    return true;
+}
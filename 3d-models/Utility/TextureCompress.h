@@ -0,0 +1,36 @@
+//--------------------------------------------------------------------------------------
+// Block compression (BC1/BC3/BC4/BC5/BC7) of 8-bit RGBA images
+//--------------------------------------------------------------------------------------
+// Done offline by the AssetCooker. Endpoints are found along the principal axis of each 4x4
+// block's colours, then refined by least squares in the Quality preset. The endpoint search
+// and choosing each pixel's index both use SSE on four pixels at a time, and rows of blocks are
+// spread over threads. BC7 uses mode 6 only (one pair of RGBA endpoints, 16 levels).
+
+#ifndef _TEXTURE_COMPRESS_H_INCLUDED_
+#define _TEXTURE_COMPRESS_H_INCLUDED_
+
+#include "DDSFile.h" // For DXGI_FORMAT
+
+#include <cstdint>
+
+
+enum class CompressQuality
+{
+    Fast,    // Endpoints from the principal axis only
+    Quality, // Least squares refinement of the endpoints and a wider search of BC4 and BC7 options
+};
+
+
+// True if CompressTexture supports the given format
+bool CanCompress(DXGI_FORMAT format);
+
+// Compress an image of 8-bit RGBA pixels into blocks of the given format. Images that aren't a multiple of 4 pixels in
+// size have their edge blocks padded. The output must hold the number of bytes given by GetSurfaceInfo for the format.
+// BC4 compresses the red channel and BC5 red and green, BC1 ignores alpha. Compression is spread over the given number
+// of threads. Returns false if the format is not supported. Optionally returns the PSNR of the compressed image compared
+// to the source in decibels, measured over the channels that the format stores (higher is better, above 40 is very good)
+bool CompressTexture(DXGI_FORMAT format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch,
+                     uint8_t* output, CompressQuality quality, unsigned int numThreads = 1, double* psnr = nullptr);
+
+
+#endif //_TEXTURE_COMPRESS_H_INCLUDED_
@@ -0,0 +1,387 @@
+//--------------------------------------------------------------------------------------
+// Streaming of texture mip levels by screen-space demand
+//--------------------------------------------------------------------------------------
+
+#include "TextureStreamer.h"
+#include "AssetPackage.h"
+#include "Profiler.h"
+#include "Allocators.h"
+#include "MemoryTracker.h"
+
+
+// The texture streamer used by the scene
+TextureStreamer gTextureStreamer;
+
+
+namespace
+{
+    // The base mip level of a texture is the largest one no bigger than this in either direction. Base levels are loaded
+    // with the texture and always stay resident, so there is always something to render with
+    const uint32_t BASE_MIP_SIZE = 64;
+
+    // Detail that hasn't been asked for in this many frames is dropped even when within budget. The delay stops detail
+    // being thrown away and loaded again as a model moves back and forth across a mip boundary
+    const uint64_t DROP_DELAY_FRAMES = 120;
+}
+
+
+TexturePage::~TexturePage()
+{
+    if (srv)      srv->Release();
+    if (texture)  texture->Release();
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Setup
+//--------------------------------------------------------------------------------------
+
+// Start the worker thread. Streamed textures will only be given more detail while their total size is within the
+// given budget (in bytes). The base mip levels of each texture are always resident and may go over the budget
+void TextureStreamer::Init(size_t budgetBytes)
+{
+    Shutdown();
+    mBudget = budgetBytes;
+    mFrame  = 0;
+    mWorker = std::thread(&TextureStreamer::WorkerThread, this);
+}
+
+
+// Stop the worker thread and release all textures
+void TextureStreamer::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWorkReady.notify_all();
+    if (mWorker.joinable())  mWorker.join();
+
+    for (auto& result : mResults)
+    {
+        if (result.srv)       result.srv->Release();
+        if (result.texture)   result.texture->Release();
+    }
+    mResults.clear();
+    mQueue.clear();
+    mTextures.clear();
+    mPages.clear();
+    mAllocator.Clear();
+    mStopping = false;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Textures
+//--------------------------------------------------------------------------------------
+
+// Load a texture for streaming with only its base (smallest) mip levels on the GPU. Textures are shared between calls
+// with the same file name. Textures in the asset package are used if present, otherwise the file must be a DDS file
+// holding a single 2D texture with mip-maps. Returns nullptr on failure
+StreamedTexture* TextureStreamer::Load(const std::string& fileName)
+{
+    auto existing = mTextures.find(fileName);
+    if (existing != mTextures.end())  return existing->second.get();
+
+    std::unique_ptr<StreamedTexture> texture(new StreamedTexture);
+    texture->mName = fileName;
+
+    // The data stays mapped for the life of the texture. Loose files are not prefetched, most of a file is its most
+    // detailed mip levels, which may never be needed
+    const uint8_t* data;
+    size_t size;
+    const PackageEntry* cooked = gAssetPackage.Find(fileName, AssetType::Texture);
+    if (cooked != nullptr)
+    {
+        data = gAssetPackage.Data(*cooked);
+        size = static_cast<size_t>(cooked->size);
+    }
+    else
+    {
+        texture->mFile.reset(new MappedFile);
+        if (!texture->mFile->Open(fileName))  return nullptr;
+        data = texture->mFile->Data();
+        size = texture->mFile->Size();
+    }
+
+    DDSTexture& dds = texture->mDDS;
+    if (!ParseDDS(data, size, dds) || dds.dimension != DDS_DIMENSION_TEXTURE2D || dds.arraySize != 1 || dds.cubeMap)
+    {
+        return nullptr;
+    }
+
+    // Put the texture in a page with others of the same size and format
+    texture->mSlot = mAllocator.Allocate({ dds.format, dds.width, dds.height, dds.mipLevels });
+    if (texture->mSlot.page == mPages.size())  mPages.emplace_back(new TexturePage);
+    TexturePage& page = *mPages[texture->mSlot.page];
+    texture->mPage = &page;
+
+    // Set up new pages (or empty ones being reused) for this size and format of texture
+    if (mAllocator.UsedSlices(texture->mSlot.page) == 1)
+    {
+        // GPU memory used with each mip level as the most detailed one, i.e. the size of that level and all smaller ones
+        page.mipBytes.assign(dds.mipLevels + 1, 0);
+        for (uint32_t mip = dds.mipLevels; mip-- > 0; )
+        {
+            page.mipBytes[mip] = page.mipBytes[mip + 1] + dds.subresources[mip].slicePitch;
+        }
+
+        page.baseMip = 0;
+        while (page.baseMip + 1 < dds.mipLevels && std::max(dds.width >> page.baseMip, dds.height >> page.baseMip) > BASE_MIP_SIZE)
+        {
+            ++page.baseMip;
+        }
+        page.residentMip = TexturePage::NO_MIP;
+        page.lastUsedFrame = page.lastDetailFrame = mFrame;
+    }
+
+    // Recreate the page with the new slice at the detail it already has (any load in progress for the page is for the
+    // old slices and will be thrown away when it finishes)
+    std::vector<const DDSTexture*> slices = page.slices;
+    slices.resize(mAllocator.ArraySize(texture->mSlot.page), nullptr);
+    slices[texture->mSlot.slice] = &dds;
+
+    uint32_t mip = page.residentMip != TexturePage::NO_MIP ? page.residentMip : page.baseMip;
+    ID3D11Resource* pageTexture;
+    ID3D11ShaderResourceView* srv;
+    if (!CreateLevels(slices, mip, &pageTexture, &srv))
+    {
+        // The slice goes back to the allocator. A page that was new is left empty with no resident levels, ready for the
+        // allocator to reuse, and takes no memory in the budget (see TexturePage::Bytes)
+        mAllocator.Free(texture->mSlot);
+        return nullptr;
+    }
+    page.slices = std::move(slices);
+    SwapLevels(page, mip, pageTexture, srv);
+
+    StreamedTexture* result = texture.get();
+    mTextures[fileName] = std::move(texture);
+    return result;
+}
+
+
+// Create a texture array holding the mip levels from the given one down for the given slices, can be called from any
+// thread. Unused slices are filled with a copy of another slice
+bool TextureStreamer::CreateLevels(const std::vector<const DDSTexture*>& slices, uint32_t mip, ID3D11Resource** texture,
+                                   ID3D11ShaderResourceView** srv)
+{
+    const DDSTexture* first = nullptr;
+    for (auto slice : slices)  if (first == nullptr)  first = slice;
+    if (first == nullptr)  return false;
+
+    // The smaller texture is read from the same DDS data with the first few subresources of each slice skipped.
+    // Subresources are ordered by slice then mip level
+    uint32_t mipLevels = first->mipLevels - mip;
+    std::vector<D3D11_SUBRESOURCE_DATA> initData;
+    for (auto slice : slices)
+    {
+        if (slice == nullptr)  slice = first;
+        for (uint32_t level = mip; level < first->mipLevels; ++level)
+        {
+            const DDSSubresource& subresource = slice->subresources[level];
+            initData.push_back({ subresource.data, subresource.rowPitch, subresource.slicePitch });
+        }
+    }
+
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    textureDesc.Width      = std::max(1u, first->width  >> mip);
+    textureDesc.Height     = std::max(1u, first->height >> mip);
+    textureDesc.MipLevels  = mipLevels;
+    textureDesc.ArraySize  = static_cast<UINT>(slices.size());
+    textureDesc.Format     = first->format;
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.Usage      = D3D11_USAGE_IMMUTABLE;
+    textureDesc.BindFlags  = D3D11_BIND_SHADER_RESOURCE;
+    ID3D11Texture2D* texture2D;
+    if (FAILED(gD3DDevice->CreateTexture2D(&textureDesc, initData.data(), &texture2D)))  return false;
+
+    // Always an array view, even with one slice, as that is what the shaders expect
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = first->format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    srvDesc.Texture2DArray.MipLevels = mipLevels;
+    srvDesc.Texture2DArray.ArraySize = textureDesc.ArraySize;
+    if (FAILED(gD3DDevice->CreateShaderResourceView(texture2D, &srvDesc, srv)))
+    {
+        texture2D->Release();
+        return false;
+    }
+    *texture = texture2D;
+    return true;
+}
+
+
+// Replace a page's GPU resources with new ones holding the mip levels from the given one down for its current slices. The old texture can be
+// released even if it is still bound to the pipeline, Direct3D keeps it alive until it is no longer in use
+void TextureStreamer::SwapLevels(TexturePage& page, uint32_t mip, ID3D11Resource* texture, ID3D11ShaderResourceView* srv)
+{
+    if (page.srv)      page.srv->Release();
+    if (page.texture)  page.texture->Release();
+    page.texture     = texture;
+    page.srv         = srv;
+    page.arraySize   = static_cast<uint32_t>(page.slices.size());
+    page.residentMip = mip;
+}
+
+
+// Memory used by streamed textures on the GPU, in bytes
+size_t TextureStreamer::ResidentBytes()
+{
+    size_t bytes = 0;
+    for (auto& page : mPages)  bytes += page->Bytes(page->residentMip);
+    return bytes;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Streaming
+//--------------------------------------------------------------------------------------
+
+// Call once per frame after the RequestMip calls for the frame. Swaps in textures finished by the worker thread,
+// drops detail that is no longer needed and starts creating the most needed detail that fits in the budget
+void TextureStreamer::Update()
+{
+    MemoryScope memoryScope(MemoryCategory::StreamedTextures);
+    ++mFrame;
+
+    // Swap in pages finished by the worker thread. Results for a page that has had textures added since the load was
+    // queued are out of date and thrown away. A failed load is simply tried again when next needed
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFinished.swap(mResults);
+    }
+    for (auto& result : mFinished)
+    {
+        TexturePage& page = *result.request.page;
+        page.loadingMip = TexturePage::NO_MIP;
+        if (result.srv != nullptr && result.request.slices == page.slices)
+        {
+            SwapLevels(page, result.request.mip, result.texture, result.srv);
+        }
+        else if (result.srv != nullptr)
+        {
+            result.srv->Release();
+            result.texture->Release();
+        }
+    }
+    mFinished.clear();
+
+
+    // Find the memory that will be used once loads in progress are finished, drop detail that has not been needed
+    // recently and collect the pages that need more detail
+    size_t committed = 0;
+    FrameVector<TexturePage*> needDetail(gFrameArena);
+    needDetail.reserve(mPages.size());
+    for (auto& pagePtr : mPages)
+    {
+        TexturePage& page = *pagePtr;
+        if (page.requestedMip != TexturePage::NO_MIP)
+        {
+            page.requestedMip  = std::min(page.requestedMip, page.baseMip);
+            page.lastUsedFrame = mFrame;
+            if (page.requestedMip <= page.residentMip)  page.lastDetailFrame = mFrame;
+        }
+
+        bool loading = page.loadingMip != TexturePage::NO_MIP;
+        if (!loading && page.residentMip < page.baseMip && mFrame - page.lastDetailFrame > DROP_DELAY_FRAMES)
+        {
+            QueueLoad(page, page.requestedMip != TexturePage::NO_MIP ? page.requestedMip : page.baseMip);
+        }
+        else if (!loading && page.requestedMip < page.residentMip)
+        {
+            needDetail.push_back(&page);
+        }
+
+        committed += page.Bytes(page.loadingMip != TexturePage::NO_MIP ? page.loadingMip : page.residentMip);
+    }
+
+
+    // Pages furthest from the detail they need go first
+    std::sort(needDetail.begin(), needDetail.end(), [](TexturePage* a, TexturePage* b)
+    {
+        return a->residentMip - a->requestedMip > b->residentMip - b->requestedMip;
+    });
+
+    for (TexturePage* page : needDetail)
+    {
+        auto extraBytes = [&](uint32_t mip) { return page->Bytes(mip) - page->Bytes(page->residentMip); };
+        uint32_t mip = page->requestedMip;
+
+        // Make room by taking the detail from the least recently used pages that are not in use this frame
+        while (committed + extraBytes(mip) > mBudget)
+        {
+            TexturePage* evict = nullptr;
+            for (auto& other : mPages)
+            {
+                if (other->lastUsedFrame < mFrame && other->loadingMip == TexturePage::NO_MIP &&
+                    other->residentMip < other->baseMip && (evict == nullptr || other->lastUsedFrame < evict->lastUsedFrame))
+                {
+                    evict = other.get();
+                }
+            }
+            if (evict == nullptr)  break;
+
+            committed -= evict->Bytes(evict->residentMip) - evict->Bytes(evict->baseMip);
+            QueueLoad(*evict, evict->baseMip);
+        }
+
+        // If there still isn't room then load as much of the detail as fits
+        while (mip < page->residentMip && committed + extraBytes(mip) > mBudget)  ++mip;
+        if (mip < page->residentMip)
+        {
+            committed += extraBytes(mip);
+            QueueLoad(*page, mip);
+        }
+    }
+
+    for (auto& page : mPages)  page->requestedMip = TexturePage::NO_MIP;
+
+    // The streamer keeps its own total of GPU memory, so report that rather than tracking each texture
+    SetMemoryUsage(MemoryCategory::StreamedTextures, MemoryHeap::GPU, ResidentBytes());
+}
+
+
+// Queue a page to be recreated from the given mip level down
+void TextureStreamer::QueueLoad(TexturePage& page, uint32_t mip)
+{
+    page.loadingMip = mip;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back({ &page, mip, page.slices });
+    }
+    mWorkReady.notify_one();
+}
+
+
+// Create queued textures until stopped. The Direct3D device is free-threaded so textures can be created here while the
+// main thread renders, only the swap to the new texture happens on the main thread (in Update)
+void TextureStreamer::WorkerThread()
+{
+    PROFILE_THREAD_NAME("Texture streamer");
+    MemoryScope memoryScope(MemoryCategory::StreamedTextures);
+    for (;;)
+    {
+        StreamRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkReady.wait(lock, [&]() { return mStopping || !mQueue.empty(); });
+            if (mStopping)  return;
+            request = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        PROFILE_ZONE("Create texture levels");
+        StreamResult result = { std::move(request), nullptr, nullptr };
+        if (!CreateLevels(result.request.slices, result.request.mip, &result.texture, &result.srv))
+        {
+            result.texture = nullptr;
+            result.srv     = nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mResults.push_back(std::move(result));
+    }
+}
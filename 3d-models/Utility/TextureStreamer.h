@@ -0,0 +1,187 @@
+//--------------------------------------------------------------------------------------
+// Streaming of texture mip levels by screen-space demand
+//--------------------------------------------------------------------------------------
+// Loading every texture at full detail costs GPU memory and load time for detail that is
+// only visible when a model is close to the camera. Streamed textures start with only their
+// small mip levels on the GPU. Each frame the scene asks for the mip level each texture
+// needs, worked out from the size of the models using it on screen, and the streamer
+// creates a more detailed version of the texture on a worker thread, swapping it in when
+// ready. The total size of the streamed textures is kept within a memory budget by taking
+// detail away from the textures that were least recently used.
+//
+// Textures with the same size, format and mip count are packed into the slices of texture
+// arrays ("pages", see TextureArrayAllocator.h), so models using them need only one texture
+// bind between them and shaders select the slice from a constant. Mip levels are streamed
+// for a whole page at a time, at the detail needed by the most demanding of its textures.
+//
+// The DDS data stays mapped (in the asset package or a mapped file) so the worker reads mip
+// levels straight from the page cache, and the main thread never waits for a load.
+
+#ifndef _TEXTURE_STREAMER_H_INCLUDED_
+#define _TEXTURE_STREAMER_H_INCLUDED_
+
+#include "DDSFile.h"
+#include "MappedFile.h"
+#include "TextureArrayAllocator.h"
+#include "../Common.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+
+
+// A texture array holding streamed textures of the same size and format, one per slice. The mip levels on the GPU are
+// the same for every slice
+struct TexturePage
+{
+    static const uint32_t NO_MIP = ~0u;
+
+    std::vector<const DDSTexture*> slices;   // Data for each slice, nullptr for unused slices
+    std::vector<size_t>            mipBytes; // GPU memory used by one slice with each mip level being the most detailed one
+
+    ID3D11Resource*           texture = nullptr;
+    ID3D11ShaderResourceView* srv     = nullptr;
+    uint32_t                  arraySize = 0; // Number of slices in the texture above
+
+    uint32_t residentMip  = NO_MIP; // Most detailed mip level on the GPU
+    uint32_t baseMip      = 0;      // Mip levels from here down are always resident
+    uint32_t loadingMip   = NO_MIP; // Mip level the worker thread is currently creating, if any
+    uint32_t requestedMip = NO_MIP; // Most detailed mip level asked for this frame by any texture in the page
+
+    uint64_t lastUsedFrame   = 0; // Last frame the page was requested at all, for least recently used eviction
+    uint64_t lastDetailFrame = 0; // Last frame all of the resident detail was requested, older detail can be dropped
+
+    // GPU memory used with the given mip level as the most detailed one. Nothing for NO_MIP, which is the resident level
+    // of a page whose first texture failed to load, or of an empty page waiting to be reused
+    size_t Bytes(uint32_t mip)  { return mip != NO_MIP ? mipBytes[mip] * arraySize : 0; }
+
+    ~TexturePage();
+};
+
+
+// A single 2D texture whose most detailed mip levels are loaded and unloaded on demand
+class StreamedTexture
+{
+public:
+    // The texture array to bind when rendering with this texture, and the slice in it that holds this texture. The view
+    // changes when mip levels are streamed in or out, so fetch it each frame rather than keeping a copy. Textures with
+    // the same view can be used without binding it again
+    ID3D11ShaderResourceView* SRV()    { return mPage->srv;  }
+    uint32_t                  Slice()  { return mSlot.slice; }
+
+    // Size of the texture at full detail
+    uint32_t Width()      { return mDDS.width;     }
+    uint32_t Height()     { return mDDS.height;    }
+    uint32_t MipLevels()  { return mDDS.mipLevels; }
+
+    // Most detailed mip level currently on the GPU (0 is full detail)
+    uint32_t ResidentMip()  { return mPage->residentMip; }
+
+    // Ask for a mip level to be on the GPU this frame. Call for each use of the texture before TextureStreamer::Update,
+    // the most detailed request for any texture in the same page wins
+    void RequestMip(uint32_t mip)  { mPage->requestedMip = std::min(mPage->requestedMip, mip); }
+
+
+private:
+    friend class TextureStreamer;
+
+    std::string                 mName;
+    std::unique_ptr<MappedFile> mFile; // Only used for loose files, cooked textures are read from the asset package
+    DDSTexture                  mDDS;  // Subresources point into the mapped data
+    TextureArraySlot            mSlot;
+    TexturePage*                mPage = nullptr;
+};
+
+
+class TextureStreamer
+{
+public:
+    ~TextureStreamer()  { Shutdown(); }
+
+    // Start the worker thread. Streamed textures will only be given more detail while their total size is within the
+    // given budget (in bytes). The base mip levels of each texture are always resident and may go over the budget
+    void Init(size_t budgetBytes);
+
+    // Stop the worker thread and release all textures
+    void Shutdown();
+
+
+    // Load a texture for streaming with only its base (smallest) mip levels on the GPU. Textures are shared between calls
+    // with the same file name. Textures in the asset package are used if present, otherwise the file must be a DDS file
+    // holding a single 2D texture with mip-maps. Returns nullptr on failure
+    StreamedTexture* Load(const std::string& fileName);
+
+    // Call once per frame after the RequestMip calls for the frame. Swaps in textures finished by the worker thread,
+    // drops detail that is no longer needed and starts creating the most needed detail that fits in the budget
+    void Update();
+
+
+    // Memory budget and current GPU memory used by streamed textures, in bytes
+    size_t Budget()         { return mBudget; }
+    size_t ResidentBytes();
+
+
+private:
+    // A page texture to be created by the worker thread. Holds a copy of the slice list so more textures can be added to
+    // the page while the worker is busy
+    struct StreamRequest
+    {
+        TexturePage*                   page;
+        uint32_t                       mip;
+        std::vector<const DDSTexture*> slices;
+    };
+
+    // A page texture created by the worker thread, waiting to be swapped in
+    struct StreamResult
+    {
+        StreamRequest             request;
+        ID3D11Resource*           texture;
+        ID3D11ShaderResourceView* srv;
+    };
+
+    // Create a texture array holding the mip levels from the given one down for the given slices, can be called from any
+    // thread. Unused slices are filled with a copy of another slice
+    bool CreateLevels(const std::vector<const DDSTexture*>& slices, uint32_t mip, ID3D11Resource** texture,
+                      ID3D11ShaderResourceView** srv);
+
+    // Replace a page's GPU resources with new ones holding the mip levels from the given one down for its current slices
+    void SwapLevels(TexturePage& page, uint32_t mip, ID3D11Resource* texture, ID3D11ShaderResourceView* srv);
+
+    // Queue a page to be recreated from the given mip level down
+    void QueueLoad(TexturePage& page, uint32_t mip);
+
+    void WorkerThread();
+
+
+    std::map<std::string, std::unique_ptr<StreamedTexture>> mTextures;
+    std::vector<std::unique_ptr<TexturePage>>               mPages;
+    TextureArrayAllocator                                   mAllocator;
+
+    size_t   mBudget = 0;
+    uint64_t mFrame  = 0;
+
+    // Work for the worker thread and its results, protected by the mutex
+    std::thread                 mWorker;
+    std::mutex                  mMutex;
+    std::condition_variable     mWorkReady;
+    std::deque<StreamRequest>   mQueue;
+    std::vector<StreamResult>   mResults;
+    bool                        mStopping = false;
+
+    // Results being applied by Update, swapped with mResults so the memory of both is reused from frame to frame
+    std::vector<StreamResult> mFinished;
+};
+
+
+// The texture streamer used by the scene
+extern TextureStreamer gTextureStreamer;
+
+
+#endif //_TEXTURE_STREAMER_H_INCLUDED_
@@ -2,19 +2,113 @@
 // Timer class - works like a stopwatch
 //--------------------------------------------------------------------------------------
 
-#include "Windows.h"
 #include "Timer.h"
 
-// Constructor //
+#include <thread>
+#include <algorithm>
+
+
+namespace
+{
+    // A tenth of a second measures the TSC rate to well within 0.1%
+    const std::chrono::milliseconds TSC_CALIBRATION_TIME(100);
+
+    // Number of times the clock's smallest step is measured, and number of reads timed to measure the overhead
+    const int RESOLUTION_SAMPLES = 100;
+    const int OVERHEAD_READS     = 10000;
+
+    // Both clocks read as close together as possible when the app started, the TSC rate is measured from here
+    struct ClockStart
+    {
+        std::chrono::steady_clock::time_point steady;
+        uint64_t                              tsc;
+    };
+
+    const ClockStart& GetClockStart()
+    {
+        static const ClockStart start = { std::chrono::steady_clock::now(), TimerTicks(TimerClock::TSC) };
+        return start;
+    }
+
+    // Make sure the start is recorded during startup rather than when the TSC is first used
+    const ClockStart& gClockStart = GetClockStart();
+
+
+    uint64_t MeasureTicksPerSecond(TimerClock clock)
+    {
+#if TIMER_TSC_AVAILABLE
+        if (clock == TimerClock::TSC)
+        {
+            const ClockStart& start = GetClockStart();
+            std::this_thread::sleep_until(start.steady + TSC_CALIBRATION_TIME);
+
+            uint64_t ticks = TimerTicks(TimerClock::TSC);
+            std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start.steady;
+            return static_cast<uint64_t>((ticks - start.tsc) / seconds.count() + 0.5);
+        }
+#endif
+        return 1000000000; // Nanoseconds
+    }
+
+    TimerClockInfo MeasureClock(TimerClock clock)
+    {
+        TimerClockInfo info;
+        info.ticksPerSecond = MeasureTicksPerSecond(clock);
+        double nanosecondsPerTick = 1e9 / info.ticksPerSecond;
+
+        // Smallest step seen between one read and the next that differs
+        uint64_t minStep = UINT64_MAX;
+        for (int i = 0; i < RESOLUTION_SAMPLES; ++i)
+        {
+            uint64_t first = TimerTicks(clock);
+            uint64_t next;
+            do  { next = TimerTicks(clock); }  while (next == first);
+            minStep = std::min(minStep, next - first);
+        }
+        info.resolution = minStep * nanosecondsPerTick;
+
+        // Average time of many reads in a row
+        uint64_t start = TimerTicks(clock);
+        for (int i = 0; i < OVERHEAD_READS; ++i)  TimerTicks(clock);
+        info.overhead = (TimerTicks(clock) - start) * nanosecondsPerTick / OVERHEAD_READS;
+
+        return info;
+    }
+}
+
 
-Timer::Timer()
+const char* TimerClockName(TimerClock clock)
 {
-	// Try to initialise performance timer, will use low-resolution timer on failure
-	mHighRes = (QueryPerformanceFrequency( &mHighResFreq ) != 0);
+#if TIMER_TSC_AVAILABLE
+    if (clock == TimerClock::TSC)  return "TSC";
+#endif
+    return "steady_clock";
+}
+
+
+// Properties of the given clock, measured on the first call for each clock (which takes a few milliseconds, and for
+// the TSC may wait until 100ms after the app started). Call at startup for the clocks the app will use, so the
+// measurements aren't made in the middle of a frame. Safe to call from any thread
+const TimerClockInfo& GetTimerClockInfo(TimerClock clock)
+{
+    static const TimerClockInfo steadyInfo = MeasureClock(TimerClock::Steady);
+    if (clock == TimerClock::Steady)  return steadyInfo;
+
+    static const TimerClockInfo tscInfo = MeasureClock(TimerClock::TSC);
+    return tscInfo;
+}
+
+
+
+// Constructor //
 
-	// Reset and start the timer
-	Reset();
-	mRunning = true;
+// The timer starts running straight away
+Timer::Timer(TimerClock clock /*= TimerClock::Steady*/)
+    : mClock(clock), mTicksPerSecond(0)
+{
+    // Reset and start the timer
+    Reset();
+    mRunning = true;
 }
 
 
@@ -23,153 +117,83 @@ Timer::Timer()
 // Start the timer running
 void Timer::Start()
 {
-	if (!mRunning)
-	{
-		mRunning = true;
-
-		// Get restart time - add time passed since stop time to the start and lap times
-		// Select high or low-resolution timer
-		if (mHighRes)
-		{
-			LARGE_INTEGER newHighResTime;
-			QueryPerformanceCounter( &newHighResTime );
-			mHighResStart.QuadPart += (newHighResTime.QuadPart - mHighResStop.QuadPart);
-			mHighResLap.QuadPart += (newHighResTime.QuadPart - mHighResStop.QuadPart);
-		}
-		else
-		{
-			DWORD newLowResTime;
-			newLowResTime = timeGetTime();
-			mLowResStart += (newLowResTime - mLowResStop);
-			mLowResLap += (newLowResTime - mLowResStop);
-		}
-	}
+    if (!mRunning)
+    {
+        mRunning = true;
+
+        // Move the start forward by the time passed since the stop, so it isn't counted
+        mStart += TimerTicks(mClock) - mStop;
+    }
 }
 
 // Stop the timer running
 void Timer::Stop()
 {
-	mRunning = false;
-
-	// Get stop time
-	// Select high or low-resolution timer
-	if (mHighRes)
-	{
-		QueryPerformanceCounter( &mHighResStop );
-	}
-	else
-	{
-		mLowResStop = timeGetTime();
-	}
+    if (mRunning)
+    {
+        mRunning = false;
+        mStop = TimerTicks(mClock);
+    }
 }
 
 // Reset the timer to zero
 void Timer::Reset()
 {
-	// Reset start, lap and stop times to current time
-	// Select high or low-resolution timer
-	if (mHighRes)
-	{
-		QueryPerformanceCounter( &mHighResStart );
-		mHighResLap = mHighResStart;
-		mHighResStop = mHighResStart;
-	}
-	else
-	{
-		mLowResStart = timeGetTime();
-		mLowResLap = mLowResStart;
-		mLowResStop = mLowResStart;
-	}
+    // Reset start and stop times to current time
+    mStart = TimerTicks(mClock);
+    mStop = mStart;
+    mLapStart = 0;
 }
 
 
 // Timing //
 
-// Get frequency of the timer being used (in counts per second)
-float Timer::GetFrequency()
+// Get frequency of the clock being used (in counts per second)
+uint64_t Timer::GetFrequency()
+{
+    // Looked up on first use rather than in the constructor, so global timers don't measure the clock during startup
+    if (mTicksPerSecond == 0)  mTicksPerSecond = GetTimerClockInfo(mClock).ticksPerSecond;
+    return mTicksPerSecond;
+}
+
+// Ticks passed since the start, up to now or to when the timer was stopped
+uint64_t Timer::ElapsedTicks()
+{
+    return (mRunning ? TimerTicks(mClock) : mStop) - mStart;
+}
+
+// Nanoseconds passed since timer was started or last reset, not counting time while stopped
+int64_t Timer::Elapsed()
+{
+    return TicksToNanoseconds(ElapsedTicks(), GetFrequency());
+}
+
+// Nanoseconds passed since the last lap (or since the timer was started or last reset), and start a new lap. The
+// laps always add up to exactly Elapsed()
+int64_t Timer::Lap()
+{
+    // Measured from the start rather than from the last lap, so no rounding builds up over many laps
+    int64_t elapsed = Elapsed();
+    int64_t lap = elapsed - mLapStart;
+    mLapStart = elapsed;
+    return lap;
+}
+
+// Nanoseconds passed in the current lap so far, without starting a new one
+int64_t Timer::Split()
 {
-	// Select high or low-resolution timer
-	if (mHighRes)
-	{
-		return static_cast<float>(mHighResFreq.QuadPart);
-	}
-	else
-	{
-		return 1000.0f;
-	}
+    return Elapsed() - mLapStart;
 }
 
 // Get time passed (seconds) since since timer was started or last reset
-float Timer::GetTime()
+double Timer::GetTime()
 {
-	float fTime;
-	if (mHighRes)
-	{
-
-		LARGE_INTEGER newHighResTime;
-		if (mRunning)
-		{
-			QueryPerformanceCounter( &newHighResTime );
-		}
-		else
-		{
-			newHighResTime = mHighResStop;
-		}
-		double dTime = static_cast<double>(newHighResTime.QuadPart - mHighResStart.QuadPart) /
-			           static_cast<double>(mHighResFreq.QuadPart);
-		fTime = static_cast<float>(dTime);
-	}
-	else
-	{
-		DWORD newLowResTime;
-		if (mRunning)
-		{
-			newLowResTime = timeGetTime();
-		}
-		else
-		{
-			newLowResTime = mLowResStop;
-		}
-		fTime = static_cast<float>(newLowResTime - mLowResStart) / 1000.0f;
-	}
-
-	return fTime;
+    return NanosecondsToSeconds(Elapsed());
 }
 
 // Get time passed (seconds) since last call to this function. If this is the first call, then
 // the time since timer was started or the last reset is returned
 float Timer::GetLapTime()
 {
-	float fTime;
-	if (mHighRes)
-	{
-		LARGE_INTEGER newHighResTime;
-		if (mRunning)
-		{
-			QueryPerformanceCounter( &newHighResTime );
-		}
-		else
-		{
-			newHighResTime = mHighResStop;
-		}
-		double dTime = static_cast<double>(newHighResTime.QuadPart - mHighResLap.QuadPart) /
-			           static_cast<double>(mHighResFreq.QuadPart);
-		fTime = static_cast<float>(dTime);
-		mHighResLap = newHighResTime;
-	}
-	else
-	{
-		DWORD newLowResTime;
-		if (mRunning)
-		{
-			newLowResTime = timeGetTime();
-		}
-		else
-		{
-			newLowResTime = mLowResStop;
-		}
-		fTime = static_cast<float>(newLowResTime - mLowResLap) / 1000.0f;
-		mLowResLap = newLowResTime;
-	}
-	return fTime;
+    return static_cast<float>(NanosecondsToSeconds(Lap()));
 }
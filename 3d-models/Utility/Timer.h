@@ -1,69 +1,217 @@
 //--------------------------------------------------------------------------------------
 // Timer class - works like a stopwatch
 //--------------------------------------------------------------------------------------
+// Times are whole clock ticks converted to nanoseconds with integer arithmetic, so they stay
+// exact however long the app runs and laps always add up to the total. The clock is either
+// std::chrono::steady_clock or the x86 timestamp counter (TSC), which is much quicker to read.
+// See GetTimerClockInfo for the resolution and read cost of each.
 
 #ifndef _TIMER_H_INCLUDED_
 #define _TIMER_H_INCLUDED_
 
-#include "Windows.h"
+// The CPU timestamp counter can be read on x86 CPUs. Modern ones have an "invariant" TSC that runs at a constant
+// rate on every core
+#ifndef TIMER_TSC_AVAILABLE
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TIMER_TSC_AVAILABLE 1
+#else
+#define TIMER_TSC_AVAILABLE 0
+#endif
+#endif
+
+#if TIMER_TSC_AVAILABLE
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#include <chrono>
+#include <cstdint>
+
+
+//--------------------------------------------------------------------------------------
+// Clocks
+//--------------------------------------------------------------------------------------
+
+enum class TimerClock
+{
+    Steady, // std::chrono::steady_clock
+    TSC,    // CPU timestamp counter, falls back to the steady clock where there isn't one
+};
+
+const char* TimerClockName(TimerClock clock);
+
+
+// Current time in ticks of the given clock, from an arbitrary starting point
+inline uint64_t TimerTicks(TimerClock clock)
+{
+#if TIMER_TSC_AVAILABLE
+    if (clock == TimerClock::TSC)  return __rdtsc();
+#endif
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
+// Measured properties of a clock
+struct TimerClockInfo
+{
+    uint64_t ticksPerSecond;
+    double   resolution; // Smallest non-zero step between two reads of the clock, in nanoseconds
+    double   overhead;   // Time taken to read the clock, in nanoseconds
+};
+
+// Properties of the given clock, measured on the first call for each clock (which takes a few milliseconds, and for
+// the TSC may wait until 100ms after the app started). Call at startup for the clocks the app will use, so the
+// measurements aren't made in the middle of a frame. Safe to call from any thread
+const TimerClockInfo& GetTimerClockInfo(TimerClock clock);
+
+
+// Convert a number of ticks to whole nanoseconds (rounded down) without overflow or floating point rounding
+inline int64_t TicksToNanoseconds(uint64_t ticks, uint64_t ticksPerSecond)
+{
+    const uint64_t NS_PER_SECOND = 1000000000;
+    if (ticksPerSecond == NS_PER_SECOND)  return static_cast<int64_t>(ticks);
+    return static_cast<int64_t>((ticks / ticksPerSecond) * NS_PER_SECOND + (ticks % ticksPerSecond) * NS_PER_SECOND / ticksPerSecond);
+}
+
+
+// Convert nanoseconds to seconds
+inline double NanosecondsToSeconds(int64_t nanoseconds)
+{
+    return static_cast<double>(nanoseconds) * 1e-9;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Timer
+//--------------------------------------------------------------------------------------
 
 class Timer
 {
 public:
 
-	// Constructor //
+    // Constructor //
+
+    // The timer starts running straight away
+    explicit Timer(TimerClock clock = TimerClock::Steady);
+
+
+    // Timer control //
 
-	Timer();
+    // Start the timer running
+    void Start();
 
-	
-	// Timer control //
+    // Stop the timer running
+    void Stop();
 
-	// Start the timer running
-	void Start();
+    // Reset the timer to zero
+    void Reset();
 
-	// Stop the timer running
-	void Stop();
+    bool IsRunning()  { return mRunning; }
 
-	// Reset the timer to zero
-	void Reset();
 
+    // Timing //
 
-	// Timing //
+    // Get frequency of the clock being used (in counts per second)
+    uint64_t GetFrequency();
 
-	// Get frequency of the timer being used (in counts per second)
-	float GetFrequency();
+    // Nanoseconds passed since timer was started or last reset, not counting time while stopped
+    int64_t Elapsed();
 
-	// Get time passed (seconds) since since timer was started or last reset
-	float GetTime();
+    // Nanoseconds passed since the last lap (or since the timer was started or last reset), and start a new lap. The
+    // laps always add up to exactly Elapsed()
+    int64_t Lap();
 
-	// Get time passed (seconds) since last call to this function. If this is the first call, then
-	// the time since timer was started or the last reset is returned
-	float GetLapTime();
+    // Nanoseconds passed in the current lap so far, without starting a new one
+    int64_t Split();
+
+    // Get time passed (seconds) since since timer was started or last reset
+    double GetTime();
+
+    // Get time passed (seconds) since last call to this function. If this is the first call, then
+    // the time since timer was started or the last reset is returned
+    float GetLapTime();
 
 
 private:
-	// Is the timer running
-	bool mRunning;
+    // Ticks passed since the start, up to now or to when the timer was stopped
+    uint64_t ElapsedTicks();
+
+    TimerClock mClock;
+    uint64_t   mTicksPerSecond;
+
+    // Is the timer running
+    bool mRunning;
+
+    // Start time in ticks, moved forward by the time spent stopped so the elapsed time doesn't include it
+    uint64_t mStart;
+
+    // Time when the timer was stopped (if it has been)
+    uint64_t mStop;
+
+    // Nanoseconds from the start to the start of the current lap
+    int64_t mLapStart;
+};
+
+
 
+//--------------------------------------------------------------------------------------
+// Time accumulator
+//--------------------------------------------------------------------------------------
+
+// Adds up the times of a piece of work that happens many times, e.g. the time spent in a function over a frame, and
+// keeps the number of times, the total and the longest. Times are whole nanoseconds so no precision is lost
+class TimeAccumulator
+{
+public:
+    explicit TimeAccumulator(TimerClock clock = TimerClock::Steady) : mClock(clock)  {}
+
+    // Forget all the times added so far
+    void Reset()  { mCount = 0; mTotal = mMax = 0; }
+
+    // Add a time in nanoseconds
+    void Add(int64_t nanoseconds)
+    {
+        ++mCount;
+        mTotal += nanoseconds;
+        if (nanoseconds > mMax)  mMax = nanoseconds;
+    }
 
-	// Using high resolution timer and if so its frequency
-	bool          mHighRes;
-	LARGE_INTEGER mHighResFreq;
+    // Time a piece of work by calling Begin before it and End after it
+    void Begin()  { mBegin = TimerTicks(mClock); }
+    void End()    { Add(TicksToNanoseconds(TimerTicks(mClock) - mBegin, GetTimerClockInfo(mClock).ticksPerSecond)); }
 
-	// Start time and last lap start time of high-resolution timer
-	LARGE_INTEGER mHighResStart;
-	LARGE_INTEGER mHighResLap;
+    uint32_t Count()  { return mCount; }
+    int64_t  Total()  { return mTotal; }
+    int64_t  Max()    { return mMax; }
+    int64_t  Mean()   { return mCount > 0 ? mTotal / mCount : 0; }
 
-	// Time when high-resolution timer was stopped (if it has been)
-	LARGE_INTEGER mHighResStop;
 
+private:
+    TimerClock mClock;
+    uint64_t   mBegin = 0;
+    uint32_t   mCount = 0;
+    int64_t    mTotal = 0;
+    int64_t    mMax   = 0;
+};
 
-	// Start time and last lap start time of low-resolution timer
-	DWORD mLowResStart;
-	DWORD mLowResLap;
 
-	// Time when low-resolution timer was stopped (if it has been)
-	DWORD mLowResStop;
+// Adds the time until the end of the scope it is declared in to an accumulator
+class AccumulateTime
+{
+public:
+    explicit AccumulateTime(TimeAccumulator& accumulator) : mAccumulator(accumulator)  { mAccumulator.Begin(); }
+    ~AccumulateTime()  { mAccumulator.End(); }
+
+    AccumulateTime(const AccumulateTime&) = delete;
+    AccumulateTime& operator=(const AccumulateTime&) = delete;
+
+private:
+    TimeAccumulator& mAccumulator;
 };
 
 